@@ -46,4 +46,7 @@ void error_dialog(const std::string &message, SDL_Window *window = nullptr);
 void set_window_title(EmuEnvState &emuenv);
 void calculate_fps(EmuEnvState &emuenv);
 
+// Write the frame count and the time spent by each subsystem during a headless run as JSON
+bool write_headless_report(EmuEnvState &emuenv, const std::string &path, double wall_time, double cpu_time);
+
 } // namespace app
@@ -22,7 +22,12 @@
 #include <display/state.h>
 #include <emuenv/state.h>
 #include <io/state.h>
+#include <mem/functions.h>
+#include <mem/protect.h>
+#include <renderer/null/state.h>
+#include <util/fs.h>
 #include <util/log.h>
+#include <util/string_utils.h>
 
 #include <SDL.h>
 
@@ -75,4 +80,63 @@ void set_window_title(EmuEnvState &emuenv) {
     SDL_SetWindowTitle(emuenv.window.get(), title_to_set.c_str());
 }
 
+static double ns_to_ms(const std::uint64_t ns) {
+    return static_cast<double>(ns) / 1'000'000.0;
+}
+
+bool write_headless_report(EmuEnvState &emuenv, const std::string &path, double wall_time, double cpu_time) {
+    const auto *null_renderer = dynamic_cast<const renderer::null::NullState *>(emuenv.renderer.get());
+    if (!null_renderer) {
+        LOG_ERROR("The headless report needs the null renderer");
+        return false;
+    }
+
+    const renderer::null::NullStats &render = null_renderer->stats;
+    const ProtectStats protect = get_protect_stats(emuenv.mem);
+
+    // the frame counter is not reset by calculate_fps in headless mode
+    const std::size_t frames = emuenv.frame_count;
+
+    std::string report = "{\n";
+    report += fmt::format("  \"title_id\": \"{}\",\n", string_utils::escape_json(emuenv.io.title_id));
+    report += fmt::format("  \"title\": \"{}\",\n", string_utils::escape_json(emuenv.current_app_title));
+    report += fmt::format("  \"version\": \"{}\",\n", string_utils::escape_json(window_title));
+    report += fmt::format("  \"cpu_backend\": \"{}\",\n", string_utils::escape_json(emuenv.cfg.current_config.cpu_backend));
+    report += fmt::format("  \"wall_time_s\": {:.3f},\n", wall_time);
+    report += fmt::format("  \"cpu_time_s\": {:.3f},\n", cpu_time);
+    report += fmt::format("  \"frames\": {},\n", frames);
+    report += fmt::format("  \"fps\": {:.2f},\n", wall_time > 0 ? frames / wall_time : 0.0);
+    report += "  \"renderer\": {\n";
+    report += fmt::format("    \"presented_frames\": {},\n", render.frame_count);
+    report += fmt::format("    \"draws\": {},\n", render.draw_count);
+    report += fmt::format("    \"draw_time_ms\": {:.3f},\n", ns_to_ms(render.draw_time_ns));
+    report += fmt::format("    \"texture_uploads\": {},\n", render.texture_upload_count);
+    report += fmt::format("    \"texture_upload_bytes\": {},\n", render.texture_upload_size);
+    report += fmt::format("    \"texture_time_ms\": {:.3f},\n", ns_to_ms(render.texture_time_ns));
+    report += fmt::format("    \"shaders_translated\": {},\n", render.shader_count);
+    report += fmt::format("    \"shader_time_ms\": {:.3f},\n", ns_to_ms(render.shader_time_ns));
+    report += fmt::format("    \"uniform_upload_bytes\": {},\n", render.uniform_upload_size);
+    report += fmt::format("    \"surface_syncs\": {}\n", render.surface_sync_count);
+    report += "  },\n";
+    report += "  \"memory_protection\": {\n";
+    report += fmt::format("    \"faults\": {},\n", protect.fault_count);
+    report += fmt::format("    \"fault_time_ms\": {:.3f},\n", ns_to_ms(protect.fault_time_ns));
+    report += fmt::format("    \"collects\": {},\n", protect.collect_count);
+    report += fmt::format("    \"collect_time_ms\": {:.3f},\n", ns_to_ms(protect.collect_time_ns));
+    report += fmt::format("    \"collected_pages\": {},\n", protect.collected_page_count);
+    report += fmt::format("    \"host_protects\": {}\n", protect.host_protect_count);
+    report += "  }\n";
+    report += "}\n";
+
+    fs::ofstream file(fs::path(path), std::ios::out | std::ios::trunc);
+    if (!file) {
+        LOG_ERROR("Failed to write the headless report to {}", path);
+        return false;
+    }
+    file << report;
+
+    LOG_INFO("Headless report written to {}: {} frames in {:.2f}s", path, frames, wall_time);
+    return true;
+}
+
 } // namespace app
@@ -26,16 +26,21 @@
 #include <gui/imgui_impl_sdl.h>
 #include <io/functions.h>
 #include <kernel/state.h>
+#include <mem/functions.h>
+#include <mem/protect.h>
 #include <ngs/state.h>
 #include <renderer/state.h>
 
 #include <nids/functions.h>
+#include <renderer/capture.h>
 #include <renderer/functions.h>
 #include <rtc/rtc.h>
 #include <util/fs.h>
 #include <util/lock_and_find.h>
 #include <util/log.h>
+#include <util/metrics.h>
 #include <util/string_utils.h>
+#include <util/trace.h>
 
 #if USE_DISCORD
 #include <app/discord.h>
@@ -63,6 +68,12 @@ void update_viewport(EmuEnvState &state) {
         SDL_Vulkan_GetDrawableSize(state.window.get(), &w, &h);
         break;
 
+    case renderer::Backend::Null:
+        // no window, use the size of the screen of the console
+        w = DEFAULT_RES_WIDTH;
+        h = DEFAULT_RES_HEIGHT;
+        break;
+
     default:
         LOG_ERROR("Unimplemented backend render: {}.", static_cast<int>(state.renderer->current_backend));
         break;
@@ -129,6 +140,9 @@ bool init(EmuEnvState &state, Config &cfg, const Root &root_paths) {
 #endif
     }
 
+    if (state.cfg.headless)
+        state.backend_renderer = renderer::Backend::Null;
+
     int window_type = 0;
     switch (state.backend_renderer) {
     case renderer::Backend::OpenGL:
@@ -139,6 +153,9 @@ bool init(EmuEnvState &state, Config &cfg, const Root &root_paths) {
         window_type = SDL_WINDOW_VULKAN;
         break;
 
+    case renderer::Backend::Null:
+        break;
+
     default:
         LOG_ERROR("Unimplemented backend render: {}.", state.cfg.backend_renderer);
         break;
@@ -155,17 +172,21 @@ bool init(EmuEnvState &state, Config &cfg, const Root &root_paths) {
 #endif
     state.res_width_dpi_scale = DEFAULT_RES_WIDTH * state.dpi_scale;
     state.res_height_dpi_scale = DEFAULT_RES_HEIGHT * state.dpi_scale;
-    state.window = WindowPtr(SDL_CreateWindow(window_title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, state.res_width_dpi_scale, state.res_height_dpi_scale, window_type | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI), SDL_DestroyWindow);
+    if (!state.cfg.headless) {
+        state.window = WindowPtr(SDL_CreateWindow(window_title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, state.res_width_dpi_scale, state.res_height_dpi_scale, window_type | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI), SDL_DestroyWindow);
 
-    if (!state.window) {
-        LOG_ERROR("SDL failed to create window!");
-        return false;
+        if (!state.window) {
+            LOG_ERROR("SDL failed to create window!");
+            return false;
+        }
     }
 
-    if (!init(state.mem)) {
+    if (!init(state.mem, get_write_tracker_type(state.cfg.memory_tracking))) {
         LOG_ERROR("Failed to initialize memory for emulator state!");
         return false;
     }
+    // the faults are counted by the signal handler, which can't touch the metrics
+    metrics::set_source(metrics::PAGE_FAULTS, [&mem = state.mem]() { return get_protect_stats(mem).fault_count; });
 
     if (!state.audio.init(resume_thread, state.cfg.audio_backend)) {
         LOG_WARN("Failed to init audio! Audio will not work.");
@@ -222,6 +243,10 @@ void destroy(EmuEnvState &emuenv, ImGui_State *imgui) {
     if (emuenv.cfg.gdbstub)
         server_close(emuenv);
 
+    trace::stop();
+    metrics::stop_dump();
+    renderer::capture::stop();
+
     // There may be changes that made in the GUI, so we should save, again
     if (emuenv.cfg.overwrite_config)
         config::serialize_config(emuenv.cfg, emuenv.cfg.config_path);
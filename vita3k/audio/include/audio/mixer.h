@@ -0,0 +1,30 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+
+// Fixed point gains used by the mixer, AUDIO_MIX_GAIN_ONE is 0 dB
+constexpr int AUDIO_MIX_GAIN_SHIFT = 14;
+constexpr int AUDIO_MIX_GAIN_ONE = 1 << AUDIO_MIX_GAIN_SHIFT;
+
+// Add nb_frames interleaved stereo S16 frames, scaled by the channel gains, to the accumulation buffer
+void audio_mix_s16_stereo(int32_t *mix, const int16_t *src, int nb_frames, int left_gain, int right_gain);
+
+// Convert nb_samples accumulated samples back to S16 with saturation
+void audio_mix_to_s16(int16_t *dest, const int32_t *mix, int nb_samples);
@@ -17,10 +17,13 @@
 
 #pragma once
 
+#include <audio/mixer.h>
+#include <util/spsc_ring_buffer.h>
 #include <util/types.h>
 
 #include <SDL_audio.h>
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -43,10 +46,21 @@ struct AudioOutPort {
     int len_bytes = 0;
 
     std::mutex mutex;
-    // stream to get the data
+    // stream used to convert the data to the host format, only used by the guest thread
     AudioStreamPtr stream;
+    // converted data waiting to be mixed, filled by the guest thread and emptied by the audio callback without locking
+    std::unique_ptr<SPSCByteRingBuffer> buffer;
+    // used to move the data from the stream to the buffer, only used by the guest thread
+    std::vector<uint8_t> convert_buffer;
+    // channel gains used by the mixer
+    std::atomic<int> left_gain = AUDIO_MIX_GAIN_ONE;
+    std::atomic<int> right_gain = AUDIO_MIX_GAIN_ONE;
     // thread currently waiting for the audio to be processed
-    SceUID thread = -1;
+    std::atomic<SceUID> thread = -1;
+    // number of times the audio callback ran out of data while the port was playing
+    std::atomic<uint64_t> underruns = 0;
+    // only used by the audio callback
+    bool playing = false;
 };
 
 typedef std::shared_ptr<AudioOutPort> AudioOutPortPtr;
@@ -72,14 +86,19 @@ struct AudioState;
 // abstract class that need to be overloaded with an audio implementation
 class AudioAdapter {
 private:
-    // buffer used to mix audio
-    std::vector<uint8_t> temp_buffer;
+    // buffer used to get the audio of a port
+    std::vector<int16_t> temp_buffer;
+    // buffer used to accumulate the audio of all ports
+    std::vector<int32_t> mix_buffer;
 
 protected:
     AudioState &state;
     // are we using a single stream and mixing everything inside or multiple streams?
     bool single_stream = true;
 
+    // must be called by single stream adapters once state.spec is known, before the first callback
+    void init_mix_buffers();
+
 public:
     // called by subclasses once they get called by their implementation callback
     // stream points to the location where we need to write state.ro.len_bytes bytes
@@ -108,9 +127,21 @@ struct AudioState {
     ResumeAudioThread resume_thread;
     std::string audio_backend;
 
+    // copy of out_ports read by the audio callback, replaced by update_active_ports
+    std::unique_ptr<const std::vector<AudioOutPortPtr>> active_ports_storage;
+    std::atomic<const std::vector<AudioOutPortPtr> *> active_ports = nullptr;
+    // incremented when the audio callback starts and when it ends, odd while it is running
+    std::atomic<uint32_t> callback_epoch = 0;
+    // total number of underruns of the ports that were released
+    std::atomic<uint64_t> underruns = 0;
+
+    // must be called with mutex locked each time out_ports is modified
+    void update_active_ports();
+
     bool init(const ResumeAudioThread &resume_thread, const std::string &adapter_name);
     void set_backend(const std::string &adapter_name);
     AudioOutPortPtr open_port(int nb_channels, int freq, int nb_sample);
     void audio_output(ThreadState &thread, AudioOutPort &out_port, const void *buffer);
     void set_volume(AudioOutPort &out_port, float volume);
+    int get_rest_sample(AudioOutPort &out_port);
 };
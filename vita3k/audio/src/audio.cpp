@@ -25,39 +25,43 @@
 #include <kernel/thread/thread_state.h>
 
 #include <util/log.h>
+#include <util/metrics.h>
 
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <thread>
 
-static void mix_out_port(uint8_t *stream, uint8_t *temp_buffer, int len, AudioOutPort &port, const ResumeAudioThread &resume_thread) {
+static void mix_out_port(int32_t *mix_buffer, int16_t *temp_buffer, int len, AudioOutPort &port, const ResumeAudioThread &resume_thread) {
     ZoneScopedC(0xF6C2FF); // Tracy - Track function scope with color thistle
 
     // How much data is available?
-    std::unique_lock<std::mutex> lock(port.mutex);
-    const int bytes_available = SDL_AudioStreamAvailable(port.stream.get());
-    assert(bytes_available >= 0);
+    const std::size_t bytes_available = port.buffer->Used();
 
     // Running out of data?
     // The (len * 3) is according to the value in sceAudioOutOutput
-    if (bytes_available < len * 3) {
-        // Is there a thread waiting for playback to finish?
-        if (port.thread >= 0) {
-            // Wake the thread up.
-            resume_thread(port.thread);
-            port.thread = -1;
-        }
+    if (bytes_available < static_cast<std::size_t>(len * 3)) {
+        // Is there a thread waiting for playback to finish? Wake it up.
+        const SceUID thread = port.thread.exchange(-1);
+        if (thread >= 0)
+            resume_thread(thread);
     }
 
-    if (bytes_available == 0)
-        return;
-
     // Mix as much as we need.
-    const int bytes_to_get = std::min(len, bytes_available);
-    const int bytes_got = SDL_AudioStreamGet(port.stream.get(), temp_buffer, bytes_to_get);
-    lock.unlock();
+    const int bytes_got = static_cast<int>(port.buffer->Remove(temp_buffer, len));
+    if (bytes_got < len) {
+        if (port.playing) {
+            port.underruns++;
+            metrics::add(metrics::AUDIO_UNDERRUNS);
+        }
+        port.playing = false;
+    } else {
+        port.playing = true;
+    }
+
     if (bytes_got > 0) {
-        SDL_MixAudioFormat(stream, temp_buffer, AUDIO_S16LSB, bytes_got, static_cast<int>(port.volume * SDL_MIX_MAXVOLUME));
+        const int nb_frames = bytes_got / (2 * sizeof(int16_t));
+        audio_mix_s16_stereo(mix_buffer, temp_buffer, nb_frames, port.left_gain, port.right_gain);
     }
 }
 
@@ -65,24 +69,58 @@ void AudioAdapter::audio_callback(uint8_t *stream, int len_bytes) {
     tracy::SetThreadName("Host audio thread"); // Tracy - Declare belonging of this function to the audio thread
     ZoneScopedC(0xF6C2FF); // Tracy - Track function scope with color thistle
 
-    std::vector<AudioOutPortPtr> ports;
-    {
-        // Read from shared state.
-        const std::lock_guard<std::mutex> lock(state.mutex);
-        ports.reserve(state.out_ports.size());
-        for (const AudioOutPortPtrs::value_type &port : state.out_ports) {
-            ports.push_back(port.second);
+    // Nothing here must lock or allocate, the ports can only be released once the callback is done with them
+    state.callback_epoch++;
+    const std::vector<AudioOutPortPtr> *ports = state.active_ports;
+
+    int16_t *output = reinterpret_cast<int16_t *>(stream);
+    int samples_left = len_bytes / sizeof(int16_t);
+    while (samples_left > 0) {
+        const int nb_samples = std::min<int>(samples_left, mix_buffer.size());
+        std::fill_n(mix_buffer.data(), nb_samples, 0);
+
+        if (ports) {
+            for (const AudioOutPortPtr &port : *ports)
+                mix_out_port(mix_buffer.data(), temp_buffer.data(), nb_samples * sizeof(int16_t), *port, state.resume_thread);
         }
-    }
-    std::memset(stream, state.spec.silence, len_bytes);
 
-    for (const AudioOutPortPtr &port : ports) {
-        mix_out_port(stream, temp_buffer.data(), len_bytes, *port.get(), state.resume_thread);
+        audio_mix_to_s16(output, mix_buffer.data(), nb_samples);
+        output += nb_samples;
+        samples_left -= nb_samples;
     }
 
+    state.callback_epoch++;
+
     FrameMarkNamed("Audio"); // Tracy - End discontinuous frame for audio rendering
 }
 
+void AudioAdapter::init_mix_buffers() {
+    temp_buffer.resize(state.spec.nb_samples * 2);
+    mix_buffer.resize(state.spec.nb_samples * 2);
+}
+
+void AudioState::update_active_ports() {
+    auto ports = std::make_unique<std::vector<AudioOutPortPtr>>();
+    ports->reserve(out_ports.size());
+    for (const AudioOutPortPtrs::value_type &port : out_ports) {
+        // only the ports mixed by the callback
+        if (port.second->buffer)
+            ports->push_back(port.second);
+    }
+
+    active_ports = ports.get();
+
+    // Wait for a running callback, which may still use the previous list, to be done
+    const uint32_t epoch = callback_epoch;
+    if (epoch & 1) {
+        while (callback_epoch == epoch)
+            std::this_thread::yield();
+    }
+
+    // The previous list can now be destroyed
+    active_ports_storage = std::move(ports);
+}
+
 bool AudioState::init(const ResumeAudioThread &resume_thread, const std::string &adapter_name) {
     this->resume_thread = resume_thread;
 
@@ -98,7 +136,11 @@ void AudioState::set_backend(const std::string &adapter_name) {
         return;
 
     // first delete all ports then delete the backend
-    out_ports.clear();
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        out_ports.clear();
+        update_active_ports();
+    }
     adapter.reset();
     if (adapter_name == "SDL") {
         adapter = std::make_unique<SDLAudioAdapter>(*this);
@@ -116,8 +158,6 @@ void AudioState::set_backend(const std::string &adapter_name) {
         adapter.reset();
         return;
     }
-
-    adapter->temp_buffer.resize(spec.nb_samples * 2 * sizeof(uint16_t));
 }
 
 AudioOutPortPtr AudioState::open_port(int nb_channels, int freq, int nb_sample) {
@@ -131,6 +171,12 @@ AudioOutPortPtr AudioState::open_port(int nb_channels, int freq, int nb_sample)
         port->len_bytes = nb_sample * nb_channels * sizeof(int16_t);
         port->stream = stream;
 
+        // enough space for the 3 callbacks of data waited for in audio_output, one more callback and two converted outputs
+        const int callback_bytes = spec.nb_samples * 2 * sizeof(int16_t);
+        const int converted_output_bytes = (nb_sample * spec.freq / freq + 1) * 2 * sizeof(int16_t);
+        port->buffer = std::make_unique<SPSCByteRingBuffer>(4 * callback_bytes + 2 * converted_output_bytes);
+        port->convert_buffer.resize(port->buffer->Capacity());
+
         return port;
     } else {
         // let the adapter open the port
@@ -141,10 +187,17 @@ AudioOutPortPtr AudioState::open_port(int nb_channels, int freq, int nb_sample)
 
 void AudioState::audio_output(ThreadState &thread, AudioOutPort &out_port, const void *buffer) {
     if (adapter->single_stream) {
-        // Put audio to the port's stream and see how much is left to play.
+        // Put audio to the port's stream, move what has been converted to the buffer and see how much is left to play.
         std::unique_lock<std::mutex> lock(out_port.mutex);
         SDL_AudioStreamPut(out_port.stream.get(), buffer, out_port.len_bytes);
-        const int available = SDL_AudioStreamAvailable(out_port.stream.get());
+        // only move whole frames, if the buffer is full the rest stays in the stream until the next call
+        const int bytes_to_move = std::min<int>(SDL_AudioStreamAvailable(out_port.stream.get()), out_port.buffer->Free()) & ~static_cast<int>(2 * sizeof(int16_t) - 1);
+        if (bytes_to_move > 0) {
+            const int bytes_got = SDL_AudioStreamGet(out_port.stream.get(), out_port.convert_buffer.data(), bytes_to_move);
+            if (bytes_got > 0)
+                out_port.buffer->Insert(out_port.convert_buffer.data(), bytes_got);
+        }
+        const std::size_t available = out_port.buffer->Used();
         lock.unlock();
 
         // If there's lots of audio left to play, stop this thread.
@@ -168,6 +221,19 @@ void AudioState::audio_output(ThreadState &thread, AudioOutPort &out_port, const
 
 void AudioState::set_volume(AudioOutPort &out_port, float volume) {
     out_port.volume = volume;
+    out_port.left_gain = std::clamp(out_port.left_channel_volume, 0, SCE_AUDIO_VOLUME_0DB) * AUDIO_MIX_GAIN_ONE / SCE_AUDIO_VOLUME_0DB;
+    out_port.right_gain = std::clamp(out_port.right_channel_volume, 0, SCE_AUDIO_VOLUME_0DB) * AUDIO_MIX_GAIN_ONE / SCE_AUDIO_VOLUME_0DB;
 
     adapter->set_volume(out_port, volume);
 }
+
+int AudioState::get_rest_sample(AudioOutPort &out_port) {
+    if (!out_port.buffer)
+        return 0;
+
+    const std::lock_guard<std::mutex> lock(out_port.mutex);
+    const int bytes_available = static_cast<int>(out_port.buffer->Used()) + SDL_AudioStreamAvailable(out_port.stream.get());
+
+    // we have the number of bytes left, we can convert it back to the number of samples left
+    return bytes_available / (2 * sizeof(int16_t));
+}
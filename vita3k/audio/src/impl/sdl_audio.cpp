@@ -62,6 +62,7 @@ bool SDLAudioAdapter::init() {
         .nb_samples = spec.samples,
         .silence = spec.silence
     };
+    init_mix_buffers();
 
     SDL_PauseAudioDevice(device_id, 0);
 
@@ -0,0 +1,85 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <audio/mixer.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_MIX_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define AUDIO_MIX_NEON
+#include <arm_neon.h>
+#endif
+
+void audio_mix_s16_stereo(int32_t *mix, const int16_t *src, int nb_frames, int left_gain, int right_gain) {
+    int nb_samples = nb_frames * 2;
+    int i = 0;
+
+#if defined(AUDIO_MIX_SSE2)
+    // each 32-bit lane is (sample, 0) * (gain, 0), so _mm_madd_epi16 gives sample * gain
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i gains = _mm_set_epi16(0, static_cast<int16_t>(right_gain), 0, static_cast<int16_t>(left_gain),
+        0, static_cast<int16_t>(right_gain), 0, static_cast<int16_t>(left_gain));
+    for (; i + 8 <= nb_samples; i += 8) {
+        const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i low = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(samples, zero), gains), AUDIO_MIX_GAIN_SHIFT);
+        const __m128i high = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(samples, zero), gains), AUDIO_MIX_GAIN_SHIFT);
+
+        __m128i *dest = reinterpret_cast<__m128i *>(mix + i);
+        _mm_storeu_si128(dest, _mm_add_epi32(_mm_loadu_si128(dest), low));
+        _mm_storeu_si128(dest + 1, _mm_add_epi32(_mm_loadu_si128(dest + 1), high));
+    }
+#elif defined(AUDIO_MIX_NEON)
+    const int32_t gain_values[4] = { left_gain, right_gain, left_gain, right_gain };
+    const int32x4_t gains = vld1q_s32(gain_values);
+    for (; i + 8 <= nb_samples; i += 8) {
+        const int16x8_t samples = vld1q_s16(src + i);
+        const int32x4_t low = vshrq_n_s32(vmulq_s32(vmovl_s16(vget_low_s16(samples)), gains), AUDIO_MIX_GAIN_SHIFT);
+        const int32x4_t high = vshrq_n_s32(vmulq_s32(vmovl_s16(vget_high_s16(samples)), gains), AUDIO_MIX_GAIN_SHIFT);
+
+        vst1q_s32(mix + i, vaddq_s32(vld1q_s32(mix + i), low));
+        vst1q_s32(mix + i + 4, vaddq_s32(vld1q_s32(mix + i + 4), high));
+    }
+#endif
+
+    // remaining frames, gives the same result as the vectorized loops
+    for (; i < nb_samples; i += 2) {
+        mix[i] += (src[i] * left_gain) >> AUDIO_MIX_GAIN_SHIFT;
+        mix[i + 1] += (src[i + 1] * right_gain) >> AUDIO_MIX_GAIN_SHIFT;
+    }
+}
+
+void audio_mix_to_s16(int16_t *dest, const int32_t *mix, int nb_samples) {
+    int i = 0;
+
+#if defined(AUDIO_MIX_SSE2)
+    for (; i + 8 <= nb_samples; i += 8) {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mix + i));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mix + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_packs_epi32(low, high));
+    }
+#elif defined(AUDIO_MIX_NEON)
+    for (; i + 8 <= nb_samples; i += 8) {
+        vst1q_s16(dest + i, vcombine_s16(vqmovn_s32(vld1q_s32(mix + i)), vqmovn_s32(vld1q_s32(mix + i + 4))));
+    }
+#endif
+
+    for (; i < nb_samples; i++)
+        dest[i] = static_cast<int16_t>(std::clamp<int32_t>(mix[i], INT16_MIN, INT16_MAX));
+}
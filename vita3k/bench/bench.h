@@ -0,0 +1,121 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+struct MemState;
+
+// Harness of vita3k-bench. Each benchmark runs its loop while keep_running returns true,
+// the runner increases the iteration count until the loop lasts long enough to be measured.
+namespace bench {
+
+class State {
+public:
+    explicit State(std::uint64_t max_iterations)
+        : max_iterations(max_iterations) {}
+
+    // The time is measured from the first call to the last one, the setup must be done before the loop
+    bool keep_running() {
+        if (iterations == 0) {
+            start_cpu = std::clock();
+            start_time = std::chrono::steady_clock::now();
+        }
+        if (iterations == max_iterations) {
+            real_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+            cpu_ns = static_cast<double>(std::clock() - start_cpu) * 1e9 / CLOCKS_PER_SEC;
+            return false;
+        }
+        iterations++;
+        return true;
+    }
+
+    // Amounts processed by each iteration, reported as throughputs
+    void set_bytes_per_iteration(std::uint64_t bytes) {
+        bytes_per_iteration = bytes;
+    }
+    void set_items_per_iteration(std::uint64_t items) {
+        items_per_iteration = items;
+    }
+
+    // Called instead of running the loop when the benchmark can't run, for example without its input files
+    void skip(const std::string &reason) {
+        skip_reason = reason;
+    }
+
+    const std::uint64_t max_iterations;
+    std::uint64_t iterations = 0;
+    double real_ns = 0;
+    double cpu_ns = 0;
+    std::uint64_t bytes_per_iteration = 0;
+    std::uint64_t items_per_iteration = 0;
+    std::string skip_reason;
+
+private:
+    std::chrono::steady_clock::time_point start_time;
+    std::clock_t start_cpu = 0;
+};
+
+struct Benchmark {
+    // <module>/<kernel>, used to filter them
+    std::string name;
+    std::function<void(State &)> run;
+};
+
+// Registers the benchmarks of a file, from a static object
+struct Registration {
+    Registration(std::initializer_list<Benchmark> benchmarks);
+    // for the benchmarks generated from a list of variants
+    explicit Registration(const std::vector<Benchmark> &benchmarks);
+};
+
+struct Options {
+    // GXP programs dumped by the emulator (shaderlog/<title id>), used by the shader benchmarks
+    fs::path gxp_dir;
+    // H264 elementary stream decoded by the codec benchmarks
+    fs::path h264_stream;
+};
+
+const Options &get_options();
+
+// Guest memory shared by the benchmarks working on guest addresses, nullptr when it can't be reserved
+MemState *get_guest_memory();
+
+// Keeps the compiler from removing the computation of a value nobody reads
+template <typename T>
+inline void do_not_optimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile(""
+                 :
+                 : "r,m"(value)
+                 : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+} // namespace bench
@@ -0,0 +1,139 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "bench.h"
+
+#include <codec/state.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Frames of 16 bytes giving 28 samples, about 1 second of audio at 48 kHz for each channel
+constexpr std::size_t FRAME_SIZE = 16;
+constexpr std::size_t FRAME_COUNT = 1728;
+
+// Random nibbles with a valid coefficient index and shift in each frame header
+static std::vector<std::uint8_t> make_he_adpcm_stream(std::uint32_t channels) {
+    std::vector<std::uint8_t> stream(FRAME_COUNT * channels * FRAME_SIZE);
+    std::uint32_t seed = 0x12345678;
+    for (std::size_t offset = 0; offset < stream.size(); offset += FRAME_SIZE) {
+        seed = seed * 1664525 + 1013904223;
+        const std::uint32_t coef_index = (seed >> 8) % 128;
+        const std::uint32_t shift = (seed >> 16) % 13;
+        stream[offset] = static_cast<std::uint8_t>(((coef_index & 0xF) << 4) | shift);
+        stream[offset + 1] = static_cast<std::uint8_t>(coef_index & 0xF0);
+        for (std::size_t i = 2; i < FRAME_SIZE; i++) {
+            seed = seed * 1664525 + 1013904223;
+            stream[offset + i] = static_cast<std::uint8_t>(seed >> 24);
+        }
+    }
+    return stream;
+}
+
+// Decoding and conversion to the F32 stereo samples given to the audio output
+static void decode_he_adpcm(bench::State &state, std::uint32_t channels) {
+    const std::vector<std::uint8_t> stream = make_he_adpcm_stream(channels);
+    PCMDecoderState decoder(48000.0f);
+    decoder.he_adpcm = true;
+    decoder.source_channels = channels;
+
+    while (state.keep_running()) {
+        decoder.send(stream.data(), static_cast<std::uint32_t>(stream.size()));
+        DecoderSize size;
+        decoder.receive(nullptr, &size);
+        bench::do_not_optimize(size.samples);
+    }
+    state.set_bytes_per_iteration(stream.size());
+    state.set_items_per_iteration(FRAME_COUNT * (FRAME_SIZE - 2) * 2);
+}
+
+// Cut the stream into access units, as games give them to sceAvcdecDecode
+static std::vector<std::vector<std::uint8_t>> split_access_units(const std::vector<std::uint8_t> &stream) {
+    std::vector<std::vector<std::uint8_t>> access_units;
+    AVCodecParserContext *parser = av_parser_init(AV_CODEC_ID_H264);
+    AVCodecContext *context = avcodec_alloc_context3(avcodec_find_decoder(AV_CODEC_ID_H264));
+
+    const std::uint8_t *data = stream.data();
+    int remaining = static_cast<int>(stream.size());
+    while (true) {
+        std::uint8_t *au = nullptr;
+        int au_size = 0;
+        const int used = av_parser_parse2(parser, context, &au, &au_size, data, remaining, AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+        if (used < 0)
+            break;
+        if (au_size > 0)
+            access_units.emplace_back(au, au + au_size);
+        // an empty input flushes the last access unit
+        if (remaining == 0)
+            break;
+        data += used;
+        remaining -= used;
+    }
+
+    avcodec_free_context(&context);
+    av_parser_close(parser);
+    return access_units;
+}
+
+// Decoding of the whole stream given with --h264-stream by the SceVideodec path, with a new decoder each time
+static void decode_h264(bench::State &state, int threads) {
+    const fs::path &path = bench::get_options().h264_stream;
+    if (path.empty()) {
+        state.skip("no stream given with --h264-stream");
+        return;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<std::uint8_t> stream{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    const auto access_units = split_access_units(stream);
+    if (access_units.empty()) {
+        state.skip("no access unit found in " + path.string());
+        return;
+    }
+
+    // the stream resolution wins over the one given to the decoder, leave room for any of them
+    std::vector<std::uint8_t> picture(H264DecoderState::buffer_size({ 4096, 4096 }));
+    std::size_t frames = 0;
+    std::size_t output_size = 0;
+    while (state.keep_running()) {
+        H264DecoderState decoder(960, 544, threads);
+        frames = 0;
+        output_size = 0;
+        for (const auto &au : access_units) {
+            DecoderSize size{};
+            if (decoder.send(au.data(), static_cast<std::uint32_t>(au.size())) && decoder.receive(picture.data(), &size)) {
+                frames++;
+                output_size += H264DecoderState::buffer_size(size);
+            }
+        }
+    }
+    state.set_bytes_per_iteration(output_size);
+    state.set_items_per_iteration(frames);
+}
+
+static const bench::Registration registration({
+    { "codec/he_adpcm_mono", [](bench::State &state) { decode_he_adpcm(state, 1); } },
+    { "codec/he_adpcm_stereo", [](bench::State &state) { decode_he_adpcm(state, 2); } },
+    { "codec/h264_decode_1_thread", [](bench::State &state) { decode_h264(state, 1); } },
+    { "codec/h264_decode_threads", [](bench::State &state) { decode_h264(state, get_codec_thread_count()); } },
+});
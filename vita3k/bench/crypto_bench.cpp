@@ -0,0 +1,171 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#include "bench.h"
+
+#include <crypto/aes.h>
+#include <packages/pkg_crypto.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Amount of data given to the modes of each AES implementation
+constexpr std::size_t AES_DATA_SIZE = 1024 * 1024;
+// Chunk read at once by the pkg installer
+constexpr std::size_t PKG_CHUNK_SIZE = 8 * 1024 * 1024;
+
+const std::uint8_t KEY[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+const std::uint8_t IV[16] = { 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+
+struct Backend {
+    aes_backend backend;
+    // suffix of the benchmark names
+    const char *name;
+};
+
+const Backend BACKENDS[] = {
+    { AES_BACKEND_SOFTWARE, "software" },
+    { AES_BACKEND_AESNI, "aesni" },
+    { AES_BACKEND_VAES, "vaes" },
+    { AES_BACKEND_ARMV8_CE, "armv8_ce" },
+};
+
+// Runs the benchmark with this AES implementation, or skips it if the host does not support it
+static void with_backend(bench::State &state, aes_backend backend, const std::function<void()> &run) {
+    const aes_backend previous = aes_get_backend();
+    if (aes_set_backend(backend) != 0) {
+        state.skip(std::string(aes_backend_name(backend)) + " is not supported by the host");
+        return;
+    }
+
+    run();
+    aes_set_backend(previous);
+}
+
+// One slice of the pkg decryption, with the function of the installer
+static void pkg_ctr_xor(bench::State &state, aes_backend backend) {
+    with_backend(state, backend, [&]() {
+        aes_context ctx;
+        aes_setkey_enc(&ctx, KEY, 128);
+        std::vector<std::uint8_t> data(PKG_DECRYPT_SLICE_SIZE, 0x5a);
+
+        std::uint64_t block = 0;
+        while (state.keep_running()) {
+            aes128_ctr_xor(&ctx, IV, block, data.data(), data.size());
+            block += PKG_DECRYPT_SLICE_SIZE / 16;
+        }
+        state.set_bytes_per_iteration(PKG_DECRYPT_SLICE_SIZE);
+    });
+}
+
+// A whole chunk of the pkg decryption, split into slices on the shared workers, with the fastest implementation
+static void pkg_ctr_xor_parallel(bench::State &state) {
+    aes_context ctx;
+    aes_setkey_enc(&ctx, KEY, 128);
+    std::vector<std::uint8_t> data(PKG_CHUNK_SIZE, 0x5a);
+
+    std::uint64_t offset = 0;
+    while (state.keep_running()) {
+        aes128_ctr_xor_parallel(&ctx, IV, offset, data.data(), data.size());
+        offset += PKG_CHUNK_SIZE;
+    }
+    state.set_bytes_per_iteration(PKG_CHUNK_SIZE);
+}
+
+static void aes_ecb(bench::State &state, aes_backend backend) {
+    with_backend(state, backend, [&]() {
+        aes_context ctx;
+        aes_setkey_enc(&ctx, KEY, 128);
+        std::vector<std::uint8_t> data(AES_DATA_SIZE, 0x5a);
+
+        while (state.keep_running()) {
+            for (std::size_t offset = 0; offset < data.size(); offset += 16)
+                aes_crypt_ecb(&ctx, AES_ENCRYPT, &data[offset], &data[offset]);
+        }
+        state.set_bytes_per_iteration(AES_DATA_SIZE);
+    });
+}
+
+static void aes_cbc(bench::State &state, aes_backend backend, int mode) {
+    with_backend(state, backend, [&]() {
+        aes_context ctx;
+        if (mode == AES_ENCRYPT)
+            aes_setkey_enc(&ctx, KEY, 128);
+        else
+            aes_setkey_dec(&ctx, KEY, 128);
+        std::vector<std::uint8_t> data(AES_DATA_SIZE, 0x5a);
+
+        while (state.keep_running()) {
+            std::uint8_t iv[16] = {};
+            aes_crypt_cbc(&ctx, mode, data.size(), iv, data.data(), data.data());
+        }
+        state.set_bytes_per_iteration(AES_DATA_SIZE);
+    });
+}
+
+static void aes_ctr(bench::State &state, aes_backend backend) {
+    with_backend(state, backend, [&]() {
+        aes_context ctx;
+        aes_setkey_enc(&ctx, KEY, 128);
+        std::vector<std::uint8_t> data(AES_DATA_SIZE, 0x5a);
+
+        while (state.keep_running()) {
+            std::uint8_t counter[16] = {};
+            std::uint8_t stream_block[16];
+            std::size_t nc_off = 0;
+            aes_crypt_ctr(&ctx, data.size(), &nc_off, counter, stream_block, data.data(), data.data());
+        }
+        state.set_bytes_per_iteration(AES_DATA_SIZE);
+    });
+}
+
+static void aes_cmac(bench::State &state, aes_backend backend) {
+    with_backend(state, backend, [&]() {
+        aes_context ctx;
+        aes_setkey_enc(&ctx, KEY, 128);
+        std::vector<std::uint8_t> data(AES_DATA_SIZE, 0x5a);
+
+        while (state.keep_running()) {
+            std::uint8_t mac[16];
+            aes_cmac(&ctx, static_cast<int>(data.size()), data.data(), mac);
+            bench::do_not_optimize(mac);
+        }
+        state.set_bytes_per_iteration(AES_DATA_SIZE);
+    });
+}
+
+static std::vector<bench::Benchmark> get_crypto_benchmarks() {
+    std::vector<bench::Benchmark> benchmarks = {
+        { "crypto/pkg_ctr_xor_parallel", pkg_ctr_xor_parallel },
+    };
+
+    for (const Backend &backend : BACKENDS) {
+        const aes_backend id = backend.backend;
+        const std::string suffix = backend.name;
+        benchmarks.push_back({ "crypto/pkg_ctr_xor_" + suffix, [id](bench::State &state) { pkg_ctr_xor(state, id); } });
+        benchmarks.push_back({ "crypto/aes_ecb_" + suffix, [id](bench::State &state) { aes_ecb(state, id); } });
+        benchmarks.push_back({ "crypto/aes_cbc_encrypt_" + suffix, [id](bench::State &state) { aes_cbc(state, id, AES_ENCRYPT); } });
+        benchmarks.push_back({ "crypto/aes_cbc_decrypt_" + suffix, [id](bench::State &state) { aes_cbc(state, id, AES_DECRYPT); } });
+        benchmarks.push_back({ "crypto/aes_ctr_" + suffix, [id](bench::State &state) { aes_ctr(state, id); } });
+        benchmarks.push_back({ "crypto/aes_cmac_" + suffix, [id](bench::State &state) { aes_cmac(state, id); } });
+    }
+
+    return benchmarks;
+}
+
+static const bench::Registration registration(get_crypto_benchmarks());
@@ -0,0 +1,241 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Run the CPU side kernels on synthetic inputs and print the time they take:
+// vita3k-bench [--filter <regex>] [--min-time <seconds>] [--json <file>] [--gxp-dir <dir>] [--h264-stream <file>] [--list]
+// The JSON file uses the format of Google Benchmark, so its compare.py can tell the changes between two commits.
+
+#include "bench.h"
+
+#include <config/version.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <util/string_utils.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench {
+
+static std::vector<Benchmark> &get_benchmarks() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+static Options options;
+
+Registration::Registration(std::initializer_list<Benchmark> benchmarks) {
+    get_benchmarks().insert(get_benchmarks().end(), benchmarks);
+}
+
+Registration::Registration(const std::vector<Benchmark> &benchmarks) {
+    get_benchmarks().insert(get_benchmarks().end(), benchmarks.begin(), benchmarks.end());
+}
+
+const Options &get_options() {
+    return options;
+}
+
+MemState *get_guest_memory() {
+    static MemState mem;
+    // the write tracker is not used, mprotect does not need anything from the host
+    static const bool ready = init(mem, WriteTrackerType::MPROTECT);
+    return ready ? &mem : nullptr;
+}
+
+} // namespace bench
+
+struct Result {
+    std::string name;
+    std::uint64_t iterations;
+    double real_ns;
+    double cpu_ns;
+    double bytes_per_second;
+    double items_per_second;
+    std::string skip_reason;
+};
+
+static void print_usage() {
+    std::printf("Usage: vita3k-bench [--filter <regex>] [--min-time <seconds>] [--json <file>] [--gxp-dir <dir>] [--h264-stream <file>] [--list]\n");
+}
+
+static Result run(const bench::Benchmark &benchmark, double min_time) {
+    std::uint64_t iterations = 1;
+    while (true) {
+        bench::State state(iterations);
+        benchmark.run(state);
+        if (!state.skip_reason.empty())
+            return { benchmark.name, 0, 0, 0, 0, 0, state.skip_reason };
+
+        const double seconds = state.real_ns / 1e9;
+        if (seconds >= min_time || iterations >= 1000000000) {
+            const double per_second = seconds > 0 ? state.iterations / seconds : 0;
+            return { benchmark.name, state.iterations, state.real_ns / state.iterations, state.cpu_ns / state.iterations,
+                state.bytes_per_iteration * per_second, state.items_per_iteration * per_second, {} };
+        }
+
+        // aim a bit past the minimum time so the next run is usually the last one
+        const double multiplier = seconds > min_time / 10 ? min_time * 1.4 / seconds : 10.0;
+        iterations = std::max(iterations + 1, static_cast<std::uint64_t>(iterations * multiplier));
+    }
+}
+
+static std::string format_time(double ns) {
+    char text[32];
+    if (ns >= 1e6)
+        std::snprintf(text, sizeof(text), "%.3f ms", ns / 1e6);
+    else if (ns >= 1e3)
+        std::snprintf(text, sizeof(text), "%.3f us", ns / 1e3);
+    else
+        std::snprintf(text, sizeof(text), "%.1f ns", ns);
+    return text;
+}
+
+static bool write_json(const char *path, const char *executable, const std::vector<Result> &results) {
+    FILE *file = std::strcmp(path, "-") == 0 ? stdout : std::fopen(path, "w");
+    if (!file) {
+        std::printf("Failed to create %s\n", path);
+        return false;
+    }
+
+    char date[64];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+#ifdef NDEBUG
+    const char *build_type = "release";
+#else
+    const char *build_type = "debug";
+#endif
+
+    std::fprintf(file, "{\n  \"context\": {\n");
+    std::fprintf(file, "    \"date\": \"%s\",\n", date);
+    std::fprintf(file, "    \"executable\": \"%s\",\n", string_utils::escape_json(executable).c_str());
+    std::fprintf(file, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    std::fprintf(file, "    \"library_build_type\": \"%s\",\n", build_type);
+    std::fprintf(file, "    \"vita3k_version\": \"%s\"\n", string_utils::escape_json(window_title).c_str());
+    std::fprintf(file, "  },\n  \"benchmarks\": [");
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const Result &result = results[i];
+        std::fprintf(file, "%s\n    {\n", i == 0 ? "" : ",");
+        std::fprintf(file, "      \"name\": \"%s\",\n", string_utils::escape_json(result.name).c_str());
+        std::fprintf(file, "      \"run_name\": \"%s\",\n", string_utils::escape_json(result.name).c_str());
+        std::fprintf(file, "      \"run_type\": \"iteration\",\n");
+        std::fprintf(file, "      \"repetitions\": 1,\n      \"repetition_index\": 0,\n      \"threads\": 1,\n");
+        if (!result.skip_reason.empty()) {
+            std::fprintf(file, "      \"error_occurred\": true,\n");
+            std::fprintf(file, "      \"error_message\": \"%s\"\n    }", string_utils::escape_json(result.skip_reason).c_str());
+            continue;
+        }
+        std::fprintf(file, "      \"iterations\": %" PRIu64 ",\n", result.iterations);
+        std::fprintf(file, "      \"real_time\": %.4f,\n", result.real_ns);
+        std::fprintf(file, "      \"cpu_time\": %.4f,\n", result.cpu_ns);
+        std::fprintf(file, "      \"time_unit\": \"ns\"");
+        if (result.bytes_per_second > 0)
+            std::fprintf(file, ",\n      \"bytes_per_second\": %.4f", result.bytes_per_second);
+        if (result.items_per_second > 0)
+            std::fprintf(file, ",\n      \"items_per_second\": %.4f", result.items_per_second);
+        std::fprintf(file, "\n    }");
+    }
+    std::fprintf(file, "\n  ]\n}\n");
+
+    if (file != stdout)
+        std::fclose(file);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const char *filter = nullptr;
+    const char *json_path = nullptr;
+    double min_time = 0.5;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            min_time = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            json_path = argv[++i];
+        else if (std::strcmp(argv[i], "--gxp-dir") == 0 && i + 1 < argc)
+            bench::options.gxp_dir = argv[++i];
+        else if (std::strcmp(argv[i], "--h264-stream") == 0 && i + 1 < argc)
+            bench::options.h264_stream = argv[++i];
+        else if (std::strcmp(argv[i], "--list") == 0)
+            list = true;
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    std::regex filter_regex;
+    try {
+        filter_regex = std::regex(filter ? filter : ".*");
+    } catch (const std::regex_error &) {
+        std::printf("Invalid filter %s\n", filter);
+        return 1;
+    }
+
+    std::vector<const bench::Benchmark *> selected;
+    for (const bench::Benchmark &benchmark : bench::get_benchmarks()) {
+        if (std::regex_search(benchmark.name, filter_regex))
+            selected.push_back(&benchmark);
+    }
+    std::sort(selected.begin(), selected.end(), [](const bench::Benchmark *a, const bench::Benchmark *b) { return a->name < b->name; });
+
+    if (list) {
+        for (const bench::Benchmark *benchmark : selected)
+            std::printf("%s\n", benchmark->name.c_str());
+        return 0;
+    }
+
+    // the table goes to stderr when the JSON is written to stdout
+    FILE *table = (json_path && std::strcmp(json_path, "-") == 0) ? stderr : stdout;
+    std::fprintf(table, "%-44s %14s %14s %12s %14s\n", "benchmark", "time", "cpu", "iterations", "throughput");
+
+    std::vector<Result> results;
+    for (const bench::Benchmark *benchmark : selected) {
+        const Result result = run(*benchmark, min_time);
+        results.push_back(result);
+
+        if (!result.skip_reason.empty()) {
+            std::fprintf(table, "%-44s skipped: %s\n", result.name.c_str(), result.skip_reason.c_str());
+            continue;
+        }
+
+        char throughput[32] = "";
+        if (result.bytes_per_second > 0)
+            std::snprintf(throughput, sizeof(throughput), "%.1f MiB/s", result.bytes_per_second / (1024.0 * 1024.0));
+        else if (result.items_per_second > 0)
+            std::snprintf(throughput, sizeof(throughput), "%.2f M/s", result.items_per_second / 1e6);
+        std::fprintf(table, "%-44s %14s %14s %12" PRIu64 " %14s\n", result.name.c_str(), format_time(result.real_ns).c_str(),
+            format_time(result.cpu_ns).c_str(), result.iterations, throughput);
+        std::fflush(table);
+    }
+
+    if (json_path && !write_json(json_path, argv[0], results))
+        return 1;
+
+    return 0;
+}
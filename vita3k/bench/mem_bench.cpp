@@ -0,0 +1,171 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "bench.h"
+
+#include <mem/allocator.h>
+#include <mem/functions.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+#include <mem/tracker.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// one bit per 4 KiB page of the guest address space, like the allocator of MemState
+constexpr std::size_t PAGE_COUNT = 1024 * 1024;
+
+// Fill 3/4 of the pages with blocks of 1 to 64 pages and free one block out of two,
+// so the searches go through a fragmented bitmap like after the game has been running for a while
+static void fragment(BitmapAllocator &allocator) {
+    std::uint32_t seed = 0x12345678;
+    std::vector<std::pair<int, int>> blocks;
+    std::size_t used = 0;
+    while (used < PAGE_COUNT * 3 / 4) {
+        seed = seed * 1664525 + 1013904223;
+        int size = 1 + (seed >> 26);
+        const int offset = allocator.allocate_from(0, size);
+        if (offset < 0)
+            break;
+        blocks.emplace_back(offset, size);
+        used += size;
+    }
+    for (std::size_t i = 0; i < blocks.size(); i += 2)
+        allocator.free(blocks[i].first, blocks[i].second);
+}
+
+// min_size 1 for the small blocks, past 127 pages for the searches of the runs with a full word
+static void bitmap_allocator(bench::State &state, bool best_fit, int min_size) {
+    BitmapAllocator allocator(PAGE_COUNT);
+    fragment(allocator);
+
+    std::uint32_t seed = 0x9abcdef0;
+    while (state.keep_running()) {
+        seed = seed * 1664525 + 1013904223;
+        int size = min_size + (seed >> 26);
+        const int offset = allocator.allocate_from(0, size, best_fit);
+        bench::do_not_optimize(offset);
+        if (offset >= 0)
+            allocator.free(offset, size);
+    }
+    state.set_items_per_iteration(1);
+}
+
+static void bitmap_allocator_free_slot_count(bench::State &state) {
+    BitmapAllocator allocator(PAGE_COUNT);
+    fragment(allocator);
+
+    // is_valid_addr_range on a 16 MiB buffer
+    std::uint32_t offset = 0;
+    while (state.keep_running()) {
+        bench::do_not_optimize(allocator.free_slot_count(offset, offset + 4096));
+        offset = (offset + 4096) % (PAGE_COUNT - 4096);
+    }
+    state.set_items_per_iteration(1);
+}
+
+// is_valid_addr on the pages of the guest
+static void bitmap_allocator_is_allocated(bench::State &state) {
+    BitmapAllocator allocator(PAGE_COUNT);
+    fragment(allocator);
+
+    std::uint32_t offset = 0;
+    while (state.keep_running()) {
+        bench::do_not_optimize(allocator.is_allocated(offset, offset + 1));
+        offset = (offset + 4099) % PAGE_COUNT;
+    }
+    state.set_items_per_iteration(1);
+}
+
+// Textures watched by the texture cache, a quarter of them written by the game each frame
+constexpr std::size_t TEXTURE_COUNT = 256;
+constexpr std::size_t TEXTURE_SIZE = 64 * 1024;
+constexpr std::size_t WRITTEN_TEXTURE_COUNT = TEXTURE_COUNT / 4;
+
+// Guest memory using this write tracker, nullptr when the host does not support it
+static MemState *get_tracked_memory(WriteTrackerType type) {
+    if (type == WriteTrackerType::MPROTECT)
+        return bench::get_guest_memory();
+
+    // MemState can't be released, each tracker keeps its own for the whole run
+    static MemState userfaultfd_mem;
+    static MemState soft_dirty_mem;
+    static const bool userfaultfd_ready = init(userfaultfd_mem, WriteTrackerType::USERFAULTFD) && userfaultfd_mem.tracker;
+    static const bool soft_dirty_ready = init(soft_dirty_mem, WriteTrackerType::SOFT_DIRTY) && soft_dirty_mem.tracker;
+    if (type == WriteTrackerType::USERFAULTFD)
+        return userfaultfd_ready ? &userfaultfd_mem : nullptr;
+    return soft_dirty_ready ? &soft_dirty_mem : nullptr;
+}
+
+// One frame of the texture cache: the written textures are watched again after their upload, then the game writes one byte per page of other ones
+static void write_tracker(bench::State &state, WriteTrackerType type) {
+    MemState *mem = get_tracked_memory(type);
+    if (!mem) {
+        state.skip(std::string(get_write_tracker_name(type)) + " is not supported by the host");
+        return;
+    }
+
+    const Address base = alloc(*mem, TEXTURE_COUNT * TEXTURE_SIZE, "bench");
+    if (!base) {
+        state.skip("could not allocate the textures");
+        return;
+    }
+    volatile std::uint8_t *data = Ptr<std::uint8_t>(base).get(*mem);
+    // shared with the callbacks, which may outlive this function until the protections are removed
+    const auto watched = std::make_shared<std::vector<bool>>(TEXTURE_COUNT, false);
+
+    std::size_t frame = 0;
+    while (state.keep_running()) {
+        for (std::size_t i = 0; i < TEXTURE_COUNT; i++) {
+            if ((*watched)[i])
+                continue;
+            (*watched)[i] = true;
+            add_protect(*mem, base + i * TEXTURE_SIZE, TEXTURE_SIZE, MEM_PERM_READONLY, [watched, i](Address, bool) {
+                (*watched)[i] = false;
+                return true;
+            });
+        }
+        flush_protect(*mem);
+
+        for (std::size_t n = 0; n < WRITTEN_TEXTURE_COUNT; n++) {
+            const std::size_t offset = ((frame * WRITTEN_TEXTURE_COUNT + n) % TEXTURE_COUNT) * TEXTURE_SIZE;
+            for (std::size_t page = 0; page < TEXTURE_SIZE; page += mem->page_size)
+                data[offset + page] = static_cast<std::uint8_t>(frame);
+        }
+        flush_protect(*mem);
+        frame++;
+    }
+    state.set_items_per_iteration(1);
+
+    notify_host_write(*mem, base, TEXTURE_COUNT * TEXTURE_SIZE);
+    free(*mem, base);
+}
+
+static const bench::Registration registration({
+    { "mem/bitmap_allocator_first_fit", [](bench::State &state) { bitmap_allocator(state, false, 1); } },
+    { "mem/bitmap_allocator_best_fit", [](bench::State &state) { bitmap_allocator(state, true, 1); } },
+    { "mem/bitmap_allocator_first_fit_large", [](bench::State &state) { bitmap_allocator(state, false, 200); } },
+    { "mem/bitmap_allocator_best_fit_large", [](bench::State &state) { bitmap_allocator(state, true, 200); } },
+    { "mem/bitmap_allocator_free_slot_count", bitmap_allocator_free_slot_count },
+    { "mem/bitmap_allocator_is_allocated", bitmap_allocator_is_allocated },
+    { "mem/write_tracker_mprotect", [](bench::State &state) { write_tracker(state, WriteTrackerType::MPROTECT); } },
+    { "mem/write_tracker_userfaultfd", [](bench::State &state) { write_tracker(state, WriteTrackerType::USERFAULTFD); } },
+    { "mem/write_tracker_soft_dirty", [](bench::State &state) { write_tracker(state, WriteTrackerType::SOFT_DIRTY); } },
+});
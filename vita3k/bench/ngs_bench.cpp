@@ -0,0 +1,105 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "bench.h"
+
+#include <kernel/state.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <ngs/modules/equalizer.h>
+#include <ngs/modules/master.h>
+#include <ngs/system.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+constexpr std::int32_t GRANULARITY = 512;
+constexpr std::size_t VOICE_COUNT = 32;
+constexpr std::uint32_t RACK_MEMSPACE_SIZE = 64 * 1024;
+
+static std::vector<float> make_samples(std::size_t count) {
+    std::vector<float> samples(count);
+    std::uint32_t seed = 0x12345678;
+    for (auto &sample : samples) {
+        seed = seed * 1664525 + 1013904223;
+        sample = static_cast<float>(seed >> 8) / static_cast<float>(1 << 24) * 2.0f - 1.0f;
+    }
+    return samples;
+}
+
+// One update of the mixing: the equalizer of each source voice runs on its product, which is then
+// mixed into the input of the master voice through its patch, and the master buss converts the result to S16
+static void mix_voices(bench::State &state) {
+    MemState *mem = bench::get_guest_memory();
+    if (!mem) {
+        state.skip("the guest memory can't be initialized");
+        return;
+    }
+
+    static KernelState kernel;
+    ngs::System system(Ptr<void>(), 0);
+    system.granularity = GRANULARITY;
+
+    ngs::Rack master_rack(&system, Ptr<void>(), 0);
+    master_rack.modules.push_back(std::make_unique<ngs::master::Module>());
+    master_rack.patches_per_output = 0;
+
+    // the patches are allocated in the memory of the source rack
+    const Address memspace = alloc(*mem, RACK_MEMSPACE_SIZE, "bench ngs rack");
+    ngs::Rack source_rack(&system, Ptr<void>(memspace), RACK_MEMSPACE_SIZE);
+    source_rack.modules.push_back(std::make_unique<ngs::equalizer::Module>());
+    source_rack.patches_per_output = 1;
+
+    ngs::Voice master;
+    master.init(&master_rack);
+    master.datas[0].parent = &master;
+
+    const std::vector<float> samples = make_samples(GRANULARITY * 2);
+    std::vector<std::unique_ptr<ngs::Voice>> sources;
+    std::vector<std::vector<float>> products(VOICE_COUNT);
+    for (std::size_t i = 0; i < VOICE_COUNT; i++) {
+        auto &source = sources.emplace_back(std::make_unique<ngs::Voice>());
+        source->init(&source_rack);
+        source->datas[0].parent = source.get();
+        source->patch(*mem, 0, -1, 0, &master);
+    }
+
+    std::unique_lock<std::recursive_mutex> scheduler_lock;
+    std::unique_lock<std::mutex> voice_lock;
+    while (state.keep_running()) {
+        master.inputs.reset_inputs();
+        for (std::size_t i = 0; i < VOICE_COUNT; i++) {
+            // the equalizer works in place, the samples would become denormals after a few updates
+            products[i] = samples;
+            ngs::Voice &source = *sources[i];
+            source.products[0].data = reinterpret_cast<std::uint8_t *>(products[i].data());
+            source_rack.modules[0]->process(kernel, *mem, 0, source.datas[0], scheduler_lock, voice_lock);
+            ngs::deliver_data(*mem, &source, 0, source.products[0]);
+        }
+        master_rack.modules[0]->process(kernel, *mem, 0, master.datas[0], scheduler_lock, voice_lock);
+        bench::do_not_optimize(master.datas[0].voice_state_data.data());
+    }
+    state.set_items_per_iteration(VOICE_COUNT * GRANULARITY);
+
+    free(*mem, memspace);
+}
+
+static const bench::Registration registration({
+    { "ngs/mix_voices", mix_voices },
+});
@@ -0,0 +1,239 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "bench.h"
+
+#include <config/state.h>
+#include <gxm/types.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <renderer/commands.h>
+#include <renderer/driver_functions.h>
+#include <renderer/functions.h>
+#include <renderer/pvrt-dec.h>
+#include <renderer/state.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+constexpr std::uint16_t TEXTURE_WIDTH = 512;
+constexpr std::uint16_t TEXTURE_HEIGHT = 512;
+constexpr std::size_t PIXEL_COUNT = TEXTURE_WIDTH * TEXTURE_HEIGHT;
+
+static std::vector<std::uint8_t> make_data(std::size_t size) {
+    std::vector<std::uint8_t> data(size);
+    std::uint32_t seed = 0x12345678;
+    for (auto &byte : data) {
+        seed = seed * 1664525 + 1013904223;
+        byte = static_cast<std::uint8_t>(seed >> 24);
+    }
+    return data;
+}
+
+static void swizzled_to_linear(bench::State &state, std::uint8_t bits_per_pixel) {
+    const std::vector<std::uint8_t> src = make_data(PIXEL_COUNT * bits_per_pixel / 8);
+    std::vector<std::uint8_t> dest(src.size());
+    while (state.keep_running()) {
+        renderer::texture::swizzled_texture_to_linear_texture(dest.data(), src.data(), TEXTURE_WIDTH, TEXTURE_HEIGHT, bits_per_pixel);
+        bench::do_not_optimize(dest.data());
+    }
+    state.set_bytes_per_iteration(src.size());
+}
+
+static void tiled_to_linear(bench::State &state, std::uint8_t bits_per_pixel) {
+    const std::vector<std::uint8_t> src = make_data(PIXEL_COUNT * bits_per_pixel / 8);
+    std::vector<std::uint8_t> dest(src.size());
+    while (state.keep_running()) {
+        renderer::texture::tiled_texture_to_linear_texture(dest.data(), src.data(), TEXTURE_WIDTH, TEXTURE_HEIGHT, bits_per_pixel);
+        bench::do_not_optimize(dest.data());
+    }
+    state.set_bytes_per_iteration(src.size());
+}
+
+// bc_type as given by the texture cache: 1 = BC1, 2 = BC2, 3 = BC3, 4/5 = BC4, 6/7 = BC5
+static void decompress_bc(bench::State &state, std::uint8_t bc_type) {
+    const std::size_t block_size = (bc_type != 1 && bc_type != 4 && bc_type != 5) ? 16 : 8;
+    const std::vector<std::uint8_t> blocks = make_data(PIXEL_COUNT / 16 * block_size);
+    std::vector<std::uint32_t> image(PIXEL_COUNT);
+    while (state.keep_running()) {
+        renderer::texture::decompress_bc_swizz_image(TEXTURE_WIDTH, TEXTURE_HEIGHT, blocks.data(), image.data(), bc_type);
+        bench::do_not_optimize(image.data());
+    }
+    state.set_bytes_per_iteration(image.size() * sizeof(std::uint32_t));
+}
+
+static void decompress_pvrtc(bench::State &state, bool is_2bpp, bool is_pvrtc2) {
+    const std::vector<std::uint8_t> blocks = make_data(PIXEL_COUNT * (is_2bpp ? 2 : 4) / 8);
+    std::vector<std::uint8_t> image(PIXEL_COUNT * 4);
+    while (state.keep_running()) {
+        pvr::PVRTDecompressPVRTC(blocks.data(), is_2bpp, TEXTURE_WIDTH, TEXTURE_HEIGHT, is_pvrtc2, image.data());
+        bench::do_not_optimize(image.data());
+    }
+    state.set_bytes_per_iteration(image.size());
+}
+
+static void palette_to_rgba(bench::State &state, bool is_p4) {
+    const std::vector<std::uint8_t> src = make_data(is_p4 ? PIXEL_COUNT / 2 : PIXEL_COUNT);
+    const std::vector<std::uint8_t> palette_bytes = make_data(256 * sizeof(std::uint32_t));
+    const std::uint32_t *palette = reinterpret_cast<const std::uint32_t *>(palette_bytes.data());
+    std::vector<std::uint32_t> dest(PIXEL_COUNT);
+    while (state.keep_running()) {
+        if (is_p4)
+            renderer::texture::palette_texture_to_rgba_4(dest.data(), src.data(), TEXTURE_WIDTH, TEXTURE_HEIGHT, TEXTURE_WIDTH, palette);
+        else
+            renderer::texture::palette_texture_to_rgba_8(dest.data(), src.data(), TEXTURE_WIDTH, TEXTURE_HEIGHT, TEXTURE_WIDTH, palette);
+        bench::do_not_optimize(dest.data());
+    }
+    state.set_bytes_per_iteration(dest.size() * sizeof(std::uint32_t));
+}
+
+// A null renderer for the command handlers, which only use the guest memory
+struct RendererFixture {
+    MemState *mem;
+    Config config;
+    FeatureState features;
+    std::unique_ptr<renderer::State> renderer;
+    bool ready = false;
+
+    RendererFixture()
+        : mem(bench::get_guest_memory()) {
+        ready = mem && renderer::init(nullptr, renderer, renderer::Backend::Null, config, "");
+    }
+};
+
+static RendererFixture &get_fixture() {
+    static RendererFixture fixture;
+    return fixture;
+}
+
+static void hash_texture_data(bench::State &state, SceGxmTextureFormat format) {
+    RendererFixture &fixture = get_fixture();
+    if (!fixture.ready) {
+        state.skip("the guest memory or the null renderer can't be initialized");
+        return;
+    }
+
+    const bool is_p8 = format == SCE_GXM_TEXTURE_FORMAT_P8_ABGR;
+    const std::size_t size = is_p8 ? PIXEL_COUNT : PIXEL_COUNT * 4;
+    const Address data = alloc(*fixture.mem, size, "bench texture");
+    const Address palette = alloc(*fixture.mem, 256 * sizeof(std::uint32_t), "bench palette", 64);
+    const std::vector<std::uint8_t> content = make_data(size);
+    memcpy(Ptr<std::uint8_t>(data).get(*fixture.mem), content.data(), size);
+
+    // as sceGxmTextureInitLinear sets it
+    SceGxmTexture texture{};
+    texture.mip_count = 0;
+    texture.format0 = (format & 0x80000000) >> 31;
+    texture.width = TEXTURE_WIDTH - 1;
+    texture.height = TEXTURE_HEIGHT - 1;
+    texture.base_format = (format & 0x1F000000) >> 24;
+    texture.type = SCE_GXM_TEXTURE_LINEAR >> 29;
+    texture.data_addr = data >> 2;
+    texture.palette_addr = palette >> 6;
+    texture.swizzle_format = (format & 0x7000) >> 12;
+
+    while (state.keep_running())
+        bench::do_not_optimize(renderer::texture::hash_texture_data(texture, *fixture.mem));
+    state.set_bytes_per_iteration(size);
+
+    free(*fixture.mem, palette);
+    free(*fixture.mem, data);
+}
+
+enum class TransferKind {
+    COPY,
+    DOWNSCALE,
+    FILL
+};
+
+// The handlers take the images from the command and delete them, like the ones sent by sceGxmTransfer*
+static void transfer(bench::State &state, TransferKind kind) {
+    RendererFixture &fixture = get_fixture();
+    if (!fixture.ready) {
+        state.skip("the guest memory or the null renderer can't be initialized");
+        return;
+    }
+
+    const std::size_t size = PIXEL_COUNT * 4;
+    const Address src_data = alloc(*fixture.mem, size, "bench transfer source");
+    const Address dest_data = alloc(*fixture.mem, size, "bench transfer destination");
+    const std::vector<std::uint8_t> content = make_data(size);
+    memcpy(Ptr<std::uint8_t>(src_data).get(*fixture.mem), content.data(), size);
+
+    const SceGxmTransferImage src{ SCE_GXM_TRANSFER_FORMAT_U8U8U8U8_ABGR, Ptr<void>(src_data), 0, 0, TEXTURE_WIDTH, TEXTURE_HEIGHT, TEXTURE_WIDTH * 4 };
+    const SceGxmTransferImage dest{ SCE_GXM_TRANSFER_FORMAT_U8U8U8U8_ABGR, Ptr<void>(dest_data), 0, 0, TEXTURE_WIDTH, TEXTURE_HEIGHT, TEXTURE_WIDTH * 4 };
+
+    while (state.keep_running()) {
+        renderer::Command *cmd = nullptr;
+        switch (kind) {
+        case TransferKind::COPY:
+            cmd = renderer::make_command(renderer::generic_command_allocate, renderer::generic_command_free, renderer::CommandOpcode::TransferCopy, nullptr,
+                0xFF00FF00U, 0xFFFFFFFFU, SCE_GXM_TRANSFER_COLORKEY_REJECT, new SceGxmTransferImage[2]{ src, dest }, SCE_GXM_TRANSFER_LINEAR, SCE_GXM_TRANSFER_LINEAR);
+            break;
+        case TransferKind::DOWNSCALE:
+            cmd = renderer::make_command(renderer::generic_command_allocate, renderer::generic_command_free, renderer::CommandOpcode::TransferDownscale, nullptr,
+                new SceGxmTransferImage(src), new SceGxmTransferImage(dest));
+            break;
+        case TransferKind::FILL:
+            cmd = renderer::make_command(renderer::generic_command_allocate, renderer::generic_command_free, renderer::CommandOpcode::TransferFill, nullptr,
+                0xFF204080U, new SceGxmTransferImage(dest));
+            break;
+        }
+
+        renderer::CommandHelper helper(cmd);
+        switch (kind) {
+        case TransferKind::COPY:
+            renderer::cmd_handle_transfer_copy(*fixture.renderer, *fixture.mem, fixture.config, helper, fixture.features, nullptr, "", "", "");
+            break;
+        case TransferKind::DOWNSCALE:
+            renderer::cmd_handle_transfer_downscale(*fixture.renderer, *fixture.mem, fixture.config, helper, fixture.features, nullptr, "", "", "");
+            break;
+        case TransferKind::FILL:
+            renderer::cmd_handle_transfer_fill(*fixture.renderer, *fixture.mem, fixture.config, helper, fixture.features, nullptr, "", "", "");
+            break;
+        }
+        renderer::generic_command_free(cmd);
+    }
+    state.set_bytes_per_iteration(kind == TransferKind::DOWNSCALE ? size / 4 : size);
+
+    free(*fixture.mem, dest_data);
+    free(*fixture.mem, src_data);
+}
+
+static const bench::Registration registration({
+    { "renderer/swizzled_to_linear_8bpp", [](bench::State &state) { swizzled_to_linear(state, 8); } },
+    { "renderer/swizzled_to_linear_32bpp", [](bench::State &state) { swizzled_to_linear(state, 32); } },
+    { "renderer/tiled_to_linear_8bpp", [](bench::State &state) { tiled_to_linear(state, 8); } },
+    { "renderer/tiled_to_linear_32bpp", [](bench::State &state) { tiled_to_linear(state, 32); } },
+    { "renderer/decompress_bc1", [](bench::State &state) { decompress_bc(state, 1); } },
+    { "renderer/decompress_bc2", [](bench::State &state) { decompress_bc(state, 2); } },
+    { "renderer/decompress_bc3", [](bench::State &state) { decompress_bc(state, 3); } },
+    { "renderer/decompress_bc4", [](bench::State &state) { decompress_bc(state, 4); } },
+    { "renderer/decompress_bc5", [](bench::State &state) { decompress_bc(state, 6); } },
+    { "renderer/decompress_pvrtc_2bpp", [](bench::State &state) { decompress_pvrtc(state, true, false); } },
+    { "renderer/decompress_pvrtc_4bpp", [](bench::State &state) { decompress_pvrtc(state, false, false); } },
+    { "renderer/decompress_pvrtc2_4bpp", [](bench::State &state) { decompress_pvrtc(state, false, true); } },
+    { "renderer/palette_p4_to_rgba", [](bench::State &state) { palette_to_rgba(state, true); } },
+    { "renderer/palette_p8_to_rgba", [](bench::State &state) { palette_to_rgba(state, false); } },
+    { "renderer/hash_texture_data_rgba8", [](bench::State &state) { hash_texture_data(state, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR); } },
+    { "renderer/hash_texture_data_p8", [](bench::State &state) { hash_texture_data(state, SCE_GXM_TEXTURE_FORMAT_P8_ABGR); } },
+    { "renderer/transfer_copy", [](bench::State &state) { transfer(state, TransferKind::COPY); } },
+    { "renderer/transfer_downscale", [](bench::State &state) { transfer(state, TransferKind::DOWNSCALE); } },
+    { "renderer/transfer_fill", [](bench::State &state) { transfer(state, TransferKind::FILL); } },
+});
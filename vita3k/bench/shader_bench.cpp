@@ -0,0 +1,114 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "bench.h"
+
+#include <features/state.h>
+#include <gxm/types.h>
+#include <shader/spirv_recompiler.h>
+#include <shader/usse_program_analyzer.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+constexpr std::size_t INSTRUCTION_COUNT = 4096;
+
+// Control flow analysis of a long straight program, the first pass of the translation.
+// The instructions are random words without the branches, which would jump to random places.
+static void usse_analyze(bench::State &state) {
+    std::vector<std::uint64_t> program;
+    std::uint64_t seed = 0x123456789abcdef;
+    while (program.size() < INSTRUCTION_COUNT) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::uint8_t pred = 0;
+        std::int32_t br_off = 0;
+        if (seed != 0 && !shader::usse::is_branch(seed, pred, br_off))
+            program.push_back(seed);
+    }
+
+    shader::usse::USSEBlockNode root(nullptr, 0);
+    while (state.keep_running()) {
+        shader::usse::analyze(root, static_cast<shader::usse::USSEOffset>(program.size() - 1), [&](shader::usse::USSEOffset offset) { return program[offset]; });
+        bench::do_not_optimize(root.children_count());
+    }
+    state.set_items_per_iteration(program.size());
+}
+
+// The programs dumped by the emulator in shaderlog, there is no synthetic valid GXP program
+static std::vector<std::vector<std::uint8_t>> load_gxp_programs() {
+    std::vector<std::vector<std::uint8_t>> programs;
+    const fs::path &dir = bench::get_options().gxp_dir;
+    if (dir.empty() || !fs::is_directory(dir))
+        return programs;
+
+    for (const auto &entry : fs::recursive_directory_iterator(dir)) {
+        if (!fs::is_regular_file(entry.path()) || entry.path().extension() != ".gxp")
+            continue;
+
+        fs::ifstream file(entry.path(), std::ios::binary);
+        std::vector<std::uint8_t> data{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        if (data.size() < sizeof(SceGxmProgram) || std::memcmp(data.data(), "GXP", 4) != 0)
+            continue;
+        programs.push_back(std::move(data));
+    }
+    return programs;
+}
+
+static const std::vector<std::vector<std::uint8_t>> &get_gxp_programs() {
+    static const std::vector<std::vector<std::uint8_t>> programs = load_gxp_programs();
+    return programs;
+}
+
+// One iteration translates all the dumped programs
+static void convert_gxp(bench::State &state, shader::Target target) {
+    const auto &programs = get_gxp_programs();
+    if (programs.empty()) {
+        state.skip("no GXP program, give the shaderlog directory of a game with --gxp-dir");
+        return;
+    }
+
+    FeatureState features;
+    features.spirv_shader = target != shader::Target::GLSLOpenGL;
+    const std::vector<SceGxmVertexAttribute> attributes;
+    shader::Hints hints{};
+    hints.attributes = &attributes;
+    hints.color_format = SCE_GXM_COLOR_FORMAT_U8U8U8U8_ABGR;
+    std::fill_n(hints.vertex_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+    std::fill_n(hints.fragment_textures, SCE_GXM_MAX_TEXTURE_UNITS, SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR);
+
+    // the translator prints its disassembly to the console, it is still formatted but not written
+    std::cout.setstate(std::ios::failbit);
+    while (state.keep_running()) {
+        for (const auto &data : programs) {
+            const SceGxmProgram &program = *reinterpret_cast<const SceGxmProgram *>(data.data());
+            const shader::GeneratedShader shader = shader::convert_gxp(program, "bench", features, target, hints);
+            bench::do_not_optimize(shader.spirv.data());
+        }
+    }
+    std::cout.clear();
+    state.set_items_per_iteration(programs.size());
+}
+
+static const bench::Registration registration({
+    { "shader/usse_analyze", usse_analyze },
+    { "shader/convert_gxp_spirv_vulkan", [](bench::State &state) { convert_gxp(state, shader::Target::SpirVVulkan); } },
+    { "shader/convert_gxp_glsl", [](bench::State &state) { convert_gxp(state, shader::Target::GLSLOpenGL); } },
+});
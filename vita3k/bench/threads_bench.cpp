@@ -0,0 +1,67 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include "bench.h"
+
+#include <threads/queue.h>
+
+#include <cstdint>
+#include <thread>
+
+// Same size as the command lists sent to the renderer through its queue
+struct Item {
+    void *first;
+    void *last;
+    void *context;
+};
+
+// Items given by each iteration of the threaded benchmark
+constexpr std::uint64_t BATCH_SIZE = 1024;
+
+static void queue_push_pop(bench::State &state) {
+    Queue<Item> queue;
+    Item item{};
+    while (state.keep_running()) {
+        queue.push(item);
+        bench::do_not_optimize(queue.pop());
+    }
+    state.set_items_per_iteration(1);
+}
+
+// A producer thread pushes the items the benchmark thread pops, the queue holds at most
+// 30 items like the command buffer queue of the renderer
+static void queue_producer_consumer(bench::State &state) {
+    Queue<Item> queue;
+    queue.maxPendingCount_ = 30;
+    std::thread producer([&queue, count = state.max_iterations * BATCH_SIZE]() {
+        Item item{};
+        for (std::uint64_t i = 0; i < count; i++)
+            queue.push(item);
+    });
+
+    while (state.keep_running()) {
+        for (std::uint64_t i = 0; i < BATCH_SIZE; i++)
+            bench::do_not_optimize(queue.pop());
+    }
+    producer.join();
+    state.set_items_per_iteration(BATCH_SIZE);
+}
+
+static const bench::Registration registration({
+    { "threads/queue_push_pop", queue_push_pop },
+    { "threads/queue_producer_consumer", queue_producer_consumer },
+});
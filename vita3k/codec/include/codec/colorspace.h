@@ -0,0 +1,65 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+
+// Conversion of the yuv images of the video decoders and textures into rgb, with the limited range matrices of the Vita.
+// The converters are cached by conversion, use SIMD instructions when available and split large images between threads.
+
+enum class ColorspaceFormat : uint8_t {
+    YUV444P, // Y, U and V planes
+    YUV420P, // Y plane, then U and V planes of half width and height
+    YVU420P, // same with the V plane before the U plane
+    NV12, // Y plane, then a plane of half width and height with interleaved U and V
+    NV21, // same with V before U
+    RGBA,
+    RGB24,
+};
+
+enum class ColorMatrix : uint8_t {
+    BT601,
+    BT709,
+};
+
+struct ColorspaceKey {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    ColorspaceFormat src = ColorspaceFormat::YUV420P;
+    ColorspaceFormat dst = ColorspaceFormat::RGBA;
+    ColorMatrix matrix = ColorMatrix::BT601;
+
+    bool operator==(const ColorspaceKey &other) const = default;
+};
+
+struct ColorspaceImage {
+    // Only the first planes used by the format are read, the strides are in bytes
+    const uint8_t *planes[3] = {};
+    int strides[3] = {};
+};
+
+/**
+ * \brief Convert a yuv image into a rgb one.
+ *
+ * Chroma is upsampled by duplicating the samples, like swscale does without interpolation flags.
+ * \return false if the source or destination format is not supported.
+ */
+bool convert_colorspace(const ColorspaceKey &key, const ColorspaceImage &src, uint8_t *dst, int dst_stride);
+
+// Packed planes as written by the decoders: each plane follows the previous one without padding
+ColorspaceImage make_packed_yuv_image(ColorspaceFormat format, const uint8_t *data, uint32_t width, uint32_t height);
@@ -22,6 +22,7 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <vector>
 
 struct AVFrame;
 struct AVPacket;
@@ -30,6 +31,7 @@ struct AVCodecContext;
 struct AVFormatContext;
 struct AVCodecParserContext;
 struct AVCodec;
+struct AVBufferPool;
 struct SwrContext;
 
 union DecoderSize {
@@ -83,6 +85,12 @@ struct H264DecoderOptions {
 
 struct H264DecoderState : public DecoderState {
     AVCodecParserContext *parser{};
+    AVPacket *packet{};
+    AVFrame *frame{};
+
+    // Padded copies of the access units, handed to the decoder by reference instead of being copied again
+    AVBufferPool *au_pool{};
+    uint32_t au_pool_size = 0;
 
     uint32_t width_out = 0;
     uint32_t height_out = 0;
@@ -103,7 +111,8 @@ struct H264DecoderState : public DecoderState {
     void get_res(uint32_t &width, uint32_t &height);
     void get_pts(uint32_t &upper, uint32_t &lower);
 
-    H264DecoderState(uint32_t width, uint32_t height);
+    // thread_count is the number of slice threads, 0 picks it from the host cores
+    H264DecoderState(uint32_t width, uint32_t height, int thread_count = 0);
     ~H264DecoderState() override;
 };
 
@@ -244,4 +253,5 @@ struct PlayerState {
 
 void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t width, uint32_t height);
 void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest);
+int get_codec_thread_count();
 std::string codec_error_name(int error);
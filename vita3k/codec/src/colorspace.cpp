@@ -0,0 +1,443 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/colorspace.h>
+
+#include <util/log.h>
+#include <util/worker_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CODEC_CSC_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define CODEC_CSC_NEON
+#include <arm_neon.h>
+#endif
+
+// Number of cached converters, games usually convert a few sizes at most
+static constexpr std::size_t CONVERTER_CACHE_SIZE = 8;
+// Images with less rows than this per worker are converted by the calling thread only
+static constexpr uint32_t MIN_ROWS_PER_SLICE = 64;
+
+// The conversion is done in fixed point on 16 bits so every implementation gives the same result:
+// the components minus their offset are shifted by 6, multiplied by the coefficients in 3.13 keeping the high 16 bits,
+// which gives the rgb values with 3 fractional bits.
+struct ColorCoefficients {
+    int16_t y;
+    int16_t r_v;
+    int16_t g_u;
+    int16_t g_v;
+    int16_t b_u;
+};
+
+static ColorCoefficients make_coefficients(ColorMatrix matrix) {
+    const double kr = (matrix == ColorMatrix::BT709) ? 0.2126 : 0.299;
+    const double kb = (matrix == ColorMatrix::BT709) ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+    // limited range: Y in [16, 235], U and V in [16, 240]
+    const double y_scale = 255.0 / 219.0;
+    const double c_scale = 255.0 / 224.0;
+
+    const auto to_fixed = [](double coefficient) {
+        return static_cast<int16_t>(std::lround(coefficient * 8192.0));
+    };
+    return {
+        to_fixed(y_scale),
+        to_fixed(c_scale * 2.0 * (1.0 - kr)),
+        to_fixed(c_scale * 2.0 * (1.0 - kb) * kb / kg),
+        to_fixed(c_scale * 2.0 * (1.0 - kr) * kr / kg),
+        to_fixed(c_scale * 2.0 * (1.0 - kb)),
+    };
+}
+
+// One row of the source image. For the interleaved formats u and v point to the first sample of their component.
+struct ColorRow {
+    const uint8_t *y;
+    const uint8_t *u;
+    const uint8_t *v;
+    uint8_t *dst;
+};
+
+enum class ChromaLayout {
+    FULL, // one U and V sample per pixel
+    HALF, // one U and V sample every 2 pixels
+    HALF_INTERLEAVED, // same with U and V in the same plane
+};
+
+static int chroma_offset(ChromaLayout layout, int x) {
+    switch (layout) {
+    case ChromaLayout::FULL: return x;
+    case ChromaLayout::HALF: return x / 2;
+    case ChromaLayout::HALF_INTERLEAVED: return (x / 2) * 2;
+    }
+    return x;
+}
+
+static int16_t mul_high(int16_t value, int16_t coefficient) {
+    return static_cast<int16_t>((static_cast<int32_t>(value) * coefficient) >> 16);
+}
+
+static uint8_t to_component(int value) {
+    return static_cast<uint8_t>(std::clamp((value + 4) >> 3, 0, 255));
+}
+
+static void convert_row_scalar(const ColorCoefficients &coefs, ChromaLayout layout, int bytes_per_pixel, const ColorRow &row, int start, int width) {
+    for (int x = start; x < width; x++) {
+        const int c = chroma_offset(layout, x);
+        const int16_t y = static_cast<int16_t>((row.y[x] - 16) << 6);
+        const int16_t u = static_cast<int16_t>((row.u[c] - 128) << 6);
+        const int16_t v = static_cast<int16_t>((row.v[c] - 128) << 6);
+
+        const int y_term = mul_high(y, coefs.y);
+        uint8_t *pixel = row.dst + x * bytes_per_pixel;
+        pixel[0] = to_component(static_cast<int16_t>(y_term + mul_high(v, coefs.r_v)));
+        pixel[1] = to_component(static_cast<int16_t>(y_term - mul_high(u, coefs.g_u) - mul_high(v, coefs.g_v)));
+        pixel[2] = to_component(static_cast<int16_t>(y_term + mul_high(u, coefs.b_u)));
+        if (bytes_per_pixel == 4)
+            pixel[3] = 0xFF;
+    }
+}
+
+// The vectorized versions convert 16 pixels at a time from the beginning of the row and return how many pixels were done,
+// the scalar version converts the rest.
+#if defined(CODEC_CSC_SSE2)
+static inline __m128i widen_offset(__m128i bytes_half, int16_t offset) {
+    return _mm_slli_epi16(_mm_sub_epi16(bytes_half, _mm_set1_epi16(offset)), 6);
+}
+
+// Load the chroma of 16 pixels as two vectors of 8 signed 16-bit values
+static inline void load_chroma_sse2(ChromaLayout layout, const uint8_t *src, int x, __m128i &lo, __m128i &hi) {
+    const __m128i zero = _mm_setzero_si128();
+    switch (layout) {
+    case ChromaLayout::FULL: {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        lo = _mm_unpacklo_epi8(bytes, zero);
+        hi = _mm_unpackhi_epi8(bytes, zero);
+        break;
+    }
+    case ChromaLayout::HALF: {
+        const __m128i samples = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + x / 2)), zero);
+        lo = _mm_unpacklo_epi16(samples, samples);
+        hi = _mm_unpackhi_epi16(samples, samples);
+        break;
+    }
+    case ChromaLayout::HALF_INTERLEAVED: {
+        const __m128i samples = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x)), _mm_set1_epi16(0xFF));
+        lo = _mm_unpacklo_epi16(samples, samples);
+        hi = _mm_unpackhi_epi16(samples, samples);
+        break;
+    }
+    }
+    lo = widen_offset(lo, 128);
+    hi = widen_offset(hi, 128);
+}
+
+static inline __m128i to_components_sse2(__m128i lo, __m128i hi) {
+    const __m128i rounding = _mm_set1_epi16(4);
+    return _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(lo, rounding), 3), _mm_srai_epi16(_mm_add_epi16(hi, rounding), 3));
+}
+
+static int convert_row_sse2(const ColorCoefficients &coefs, ChromaLayout layout, int bytes_per_pixel, const ColorRow &row, int width) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c_y = _mm_set1_epi16(coefs.y);
+    const __m128i c_r_v = _mm_set1_epi16(coefs.r_v);
+    const __m128i c_g_u = _mm_set1_epi16(coefs.g_u);
+    const __m128i c_g_v = _mm_set1_epi16(coefs.g_v);
+    const __m128i c_b_u = _mm_set1_epi16(coefs.b_u);
+    // the interleaved chroma is loaded 16 bytes at a time from u and v, v can be one byte after u
+    const int needed = (layout == ChromaLayout::HALF_INTERLEAVED) ? 17 : 16;
+
+    int x = 0;
+    for (; x + needed <= width; x += 16) {
+        const __m128i luma = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row.y + x));
+        __m128i y[2] = { widen_offset(_mm_unpacklo_epi8(luma, zero), 16), widen_offset(_mm_unpackhi_epi8(luma, zero), 16) };
+        __m128i u[2];
+        __m128i v[2];
+        load_chroma_sse2(layout, row.u, x, u[0], u[1]);
+        load_chroma_sse2(layout, row.v, x, v[0], v[1]);
+
+        __m128i r[2], g[2], b[2];
+        for (int i = 0; i < 2; i++) {
+            const __m128i y_term = _mm_mulhi_epi16(y[i], c_y);
+            r[i] = _mm_add_epi16(y_term, _mm_mulhi_epi16(v[i], c_r_v));
+            g[i] = _mm_sub_epi16(_mm_sub_epi16(y_term, _mm_mulhi_epi16(u[i], c_g_u)), _mm_mulhi_epi16(v[i], c_g_v));
+            b[i] = _mm_add_epi16(y_term, _mm_mulhi_epi16(u[i], c_b_u));
+        }
+        const __m128i red = to_components_sse2(r[0], r[1]);
+        const __m128i green = to_components_sse2(g[0], g[1]);
+        const __m128i blue = to_components_sse2(b[0], b[1]);
+
+        const __m128i rg_lo = _mm_unpacklo_epi8(red, green);
+        const __m128i rg_hi = _mm_unpackhi_epi8(red, green);
+        const __m128i ba_lo = _mm_unpacklo_epi8(blue, _mm_set1_epi8(-1));
+        const __m128i ba_hi = _mm_unpackhi_epi8(blue, _mm_set1_epi8(-1));
+        const __m128i pixels[4] = {
+            _mm_unpacklo_epi16(rg_lo, ba_lo),
+            _mm_unpackhi_epi16(rg_lo, ba_lo),
+            _mm_unpacklo_epi16(rg_hi, ba_hi),
+            _mm_unpackhi_epi16(rg_hi, ba_hi),
+        };
+
+        uint8_t *dst = row.dst + x * bytes_per_pixel;
+        if (bytes_per_pixel == 4) {
+            for (int i = 0; i < 4; i++)
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 16), pixels[i]);
+        } else {
+            alignas(16) uint8_t rgba[64];
+            for (int i = 0; i < 4; i++)
+                _mm_store_si128(reinterpret_cast<__m128i *>(rgba + i * 16), pixels[i]);
+            for (int i = 0; i < 16; i++) {
+                dst[i * 3] = rgba[i * 4];
+                dst[i * 3 + 1] = rgba[i * 4 + 1];
+                dst[i * 3 + 2] = rgba[i * 4 + 2];
+            }
+        }
+    }
+
+    return x;
+}
+#elif defined(CODEC_CSC_NEON)
+static inline int16x8_t widen_offset(uint8x8_t bytes, int16_t offset) {
+    return vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(bytes)), vdupq_n_s16(offset)), 6);
+}
+
+// Same as _mm_mulhi_epi16
+static inline int16x8_t mul_high_neon(int16x8_t value, int16_t coefficient) {
+    return vcombine_s16(vshrn_n_s32(vmull_n_s16(vget_low_s16(value), coefficient), 16),
+        vshrn_n_s32(vmull_n_s16(vget_high_s16(value), coefficient), 16));
+}
+
+// Load the chroma of 16 pixels as 16 bytes
+static inline uint8x16_t load_chroma_neon(ChromaLayout layout, const uint8_t *src, int x) {
+    switch (layout) {
+    case ChromaLayout::HALF: {
+        const uint8x8x2_t doubled = vzip_u8(vld1_u8(src + x / 2), vld1_u8(src + x / 2));
+        return vcombine_u8(doubled.val[0], doubled.val[1]);
+    }
+    case ChromaLayout::HALF_INTERLEAVED: {
+        const uint8x8_t samples = vmovn_u16(vreinterpretq_u16_u8(vld1q_u8(src + x)));
+        const uint8x8x2_t doubled = vzip_u8(samples, samples);
+        return vcombine_u8(doubled.val[0], doubled.val[1]);
+    }
+    case ChromaLayout::FULL:
+    default:
+        return vld1q_u8(src + x);
+    }
+}
+
+static inline uint8x8_t to_components_neon(int16x8_t value) {
+    return vqmovun_s16(vshrq_n_s16(vaddq_s16(value, vdupq_n_s16(4)), 3));
+}
+
+static int convert_row_neon(const ColorCoefficients &coefs, ChromaLayout layout, int bytes_per_pixel, const ColorRow &row, int width) {
+    const int needed = (layout == ChromaLayout::HALF_INTERLEAVED) ? 17 : 16;
+
+    int x = 0;
+    for (; x + needed <= width; x += 16) {
+        const uint8x16_t luma = vld1q_u8(row.y + x);
+        const uint8x16_t chroma_u = load_chroma_neon(layout, row.u, x);
+        const uint8x16_t chroma_v = load_chroma_neon(layout, row.v, x);
+
+        uint8x8_t red[2], green[2], blue[2];
+        for (int i = 0; i < 2; i++) {
+            const int16x8_t y = widen_offset(i ? vget_high_u8(luma) : vget_low_u8(luma), 16);
+            const int16x8_t u = widen_offset(i ? vget_high_u8(chroma_u) : vget_low_u8(chroma_u), 128);
+            const int16x8_t v = widen_offset(i ? vget_high_u8(chroma_v) : vget_low_u8(chroma_v), 128);
+
+            const int16x8_t y_term = mul_high_neon(y, coefs.y);
+            red[i] = to_components_neon(vaddq_s16(y_term, mul_high_neon(v, coefs.r_v)));
+            green[i] = to_components_neon(vsubq_s16(vsubq_s16(y_term, mul_high_neon(u, coefs.g_u)), mul_high_neon(v, coefs.g_v)));
+            blue[i] = to_components_neon(vaddq_s16(y_term, mul_high_neon(u, coefs.b_u)));
+        }
+
+        uint8_t *dst = row.dst + x * bytes_per_pixel;
+        if (bytes_per_pixel == 4) {
+            const uint8x16x4_t pixels = { { vcombine_u8(red[0], red[1]), vcombine_u8(green[0], green[1]), vcombine_u8(blue[0], blue[1]), vdupq_n_u8(0xFF) } };
+            vst4q_u8(dst, pixels);
+        } else {
+            const uint8x16x3_t pixels = { { vcombine_u8(red[0], red[1]), vcombine_u8(green[0], green[1]), vcombine_u8(blue[0], blue[1]) } };
+            vst3q_u8(dst, pixels);
+        }
+    }
+
+    return x;
+}
+#endif
+
+static void convert_row(const ColorCoefficients &coefs, ChromaLayout layout, int bytes_per_pixel, const ColorRow &row, int width) {
+    int start = 0;
+#if defined(CODEC_CSC_SSE2)
+    start = convert_row_sse2(coefs, layout, bytes_per_pixel, row, width);
+#elif defined(CODEC_CSC_NEON)
+    start = convert_row_neon(coefs, layout, bytes_per_pixel, row, width);
+#endif
+    convert_row_scalar(coefs, layout, bytes_per_pixel, row, start, width);
+}
+
+// Everything needed for a conversion which does not depend on the image content
+struct ColorspaceConverter {
+    ColorspaceKey key;
+    ColorCoefficients coefs;
+    ChromaLayout layout;
+    int bytes_per_pixel;
+    // the chroma planes have one row for every 2 rows
+    bool half_height;
+    // index of the planes and offset of the first sample of U and V
+    int u_plane;
+    int v_plane;
+    int u_offset;
+    int v_offset;
+
+    void convert_rows(const ColorspaceImage &src, uint8_t *dst, int dst_stride, uint32_t start, uint32_t end) const {
+        for (uint32_t line = start; line < end; line++) {
+            const uint32_t chroma_line = half_height ? line / 2 : line;
+            const ColorRow row = {
+                src.planes[0] + static_cast<std::ptrdiff_t>(line) * src.strides[0],
+                src.planes[u_plane] + static_cast<std::ptrdiff_t>(chroma_line) * src.strides[u_plane] + u_offset,
+                src.planes[v_plane] + static_cast<std::ptrdiff_t>(chroma_line) * src.strides[v_plane] + v_offset,
+                dst + static_cast<std::ptrdiff_t>(line) * dst_stride,
+            };
+            convert_row(coefs, layout, bytes_per_pixel, row, static_cast<int>(key.width));
+        }
+    }
+};
+
+static std::shared_ptr<const ColorspaceConverter> create_converter(const ColorspaceKey &key) {
+    auto converter = std::make_shared<ColorspaceConverter>();
+    converter->key = key;
+    converter->coefs = make_coefficients(key.matrix);
+    converter->half_height = key.src != ColorspaceFormat::YUV444P;
+    converter->u_offset = 0;
+    converter->v_offset = 0;
+
+    switch (key.src) {
+    case ColorspaceFormat::YUV444P:
+        converter->layout = ChromaLayout::FULL;
+        converter->u_plane = 1;
+        converter->v_plane = 2;
+        break;
+    case ColorspaceFormat::YUV420P:
+    case ColorspaceFormat::YVU420P:
+        converter->layout = ChromaLayout::HALF;
+        converter->u_plane = (key.src == ColorspaceFormat::YUV420P) ? 1 : 2;
+        converter->v_plane = (key.src == ColorspaceFormat::YUV420P) ? 2 : 1;
+        break;
+    case ColorspaceFormat::NV12:
+    case ColorspaceFormat::NV21:
+        converter->layout = ChromaLayout::HALF_INTERLEAVED;
+        converter->u_plane = 1;
+        converter->v_plane = 1;
+        converter->u_offset = (key.src == ColorspaceFormat::NV12) ? 0 : 1;
+        converter->v_offset = (key.src == ColorspaceFormat::NV12) ? 1 : 0;
+        break;
+    default:
+        return nullptr;
+    }
+
+    switch (key.dst) {
+    case ColorspaceFormat::RGBA: converter->bytes_per_pixel = 4; break;
+    case ColorspaceFormat::RGB24: converter->bytes_per_pixel = 3; break;
+    default: return nullptr;
+    }
+
+    return converter;
+}
+
+static std::mutex converters_mutex;
+// most recently used first
+static std::list<std::shared_ptr<const ColorspaceConverter>> converters;
+
+static std::shared_ptr<const ColorspaceConverter> get_converter(const ColorspaceKey &key) {
+    const std::lock_guard<std::mutex> guard(converters_mutex);
+    const auto it = std::find_if(converters.begin(), converters.end(), [&](const auto &converter) {
+        return converter->key == key;
+    });
+    if (it != converters.end()) {
+        converters.splice(converters.begin(), converters, it);
+        return converters.front();
+    }
+
+    auto converter = create_converter(key);
+    if (!converter)
+        return nullptr;
+
+    converters.push_front(converter);
+    if (converters.size() > CONVERTER_CACHE_SIZE)
+        converters.pop_back();
+    return converter;
+}
+
+bool convert_colorspace(const ColorspaceKey &key, const ColorspaceImage &src, uint8_t *dst, int dst_stride) {
+    const auto converter = get_converter(key);
+    if (!converter) {
+        LOG_ERROR("Unsupported colorspace conversion from {} to {}.", static_cast<int>(key.src), static_cast<int>(key.dst));
+        return false;
+    }
+
+    const uint32_t slice_count = std::min<uint32_t>(key.height / MIN_ROWS_PER_SLICE, std::clamp(std::thread::hardware_concurrency(), 2u, 8u));
+    if (slice_count < 2) {
+        converter->convert_rows(src, dst, dst_stride, 0, key.height);
+        return true;
+    }
+
+    // slices start on an even row so they do not share chroma rows
+    const uint32_t rows_per_slice = ((key.height + slice_count - 1) / slice_count + 1) & ~1u;
+    util::parallel_for(slice_count, [&](std::size_t i) {
+        const uint32_t start = static_cast<uint32_t>(i) * rows_per_slice;
+        converter->convert_rows(src, dst, dst_stride, std::min(start, key.height), std::min(start + rows_per_slice, key.height));
+    });
+    return true;
+}
+
+ColorspaceImage make_packed_yuv_image(ColorspaceFormat format, const uint8_t *data, uint32_t width, uint32_t height) {
+    ColorspaceImage image;
+    const std::size_t luma_size = static_cast<std::size_t>(width) * height;
+    image.planes[0] = data;
+    image.strides[0] = static_cast<int>(width);
+
+    switch (format) {
+    case ColorspaceFormat::YUV444P:
+        image.planes[1] = data + luma_size;
+        image.planes[2] = data + luma_size * 2;
+        image.strides[1] = image.strides[2] = static_cast<int>(width);
+        break;
+    case ColorspaceFormat::YUV420P:
+    case ColorspaceFormat::YVU420P: {
+        const uint32_t chroma_width = (width + 1) / 2;
+        image.planes[1] = data + luma_size;
+        image.planes[2] = data + luma_size + static_cast<std::size_t>(chroma_width) * ((height + 1) / 2);
+        image.strides[1] = image.strides[2] = static_cast<int>(chroma_width);
+        break;
+    }
+    case ColorspaceFormat::NV12:
+    case ColorspaceFormat::NV21:
+        image.planes[1] = data + luma_size;
+        image.strides[1] = static_cast<int>((width + 1) / 2 * 2);
+        break;
+    default:
+        break;
+    }
+
+    return image;
+}
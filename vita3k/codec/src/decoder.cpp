@@ -23,7 +23,9 @@ extern "C" {
 
 #include <util/log.h>
 
+#include <algorithm>
 #include <cassert>
+#include <thread>
 
 uint32_t DecoderState::get(DecoderQuery query) {
     return 0;
@@ -44,6 +46,12 @@ DecoderState::~DecoderState() {
     avcodec_free_context(&context);
 }
 
+// Leave a core to the emulated cpu and cap it, ffmpeg gains little past 8 threads at the vita resolutions
+int get_codec_thread_count() {
+    const int host_threads = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(host_threads - 1, 1, 8);
+}
+
 // Handy to have this in logs, some debuggers dont seem to be able to evaluate there error macros properly.
 std::string codec_error_name(int error) {
     switch (error) {
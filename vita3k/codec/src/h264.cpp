@@ -23,21 +23,27 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 }
 
+#include <algorithm>
 #include <cassert>
 
-void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest) {
-    for (int32_t a = 0; a < frame->height; a++) {
-        memcpy(dest, &frame->data[0][frame->linesize[0] * a], frame->width);
-        dest += frame->width;
-    }
-    for (int32_t a = 0; a < frame->height / 2; a++) {
-        memcpy(dest, &frame->data[1][frame->linesize[1] * a], frame->width / 2);
-        dest += frame->width / 2;
+// Copy a plane without its row padding, in a single copy when the decoder did not pad the rows
+static uint8_t *copy_plane(const uint8_t *src, int linesize, int width, int height, uint8_t *dest) {
+    if (linesize == width) {
+        memcpy(dest, src, static_cast<size_t>(width) * height);
+        return dest + static_cast<size_t>(width) * height;
     }
-    for (int32_t a = 0; a < frame->height / 2; a++) {
-        memcpy(dest, &frame->data[2][frame->linesize[2] * a], frame->width / 2);
-        dest += frame->width / 2;
+
+    for (int32_t a = 0; a < height; a++) {
+        memcpy(dest, &src[linesize * a], width);
+        dest += width;
     }
+    return dest;
+}
+
+void copy_yuv_data_from_frame(AVFrame *frame, uint8_t *dest) {
+    dest = copy_plane(frame->data[0], frame->linesize[0], frame->width, frame->height, dest);
+    dest = copy_plane(frame->data[1], frame->linesize[1], frame->width / 2, frame->height / 2, dest);
+    copy_plane(frame->data[2], frame->linesize[2], frame->width / 2, frame->height / 2, dest);
 }
 
 uint32_t H264DecoderState::buffer_size(DecoderSize size) {
@@ -55,16 +61,30 @@ uint32_t H264DecoderState::get(DecoderQuery query) {
 bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
     int error = 0;
 
-    std::vector<uint8_t> au_frame(size + AV_INPUT_BUFFER_PADDING_SIZE);
-    memcpy(au_frame.data(), data, size);
+    // Grow the pool when an access unit does not fit, buffers still held by the decoder stay valid
+    const uint32_t padded_size = size + AV_INPUT_BUFFER_PADDING_SIZE;
+    if (padded_size > au_pool_size) {
+        av_buffer_pool_uninit(&au_pool);
+        au_pool_size = std::max(padded_size, au_pool_size * 2);
+        au_pool = av_buffer_pool_init(au_pool_size, nullptr);
+    }
+
+    AVBufferRef *au_buffer = av_buffer_pool_get(au_pool);
+    if (!au_buffer) {
+        LOG_WARN("Error allocating H264 access unit buffer of size {}.", padded_size);
+        return false;
+    }
+    memcpy(au_buffer->data, data, size);
+    memset(au_buffer->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
 
-    AVPacket *packet = av_packet_alloc();
+    uint8_t *packet_data = nullptr;
+    int packet_size = 0;
     error = av_parser_parse2(
         parser, // AVCodecParserContext *s,
         context, // AVCodecContext *avctx,
-        &packet->data, // uint8_t **poutbuf,
-        &packet->size, // int *poutbuf_size,
-        au_frame.data(), // const uint8_t *buf,
+        &packet_data, // uint8_t **poutbuf,
+        &packet_size, // int *poutbuf_size,
+        au_buffer->data, // const uint8_t *buf,
         size, // int buf_size,
         pts == ~0ull ? AV_NOPTS_VALUE : pts, // int64_t pts,
         dts == ~0ull ? AV_NOPTS_VALUE : dts, // int64_t dts,
@@ -72,15 +92,29 @@ bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
     );
     if (error < 0) {
         LOG_WARN("Error parsing H264 packet: {}.", codec_error_name(error));
-        av_packet_free(&packet);
+        av_buffer_unref(&au_buffer);
         return false;
     }
 
+    // An empty packet would put the decoder in draining mode
+    if (packet_size == 0) {
+        av_buffer_unref(&au_buffer);
+        return true;
+    }
+
+    // With complete frames the parser returns the input, which the decoder can then reference without copying it
+    if (packet_data >= au_buffer->data && packet_data + packet_size <= au_buffer->data + size)
+        packet->buf = au_buffer;
+    else
+        av_buffer_unref(&au_buffer);
+
+    packet->data = packet_data;
+    packet->size = packet_size;
     packet->pts = parser->pts;
     packet->dts = parser->dts;
 
     error = avcodec_send_packet(context, packet);
-    av_packet_free(&packet);
+    av_packet_unref(packet);
     if (error < 0) {
         LOG_WARN("Error sending H264 packet: {}.", codec_error_name(error));
         return false;
@@ -90,12 +124,9 @@ bool H264DecoderState::send(const uint8_t *data, uint32_t size) {
 }
 
 bool H264DecoderState::receive(uint8_t *data, DecoderSize *size) {
-    AVFrame *frame = av_frame_alloc();
-
     int error = avcodec_receive_frame(context, frame);
     if (error < 0) {
         LOG_WARN("Error receiving H264 frame: {}.", codec_error_name(error));
-        av_frame_free(&frame);
         return false;
     }
 
@@ -112,7 +143,7 @@ bool H264DecoderState::receive(uint8_t *data, DecoderSize *size) {
 
     pts_out = frame->pts;
 
-    av_frame_free(&frame);
+    av_frame_unref(frame);
     return true;
 }
 
@@ -133,7 +164,7 @@ void H264DecoderState::get_pts(uint32_t &upper, uint32_t &lower) {
     lower = pts_out & 0xFFFFFFFF;
 }
 
-H264DecoderState::H264DecoderState(uint32_t width, uint32_t height) {
+H264DecoderState::H264DecoderState(uint32_t width, uint32_t height, int thread_count) {
     AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
     assert(codec);
 
@@ -146,10 +177,22 @@ H264DecoderState::H264DecoderState(uint32_t width, uint32_t height) {
     context->width = width;
     context->height = height;
 
+    // The games expect the picture of an access unit to be returned by the same decode call,
+    // frame threading would delay the output by a frame per thread so only slices are decoded in parallel
+    context->thread_type = FF_THREAD_SLICE;
+    context->thread_count = thread_count > 0 ? thread_count : get_codec_thread_count();
+
     int result = avcodec_open2(context, codec, nullptr);
     assert(result == 0);
+
+    packet = av_packet_alloc();
+    frame = av_frame_alloc();
+    assert(packet && frame);
 }
 
 H264DecoderState::~H264DecoderState() {
+    av_frame_free(&frame);
+    av_packet_free(&packet);
     av_parser_close(parser);
+    av_buffer_pool_uninit(&au_pool);
 }
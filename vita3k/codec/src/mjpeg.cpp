@@ -15,11 +15,11 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <codec/colorspace.h>
 #include <codec/state.h>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
-#include <libswscale/swscale.h>
 }
 
 #include <util/log.h>
@@ -27,33 +27,9 @@ extern "C" {
 #include <cassert>
 
 void convert_yuv_to_rgb(const uint8_t *yuv, uint8_t *rgba, uint32_t width, uint32_t height) {
-    SwsContext *context = sws_getContext(width, height, AV_PIX_FMT_YUV444P, width, height, AV_PIX_FMT_RGBA,
-        0, nullptr, nullptr, nullptr);
-    assert(context);
-
-    const uint8_t *slices[] = {
-        &yuv[0], // Y Slice
-        &yuv[width * height], // U Slice
-        &yuv[width * height * 2], // V Slice
-    };
-
-    int strides[] = {
-        static_cast<int>(width),
-        static_cast<int>(width),
-        static_cast<int>(width),
-    };
-
-    uint8_t *dst_slices[] = {
-        rgba,
-    };
-
-    const int dst_strides[] = {
-        static_cast<int>(width * 4),
-    };
-
-    int error = sws_scale(context, slices, strides, 0, height, dst_slices, dst_strides);
-    assert(error == height);
-    sws_freeContext(context);
+    const ColorspaceKey key = { width, height, ColorspaceFormat::YUV444P, ColorspaceFormat::RGBA, ColorMatrix::BT601 };
+    const bool converted = convert_colorspace(key, make_packed_yuv_image(key.src, yuv, width, height), rgba, static_cast<int>(width * 4));
+    assert(converted);
 }
 
 bool MjpegDecoderState::send(const uint8_t *data, uint32_t size) {
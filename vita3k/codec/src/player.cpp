@@ -96,6 +96,9 @@ void PlayerState::switch_video(const std::string &path) {
         AVCodec *video_codec = avcodec_find_decoder(video_stream->codecpar->codec_id);
         video_context = avcodec_alloc_context3(video_codec);
         avcodec_parameters_to_context(video_context, video_stream->codecpar);
+        // Frames are pulled until one is ready, so the latency of frame threading is fine here
+        video_context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        video_context->thread_count = get_codec_thread_count();
         avcodec_open2(video_context, video_codec, nullptr);
     }
 
@@ -210,8 +213,14 @@ std::vector<uint8_t> PlayerState::receive_video() {
     while (true) {
         error = avcodec_receive_frame(video_context, frame);
 
-        if (error == AVERROR(EAGAIN) && next_packet(video_stream_id))
-            continue;
+        if (error == AVERROR(EAGAIN)) {
+            if (next_packet(video_stream_id))
+                continue;
+
+            // The frame threads still hold the last frames of the video, drain them
+            if (avcodec_send_packet(video_context, nullptr) == 0)
+                continue;
+        }
 
         if (error != 0) {
             if (videos_queue.empty()) {
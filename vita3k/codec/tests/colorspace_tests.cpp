@@ -0,0 +1,228 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <codec/colorspace.h>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// The conversions must match swscale, which the emulator used before, and the exact formulas
+
+struct TestImage {
+    ColorspaceFormat format;
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> data;
+};
+
+static TestImage make_image(ColorspaceFormat format, uint32_t width, uint32_t height) {
+    const std::size_t luma_size = static_cast<std::size_t>(width) * height;
+    const std::size_t chroma_size = (format == ColorspaceFormat::YUV444P) ? luma_size * 2 : static_cast<std::size_t>((width + 1) / 2) * ((height + 1) / 2) * 2;
+    TestImage image{ format, width, height, std::vector<uint8_t>(luma_size + chroma_size) };
+
+    // deterministic values covering the whole range, including the values outside of the limited range
+    uint32_t seed = 0x12345678;
+    for (auto &value : image.data) {
+        seed = seed * 1664525 + 1013904223;
+        value = static_cast<uint8_t>(seed >> 24);
+    }
+    return image;
+}
+
+// Y, U and V of a pixel whatever the format
+static void get_yuv(const TestImage &image, uint32_t x, uint32_t y, int &luma, int &u, int &v) {
+    const ColorspaceImage planes = make_packed_yuv_image(image.format, image.data.data(), image.width, image.height);
+    luma = planes.planes[0][y * planes.strides[0] + x];
+    switch (image.format) {
+    case ColorspaceFormat::YUV444P:
+        u = planes.planes[1][y * planes.strides[1] + x];
+        v = planes.planes[2][y * planes.strides[2] + x];
+        break;
+    case ColorspaceFormat::YUV420P:
+    case ColorspaceFormat::YVU420P: {
+        const int first = planes.planes[1][(y / 2) * planes.strides[1] + x / 2];
+        const int second = planes.planes[2][(y / 2) * planes.strides[2] + x / 2];
+        u = (image.format == ColorspaceFormat::YUV420P) ? first : second;
+        v = (image.format == ColorspaceFormat::YUV420P) ? second : first;
+        break;
+    }
+    default: {
+        const uint8_t *pair = planes.planes[1] + (y / 2) * planes.strides[1] + (x / 2) * 2;
+        u = (image.format == ColorspaceFormat::NV12) ? pair[0] : pair[1];
+        v = (image.format == ColorspaceFormat::NV12) ? pair[1] : pair[0];
+        break;
+    }
+    }
+}
+
+static std::vector<uint8_t> convert(const TestImage &image, ColorspaceFormat dst_format, ColorMatrix matrix) {
+    const int bytes_per_pixel = (dst_format == ColorspaceFormat::RGBA) ? 4 : 3;
+    std::vector<uint8_t> rgb(static_cast<std::size_t>(image.width) * image.height * bytes_per_pixel);
+    const ColorspaceKey key = { image.width, image.height, image.format, dst_format, matrix };
+    EXPECT_TRUE(convert_colorspace(key, make_packed_yuv_image(image.format, image.data.data(), image.width, image.height), rgb.data(), image.width * bytes_per_pixel));
+    return rgb;
+}
+
+static std::vector<uint8_t> convert_swscale(const TestImage &image, ColorspaceFormat dst_format, ColorMatrix matrix) {
+    // swscale is given a planar copy of the image, the interleaved formats only differ by their memory layout
+    const bool full_chroma = image.format == ColorspaceFormat::YUV444P;
+    const uint32_t chroma_width = full_chroma ? image.width : (image.width + 1) / 2;
+    const uint32_t chroma_height = full_chroma ? image.height : (image.height + 1) / 2;
+    std::vector<uint8_t> planes[3] = {
+        std::vector<uint8_t>(image.width * image.height),
+        std::vector<uint8_t>(chroma_width * chroma_height),
+        std::vector<uint8_t>(chroma_width * chroma_height),
+    };
+    for (uint32_t y = 0; y < image.height; y++) {
+        for (uint32_t x = 0; x < image.width; x++) {
+            int luma, u, v;
+            get_yuv(image, x, y, luma, u, v);
+            const uint32_t chroma_x = full_chroma ? x : x / 2;
+            const uint32_t chroma_y = full_chroma ? y : y / 2;
+            planes[0][y * image.width + x] = static_cast<uint8_t>(luma);
+            planes[1][chroma_y * chroma_width + chroma_x] = static_cast<uint8_t>(u);
+            planes[2][chroma_y * chroma_width + chroma_x] = static_cast<uint8_t>(v);
+        }
+    }
+
+    const int bytes_per_pixel = (dst_format == ColorspaceFormat::RGBA) ? 4 : 3;
+    SwsContext *context = sws_getContext(image.width, image.height, full_chroma ? AV_PIX_FMT_YUV444P : AV_PIX_FMT_YUV420P,
+        image.width, image.height, (dst_format == ColorspaceFormat::RGBA) ? AV_PIX_FMT_RGBA : AV_PIX_FMT_RGB24,
+        SWS_POINT, nullptr, nullptr, nullptr);
+    EXPECT_NE(context, nullptr);
+
+    int *inv_table, *table;
+    int src_range, dst_range, brightness, contrast, saturation;
+    sws_getColorspaceDetails(context, &inv_table, &src_range, &table, &dst_range, &brightness, &contrast, &saturation);
+    sws_setColorspaceDetails(context, sws_getCoefficients(matrix == ColorMatrix::BT709 ? SWS_CS_ITU709 : SWS_CS_ITU601),
+        0, table, dst_range, brightness, contrast, saturation);
+
+    std::vector<uint8_t> rgb(static_cast<std::size_t>(image.width) * image.height * bytes_per_pixel);
+    const uint8_t *src_slices[] = { planes[0].data(), planes[1].data(), planes[2].data() };
+    const int src_strides[] = { static_cast<int>(image.width), static_cast<int>(chroma_width), static_cast<int>(chroma_width) };
+    uint8_t *dst_slices[] = { rgb.data() };
+    const int dst_strides[] = { static_cast<int>(image.width) * bytes_per_pixel };
+    sws_scale(context, src_slices, src_strides, 0, image.height, dst_slices, dst_strides);
+    sws_freeContext(context);
+    return rgb;
+}
+
+// Limited range conversion in floating point
+static std::vector<uint8_t> convert_reference(const TestImage &image, ColorspaceFormat dst_format, ColorMatrix matrix) {
+    const double kr = (matrix == ColorMatrix::BT709) ? 0.2126 : 0.299;
+    const double kb = (matrix == ColorMatrix::BT709) ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+    const double y_scale = 255.0 / 219.0;
+    const double c_scale = 255.0 / 224.0;
+    const int bytes_per_pixel = (dst_format == ColorspaceFormat::RGBA) ? 4 : 3;
+
+    std::vector<uint8_t> rgb(static_cast<std::size_t>(image.width) * image.height * bytes_per_pixel);
+    const auto to_component = [](double value) {
+        return static_cast<uint8_t>(std::clamp(std::lround(value), 0l, 255l));
+    };
+    for (uint32_t y = 0; y < image.height; y++) {
+        for (uint32_t x = 0; x < image.width; x++) {
+            int luma, u, v;
+            get_yuv(image, x, y, luma, u, v);
+            const double y_term = y_scale * (luma - 16);
+            const double u_term = c_scale * (u - 128);
+            const double v_term = c_scale * (v - 128);
+            uint8_t *pixel = &rgb[(static_cast<std::size_t>(y) * image.width + x) * bytes_per_pixel];
+            pixel[0] = to_component(y_term + 2.0 * (1.0 - kr) * v_term);
+            pixel[1] = to_component(y_term - 2.0 * (1.0 - kb) * kb / kg * u_term - 2.0 * (1.0 - kr) * kr / kg * v_term);
+            pixel[2] = to_component(y_term + 2.0 * (1.0 - kb) * u_term);
+            if (bytes_per_pixel == 4)
+                pixel[3] = 0xFF;
+        }
+    }
+    return rgb;
+}
+
+static int max_difference(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+    EXPECT_EQ(a.size(), b.size());
+    int difference = 0;
+    for (std::size_t i = 0; i < std::min(a.size(), b.size()); i++)
+        difference = std::max(difference, std::abs(a[i] - b[i]));
+    return difference;
+}
+
+static const ColorspaceFormat yuv_formats[] = { ColorspaceFormat::YUV444P, ColorspaceFormat::YUV420P, ColorspaceFormat::YVU420P, ColorspaceFormat::NV12, ColorspaceFormat::NV21 };
+static const ColorspaceFormat rgb_formats[] = { ColorspaceFormat::RGBA, ColorspaceFormat::RGB24 };
+static const ColorMatrix matrices[] = { ColorMatrix::BT601, ColorMatrix::BT709 };
+
+TEST(colorspace, matches_swscale) {
+    for (const auto src_format : yuv_formats) {
+        const TestImage image = make_image(src_format, 96, 34);
+        for (const auto dst_format : rgb_formats) {
+            for (const auto matrix : matrices) {
+                EXPECT_LE(max_difference(convert(image, dst_format, matrix), convert_swscale(image, dst_format, matrix)), 3)
+                    << "src = " << static_cast<int>(src_format) << ", dst = " << static_cast<int>(dst_format) << ", matrix = " << static_cast<int>(matrix);
+            }
+        }
+    }
+}
+
+TEST(colorspace, matches_reference) {
+    // odd sizes exercise the end of the rows, the large one is split between threads
+    for (const auto &[width, height] : { std::pair{ 1u, 1u }, { 17u, 3u }, { 33u, 9u }, { 64u, 64u }, { 960u, 544u } }) {
+        for (const auto src_format : yuv_formats) {
+            const TestImage image = make_image(src_format, width, height);
+            for (const auto dst_format : rgb_formats) {
+                for (const auto matrix : matrices) {
+                    EXPECT_LE(max_difference(convert(image, dst_format, matrix), convert_reference(image, dst_format, matrix)), 1)
+                        << width << "x" << height << ", src = " << static_cast<int>(src_format) << ", dst = " << static_cast<int>(dst_format);
+                }
+            }
+        }
+    }
+}
+
+TEST(colorspace, same_result_on_any_column) {
+    // the first columns of a wide image go through the SIMD code and those of a narrow one through the scalar code
+    constexpr uint32_t width = 64;
+    constexpr uint32_t narrow_width = 15;
+    constexpr uint32_t height = 4;
+    for (const auto src_format : yuv_formats) {
+        const TestImage image = make_image(src_format, width, height);
+        const ColorspaceImage planes = make_packed_yuv_image(src_format, image.data.data(), width, height);
+        for (const auto matrix : matrices) {
+            std::vector<uint8_t> wide(width * height * 4);
+            std::vector<uint8_t> narrow(width * height * 4);
+            EXPECT_TRUE(convert_colorspace({ width, height, src_format, ColorspaceFormat::RGBA, matrix }, planes, wide.data(), width * 4));
+            EXPECT_TRUE(convert_colorspace({ narrow_width, height, src_format, ColorspaceFormat::RGBA, matrix }, planes, narrow.data(), width * 4));
+            for (uint32_t y = 0; y < height; y++) {
+                const auto row = y * width * 4;
+                EXPECT_TRUE(std::equal(&wide[row], &wide[row + narrow_width * 4], &narrow[row])) << "row " << y << ", src = " << static_cast<int>(src_format);
+            }
+        }
+    }
+}
+
+TEST(colorspace, unsupported_conversion) {
+    uint8_t pixel[4] = {};
+    const ColorspaceImage image = make_packed_yuv_image(ColorspaceFormat::YUV444P, pixel, 1, 1);
+    EXPECT_FALSE(convert_colorspace({ 1, 1, ColorspaceFormat::RGBA, ColorspaceFormat::YUV444P, ColorMatrix::BT601 }, image, pixel, 4));
+}
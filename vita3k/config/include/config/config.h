@@ -84,6 +84,11 @@ enum PerfomanceOverleyPosition {
     code(int, "log-level", static_cast<int>(spdlog::level::trace), log_level)                           \
     code(std::string, "cpu-backend", "Dynarmic", cpu_backend)                                           \
     code(bool, "cpu-opt", true, cpu_opt)                                                                \
+    code(std::string, "memory-tracking", "Auto", memory_tracking)                                       \
+    code(std::string, "clock-mode", "Real-time", clock_mode)                                            \
+    code(float, "clock-scale", 2.0f, clock_scale)                                                       \
+    code(int, "metrics-dump-interval", 0, metrics_dump_interval)                                        \
+    code(std::string, "metrics-dump-format", "CSV", metrics_dump_format)                                \
     code(std::string, "pref-path", std::string{}, pref_path)                                            \
     code(bool, "discord-rich-presence", true, discord_rich_presence)                                    \
     code(bool, "wait-for-debugger", false, wait_for_debugger)                                           \
@@ -124,6 +129,7 @@ enum PerfomanceOverleyPosition {
     code(bool, "asia-font-support", false, asia_font_support)                                           \
     code(bool, "shader-cache", true, shader_cache)                                                      \
     code(bool, "spirv-shader", false, spirv_shader)                                                     \
+    code(int, "spirv-optimization-level", 0, spirv_optimization_level)                                  \
     code(uint64_t, "current-ime-lang", 4, current_ime_lang)                                             \
     code(int, "psn-status", static_cast<int>(SCE_NP_SERVICE_STATE_UNKNOWN), psn_status)                 \
     code(bool, "http-enable", true, http_enable)                                                        \
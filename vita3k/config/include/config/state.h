@@ -80,6 +80,12 @@ private:
         load_app_list = rhs.load_app_list;
         self_path = rhs.self_path;
         shader_cache = rhs.shader_cache;
+        headless = rhs.headless;
+        headless_frames = rhs.headless_frames;
+        headless_report = rhs.headless_report;
+        trace_path = rhs.trace_path;
+        gxm_capture_path = rhs.gxm_capture_path;
+        gxm_capture_frames = rhs.gxm_capture_frames;
     }
 
 public:
@@ -101,6 +107,18 @@ public:
     bool console = false;
     bool load_app_list = false;
 
+    // Run without window and GPU, then write a report of the run to headless_report
+    bool headless = false;
+    int headless_frames = 0;
+    std::string headless_report = "headless-report.json";
+
+    // Binary trace of the import calls and thread status changes, not written when empty
+    std::string trace_path;
+
+    // Capture of the GXM commands and the memory they read, replayed with gxm-replay. Not written when empty
+    std::string gxm_capture_path;
+    int gxm_capture_frames = 0;
+
     /**
      * @brief Available HLE modules for advanced profiling using Tracy
      *
@@ -156,6 +156,18 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
         ->default_str({})->group("Input");
     input->add_option("--shader-cache,-D", command_line.shader_cache, "Enable shader cache to pre-compile it at boot up")
        ->default_val(true)->group("Input");
+    input->add_flag("--headless,-H", command_line.headless, "Run the app without window nor GPU using the null renderer, then write a report of the run")
+        ->group("Input");
+    input->add_option("--headless-frames", command_line.headless_frames, "Stop the headless run after this number of frames, 0 to run until the app exits")
+        ->default_val(0)->check(CLI::NonNegativeNumber)->group("Input");
+    input->add_option("--headless-report", command_line.headless_report, "Path of the JSON report written at the end of the headless run")
+        ->default_str("headless-report.json")->group("Input");
+    input->add_option("--trace", command_line.trace_path, "Write a binary trace of the import calls and thread status changes to this file, read it with trace-decode")
+        ->group("Input");
+    input->add_option("--gxm-capture", command_line.gxm_capture_path, "Capture the GXM commands with the memory they read to this file from the start of the app, replay it with gxm-replay")
+        ->group("Input");
+    input->add_option("--gxm-capture-frames", command_line.gxm_capture_frames, "Stop the GXM capture after this number of frames, 0 to capture until the app exits")
+        ->default_val(0)->check(CLI::NonNegativeNumber)->group("Input");
     input->add_option("--deleted-id,-d", command_line.delete_title_id, "Title ID of installed app to delete")
         ->default_str({})->check(CLI::IsMember(get_file_set(fs::path(cfg.pref_path) / "ux0/app")))->group("Input");
     auto input_pkg = input->add_option("--pkg", command_line.pkg_path, "Path of app (in .pkg format) to install")
@@ -172,6 +184,10 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
         ->ignore_case()->check(CLI::IsMember(std::set<std::string>{ "OpenGL", "Vulkan" }))->group("Vita Emulation");
     config->add_flag("--" + cfg[e_color_surface_debug] + ",-C", command_line.color_surface_debug, "Save color surfaces")
         ->group("Vita Emulation");
+    config->add_option("--" + cfg[e_clock_mode], command_line.clock_mode, "Clock of the emulated console:\nReal-time: follow the host time\nScaled: run the time faster by clock-scale\nVirtual: skip the time where every guest thread is waiting")
+        ->check(CLI::IsMember(std::set<std::string>{ "Real-time", "Scaled", "Virtual" }, CLI::ignore_case))->group("Vita Emulation");
+    config->add_option("--" + cfg[e_clock_scale], command_line.clock_scale, "Speed of the scaled clock, 2 runs the time twice faster")
+        ->check(CLI::PositiveNumber)->group("Vita Emulation");
     config->add_option("--config-location,-c", command_line.config_path, "Get a configuration file from a given location. If a filename is given, it must end with \".yml\", otherwise it will be assumed to be a directory. \nDefault loaded: <Vita3K>/config.yml \nDefaults: <Vita3K>/data/config/default.yml")
         ->group("YML");
     config->add_flag("!--keep-config,!-w", command_line.overwrite_config, "Do not modify the configuration file after loading.")
@@ -184,6 +200,10 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
     std::vector<std::string> lle_modules{};
     config->add_option("--" + cfg[e_lle_modules] + ",-m", lle_modules, "Load given (decrypted) OS modules from disk.\nSeparate by commas to specify multiple modules. Full path and extension should not be included, the following are assumed: vs0:sys/external/<name>.suprx\nExample: --lle-modules libscemp4,libngs")
         ->group("Modules");
+    config->add_option("--" + cfg[e_metrics_dump_interval], command_line.metrics_dump_interval, "Write the per-frame metrics summed over this many frames to logs/<TITLE_ID>-metrics, 0 to disable")
+        ->check(CLI::NonNegativeNumber)->group("Logging");
+    config->add_option("--" + cfg[e_metrics_dump_format], command_line.metrics_dump_format, "Format of the metrics file, CSV or JSON (one object per line)")
+        ->check(CLI::IsMember(std::set<std::string>{ "CSV", "JSON" }, CLI::ignore_case))->group("Logging");
     config->add_option("--" + cfg[e_log_level] + ",-l", command_line.log_level, "Logging level:\nTRACE = 0\nDEBUG = 1\nINFO = 2\nWARN = 3\nERROR = 4\nCRITICAL = 5\nOFF = 6")
         ->check(CLI::Range( 0, 6 ))->group("Logging");
     config->add_flag("--" + cfg[e_log_active_shaders] + ",-S", command_line.log_active_shaders, "Log Active Shaders")
@@ -253,6 +273,11 @@ ExitCode init_config(Config &cfg, int argc, char **argv, const Root &root_paths)
     if (cfg.pref_path.empty())
         cfg.pref_path = root_paths.get_pref_path_string();
 
+    if (cfg.headless && !cfg.run_app_path && !cfg.content_path) {
+        LOG_ERROR("Headless mode needs an app to run, use --installed-path or give a content path");
+        return InitConfigFailed;
+    }
+
     if (!cfg.console) {
         LOG_INFO_IF(cfg.load_config, "Custom configuration file loaded successfully.");
 
@@ -22,6 +22,7 @@
 #include <cpu/state.h>
 #include <set>
 #include <util/log.h>
+#include <util/metrics.h>
 
 #include <mem/ptr.h>
 
@@ -118,6 +119,9 @@ public:
     }
 
     void PreCodeTranslationHook(bool is_thumb, Dynarmic::A32::VAddr pc, Dynarmic::A32::IREmitter &ir) override {
+        // nothing has been emitted yet for the first instruction of a block
+        if (ir.block.empty())
+            metrics::add(metrics::JIT_BLOCKS);
         if (cpu->log_code) {
             ir.CallHostFunction(&TraceInstruction, ir.Imm64((uint64_t)this), ir.Imm64(pc), ir.Imm64(is_thumb));
         }
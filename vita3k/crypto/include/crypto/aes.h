@@ -40,6 +40,7 @@ typedef UINT32 uint32_t;
 
 #define POLARSSL_ERR_AES_INVALID_KEY_LENGTH -0x0020 /**< Invalid key length. */
 #define POLARSSL_ERR_AES_INVALID_INPUT_LENGTH -0x0022 /**< Invalid data input length. */
+#define POLARSSL_ERR_AES_FEATURE_UNAVAILABLE -0x0023 /**< Feature not available, e.g. unsupported AES instructions. */
 
 // Regular implementation
 //
@@ -173,6 +174,43 @@ int aes_crypt_ctr(aes_context *ctx,
 
 void aes_cmac(aes_context *ctx, int length, unsigned char *input, unsigned char *output);
 
+/**
+ * \brief          Implementations of the block cipher, the best one supported
+ *                 by the host is selected on first use. All of them use the
+ *                 round keys computed by aes_setkey_enc/aes_setkey_dec.
+ */
+typedef enum {
+    AES_BACKEND_SOFTWARE = 0, /*!<  table based implementation    */
+    AES_BACKEND_AESNI, /*!<  x86 AES-NI                    */
+    AES_BACKEND_VAES, /*!<  x86 VAES with AVX2, 2 blocks per instruction */
+    AES_BACKEND_ARMV8_CE, /*!<  ARMv8 Cryptography Extension */
+    AES_BACKEND_COUNT
+} aes_backend;
+
+/**
+ * \brief          Check if an implementation is built in and supported by the host CPU
+ *
+ * \return         1 if supported, 0 otherwise
+ */
+int aes_backend_supported(aes_backend backend);
+
+/**
+ * \brief          Select the implementation used by all the functions above
+ *
+ * \return         0 if successful, or POLARSSL_ERR_AES_FEATURE_UNAVAILABLE
+ */
+int aes_set_backend(aes_backend backend);
+
+/**
+ * \brief          Implementation currently in use
+ */
+aes_backend aes_get_backend(void);
+
+/**
+ * \brief          Printable name of an implementation
+ */
+const char *aes_backend_name(aes_backend backend);
+
 #ifdef __cplusplus
 }
 #endif
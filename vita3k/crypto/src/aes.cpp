@@ -29,9 +29,14 @@
  *  http://csrc.nist.gov/publications/fips/fips197/fips-197.pdf
  */
 
+#include "aes_accel.h"
+
 #include <aes.h>
 #include <crypto/aes.h>
 
+#include <atomic>
+#include <initializer_list>
+
 /*
  * 32-bit integer manipulation macros (little endian)
  */
@@ -349,8 +354,6 @@ static uint32_t RCON[10];
 #define XTIME(x) ((x << 1) ^ ((x & 0x80) ? 0x1B : 0x00))
 #define MUL(x, y) ((x && y) ? pow[(log[x] + log[y]) % 255] : 0)
 
-static int aes_init_done = 0;
-
 static void aes_gen_tables(void) {
     int i, x, y, z;
     int pow[256];
@@ -422,6 +425,63 @@ static void aes_gen_tables(void) {
 
 #endif
 
+/*
+ * Hardware implementations
+ */
+static const crypto::AesAccel *get_backend_accel(aes_backend backend) {
+    switch (backend) {
+    case AES_BACKEND_AESNI: return crypto::get_aesni_accel();
+    case AES_BACKEND_VAES: return crypto::get_vaes_accel();
+    case AES_BACKEND_ARMV8_CE: return crypto::get_armv8_accel();
+    default: return nullptr;
+    }
+}
+
+static aes_backend detect_backend() {
+    for (const aes_backend backend : { AES_BACKEND_VAES, AES_BACKEND_AESNI, AES_BACKEND_ARMV8_CE }) {
+        if (get_backend_accel(backend))
+            return backend;
+    }
+    return AES_BACKEND_SOFTWARE;
+}
+
+static std::atomic<const crypto::AesAccel *> &active_accel() {
+    static std::atomic<const crypto::AesAccel *> accel = get_backend_accel(detect_backend());
+    return accel;
+}
+
+// nullptr when the software version is used
+static const crypto::AesAccel *get_accel() {
+    return active_accel().load(std::memory_order_relaxed);
+}
+
+int aes_backend_supported(aes_backend backend) {
+    return (backend == AES_BACKEND_SOFTWARE) || (get_backend_accel(backend) != nullptr);
+}
+
+int aes_set_backend(aes_backend backend) {
+    if (!aes_backend_supported(backend))
+        return (POLARSSL_ERR_AES_FEATURE_UNAVAILABLE);
+
+    active_accel().store(get_backend_accel(backend), std::memory_order_relaxed);
+    return (0);
+}
+
+aes_backend aes_get_backend(void) {
+    const crypto::AesAccel *accel = get_accel();
+    return accel ? accel->backend : AES_BACKEND_SOFTWARE;
+}
+
+const char *aes_backend_name(aes_backend backend) {
+    switch (backend) {
+    case AES_BACKEND_SOFTWARE: return "software";
+    case AES_BACKEND_AESNI: return "AES-NI";
+    case AES_BACKEND_VAES: return "VAES";
+    case AES_BACKEND_ARMV8_CE: return "ARMv8 CE";
+    default: return "unknown";
+    }
+}
+
 /*
  * AES key schedule (encryption)
  */
@@ -430,10 +490,9 @@ int aes_setkey_enc(aes_context *ctx, const unsigned char *key, unsigned int keys
     uint32_t *RK;
 
 #if !defined(POLARSSL_AES_ROM_TABLES)
-    if (aes_init_done == 0) {
-        aes_gen_tables();
-        aes_init_done = 1;
-    }
+    // keys can be set up from several threads
+    static const bool tables_done = (aes_gen_tables(), true);
+    (void)tables_done;
 #endif
 
     switch (keysize) {
@@ -577,6 +636,14 @@ int aes_crypt_ecb(aes_context *ctx,
     int i;
     uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
 
+    if (const crypto::AesAccel *accel = get_accel()) {
+        if (mode == AES_DECRYPT)
+            accel->decrypt_ecb(ctx, input, output, 1);
+        else
+            accel->encrypt_ecb(ctx, input, output, 1);
+        return (0);
+    }
+
     RK = ctx->rk;
 
     GET_UINT32_LE(X0, input, 0);
@@ -645,6 +712,17 @@ int aes_crypt_cbc(aes_context *ctx,
     if (length % 16)
         return (POLARSSL_ERR_AES_INVALID_INPUT_LENGTH);
 
+    if (const crypto::AesAccel *accel = get_accel()) {
+        if (mode == AES_DECRYPT) {
+            // the iv is left untouched when decrypting, same as below
+            memcpy(orig_iv, iv, 16);
+            accel->decrypt_cbc(ctx, orig_iv, input, output, length / 16);
+        } else {
+            accel->encrypt_cbc(ctx, iv, input, output, length / 16);
+        }
+        return (0);
+    }
+
     if (mode == AES_DECRYPT) {
         memcpy(orig_iv, iv, 16);
         while (length > 0) {
@@ -731,6 +809,20 @@ int aes_crypt_ctr(aes_context *ctx,
     int c, i;
     size_t n = *nc_off;
 
+    if (const crypto::AesAccel *accel = get_accel()) {
+        // use the rest of the current stream block, then do the whole blocks at once, the last partial block is done below
+        for (; (n != 0) && (length != 0); length--) {
+            *output++ = (unsigned char)(*input++ ^ stream_block[n]);
+            n = (n + 1) & 0x0F;
+        }
+
+        const size_t blocks = length / 16;
+        accel->crypt_ctr(ctx, nonce_counter, input, output, blocks);
+        input += blocks * 16;
+        output += blocks * 16;
+        length -= blocks * 16;
+    }
+
     while (length--) {
         if (n == 0) {
             aes_crypt_ecb(ctx, AES_ENCRYPT, nonce_counter, stream_block);
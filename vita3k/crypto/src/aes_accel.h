@@ -0,0 +1,81 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <crypto/aes.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <stdlib.h>
+#endif
+
+namespace crypto {
+
+// Hardware implementation of the AES modes working on whole 16-byte blocks.
+// The round keys are the ones computed by aes_setkey_enc/aes_setkey_dec, so the contexts are shared with the software version.
+// The input and output buffers may be the same.
+struct AesAccel {
+    aes_backend backend;
+    void (*encrypt_ecb)(const aes_context *ctx, const uint8_t *input, uint8_t *output, size_t blocks);
+    void (*decrypt_ecb)(const aes_context *ctx, const uint8_t *input, uint8_t *output, size_t blocks);
+    // iv is updated to the last ciphertext block
+    void (*encrypt_cbc)(const aes_context *ctx, uint8_t iv[16], const uint8_t *input, uint8_t *output, size_t blocks);
+    void (*decrypt_cbc)(const aes_context *ctx, uint8_t iv[16], const uint8_t *input, uint8_t *output, size_t blocks);
+    // counter is a 128-bit big endian integer, incremented once per block
+    void (*crypt_ctr)(const aes_context *ctx, uint8_t counter[16], const uint8_t *input, uint8_t *output, size_t blocks);
+};
+
+// Each one returns nullptr when the implementation is not built in or not supported by the host CPU
+const AesAccel *get_aesni_accel();
+const AesAccel *get_vaes_accel();
+const AesAccel *get_armv8_accel();
+
+inline uint64_t bswap64(uint64_t value) {
+#ifdef _MSC_VER
+    return _byteswap_uint64(value);
+#else
+    return __builtin_bswap64(value);
+#endif
+}
+
+inline void load_counter(const uint8_t counter[16], uint64_t &hi, uint64_t &lo) {
+    hi = 0;
+    lo = 0;
+    for (int i = 0; i < 8; i++) {
+        hi = (hi << 8) | counter[i];
+        lo = (lo << 8) | counter[i + 8];
+    }
+}
+
+inline void store_counter(uint8_t counter[16], uint64_t hi, uint64_t lo) {
+    for (int i = 7; i >= 0; i--) {
+        counter[i] = static_cast<uint8_t>(hi);
+        counter[i + 8] = static_cast<uint8_t>(lo);
+        hi >>= 8;
+        lo >>= 8;
+    }
+}
+
+inline void increment_counter(uint64_t &hi, uint64_t &lo) {
+    if (++lo == 0)
+        hi++;
+}
+
+} // namespace crypto
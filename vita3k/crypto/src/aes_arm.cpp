@@ -0,0 +1,250 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// ARMv8 Cryptography Extension implementation of the block modes, this file is built with the crypto
+// instructions enabled and is only called after a runtime check.
+
+#include "aes_accel.h"
+
+#if (defined(__aarch64__) && (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))) || (defined(_MSC_VER) && defined(_M_ARM64))
+#define CRYPTO_ARMV8_CE
+#ifdef _MSC_VER
+#include <arm64_neon.h>
+#include <windows.h>
+#else
+#include <arm_neon.h>
+#endif
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+
+#include <utility>
+
+namespace crypto {
+
+#ifdef CRYPTO_ARMV8_CE
+
+// number of blocks processed together, enough to hide the latency of the AES instructions
+static constexpr size_t PARALLEL_BLOCKS = 8;
+
+namespace {
+
+struct RoundKeys {
+    uint8x16_t keys[15];
+    int nr;
+
+    explicit RoundKeys(const aes_context *ctx)
+        : nr(ctx->nr) {
+        for (int i = 0; i <= nr; i++)
+            keys[i] = vld1q_u8(reinterpret_cast<const uint8_t *>(ctx->rk + i * 4));
+    }
+};
+
+} // namespace
+
+// AESE does AddRoundKey first, so the last round key is xored at the end
+static inline uint8x16_t encrypt_block(const RoundKeys &rk, uint8x16_t block) {
+    for (int r = 0; r < rk.nr - 1; r++)
+        block = vaesmcq_u8(vaeseq_u8(block, rk.keys[r]));
+    block = vaeseq_u8(block, rk.keys[rk.nr - 1]);
+    return veorq_u8(block, rk.keys[rk.nr]);
+}
+
+static inline uint8x16_t decrypt_block(const RoundKeys &rk, uint8x16_t block) {
+    for (int r = 0; r < rk.nr - 1; r++)
+        block = vaesimcq_u8(vaesdq_u8(block, rk.keys[r]));
+    block = vaesdq_u8(block, rk.keys[rk.nr - 1]);
+    return veorq_u8(block, rk.keys[rk.nr]);
+}
+
+// The intrinsics are wrapped since msvc can't take their address
+struct XorRound {
+    static uint8x16_t apply(uint8x16_t block, uint8x16_t key) { return veorq_u8(block, key); }
+};
+struct EncryptRound {
+    static uint8x16_t apply(uint8x16_t block, uint8x16_t key) { return vaesmcq_u8(vaeseq_u8(block, key)); }
+};
+struct EncryptLastRound {
+    static uint8x16_t apply(uint8x16_t block, uint8x16_t key) { return vaeseq_u8(block, key); }
+};
+struct DecryptRound {
+    static uint8x16_t apply(uint8x16_t block, uint8x16_t key) { return vaesimcq_u8(vaesdq_u8(block, key)); }
+};
+struct DecryptLastRound {
+    static uint8x16_t apply(uint8x16_t block, uint8x16_t key) { return vaesdq_u8(block, key); }
+};
+
+// Apply a round to all the blocks, expanded at compile time so the blocks stay in registers
+template <typename Round, size_t... I>
+static inline void round_blocks(uint8x16_t (&blocks)[PARALLEL_BLOCKS], uint8x16_t key, std::index_sequence<I...>) {
+    ((blocks[I] = Round::apply(blocks[I], key)), ...);
+}
+
+// The rounds are interleaved across the blocks so the instructions of independent blocks overlap
+template <typename Round, typename LastRound>
+static inline void crypt_blocks(const RoundKeys &rk, uint8x16_t (&blocks)[PARALLEL_BLOCKS]) {
+    constexpr auto indexes = std::make_index_sequence<PARALLEL_BLOCKS>();
+    for (int r = 0; r < rk.nr - 1; r++)
+        round_blocks<Round>(blocks, rk.keys[r], indexes);
+    round_blocks<LastRound>(blocks, rk.keys[rk.nr - 1], indexes);
+    round_blocks<XorRound>(blocks, rk.keys[rk.nr], indexes);
+}
+
+static inline void encrypt_blocks(const RoundKeys &rk, uint8x16_t (&blocks)[PARALLEL_BLOCKS]) {
+    crypt_blocks<EncryptRound, EncryptLastRound>(rk, blocks);
+}
+
+static inline void decrypt_blocks(const RoundKeys &rk, uint8x16_t (&blocks)[PARALLEL_BLOCKS]) {
+    crypt_blocks<DecryptRound, DecryptLastRound>(rk, blocks);
+}
+
+static inline uint8x16_t make_counter_block(uint64_t hi, uint64_t lo) {
+    return vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(bswap64(hi)), vcreate_u64(bswap64(lo))));
+}
+
+static void encrypt_ecb(const aes_context *ctx, const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        uint8x16_t data[PARALLEL_BLOCKS];
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            data[i] = vld1q_u8(input + i * 16);
+        encrypt_blocks(rk, data);
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            vst1q_u8(output + i * 16, data[i]);
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    for (; blocks > 0; blocks--) {
+        vst1q_u8(output, encrypt_block(rk, vld1q_u8(input)));
+        input += 16;
+        output += 16;
+    }
+}
+
+static void decrypt_ecb(const aes_context *ctx, const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        uint8x16_t data[PARALLEL_BLOCKS];
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            data[i] = vld1q_u8(input + i * 16);
+        decrypt_blocks(rk, data);
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            vst1q_u8(output + i * 16, data[i]);
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    for (; blocks > 0; blocks--) {
+        vst1q_u8(output, decrypt_block(rk, vld1q_u8(input)));
+        input += 16;
+        output += 16;
+    }
+}
+
+// each block depends on the previous one, CBC encryption can't be interleaved
+static void encrypt_cbc(const aes_context *ctx, uint8_t iv[16], const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    uint8x16_t chain = vld1q_u8(iv);
+    for (; blocks > 0; blocks--) {
+        chain = encrypt_block(rk, veorq_u8(vld1q_u8(input), chain));
+        vst1q_u8(output, chain);
+        input += 16;
+        output += 16;
+    }
+    vst1q_u8(iv, chain);
+}
+
+static void decrypt_cbc(const aes_context *ctx, uint8_t iv[16], const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    uint8x16_t chain = vld1q_u8(iv);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        uint8x16_t cipher[PARALLEL_BLOCKS];
+        uint8x16_t data[PARALLEL_BLOCKS];
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            data[i] = cipher[i] = vld1q_u8(input + i * 16);
+        decrypt_blocks(rk, data);
+        vst1q_u8(output, veorq_u8(data[0], chain));
+        for (size_t i = 1; i < PARALLEL_BLOCKS; i++)
+            vst1q_u8(output + i * 16, veorq_u8(data[i], cipher[i - 1]));
+        chain = cipher[PARALLEL_BLOCKS - 1];
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    for (; blocks > 0; blocks--) {
+        const uint8x16_t cipher = vld1q_u8(input);
+        vst1q_u8(output, veorq_u8(decrypt_block(rk, cipher), chain));
+        chain = cipher;
+        input += 16;
+        output += 16;
+    }
+    vst1q_u8(iv, chain);
+}
+
+static void crypt_ctr(const aes_context *ctx, uint8_t counter[16], const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    uint64_t hi, lo;
+    load_counter(counter, hi, lo);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        uint8x16_t stream[PARALLEL_BLOCKS];
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++) {
+            stream[i] = make_counter_block(hi, lo);
+            increment_counter(hi, lo);
+        }
+        encrypt_blocks(rk, stream);
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            vst1q_u8(output + i * 16, veorq_u8(vld1q_u8(input + i * 16), stream[i]));
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    for (; blocks > 0; blocks--) {
+        vst1q_u8(output, veorq_u8(vld1q_u8(input), encrypt_block(rk, make_counter_block(hi, lo))));
+        increment_counter(hi, lo);
+        input += 16;
+        output += 16;
+    }
+    store_counter(counter, hi, lo);
+}
+
+static bool has_aes_instructions() {
+#if defined(__APPLE__)
+    // all the Apple ARM64 CPUs have the crypto extension
+    return true;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#elif defined(_WIN32)
+    return IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE);
+#else
+    return false;
+#endif
+}
+
+const AesAccel *get_armv8_accel() {
+    static const AesAccel accel = { AES_BACKEND_ARMV8_CE, encrypt_ecb, decrypt_ecb, encrypt_cbc, decrypt_cbc, crypt_ctr };
+    static const bool supported = has_aes_instructions();
+    return supported ? &accel : nullptr;
+}
+
+#else
+
+const AesAccel *get_armv8_accel() {
+    return nullptr;
+}
+
+#endif
+
+} // namespace crypto
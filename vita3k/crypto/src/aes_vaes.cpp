@@ -0,0 +1,224 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// VAES implementation of the block modes, each instruction works on 2 blocks.
+// This file is built with the VAES and AVX2 instructions enabled and is only called after a runtime check.
+
+#include "aes_accel.h"
+
+#if (defined(__VAES__) && defined(__AVX2__)) || (defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64))
+#define CRYPTO_VAES
+#include <util/instrset_detect.h>
+#include <immintrin.h>
+#endif
+
+#include <utility>
+
+namespace crypto {
+
+#ifdef CRYPTO_VAES
+
+// 8 registers of 2 blocks
+static constexpr size_t PARALLEL_REGS = 8;
+static constexpr size_t PARALLEL_BLOCKS = PARALLEL_REGS * 2;
+
+namespace {
+
+struct RoundKeys {
+    __m256i keys[15];
+    int nr;
+
+    explicit RoundKeys(const aes_context *ctx)
+        : nr(ctx->nr) {
+        for (int i = 0; i <= nr; i++)
+            keys[i] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ctx->rk) + i));
+    }
+};
+
+} // namespace
+
+// The intrinsics are wrapped since msvc can't take their address
+struct XorRound {
+    static __m256i apply(__m256i regs, __m256i key) { return _mm256_xor_si256(regs, key); }
+};
+struct EncryptRound {
+    static __m256i apply(__m256i regs, __m256i key) { return _mm256_aesenc_epi128(regs, key); }
+};
+struct EncryptLastRound {
+    static __m256i apply(__m256i regs, __m256i key) { return _mm256_aesenclast_epi128(regs, key); }
+};
+struct DecryptRound {
+    static __m256i apply(__m256i regs, __m256i key) { return _mm256_aesdec_epi128(regs, key); }
+};
+struct DecryptLastRound {
+    static __m256i apply(__m256i regs, __m256i key) { return _mm256_aesdeclast_epi128(regs, key); }
+};
+
+// Apply a round to all the registers, expanded at compile time so they are not spilled
+template <typename Round, size_t... I>
+static inline void round_regs(__m256i (&regs)[PARALLEL_REGS], __m256i key, std::index_sequence<I...>) {
+    ((regs[I] = Round::apply(regs[I], key)), ...);
+}
+
+template <typename Round, typename LastRound>
+static inline void crypt_regs(const RoundKeys &rk, __m256i (&regs)[PARALLEL_REGS]) {
+    constexpr auto indexes = std::make_index_sequence<PARALLEL_REGS>();
+    round_regs<XorRound>(regs, rk.keys[0], indexes);
+    for (int r = 1; r < rk.nr; r++)
+        round_regs<Round>(regs, rk.keys[r], indexes);
+    round_regs<LastRound>(regs, rk.keys[rk.nr], indexes);
+}
+
+static inline void encrypt_regs(const RoundKeys &rk, __m256i (&regs)[PARALLEL_REGS]) {
+    crypt_regs<EncryptRound, EncryptLastRound>(rk, regs);
+}
+
+static inline void decrypt_regs(const RoundKeys &rk, __m256i (&regs)[PARALLEL_REGS]) {
+    crypt_regs<DecryptRound, DecryptLastRound>(rk, regs);
+}
+
+static inline __m128i make_counter_block(uint64_t hi, uint64_t lo) {
+    return _mm_set_epi64x(static_cast<int64_t>(bswap64(lo)), static_cast<int64_t>(bswap64(hi)));
+}
+
+static inline __m256i load_regs(const uint8_t *src) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+}
+
+static inline void store_regs(uint8_t *dest, __m256i value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), value);
+}
+
+// The remaining blocks are done by the AES-NI version, which is always supported along VAES
+static const AesAccel &aesni() {
+    return *get_aesni_accel();
+}
+
+static void encrypt_ecb(const aes_context *ctx, const uint8_t *input, uint8_t *output, size_t blocks) {
+    if (blocks < PARALLEL_BLOCKS) {
+        aesni().encrypt_ecb(ctx, input, output, blocks);
+        return;
+    }
+
+    const RoundKeys rk(ctx);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        __m256i data[PARALLEL_REGS];
+        for (size_t i = 0; i < PARALLEL_REGS; i++)
+            data[i] = load_regs(input + i * 32);
+        encrypt_regs(rk, data);
+        for (size_t i = 0; i < PARALLEL_REGS; i++)
+            store_regs(output + i * 32, data[i]);
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    aesni().encrypt_ecb(ctx, input, output, blocks);
+}
+
+static void decrypt_ecb(const aes_context *ctx, const uint8_t *input, uint8_t *output, size_t blocks) {
+    if (blocks < PARALLEL_BLOCKS) {
+        aesni().decrypt_ecb(ctx, input, output, blocks);
+        return;
+    }
+
+    const RoundKeys rk(ctx);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        __m256i data[PARALLEL_REGS];
+        for (size_t i = 0; i < PARALLEL_REGS; i++)
+            data[i] = load_regs(input + i * 32);
+        decrypt_regs(rk, data);
+        for (size_t i = 0; i < PARALLEL_REGS; i++)
+            store_regs(output + i * 32, data[i]);
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    aesni().decrypt_ecb(ctx, input, output, blocks);
+}
+
+static void encrypt_cbc(const aes_context *ctx, uint8_t iv[16], const uint8_t *input, uint8_t *output, size_t blocks) {
+    aesni().encrypt_cbc(ctx, iv, input, output, blocks);
+}
+
+static void decrypt_cbc(const aes_context *ctx, uint8_t iv[16], const uint8_t *input, uint8_t *output, size_t blocks) {
+    if (blocks < PARALLEL_BLOCKS) {
+        aesni().decrypt_cbc(ctx, iv, input, output, blocks);
+        return;
+    }
+
+    const RoundKeys rk(ctx);
+    __m128i chain = _mm_loadu_si128(reinterpret_cast<const __m128i *>(iv));
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        // the block before each pair is xored after decryption, load everything before writing for in place decryption
+        __m256i previous[PARALLEL_REGS];
+        __m256i data[PARALLEL_REGS];
+        previous[0] = _mm256_inserti128_si256(_mm256_castsi128_si256(chain), _mm_loadu_si128(reinterpret_cast<const __m128i *>(input)), 1);
+        for (size_t i = 1; i < PARALLEL_REGS; i++)
+            previous[i] = load_regs(input + i * 32 - 16);
+        for (size_t i = 0; i < PARALLEL_REGS; i++)
+            data[i] = load_regs(input + i * 32);
+        chain = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + (PARALLEL_BLOCKS - 1) * 16));
+        decrypt_regs(rk, data);
+        for (size_t i = 0; i < PARALLEL_REGS; i++)
+            store_regs(output + i * 32, _mm256_xor_si256(data[i], previous[i]));
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(iv), chain);
+    aesni().decrypt_cbc(ctx, iv, input, output, blocks);
+}
+
+static void crypt_ctr(const aes_context *ctx, uint8_t counter[16], const uint8_t *input, uint8_t *output, size_t blocks) {
+    if (blocks < PARALLEL_BLOCKS) {
+        aesni().crypt_ctr(ctx, counter, input, output, blocks);
+        return;
+    }
+
+    const RoundKeys rk(ctx);
+    uint64_t hi, lo;
+    load_counter(counter, hi, lo);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        __m256i stream[PARALLEL_REGS];
+        for (size_t i = 0; i < PARALLEL_REGS; i++) {
+            const __m128i first = make_counter_block(hi, lo);
+            increment_counter(hi, lo);
+            stream[i] = _mm256_set_m128i(make_counter_block(hi, lo), first);
+            increment_counter(hi, lo);
+        }
+        encrypt_regs(rk, stream);
+        for (size_t i = 0; i < PARALLEL_REGS; i++)
+            store_regs(output + i * 32, _mm256_xor_si256(load_regs(input + i * 32), stream[i]));
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    store_counter(counter, hi, lo);
+    aesni().crypt_ctr(ctx, counter, input, output, blocks);
+}
+
+const AesAccel *get_vaes_accel() {
+    static const AesAccel accel = { AES_BACKEND_VAES, encrypt_ecb, decrypt_ecb, encrypt_cbc, decrypt_cbc, crypt_ctr };
+    static const bool supported = util::instrset::hasVAES() && get_aesni_accel();
+    return supported ? &accel : nullptr;
+}
+
+#else
+
+const AesAccel *get_vaes_accel() {
+    return nullptr;
+}
+
+#endif
+
+} // namespace crypto
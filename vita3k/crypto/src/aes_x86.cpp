@@ -0,0 +1,236 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// AES-NI implementation of the block modes, this file is built with the AES instructions enabled
+// and is only called after a runtime check.
+
+#include "aes_accel.h"
+
+#if defined(__AES__) || (defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86)))
+#define CRYPTO_AESNI
+#include <util/instrset_detect.h>
+#include <wmmintrin.h>
+#endif
+
+#include <utility>
+
+namespace crypto {
+
+#ifdef CRYPTO_AESNI
+
+// number of blocks processed together, enough to hide the latency of the AES instructions
+static constexpr size_t PARALLEL_BLOCKS = 8;
+
+namespace {
+
+struct RoundKeys {
+    __m128i keys[15];
+    int nr;
+
+    explicit RoundKeys(const aes_context *ctx)
+        : nr(ctx->nr) {
+        for (int i = 0; i <= nr; i++)
+            keys[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctx->rk) + i);
+    }
+};
+
+} // namespace
+
+static inline __m128i encrypt_block(const RoundKeys &rk, __m128i block) {
+    block = _mm_xor_si128(block, rk.keys[0]);
+    for (int r = 1; r < rk.nr; r++)
+        block = _mm_aesenc_si128(block, rk.keys[r]);
+    return _mm_aesenclast_si128(block, rk.keys[rk.nr]);
+}
+
+static inline __m128i decrypt_block(const RoundKeys &rk, __m128i block) {
+    block = _mm_xor_si128(block, rk.keys[0]);
+    for (int r = 1; r < rk.nr; r++)
+        block = _mm_aesdec_si128(block, rk.keys[r]);
+    return _mm_aesdeclast_si128(block, rk.keys[rk.nr]);
+}
+
+// The intrinsics are wrapped since msvc can't take their address
+struct XorRound {
+    static __m128i apply(__m128i block, __m128i key) { return _mm_xor_si128(block, key); }
+};
+struct EncryptRound {
+    static __m128i apply(__m128i block, __m128i key) { return _mm_aesenc_si128(block, key); }
+};
+struct EncryptLastRound {
+    static __m128i apply(__m128i block, __m128i key) { return _mm_aesenclast_si128(block, key); }
+};
+struct DecryptRound {
+    static __m128i apply(__m128i block, __m128i key) { return _mm_aesdec_si128(block, key); }
+};
+struct DecryptLastRound {
+    static __m128i apply(__m128i block, __m128i key) { return _mm_aesdeclast_si128(block, key); }
+};
+
+// Apply a round to all the blocks, expanded at compile time so the blocks stay in registers
+template <typename Round, size_t... I>
+static inline void round_blocks(__m128i (&blocks)[PARALLEL_BLOCKS], __m128i key, std::index_sequence<I...>) {
+    ((blocks[I] = Round::apply(blocks[I], key)), ...);
+}
+
+// The rounds are interleaved across the blocks so the instructions of independent blocks overlap
+template <typename Round, typename LastRound>
+static inline void crypt_blocks(const RoundKeys &rk, __m128i (&blocks)[PARALLEL_BLOCKS]) {
+    constexpr auto indexes = std::make_index_sequence<PARALLEL_BLOCKS>();
+    round_blocks<XorRound>(blocks, rk.keys[0], indexes);
+    for (int r = 1; r < rk.nr; r++)
+        round_blocks<Round>(blocks, rk.keys[r], indexes);
+    round_blocks<LastRound>(blocks, rk.keys[rk.nr], indexes);
+}
+
+static inline void encrypt_blocks(const RoundKeys &rk, __m128i (&blocks)[PARALLEL_BLOCKS]) {
+    crypt_blocks<EncryptRound, EncryptLastRound>(rk, blocks);
+}
+
+static inline void decrypt_blocks(const RoundKeys &rk, __m128i (&blocks)[PARALLEL_BLOCKS]) {
+    crypt_blocks<DecryptRound, DecryptLastRound>(rk, blocks);
+}
+
+static inline __m128i load_block(const uint8_t *src) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+}
+
+static inline void store_block(uint8_t *dest, __m128i block) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), block);
+}
+
+static inline __m128i make_counter_block(uint64_t hi, uint64_t lo) {
+    return _mm_set_epi64x(static_cast<int64_t>(bswap64(lo)), static_cast<int64_t>(bswap64(hi)));
+}
+
+static void encrypt_ecb(const aes_context *ctx, const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        __m128i data[PARALLEL_BLOCKS];
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            data[i] = load_block(input + i * 16);
+        encrypt_blocks(rk, data);
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            store_block(output + i * 16, data[i]);
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    for (; blocks > 0; blocks--) {
+        store_block(output, encrypt_block(rk, load_block(input)));
+        input += 16;
+        output += 16;
+    }
+}
+
+static void decrypt_ecb(const aes_context *ctx, const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        __m128i data[PARALLEL_BLOCKS];
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            data[i] = load_block(input + i * 16);
+        decrypt_blocks(rk, data);
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            store_block(output + i * 16, data[i]);
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    for (; blocks > 0; blocks--) {
+        store_block(output, decrypt_block(rk, load_block(input)));
+        input += 16;
+        output += 16;
+    }
+}
+
+// each block depends on the previous one, CBC encryption can't be interleaved
+static void encrypt_cbc(const aes_context *ctx, uint8_t iv[16], const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    __m128i chain = load_block(iv);
+    for (; blocks > 0; blocks--) {
+        chain = encrypt_block(rk, _mm_xor_si128(load_block(input), chain));
+        store_block(output, chain);
+        input += 16;
+        output += 16;
+    }
+    store_block(iv, chain);
+}
+
+static void decrypt_cbc(const aes_context *ctx, uint8_t iv[16], const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    __m128i chain = load_block(iv);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        __m128i cipher[PARALLEL_BLOCKS];
+        __m128i data[PARALLEL_BLOCKS];
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            data[i] = cipher[i] = load_block(input + i * 16);
+        decrypt_blocks(rk, data);
+        store_block(output, _mm_xor_si128(data[0], chain));
+        for (size_t i = 1; i < PARALLEL_BLOCKS; i++)
+            store_block(output + i * 16, _mm_xor_si128(data[i], cipher[i - 1]));
+        chain = cipher[PARALLEL_BLOCKS - 1];
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    for (; blocks > 0; blocks--) {
+        const __m128i cipher = load_block(input);
+        store_block(output, _mm_xor_si128(decrypt_block(rk, cipher), chain));
+        chain = cipher;
+        input += 16;
+        output += 16;
+    }
+    store_block(iv, chain);
+}
+
+static void crypt_ctr(const aes_context *ctx, uint8_t counter[16], const uint8_t *input, uint8_t *output, size_t blocks) {
+    const RoundKeys rk(ctx);
+    uint64_t hi, lo;
+    load_counter(counter, hi, lo);
+    for (; blocks >= PARALLEL_BLOCKS; blocks -= PARALLEL_BLOCKS) {
+        __m128i stream[PARALLEL_BLOCKS];
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++) {
+            stream[i] = make_counter_block(hi, lo);
+            increment_counter(hi, lo);
+        }
+        encrypt_blocks(rk, stream);
+        for (size_t i = 0; i < PARALLEL_BLOCKS; i++)
+            store_block(output + i * 16, _mm_xor_si128(load_block(input + i * 16), stream[i]));
+        input += PARALLEL_BLOCKS * 16;
+        output += PARALLEL_BLOCKS * 16;
+    }
+    for (; blocks > 0; blocks--) {
+        store_block(output, _mm_xor_si128(load_block(input), encrypt_block(rk, make_counter_block(hi, lo))));
+        increment_counter(hi, lo);
+        input += 16;
+        output += 16;
+    }
+    store_counter(counter, hi, lo);
+}
+
+const AesAccel *get_aesni_accel() {
+    static const AesAccel accel = { AES_BACKEND_AESNI, encrypt_ecb, decrypt_ecb, encrypt_cbc, decrypt_cbc, crypt_ctr };
+    static const bool supported = util::instrset::hasAES();
+    return supported ? &accel : nullptr;
+}
+
+#else
+
+const AesAccel *get_aesni_accel() {
+    return nullptr;
+}
+
+#endif
+
+} // namespace crypto
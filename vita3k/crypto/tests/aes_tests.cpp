@@ -0,0 +1,265 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <crypto/aes.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Every implementation supported by the host must pass the known answer tests and match the software version
+
+static std::vector<uint8_t> from_hex(const std::string &hex) {
+    std::vector<uint8_t> bytes(hex.size() / 2);
+    for (size_t i = 0; i < bytes.size(); i++)
+        bytes[i] = static_cast<uint8_t>(std::stoi(hex.substr(i * 2, 2), nullptr, 16));
+    return bytes;
+}
+
+static std::vector<uint8_t> make_data(size_t size, uint32_t seed) {
+    std::vector<uint8_t> data(size);
+    for (auto &byte : data) {
+        seed = seed * 1664525 + 1013904223;
+        byte = static_cast<uint8_t>(seed >> 24);
+    }
+    return data;
+}
+
+static std::vector<aes_backend> get_supported_backends() {
+    std::vector<aes_backend> backends;
+    for (int backend = AES_BACKEND_SOFTWARE; backend < AES_BACKEND_COUNT; backend++) {
+        if (aes_backend_supported(static_cast<aes_backend>(backend)))
+            backends.push_back(static_cast<aes_backend>(backend));
+    }
+    return backends;
+}
+
+class AesBackends : public testing::Test {
+protected:
+    void SetUp() override {
+        default_backend = aes_get_backend();
+    }
+
+    void TearDown() override {
+        aes_set_backend(default_backend);
+    }
+
+    aes_backend default_backend = AES_BACKEND_SOFTWARE;
+};
+
+// FIPS-197 appendix C
+TEST_F(AesBackends, ecb_known_answers) {
+    const std::vector<uint8_t> plaintext = from_hex("00112233445566778899aabbccddeeff");
+    const struct {
+        const char *key;
+        const char *ciphertext;
+    } vectors[] = {
+        { "000102030405060708090a0b0c0d0e0f", "69c4e0d86a7b0430d8cdb78070b4c55a" },
+        { "000102030405060708090a0b0c0d0e0f1011121314151617", "dda97ca4864cdfe06eaf70a0ec0d7191" },
+        { "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", "8ea2b7ca516745bfeafc49904b496089" },
+    };
+
+    for (const aes_backend backend : get_supported_backends()) {
+        SCOPED_TRACE(aes_backend_name(backend));
+        ASSERT_EQ(aes_set_backend(backend), 0);
+
+        for (const auto &vector : vectors) {
+            const std::vector<uint8_t> key = from_hex(vector.key);
+            const std::vector<uint8_t> expected = from_hex(vector.ciphertext);
+            aes_context ctx;
+            uint8_t output[16];
+
+            ASSERT_EQ(aes_setkey_enc(&ctx, key.data(), key.size() * 8), 0);
+            aes_crypt_ecb(&ctx, AES_ENCRYPT, plaintext.data(), output);
+            EXPECT_EQ(std::vector<uint8_t>(output, output + 16), expected);
+
+            ASSERT_EQ(aes_setkey_dec(&ctx, key.data(), key.size() * 8), 0);
+            aes_crypt_ecb(&ctx, AES_DECRYPT, expected.data(), output);
+            EXPECT_EQ(std::vector<uint8_t>(output, output + 16), plaintext);
+        }
+    }
+}
+
+// NIST SP 800-38A F.2.1, F.2.2 and F.5.1
+static const char *const SP800_38A_KEY = "2b7e151628aed2a6abf7158809cf4f3c";
+static const char *const SP800_38A_PLAINTEXT = "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                                               "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+
+TEST_F(AesBackends, cbc_known_answers) {
+    const std::vector<uint8_t> key = from_hex(SP800_38A_KEY);
+    const std::vector<uint8_t> plaintext = from_hex(SP800_38A_PLAINTEXT);
+    const std::vector<uint8_t> iv = from_hex("000102030405060708090a0b0c0d0e0f");
+    const std::vector<uint8_t> expected = from_hex("7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+                                                   "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7");
+
+    for (const aes_backend backend : get_supported_backends()) {
+        SCOPED_TRACE(aes_backend_name(backend));
+        ASSERT_EQ(aes_set_backend(backend), 0);
+
+        aes_context ctx;
+        std::vector<uint8_t> output(plaintext.size());
+        std::vector<uint8_t> current_iv = iv;
+
+        aes_setkey_enc(&ctx, key.data(), 128);
+        EXPECT_EQ(aes_crypt_cbc(&ctx, AES_ENCRYPT, plaintext.size(), current_iv.data(), plaintext.data(), output.data()), 0);
+        EXPECT_EQ(output, expected);
+        // the iv is updated when encrypting
+        EXPECT_EQ(current_iv, std::vector<uint8_t>(expected.end() - 16, expected.end()));
+
+        current_iv = iv;
+        aes_setkey_dec(&ctx, key.data(), 128);
+        EXPECT_EQ(aes_crypt_cbc(&ctx, AES_DECRYPT, expected.size(), current_iv.data(), expected.data(), output.data()), 0);
+        EXPECT_EQ(output, plaintext);
+        // but not when decrypting
+        EXPECT_EQ(current_iv, iv);
+
+        EXPECT_EQ(aes_crypt_cbc(&ctx, AES_DECRYPT, 15, current_iv.data(), expected.data(), output.data()), POLARSSL_ERR_AES_INVALID_INPUT_LENGTH);
+    }
+}
+
+TEST_F(AesBackends, ctr_known_answers) {
+    const std::vector<uint8_t> key = from_hex(SP800_38A_KEY);
+    const std::vector<uint8_t> plaintext = from_hex(SP800_38A_PLAINTEXT);
+    const std::vector<uint8_t> counter = from_hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    const std::vector<uint8_t> expected = from_hex("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+                                                   "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee");
+
+    for (const aes_backend backend : get_supported_backends()) {
+        SCOPED_TRACE(aes_backend_name(backend));
+        ASSERT_EQ(aes_set_backend(backend), 0);
+
+        aes_context ctx;
+        aes_setkey_enc(&ctx, key.data(), 128);
+
+        std::vector<uint8_t> output(plaintext.size());
+        std::vector<uint8_t> current_counter = counter;
+        uint8_t stream_block[16];
+        size_t nc_off = 0;
+        aes_crypt_ctr(&ctx, plaintext.size(), &nc_off, current_counter.data(), stream_block, plaintext.data(), output.data());
+        EXPECT_EQ(output, expected);
+        EXPECT_EQ(nc_off, 0);
+        EXPECT_EQ(current_counter, from_hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdff03"));
+    }
+}
+
+// RFC 4493 section 4
+TEST_F(AesBackends, cmac_known_answers) {
+    const std::vector<uint8_t> key = from_hex(SP800_38A_KEY);
+    std::vector<uint8_t> message = from_hex(SP800_38A_PLAINTEXT);
+    const struct {
+        int length;
+        const char *mac;
+    } vectors[] = {
+        { 0, "bb1d6929e95937287fa37d129b756746" },
+        { 16, "070a16b46b4d4144f79bdd9dd04a287c" },
+        { 40, "dfa66747de9ae63030ca32611497c827" },
+        { 64, "51f0bebf7e3b9d92fc49741779363cfe" },
+    };
+
+    for (const aes_backend backend : get_supported_backends()) {
+        SCOPED_TRACE(aes_backend_name(backend));
+        ASSERT_EQ(aes_set_backend(backend), 0);
+
+        aes_context ctx;
+        aes_setkey_enc(&ctx, key.data(), 128);
+        for (const auto &vector : vectors) {
+            uint8_t mac[16];
+            aes_cmac(&ctx, vector.length, message.data(), mac);
+            EXPECT_EQ(std::vector<uint8_t>(mac, mac + 16), from_hex(vector.mac)) << "length = " << vector.length;
+        }
+    }
+}
+
+TEST_F(AesBackends, cbc_matches_software) {
+    for (const unsigned int key_bits : { 128u, 192u, 256u }) {
+        const std::vector<uint8_t> key = make_data(key_bits / 8, key_bits);
+        const std::vector<uint8_t> iv = make_data(16, 1);
+
+        for (const size_t blocks : { 1, 7, 8, 9, 16, 17, 100 }) {
+            const std::vector<uint8_t> plaintext = make_data(blocks * 16, static_cast<uint32_t>(blocks));
+            aes_context enc_ctx;
+            aes_context dec_ctx;
+            aes_setkey_enc(&enc_ctx, key.data(), key_bits);
+            aes_setkey_dec(&dec_ctx, key.data(), key_bits);
+
+            ASSERT_EQ(aes_set_backend(AES_BACKEND_SOFTWARE), 0);
+            std::vector<uint8_t> expected(plaintext.size());
+            std::vector<uint8_t> expected_iv = iv;
+            aes_crypt_cbc(&enc_ctx, AES_ENCRYPT, plaintext.size(), expected_iv.data(), plaintext.data(), expected.data());
+
+            for (const aes_backend backend : get_supported_backends()) {
+                SCOPED_TRACE(aes_backend_name(backend));
+                ASSERT_EQ(aes_set_backend(backend), 0);
+
+                std::vector<uint8_t> data = plaintext;
+                std::vector<uint8_t> current_iv = iv;
+                aes_crypt_cbc(&enc_ctx, AES_ENCRYPT, data.size(), current_iv.data(), data.data(), data.data());
+                EXPECT_EQ(data, expected) << "key bits = " << key_bits << ", blocks = " << blocks;
+                EXPECT_EQ(current_iv, expected_iv);
+
+                // in place
+                current_iv = iv;
+                aes_crypt_cbc(&dec_ctx, AES_DECRYPT, data.size(), current_iv.data(), data.data(), data.data());
+                EXPECT_EQ(data, plaintext) << "key bits = " << key_bits << ", blocks = " << blocks;
+            }
+        }
+    }
+}
+
+TEST_F(AesBackends, ctr_matches_software) {
+    const std::vector<uint8_t> key = make_data(16, 2);
+    aes_context ctx;
+    aes_setkey_enc(&ctx, key.data(), 128);
+
+    // the low 64 bits of the counter overflow in the middle of the data
+    const std::vector<uint8_t> counter = from_hex("0123456789abcdeffffffffffffffffa");
+    const std::vector<uint8_t> plaintext = make_data(16 * 40 + 5, 3);
+
+    ASSERT_EQ(aes_set_backend(AES_BACKEND_SOFTWARE), 0);
+    std::vector<uint8_t> expected(plaintext.size());
+    std::vector<uint8_t> expected_counter = counter;
+    uint8_t stream_block[16];
+    size_t nc_off = 0;
+    aes_crypt_ctr(&ctx, plaintext.size(), &nc_off, expected_counter.data(), stream_block, plaintext.data(), expected.data());
+
+    for (const aes_backend backend : get_supported_backends()) {
+        SCOPED_TRACE(aes_backend_name(backend));
+        ASSERT_EQ(aes_set_backend(backend), 0);
+
+        // split in pieces not aligned to the blocks, to resume in the middle of a stream block
+        for (const size_t piece_size : { 1, 5, 16, 33, 128, 1000 }) {
+            std::vector<uint8_t> data = plaintext;
+            std::vector<uint8_t> current_counter = counter;
+            size_t current_off = 0;
+            for (size_t offset = 0; offset < data.size(); offset += piece_size) {
+                const size_t size = std::min(piece_size, data.size() - offset);
+                aes_crypt_ctr(&ctx, size, &current_off, current_counter.data(), stream_block, &data[offset], &data[offset]);
+            }
+            EXPECT_EQ(data, expected) << "piece size = " << piece_size;
+            EXPECT_EQ(current_counter, expected_counter) << "piece size = " << piece_size;
+            EXPECT_EQ(current_off, nc_off);
+        }
+    }
+}
+
+TEST(aes, set_backend) {
+    EXPECT_TRUE(aes_backend_supported(AES_BACKEND_SOFTWARE));
+    EXPECT_EQ(aes_set_backend(AES_BACKEND_COUNT), POLARSSL_ERR_AES_FEATURE_UNAVAILABLE);
+}
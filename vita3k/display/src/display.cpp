@@ -22,7 +22,6 @@
 #include <kernel/state.h>
 #include <renderer/state.h>
 
-#include <chrono>
 #include <touch/functions.h>
 #include <util/find.h>
 
@@ -33,7 +32,10 @@ static constexpr int64_t TARGET_MICRO_PER_FRAME = 1000000LL / TARGET_FPS;
 
 static void vblank_sync_thread(EmuEnvState &emuenv) {
     DisplayState &display = emuenv.display;
+    EmuClock &clock = emuenv.kernel.clock;
 
+    // the vblanks wake up the guest threads, so this thread is running for the clock except while it sleeps
+    clock.add_runner();
     while (!display.abort.load()) {
         {
             const std::lock_guard<std::mutex> guard(display.mutex);
@@ -69,10 +71,10 @@ static void vblank_sync_thread(EmuEnvState &emuenv) {
                 }
             }
         }
-        const auto time_ms = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-        const auto time_left = TARGET_MICRO_PER_FRAME - (time_ms % TARGET_MICRO_PER_FRAME);
-        std::this_thread::sleep_for(std::chrono::microseconds(time_left));
+        const uint64_t next_vblank = (clock.now() / TARGET_MICRO_PER_FRAME + 1) * TARGET_MICRO_PER_FRAME;
+        clock.sleep_until(next_vblank);
     }
+    clock.remove_runner();
 }
 
 void start_sync_thread(EmuEnvState &emuenv) {
@@ -28,6 +28,7 @@ struct FeatureState {
     bool support_rgb_attributes = true; ///< Do the GPU supports RGB (3 components) vertex attribute? If not (AMD GPU), some modifications must be applied to the renderer and the shader recompiler
     bool use_mask_bit = false; ///< Is the mask bit (1 per sample) emulated ? It is only used in homebrews afaik
     bool support_memory_mapping = false; ///< Is the host GPU memory directly mapped with gxm memory?
+    int spirv_optimization_level = 0; ///< Level of the optimization passes run on the recompiled SPIR-V (see shader/spirv_optimizer.h), 0 to disable them.
 
     bool is_programmable_blending_supported() const {
         return support_shader_interlock || support_texture_barrier || direct_fragcolor;
@@ -18,10 +18,12 @@
 #include "private.h"
 
 #include <config/state.h>
+#include <util/metrics.h>
 
 namespace gui {
 static const ImVec2 PERF_OVERLAY_PAD = ImVec2(12.f, 12.f);
 static const ImVec4 PERF_OVERLAY_BG_COLOR = ImVec4(0.282f, 0.239f, 0.545f, 0.8f);
+static const ImVec2 PERF_METRICS_SIZE = ImVec2(130.f, 108.f);
 
 static ImVec2 get_perf_pos(ImVec2 window_size, EmuEnvState &emuenv) {
     const auto TOP = emuenv.viewport_pos.y - PERF_OVERLAY_PAD.y;
@@ -45,7 +47,7 @@ static ImVec2 get_perf_pos(ImVec2 window_size, EmuEnvState &emuenv) {
 
 static float get_perf_height(EmuEnvState &emuenv) {
     switch (emuenv.cfg.performance_overlay_detail) {
-    case MAXIMUM: return 138.f;
+    case MAXIMUM: return 138.f + PERF_METRICS_SIZE.y;
     case MEDIUM: return 80.f;
     case LOW:
     case MINIMUM:
@@ -55,6 +57,31 @@ static float get_perf_height(EmuEnvState &emuenv) {
     return 57.f;
 }
 
+// Counters of the last emulated frame
+static void draw_perf_metrics(GuiState &gui, EmuEnvState &emuenv) {
+    auto lang = gui.lang.performance_overlay;
+    const metrics::Frame frame = metrics::get_last_frame();
+    const auto count = [&frame](metrics::CounterId id) { return static_cast<uint32_t>(frame.get(id)); };
+    const auto ms = [](std::uint64_t ns) { return ns / 1e6f; };
+
+    ImGui::PushStyleColor(ImGuiCol_ChildBg, PERF_OVERLAY_BG_COLOR);
+    ImGui::PushStyleVar(ImGuiStyleVar_ChildRounding, 5.f * emuenv.dpi_scale);
+    ImGui::BeginChild("#perf_metrics", ImVec2(PERF_METRICS_SIZE.x * emuenv.dpi_scale, PERF_METRICS_SIZE.y * emuenv.dpi_scale), true, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoSavedSettings);
+    ImGui::PushFont(gui.vita_font);
+    ImGui::SetWindowFontScale(0.6f);
+    ImGui::Text("%s: %.1f ms %s: %.1f ms", lang["frame"].c_str(), ms(frame.time_ns), lang["render"].c_str(), ms(frame.get(metrics::RENDER_TIME)));
+    ImGui::Text("%s: %u %s: %u", lang["draws"].c_str(), count(metrics::DRAWS), lang["lists"].c_str(), count(metrics::COMMAND_LISTS));
+    ImGui::Text("%s: %u/%u/%u", lang["textures"].c_str(), count(metrics::TEXTURE_CACHE_HITS), count(metrics::TEXTURE_CACHE_MISSES), count(metrics::TEXTURE_UPLOADS));
+    ImGui::Text("%s: %u/%u", lang["compiles"].c_str(), count(metrics::SHADER_COMPILES), count(metrics::PIPELINE_COMPILES));
+    ImGui::Text("%s: %u %s: %u", lang["hle"].c_str(), count(metrics::HLE_CALLS), lang["jit"].c_str(), count(metrics::JIT_BLOCKS));
+    ImGui::Text("%s: %u %s: %u", lang["faults"].c_str(), count(metrics::PAGE_FAULTS), lang["underruns"].c_str(), count(metrics::AUDIO_UNDERRUNS));
+    ImGui::Text("%s: %.2f ms", lang["ngs"].c_str(), ms(frame.get(metrics::NGS_TICK_TIME)));
+    ImGui::PopFont();
+    ImGui::EndChild();
+    ImGui::PopStyleVar();
+    ImGui::PopStyleColor();
+}
+
 void draw_perf_overlay(GuiState &gui, EmuEnvState &emuenv) {
     auto lang = gui.lang.performance_overlay;
     const auto MAIN_WINDOW_SIZE = ImVec2((emuenv.cfg.performance_overlay_detail == MINIMUM ? 95.5f : 152.f) * emuenv.dpi_scale, get_perf_height(emuenv) * emuenv.dpi_scale);
@@ -85,6 +112,7 @@ void draw_perf_overlay(GuiState &gui, EmuEnvState &emuenv) {
     if (emuenv.cfg.performance_overlay_detail == PerfomanceOverleyDetail::MAXIMUM) {
         ImGui::SetCursorPosY(ImGui::GetCursorPosY() - (5.f * emuenv.dpi_scale));
         ImGui::PlotLines("##fps_graphic", emuenv.fps_values, IM_ARRAYSIZE(emuenv.fps_values), emuenv.current_fps_offset, nullptr, 0.f, float(emuenv.max_fps), WINDOW_SIZE);
+        draw_perf_metrics(gui, emuenv);
     }
     ImGui::End();
     ImGui::PopStyleVar();
@@ -31,6 +31,7 @@
 #include <packages/functions.h>
 #include <packages/pkg.h>
 #include <packages/sfo.h>
+#include <renderer/capture.h>
 
 #include <modules/module_parent.h>
 #include <string>
@@ -38,7 +39,9 @@
 #include <touch/touch.h>
 #include <util/find.h>
 #include <util/log.h>
+#include <util/metrics.h>
 #include <util/string_utils.h>
+#include <util/trace.h>
 
 #include <gui/imgui_impl_sdl.h>
 
@@ -226,6 +229,8 @@ bool install_archive_content(EmuEnvState &emuenv, GuiState *gui, const fs::path
     if (!copy_path(output_path, emuenv.pref_path, emuenv.app_info.app_title_id, emuenv.app_info.app_category))
         return false;
 
+    index_installed_content(emuenv.io, emuenv.pref_path, emuenv.app_info.app_title_id, emuenv.app_info.app_category);
+
     update_progress();
 
     LOG_INFO("{} [{}] installed succesfully!", emuenv.app_info.app_title, emuenv.app_info.app_title_id);
@@ -380,6 +385,8 @@ static bool install_content(EmuEnvState &emuenv, GuiState *gui, const fs::path &
     if (!copy_path(dst_path, emuenv.pref_path, emuenv.app_info.app_title_id, emuenv.app_info.app_category))
         return false;
 
+    index_installed_content(emuenv.io, emuenv.pref_path, emuenv.app_info.app_title_id, emuenv.app_info.app_category);
+
     LOG_INFO("{} [{}] installed succesfully!", emuenv.app_info.app_title, emuenv.app_info.app_title_id);
 
     if ((emuenv.app_info.app_category.find("gd") != std::string::npos) || (emuenv.app_info.app_category.find("gp") != std::string::npos)) {
@@ -413,31 +420,40 @@ uint32_t install_contents(EmuEnvState &emuenv, GuiState *gui, const fs::path &pa
 }
 
 static auto pre_load_module(EmuEnvState &emuenv, const std::vector<std::string> &lib_load_list, const VitaIoDevice &device) {
+    // the files stay mapped until the modules are loaded
+    std::vector<MappedFile> module_files;
+    std::vector<SelfToLoad> modules;
+    bool all_present = true;
     for (const auto &module_path : lib_load_list) {
-        vfs::FileBuffer module_buffer;
-        Ptr<const void> lib_entry_point;
+        MappedFile module_file;
         bool res;
         const auto MODULE_PATH_ABS = fmt::format("{}:{}", device._to_string(), module_path);
 
         if (device == VitaIoDevice::app0)
-            res = vfs::read_app_file(module_buffer, emuenv.pref_path, emuenv.io.app_path, module_path);
+            res = vfs::map_app_file(module_file, emuenv.pref_path, emuenv.io.app_path, module_path);
         else
-            res = vfs::read_file(device, module_buffer, emuenv.pref_path, module_path);
-
-        if (res) {
-            SceUID module_id = load_self(lib_entry_point, emuenv.kernel, emuenv.mem, module_buffer.data(), MODULE_PATH_ABS);
-            if (module_id >= 0) {
-                const auto module = emuenv.kernel.loaded_modules[module_id];
+            res = vfs::map_file(device, module_file, emuenv.pref_path, module_path);
 
-                LOG_INFO("Pre-load module {} (at \"{}\") loaded", module->module_name, module_path);
-            } else
-                return FileNotFound;
-        } else {
+        if (!res || module_file.size() == 0) {
             LOG_DEBUG("Pre-load module at \"{}\" not present", module_path);
-            return FileNotFound;
+            all_present = false;
+            break;
         }
+
+        modules.push_back({ module_file.data(), MODULE_PATH_ABS });
+        module_files.push_back(std::move(module_file));
+    }
+
+    const auto loaded = load_selfs(modules, emuenv.kernel, emuenv.mem);
+    for (size_t i = 0; i < loaded; i++) {
+        const auto module = emuenv.kernel.loaded_modules[modules[i].uid];
+
+        LOG_INFO("Pre-load module {} (at \"{}\") loaded", module->module_name, lib_load_list[i]);
     }
 
+    if (!all_present || loaded < modules.size())
+        return FileNotFound;
+
     return Success;
 }
 
@@ -448,11 +464,27 @@ static ExitCode load_app_impl(Ptr<const void> &entry_point, EmuEnvState &emuenv,
     const auto call_import = [&emuenv](CPUState &cpu, uint32_t nid, SceUID thread_id) {
         ::call_import(emuenv, cpu, nid, thread_id);
     };
-    if (!emuenv.kernel.init(emuenv.mem, call_import, emuenv.kernel.cpu_backend, emuenv.kernel.cpu_opt)) {
+    const ClockMode clock_mode = get_clock_mode(emuenv.cfg.clock_mode);
+    if (!emuenv.kernel.init(emuenv.mem, call_import, emuenv.kernel.cpu_backend, emuenv.kernel.cpu_opt, clock_mode, emuenv.cfg.clock_scale)) {
         LOG_WARN("Failed to init kernel!");
         return KernelInitFailed;
     }
 
+    if (!emuenv.cfg.trace_path.empty())
+        trace::start(emuenv.cfg.trace_path);
+
+    // the contexts are created by the app, so the capture must start before it runs
+    if (!emuenv.cfg.gxm_capture_path.empty())
+        renderer::capture::start(emuenv.cfg.gxm_capture_path, emuenv.cfg.gxm_capture_frames);
+
+    if (emuenv.cfg.metrics_dump_interval > 0) {
+        const metrics::DumpFormat format = metrics::get_dump_format(string_utils::toupper(emuenv.cfg.metrics_dump_format));
+        const fs::path log_directory{ emuenv.base_path + "/logs" };
+        fs::create_directory(log_directory);
+        const auto metrics_path{ log_directory / fmt::format("{}-metrics.{}", emuenv.io.title_id, format == metrics::DumpFormat::JSON ? "json" : "csv") };
+        metrics::start_dump(metrics_path, format, emuenv.cfg.metrics_dump_interval);
+    }
+
     if (emuenv.cfg.archive_log) {
         const fs::path log_directory{ emuenv.base_path + "/logs" };
         fs::create_directory(log_directory);
@@ -465,6 +497,8 @@ static ExitCode load_app_impl(Ptr<const void> &entry_point, EmuEnvState &emuenv,
     LOG_INFO("{}: {}", emuenv.cfg[e_cpu_backend], emuenv.cfg.current_config.cpu_backend);
     LOG_INFO_IF(emuenv.kernel.cpu_backend == CPUBackend::Dynarmic, "CPU Optimisation state: {}", emuenv.cfg.current_config.cpu_opt);
     LOG_INFO("ngs state: {}", emuenv.cfg.current_config.ngs_enable);
+    LOG_INFO("{}: {}", emuenv.cfg[e_clock_mode], get_clock_mode_name(emuenv.kernel.clock.get_mode()));
+    LOG_INFO_IF(emuenv.kernel.clock.get_mode() == ClockMode::SCALED, "{}: {}", emuenv.cfg[e_clock_scale], emuenv.cfg.clock_scale);
     LOG_INFO("Resolution multiplier: {}", emuenv.cfg.resolution_multiplier);
     refresh_controllers(emuenv.ctrl);
     if (emuenv.ctrl.controllers_num) {
@@ -532,9 +566,9 @@ static ExitCode load_app_impl(Ptr<const void> &entry_point, EmuEnvState &emuenv,
 
     // Load main executable
     emuenv.self_path = !emuenv.cfg.self_path.empty() ? emuenv.cfg.self_path : EBOOT_PATH;
-    vfs::FileBuffer eboot_buffer;
-    if (vfs::read_app_file(eboot_buffer, emuenv.pref_path, emuenv.io.app_path, emuenv.self_path)) {
-        SceUID module_id = load_self(entry_point, emuenv.kernel, emuenv.mem, eboot_buffer.data(), "app0:" + emuenv.self_path);
+    MappedFile eboot_file;
+    if (vfs::map_app_file(eboot_file, emuenv.pref_path, emuenv.io.app_path, emuenv.self_path)) {
+        SceUID module_id = load_self(entry_point, emuenv.kernel, emuenv.mem, eboot_file.data(), "app0:" + emuenv.self_path);
         if (module_id >= 0) {
             const auto module = emuenv.kernel.loaded_modules[module_id];
 
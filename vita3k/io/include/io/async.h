@@ -0,0 +1,105 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/types.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+// Runs the asynchronous I/O operations on a few host threads.
+// Operations with the same key (usually the fd) are run one at a time in submission order,
+// the other ones are picked by priority (lower value first) then submission order.
+class AsyncIoEngine {
+public:
+    using Operation = std::function<SceInt64()>;
+    using Completion = std::function<void(SceInt64)>;
+
+    // Operations submitted with this key are not ordered with the other operations
+    static constexpr SceUID NO_KEY = -1;
+
+    enum class CancelResult {
+        Canceled,
+        // the operation is being run and can't be stopped
+        Running,
+        // the operation is unknown or already done
+        NotFound,
+    };
+
+    AsyncIoEngine() = default;
+    ~AsyncIoEngine();
+
+    AsyncIoEngine(const AsyncIoEngine &) = delete;
+    AsyncIoEngine &operator=(const AsyncIoEngine &) = delete;
+
+    // Queue an operation, on_complete is called from a worker thread with the result of the operation
+    void submit(SceUID op_id, SceUID key, int priority, Operation operation, Completion on_complete);
+    // Record an operation that has already been done by the caller
+    void complete(SceUID op_id, SceInt64 result);
+    // Remove an operation that has not been started yet, on_complete is then called with result
+    CancelResult cancel(SceUID op_id, SceInt64 result);
+    // Block until the operation is done, return false if the operation is unknown
+    bool wait(SceUID op_id, SceInt64 &result);
+    // Forget a finished operation, return false if it is unknown or still running.
+    // Finished operations are kept until then, like the kernel event the guest deletes at the same time.
+    bool release(SceUID op_id);
+
+    // Stop the workers, the operations not started yet are dropped
+    void stop();
+
+private:
+    struct Request {
+        SceUID op_id;
+        SceUID key;
+        int priority;
+        std::uint64_t order;
+        Operation operation;
+        Completion on_complete;
+    };
+
+    struct OpStatus {
+        bool done = false;
+        SceInt64 result = 0;
+    };
+
+    void worker_loop();
+    // Called with the mutex locked
+    void mark_done(SceUID op_id, SceInt64 result);
+    // Index in pending of the next request that can be run, or -1 if none
+    int find_next_request() const;
+
+    std::mutex mutex;
+    std::condition_variable request_cond;
+    std::condition_variable done_cond;
+
+    // sorted by submission order
+    std::vector<Request> pending;
+    // keys of the requests being run
+    std::set<SceUID> running_keys;
+    std::map<SceUID, OpStatus> ops;
+
+    std::vector<std::thread> workers;
+    std::uint64_t next_order = 0;
+    bool exiting = false;
+};
@@ -0,0 +1,202 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/types.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Table of the opened descriptors.
+// The fd is made of a slot index and of the generation of the slot, which changes each time the slot is reused,
+// so a closed fd cannot reach the descriptor that took its slot. The generation wraps after 2^19 - 1 reuses
+// of the same slot, a fd kept that long after being closed can then reach the descriptor using its slot again.
+// Looking up a fd does not take any lock: each slot has an atomic state made of its generation, an open flag
+// and a reference count. The descriptor is destroyed when it is closed and the last reference is released.
+template <typename T>
+class FdTable {
+    static constexpr unsigned int SLOT_BITS = 12;
+    static constexpr std::uint32_t SLOT_COUNT = 1 << SLOT_BITS;
+    // the fd must stay positive, generation 0 is skipped so it is never 0 either
+    static constexpr std::uint32_t GENERATION_MASK = (1u << (31 - SLOT_BITS)) - 1;
+
+    static constexpr std::uint64_t OPEN_FLAG = 1ull << 31;
+    static constexpr std::uint64_t REF_MASK = OPEN_FLAG - 1;
+
+    struct Slot {
+        // generation << 32 | open flag | reference count
+        std::atomic<std::uint64_t> state = 0;
+        T *object = nullptr;
+    };
+
+    static std::uint32_t get_generation(std::uint64_t state) {
+        return static_cast<std::uint32_t>(state >> 32);
+    }
+
+public:
+    // Reference to an opened descriptor, the descriptor stays alive as long as the reference exists
+    class Ref {
+    public:
+        Ref() = default;
+        Ref(Ref &&other) noexcept
+            : table(other.table)
+            , slot(std::exchange(other.slot, nullptr)) {}
+        Ref &operator=(Ref &&other) noexcept {
+            std::swap(table, other.table);
+            std::swap(slot, other.slot);
+            return *this;
+        }
+        ~Ref() {
+            if (slot)
+                table->release(*slot);
+        }
+
+        explicit operator bool() const { return slot != nullptr; }
+        T *get() const { return slot ? slot->object : nullptr; }
+        T *operator->() const { return get(); }
+        T &operator*() const { return *get(); }
+
+    private:
+        friend class FdTable;
+
+        Ref(const FdTable *table, Slot *slot)
+            : table(table)
+            , slot(slot) {}
+
+        const FdTable *table = nullptr;
+        Slot *slot = nullptr;
+    };
+
+    FdTable()
+        : slots(std::make_unique<Slot[]>(SLOT_COUNT)) {
+        // start at generation 1 so no fd is 0
+        for (std::uint32_t i = 0; i < SLOT_COUNT; i++)
+            slots[i].state.store(1ull << 32, std::memory_order_relaxed);
+    }
+
+    ~FdTable() {
+        for (std::uint32_t i = 0; i < SLOT_COUNT; i++)
+            delete slots[i].object;
+    }
+
+    FdTable(const FdTable &) = delete;
+    FdTable &operator=(const FdTable &) = delete;
+
+    // Create a descriptor and return its fd, or -1 if all the slots are used
+    template <typename... Args>
+    SceUID emplace(Args &&...args) {
+        std::uint32_t index;
+        {
+            const std::lock_guard<std::mutex> lock(free_mutex);
+            if (!free_slots.empty()) {
+                index = free_slots.back();
+                free_slots.pop_back();
+            } else if (next_unused_slot < SLOT_COUNT) {
+                index = next_unused_slot++;
+            } else {
+                return -1;
+            }
+        }
+
+        Slot &slot = slots[index];
+        slot.object = new T(std::forward<Args>(args)...);
+
+        const std::uint32_t generation = get_generation(slot.state.load(std::memory_order_relaxed));
+        // publish the object
+        slot.state.store((static_cast<std::uint64_t>(generation) << 32) | OPEN_FLAG, std::memory_order_release);
+
+        return static_cast<SceUID>(((generation & GENERATION_MASK) << SLOT_BITS) | index);
+    }
+
+    Ref find(SceUID fd) const {
+        Slot *slot = get_slot(fd);
+        if (!slot)
+            return Ref();
+
+        std::uint64_t state = slot->state.load(std::memory_order_acquire);
+        while (true) {
+            if (!is_open_with_generation(state, fd))
+                return Ref();
+            if (slot->state.compare_exchange_weak(state, state + 1, std::memory_order_acquire))
+                return Ref(this, slot);
+        }
+    }
+
+    // Close the descriptor, it is destroyed once the references to it are released
+    bool erase(SceUID fd) {
+        Slot *slot = get_slot(fd);
+        if (!slot)
+            return false;
+
+        std::uint64_t state = slot->state.load(std::memory_order_acquire);
+        while (true) {
+            if (!is_open_with_generation(state, fd))
+                return false;
+            if (slot->state.compare_exchange_weak(state, state & ~OPEN_FLAG, std::memory_order_acq_rel))
+                break;
+        }
+
+        // nobody can take a new reference now, if there was none the slot can be freed
+        if ((state & REF_MASK) == 0)
+            free_slot(*slot);
+
+        return true;
+    }
+
+private:
+    Slot *get_slot(SceUID fd) const {
+        if (fd < 0)
+            return nullptr;
+        return &slots[static_cast<std::uint32_t>(fd) & (SLOT_COUNT - 1)];
+    }
+
+    static bool is_open_with_generation(std::uint64_t state, SceUID fd) {
+        const std::uint32_t fd_generation = static_cast<std::uint32_t>(fd) >> SLOT_BITS;
+        return (state & OPEN_FLAG) && (get_generation(state) & GENERATION_MASK) == fd_generation;
+    }
+
+    void release(Slot &slot) const {
+        const std::uint64_t previous = slot.state.fetch_sub(1, std::memory_order_acq_rel);
+        // last reference of a closed descriptor
+        if ((previous & REF_MASK) == 1 && !(previous & OPEN_FLAG))
+            free_slot(slot);
+    }
+
+    void free_slot(Slot &slot) const {
+        delete slot.object;
+        slot.object = nullptr;
+
+        std::uint32_t generation = get_generation(slot.state.load(std::memory_order_relaxed)) + 1;
+        if (generation > GENERATION_MASK)
+            generation = 1;
+        slot.state.store(static_cast<std::uint64_t>(generation) << 32, std::memory_order_release);
+
+        const std::lock_guard<std::mutex> lock(free_mutex);
+        free_slots.push_back(static_cast<std::uint32_t>(&slot - slots.get()));
+    }
+
+    std::unique_ptr<Slot[]> slots;
+
+    mutable std::mutex free_mutex;
+    mutable std::vector<std::uint32_t> free_slots;
+    std::uint32_t next_unused_slot = 0;
+};
@@ -17,7 +17,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 
 #include <util/fs.h>
 
@@ -27,18 +29,45 @@
 
 #include <dirent.h>
 
-typedef std::shared_ptr<FILE> FilePtr;
+// Host file accessed through its raw descriptor, without stdio buffering.
+// All the accesses are positional so they can be done from several threads,
+// the current position of the emulated file is kept here and protected by position_mutex.
+class HostFile {
+public:
+    // The handle is closed by the destructor
+    explicit HostFile(intptr_t handle)
+        : handle(handle) {}
+    ~HostFile();
 
-// For opening Boost.Filesystem files, Boost returns wide strings for Windows, normal strings for other OS
-// Dirent and FILE only accept and return wide char strings for Windows, and normal for other OS
-#ifdef WIN32
-const wchar_t *translate_open_mode(const int flags);
+    HostFile(const HostFile &) = delete;
+    HostFile &operator=(const HostFile &) = delete;
 
-inline FilePtr create_shared_file(const fs::path &path, const int open_mode) {
-    const auto file = _wfopen(path.generic_path().wstring().c_str(), translate_open_mode(open_mode));
-    return file ? FilePtr(file, std::fclose) : FilePtr();
-}
+    // Return the number of bytes read/written, or the negated host errno if nothing could be
+    int64_t pread(void *data, uint64_t size, int64_t offset) const;
+    int64_t pwrite(const void *data, uint64_t size, int64_t offset) const;
+    int64_t size() const;
+    int truncate(int64_t size) const;
+
+    std::mutex position_mutex;
+    int64_t position = 0;
+
+private:
+    // Copy through a host buffer, used when the host refuses to access the data directly (EFAULT):
+    // guest pages protected by the write tracker then go through the access violation handler
+    int64_t pread_bounced(void *data, uint64_t size, int64_t offset) const;
+    int64_t pwrite_bounced(const void *data, uint64_t size, int64_t offset) const;
+
+    intptr_t handle;
+};
+
+typedef std::shared_ptr<HostFile> FilePtr;
 
+// Open a file with SceIoMode flags, return nullptr on failure
+FilePtr create_shared_file(const fs::path &path, int open_mode);
+
+// For opening Boost.Filesystem files, Boost returns wide strings for Windows, normal strings for other OS
+// Dirent only accept and return wide char strings for Windows, and normal for other OS
+#ifdef WIN32
 typedef std::shared_ptr<_WDIR> DirPtr;
 
 inline DirPtr create_shared_dir(const fs::path &path) {
@@ -53,13 +82,6 @@ inline _wdirent *get_system_dir_ptr(const DirPtr &dir) {
     return _wreaddir(dir.get());
 }
 #else
-const char *translate_open_mode(const int flags);
-
-inline FilePtr create_shared_file(const fs::path &path, const int open_mode) {
-    const auto file = fopen(path.generic_path().string().c_str(), translate_open_mode(open_mode));
-    return file ? FilePtr(file, std::fclose) : FilePtr();
-}
-
 typedef std::shared_ptr<DIR> DirPtr;
 
 inline DirPtr create_shared_dir(const fs::path &path) {
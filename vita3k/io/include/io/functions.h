@@ -27,6 +27,7 @@
 
 #include <util/fs.h>
 
+#include <optional>
 #include <string>
 
 struct IOState;
@@ -37,8 +38,10 @@ void init_device_paths(IOState &io);
 bool init_savedata_app_path(IOState &io, const fs::path &pref_path);
 bool init(IOState &io, const fs::path &base_path, const fs::path &pref_path, bool redirect_stdout);
 
-bool find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &translated_path, const fs::path &system_path);
-fs::path find_in_cache(IOState &io, const std::string &system_path);
+// Return the path of the file matching system_path without taking the case into account, or an empty path
+fs::path find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &translated_path, const fs::path &system_path);
+// Build the case-insensitive path index of an installed app, patch or addcont
+void index_installed_content(IOState &io, const std::wstring &pref_path, const std::string &app_title_id, const std::string &app_category);
 
 std::string expand_path(IOState &io, const char *path, const std::wstring &pref_path);
 std::string translate_path(const char *path, VitaIoDevice &device, const IOState::DevicePaths &device_paths);
@@ -69,12 +72,16 @@ bool copy_path(const fs::path src_path, std::wstring pref_path, std::string app_
 SceUID open_file(IOState &io, const char *path, const int flags, const std::wstring &pref_path, const char *export_name);
 int read_file(void *data, IOState &io, SceUID fd, SceSize size, const char *export_name);
 int write_file(SceUID fd, const void *data, SceSize size, const IOState &io, const char *export_name);
+int pread_file(void *data, IOState &io, SceUID fd, SceSize size, SceOff offset, const char *export_name);
+int pwrite_file(SceUID fd, const void *data, SceSize size, SceOff offset, const IOState &io, const char *export_name);
 int truncate_file(SceUID fd, unsigned long long length, const IOState &io, const char *export_name);
 SceOff seek_file(SceUID fd, SceOff offset, SceIoSeekMode whence, IOState &io, const char *export_name);
 SceOff tell_file(IOState &io, const SceUID fd, const char *export_name);
 int stat_file(IOState &io, const char *file, SceIoStat *statp, const std::wstring &pref_path, const char *export_name, SceUID fd = invalid_fd);
 int stat_file_by_fd(IOState &io, const SceUID fd, SceIoStat *statp, const std::wstring &pref_path, const char *export_name);
 int close_file(IOState &io, SceUID fd, const char *export_name);
+// Copy of the stats of an opened file, it shares the host file so it can be used outside of the fd table
+std::optional<FileStats> get_file_stats(const IOState &io, SceUID fd);
 int remove_file(IOState &io, const char *file, const std::wstring &pref_path, const char *export_name);
 
 SceUID open_dir(IOState &io, const char *path, const std::wstring &pref_path, const char *export_name);
@@ -83,6 +90,17 @@ int create_dir(IOState &io, const char *dir, int mode, const std::wstring &pref_
 int close_dir(IOState &io, SceUID fd, const char *export_name);
 int remove_dir(IOState &io, const char *dir, const std::wstring &pref_path, const char *export_name);
 
+// Priority of the asynchronous operations on fd submitted by thread_id
+int get_io_priority(const IOState &io, SceUID thread_id, SceUID fd);
+int get_fd_io_priority(const IOState &io, SceUID thread_id, SceUID fd, const char *export_name);
+int set_fd_io_priority(IOState &io, SceUID fd, int priority, const char *export_name);
+// Priority used by the operations of thread_id on the fds without their own priority
+int get_thread_default_io_priority(const IOState &io, SceUID thread_id);
+void set_thread_default_io_priority(IOState &io, SceUID thread_id, int priority);
+
 // SceFios functions
 SceUID create_overlay(IOState &io, SceFiosProcessOverlay *fios_overlay);
+bool remove_overlay(IOState &io, SceUID id);
+bool modify_overlay(IOState &io, SceUID id, const SceFiosProcessOverlay *fios_overlay);
+bool get_overlay_info(IOState &io, SceUID id, SceFiosProcessOverlay *fios_overlay);
 std::string resolve_path(IOState &io, const char *input, const bool is_write, const SceUInt32 min_order = 0, const SceUInt32 max_order = 0x7F);
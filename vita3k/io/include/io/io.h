@@ -18,7 +18,18 @@
 #pragma once
 
 constexpr int SCE_ERROR_ERRNO_ENOENT = 0x80010002; // Associated file or directory does not exist
+constexpr int SCE_ERROR_ERRNO_EIO = 0x80010005; // I/O error
+constexpr int SCE_ERROR_ERRNO_EACCES = 0x8001000D; // Permission denied
+constexpr int SCE_ERROR_ERRNO_EFAULT = 0x8001000E; // Bad address
+constexpr int SCE_ERROR_ERRNO_EBUSY = 0x80010010; // Resource is busy
 constexpr int SCE_ERROR_ERRNO_EEXIST = 0x80010011; // File exists
+constexpr int SCE_ERROR_ERRNO_EISDIR = 0x80010015; // Is a directory
+// a macro like in kernel/types.h, which may be included with this file
+#define SCE_ERROR_ERRNO_EINVAL 0x80010016 // Invalid argument
 constexpr int SCE_ERROR_ERRNO_EMFILE = 0x80010018; // Too many files are open
+constexpr int SCE_ERROR_ERRNO_EFBIG = 0x8001001B; // File too large
+constexpr int SCE_ERROR_ERRNO_ENOSPC = 0x8001001C; // No space left on device
+constexpr int SCE_ERROR_ERRNO_EROFS = 0x8001001E; // Read-only file system
 constexpr int SCE_ERROR_ERRNO_EBADFD = 0x80010051; // File descriptor is invalid for this operation
 constexpr int SCE_ERROR_ERRNO_EOPNOTSUPP = 0x8001005F; // Operation not supported
+constexpr int SCE_ERROR_ERRNO_ECANCELED = 0x8001008C; // Operation canceled
@@ -0,0 +1,56 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only view of a whole host file mapped in memory.
+// The file must not be modified or truncated while it is mapped.
+class MappedFile {
+public:
+    // How the mapping is going to be read, used as hint for the kernel
+    enum class Access {
+        Normal,
+        // read once from the start to the end, like a module being loaded
+        Sequential,
+    };
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Return false if the file cannot be opened or mapped, an empty file is valid
+    bool open(const fs::path &path, Access access = Access::Normal);
+    void close();
+
+    bool is_open() const { return opened; }
+    const uint8_t *data() const { return view; }
+    size_t size() const { return view_size; }
+
+private:
+    bool opened = false;
+    const uint8_t *view = nullptr;
+    size_t view_size = 0;
+};
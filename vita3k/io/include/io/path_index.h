@@ -0,0 +1,73 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Index of the files of a directory tree by lowercase path, used to find files on case-sensitive host filesystems.
+// The paths are relative to the root and use '/' as separator.
+// The index can be saved to disk and loaded again: only the directories modified since are scanned again.
+class PathIndex {
+public:
+    explicit PathIndex(const fs::path &root)
+        : root(root) {}
+
+    // Scan the whole tree
+    void build();
+    // Return false if the file is missing, invalid or made for another root
+    bool load(const fs::path &index_file);
+    bool save(const fs::path &index_file) const;
+
+    // Scan again the directories modified since they were indexed, return true if the index changed
+    bool refresh();
+    // Same as refresh, only for the directory which would contain lower_path
+    bool refresh_parent(const std::string &lower_path);
+
+    // Return the real relative path of a lowercase relative path, or nullptr
+    const std::string *find(const std::string &lower_path) const;
+
+    const fs::path &get_root() const { return root; }
+    size_t size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        std::string lower;
+        std::string real;
+        // modification time of a directory, NOT_A_DIRECTORY for files
+        // and UNKNOWN_TIME if the directory may have changed during its scan
+        int64_t mtime;
+    };
+
+    static constexpr int64_t NOT_A_DIRECTORY = INT64_MIN;
+    static constexpr int64_t UNKNOWN_TIME = -1;
+
+    // Add the content of a directory and of its subdirectories
+    void scan(const std::string &real_dir, int64_t scan_start, std::vector<Entry> &result) const;
+    // Replace the content of the given directories, which must not be inside each other
+    void rescan(const std::vector<std::string> &real_dirs);
+    bool is_stale(const Entry &entry) const;
+    void sort();
+
+    fs::path root;
+    // sorted by lowercase path, the root directory is the entry with an empty path
+    std::vector<Entry> entries;
+};
@@ -17,17 +17,29 @@
 
 #pragma once
 
+#include <io/VitaIoDevice.h>
+#include <io/async.h>
+#include <io/fd_table.h>
 #include <io/filesystem.h>
+#include <io/mapped_file.h>
+#include <io/path_index.h>
 #include <io/types.h>
 #include <io/util.h>
 
+#include <atomic>
 #include <map>
+#include <mutex>
+#include <set>
 #include <unordered_map>
+#include <utility>
+#include <variant>
 
 // Class for all needed information to access files on Vita3K.
 class FileStats : public VitaStats {
     // Shared file pointer
     FilePtr wrapped_file;
+    // Mapping of the file used for the reads, only for read-only files
+    std::shared_ptr<const MappedFile> mapped_file;
 
 public:
     // Constructor used for files
@@ -55,14 +67,15 @@ public:
         return can_write(file_info.open_mode);
     }
 
-    // File operations
-    FILE *get_file_pointer() const {
-        return wrapped_file.get();
-    }
+    // Read the file from a mapping instead of the host file if it is read-only and at least min_size bytes long
+    bool map_read_only(size_t min_size);
 
-    // File functions
+    // File functions, read/write/seek/tell use the file position and can be called from several threads
     SceOff read(void *input_data, int element_size, SceSize element_count) const;
     SceOff write(const void *data, SceSize size, int count) const;
+    // Positional read/write, the file offset is left untouched
+    SceOff pread(void *data, SceSize size, SceOff offset) const;
+    SceOff pwrite(const void *data, SceSize size, SceOff offset) const;
     int truncate(const SceSize size) const;
     bool seek(SceOff offset, SceIoSeekMode seek_mode) const;
     SceOff tell() const;
@@ -94,9 +107,30 @@ public:
     }
 };
 
-typedef std::map<SceUID, TtyType> TtyFiles;
-typedef std::map<SceUID, FileStats> StdFiles;
-typedef std::map<SceUID, DirStats> DirEntries;
+// Opened tty, file or directory
+struct IoDescriptor {
+    template <typename T>
+    explicit IoDescriptor(T &&object)
+        : object(std::forward<T>(object)) {}
+
+    std::variant<TtyType, FileStats, DirStats> object;
+    // serializes the directory reads
+    std::mutex mutex;
+    // 0 if the priority was never set
+    std::atomic<int> priority = 0;
+
+    FileStats *get_file() {
+        return std::get_if<FileStats>(&object);
+    }
+    DirStats *get_dir() {
+        return std::get_if<DirStats>(&object);
+    }
+    TtyType *get_tty() {
+        return std::get_if<TtyType>(&object);
+    }
+};
+
+typedef FdTable<IoDescriptor> IoDescriptors;
 
 struct IOState {
     struct DevicePaths {
@@ -115,16 +149,32 @@ struct IOState {
 
     bool redirect_stdio;
 
-    SceUID next_fd = 0;
-    TtyFiles tty_files;
-    StdFiles std_files;
-    DirEntries dir_entries;
+    // tty, files and directories opened by the application
+    IoDescriptors fds;
 
-    std::unordered_map<std::string, std::string> cachemap;
     bool case_isens_find_enabled = false;
+    // case-insensitive indexes of the app and addcont directories, by root path
+    std::mutex path_index_mutex;
+    std::map<std::string, PathIndex> path_indexes;
+    // where the indexes are saved
+    fs::path path_index_dir;
+
+    // results of translate_path, cleared when the device paths change
+    std::mutex translated_path_mutex;
+    std::unordered_map<std::string, std::pair<VitaIoDevice, std::string>> translated_path_cache;
 
     std::mutex overlay_mutex;
     SceUID next_overlay_id = 1;
     // overlay in the order they should be applied
     std::vector<FiosOverlay> overlays;
+    // results of resolve_path, cleared when the overlays change
+    std::unordered_map<std::string, std::string> overlay_resolve_cache;
+    // threads which called sceFiosOverlayThreadSetDisabled02
+    std::set<SceUID> overlay_disabled_threads;
+
+    AsyncIoEngine async_io;
+    std::atomic<int> process_default_priority = SCE_IO_PRIORITY_DEFAULT;
+    // set and read by any guest thread, use the functions of io/functions.h
+    mutable std::mutex thread_default_priorities_mutex;
+    std::map<SceUID, int> thread_default_priorities;
 };
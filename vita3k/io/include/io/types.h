@@ -98,6 +98,23 @@ inline std::string to_debug_str<SceIoSeekMode>(const MemState &mem, SceIoSeekMod
     return std::to_string(type);
 }
 
+// Priorities of the asynchronous operations, a lower value is served first
+enum SceIoPriority {
+    SCE_IO_PRIORITY_HIGHEST = 1,
+    SCE_IO_PRIORITY_DEFAULT = 14,
+    SCE_IO_PRIORITY_LOWEST = 15
+};
+
+// Filled when an asynchronous operation completes
+struct SceIoAsyncParam {
+    SceInt32 result; //!< Result of the operation (fd, read/written size or error code)
+    SceInt32 unk_04;
+    SceInt32 unk_08;
+    SceInt32 unk_0C;
+    SceInt32 unk_10;
+    SceInt32 unk_14;
+};
+
 struct SceIoStat {
     SceMode st_mode; //!< One or more ::SceIoAccessMode
     unsigned int st_attr; //!< One or more ::SceIoFileMode
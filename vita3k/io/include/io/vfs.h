@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <io/mapped_file.h>
 #include <util/fs.h>
 #include <util/types.h>
 
@@ -34,5 +35,8 @@ using FileBuffer = std::vector<SceUInt8>;
 
 bool read_file(VitaIoDevice device, FileBuffer &buf, const std::wstring &pref_path, const fs::path &vfs_file_path);
 bool read_app_file(FileBuffer &buf, const std::wstring &pref_path, const std::string &app_path, const fs::path &vfs_file_path);
+// Same as read_file/read_app_file without copying the file, for large read-only files such as modules
+bool map_file(VitaIoDevice device, MappedFile &file, const std::wstring &pref_path, const fs::path &vfs_file_path, MappedFile::Access access = MappedFile::Access::Sequential);
+bool map_app_file(MappedFile &file, const std::wstring &pref_path, const std::string &app_path, const fs::path &vfs_file_path, MappedFile::Access access = MappedFile::Access::Sequential);
 SpaceInfo get_space_info(const VitaIoDevice device, const std::string &vfs_path, const std::wstring &pref_path);
 } // namespace vfs
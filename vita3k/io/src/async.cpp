@@ -0,0 +1,173 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/async.h>
+
+#include <algorithm>
+
+// Workers are only started when the first operation is submitted, most apps never use async I/O
+static constexpr unsigned int NB_ASYNC_IO_WORKERS = 2;
+
+AsyncIoEngine::~AsyncIoEngine() {
+    stop();
+}
+
+void AsyncIoEngine::submit(SceUID op_id, SceUID key, int priority, Operation operation, Completion on_complete) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (exiting)
+            return;
+
+        if (workers.empty()) {
+            for (unsigned int i = 0; i < NB_ASYNC_IO_WORKERS; i++)
+                workers.emplace_back(&AsyncIoEngine::worker_loop, this);
+        }
+
+        ops[op_id] = {};
+        pending.push_back({ op_id, key, priority, next_order++, std::move(operation), std::move(on_complete) });
+    }
+    request_cond.notify_one();
+}
+
+void AsyncIoEngine::complete(SceUID op_id, SceInt64 result) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    mark_done(op_id, result);
+}
+
+AsyncIoEngine::CancelResult AsyncIoEngine::cancel(SceUID op_id, SceInt64 result) {
+    Completion on_complete;
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        const auto it = std::find_if(pending.begin(), pending.end(), [&](const Request &request) { return request.op_id == op_id; });
+        if (it == pending.end()) {
+            const auto op = ops.find(op_id);
+            return (op != ops.end() && !op->second.done) ? CancelResult::Running : CancelResult::NotFound;
+        }
+
+        on_complete = std::move(it->on_complete);
+        pending.erase(it);
+    }
+
+    on_complete(result);
+
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        mark_done(op_id, result);
+    }
+    done_cond.notify_all();
+    // removing a request may allow the next one with the same key to run
+    request_cond.notify_all();
+
+    return CancelResult::Canceled;
+}
+
+bool AsyncIoEngine::wait(SceUID op_id, SceInt64 &result) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = ops.find(op_id);
+    if (it == ops.end())
+        return false;
+
+    done_cond.wait(lock, [&]() {
+        it = ops.find(op_id);
+        return it == ops.end() || it->second.done || exiting;
+    });
+    if (it == ops.end() || !it->second.done)
+        return false;
+
+    result = it->second.result;
+    return true;
+}
+
+bool AsyncIoEngine::release(SceUID op_id) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    const auto it = ops.find(op_id);
+    if (it == ops.end() || !it->second.done)
+        return false;
+
+    ops.erase(it);
+    return true;
+}
+
+void AsyncIoEngine::stop() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        exiting = true;
+        pending.clear();
+    }
+    request_cond.notify_all();
+    done_cond.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+int AsyncIoEngine::find_next_request() const {
+    // only the oldest pending request of each key can be run, and only if no request with this key is running
+    std::set<SceUID> seen_keys;
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(pending.size()); i++) {
+        const Request &request = pending[i];
+        if (request.key != NO_KEY) {
+            if (!seen_keys.insert(request.key).second || running_keys.contains(request.key))
+                continue;
+        }
+
+        // pending is sorted by submission order so only the priority needs to be compared
+        if (best == -1 || request.priority < pending[best].priority)
+            best = i;
+    }
+
+    return best;
+}
+
+void AsyncIoEngine::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        int index = -1;
+        request_cond.wait(lock, [&]() {
+            if (exiting)
+                return true;
+            index = find_next_request();
+            return index != -1;
+        });
+        if (exiting)
+            return;
+
+        Request request = std::move(pending[index]);
+        pending.erase(pending.begin() + index);
+        if (request.key != NO_KEY)
+            running_keys.insert(request.key);
+        lock.unlock();
+
+        const SceInt64 result = request.operation();
+        request.on_complete(result);
+
+        lock.lock();
+        if (request.key != NO_KEY) {
+            running_keys.erase(request.key);
+            // the next request with this key can now be run
+            request_cond.notify_one();
+        }
+        mark_done(request.op_id, result);
+        done_cond.notify_all();
+    }
+}
+
+void AsyncIoEngine::mark_done(SceUID op_id, SceInt64 result) {
+    ops[op_id] = { true, result };
+}
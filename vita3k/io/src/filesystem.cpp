@@ -18,37 +18,216 @@
 #include <io/filesystem.h>
 #include <io/util.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
 #ifdef WIN32
-// To open wide files for Boost.Filesystem, we also need the appropriate wide mode flags for Windows, and normal flags for other OS
-const wchar_t *translate_open_mode(const int flags) {
+#include <Windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr uint64_t BOUNCE_BUFFER_SIZE = 256 * 1024;
+
+// Appending is done by FileStats, which knows the position of the emulated file
+static int translate_open_mode(const int flags) {
     if (flags & SCE_O_WRONLY) {
-        if (flags & SCE_O_RDONLY) {
-            if (flags & SCE_O_APPEND) {
-                return L"ab+";
+        if (!(flags & SCE_O_RDONLY) && (flags & SCE_O_APPEND))
+            return O_WRONLY;
+
+        // write-only files used to be opened with rb+ too
+        return O_RDWR;
+    }
+    return O_RDONLY;
+}
+
+int64_t HostFile::pread_bounced(void *data, const uint64_t size, const int64_t offset) const {
+    std::vector<uint8_t> buffer(std::min(size, BOUNCE_BUFFER_SIZE));
+    uint64_t total = 0;
+    while (total < size) {
+        const int64_t read = pread(buffer.data(), std::min<uint64_t>(size - total, buffer.size()), offset + total);
+        if (read < 0)
+            return total ? static_cast<int64_t>(total) : read;
+        if (read == 0)
+            break;
+        memcpy(static_cast<uint8_t *>(data) + total, buffer.data(), read);
+        total += read;
+    }
+    return static_cast<int64_t>(total);
+}
+
+int64_t HostFile::pwrite_bounced(const void *data, const uint64_t size, const int64_t offset) const {
+    std::vector<uint8_t> buffer(std::min(size, BOUNCE_BUFFER_SIZE));
+    uint64_t total = 0;
+    while (total < size) {
+        const uint64_t to_write = std::min<uint64_t>(size - total, buffer.size());
+        memcpy(buffer.data(), static_cast<const uint8_t *>(data) + total, to_write);
+        const int64_t written = pwrite(buffer.data(), to_write, offset + total);
+        if (written < 0)
+            return total ? static_cast<int64_t>(total) : written;
+        total += written;
+        if (static_cast<uint64_t>(written) < to_write)
+            break;
+    }
+    return static_cast<int64_t>(total);
+}
+
+#ifdef WIN32
+// errno equivalent of the last error of ReadFile/WriteFile
+static int get_last_errno() {
+    switch (GetLastError()) {
+    case ERROR_NOACCESS: return EFAULT;
+    case ERROR_ACCESS_DENIED: return EACCES;
+    case ERROR_DISK_FULL:
+    case ERROR_HANDLE_DISK_FULL: return ENOSPC;
+    case ERROR_INVALID_PARAMETER: return EINVAL;
+    default: return EIO;
+    }
+}
+
+FilePtr create_shared_file(const fs::path &path, const int open_mode) {
+    int fd;
+    if (_wsopen_s(&fd, path.generic_path().wstring().c_str(), translate_open_mode(open_mode) | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0)
+        return FilePtr();
+
+    return std::make_shared<HostFile>(fd);
+}
+
+HostFile::~HostFile() {
+    _close(static_cast<int>(handle));
+}
+
+// The handle file pointer is moved by ReadFile/WriteFile, which does not matter as HostFile does not use it
+int64_t HostFile::pread(void *data, const uint64_t size, const int64_t offset) const {
+    const HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(static_cast<int>(handle)));
+    uint64_t total = 0;
+    while (total < size) {
+        OVERLAPPED overlapped = {};
+        const uint64_t position = offset + total;
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+        DWORD read = 0;
+        const DWORD to_read = static_cast<DWORD>(std::min<uint64_t>(size - total, 0x80000000ull));
+        if (!ReadFile(file, static_cast<uint8_t *>(data) + total, to_read, &read, &overlapped)) {
+            if (GetLastError() == ERROR_HANDLE_EOF)
+                break;
+            const int error = get_last_errno();
+            if (error == EFAULT) {
+                const int64_t bounced = pread_bounced(static_cast<uint8_t *>(data) + total, size - total, offset + total);
+                return (bounced < 0 && total) ? static_cast<int64_t>(total) : static_cast<int64_t>(total) + bounced;
             }
-            return L"rb+";
+            return total ? static_cast<int64_t>(total) : -error;
         }
-        if (flags & SCE_O_APPEND) {
-            return L"ab";
+        if (read == 0)
+            break;
+        total += read;
+    }
+    return static_cast<int64_t>(total);
+}
+
+int64_t HostFile::pwrite(const void *data, const uint64_t size, const int64_t offset) const {
+    const HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(static_cast<int>(handle)));
+    uint64_t total = 0;
+    while (total < size) {
+        OVERLAPPED overlapped = {};
+        const uint64_t position = offset + total;
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+        DWORD written = 0;
+        const DWORD to_write = static_cast<DWORD>(std::min<uint64_t>(size - total, 0x80000000ull));
+        if (!WriteFile(file, static_cast<const uint8_t *>(data) + total, to_write, &written, &overlapped)) {
+            const int error = get_last_errno();
+            if (error == EFAULT) {
+                const int64_t bounced = pwrite_bounced(static_cast<const uint8_t *>(data) + total, size - total, offset + total);
+                return (bounced < 0 && total) ? static_cast<int64_t>(total) : static_cast<int64_t>(total) + bounced;
+            }
+            return total ? static_cast<int64_t>(total) : -error;
         }
-        return L"rb+";
+        if (written == 0)
+            break;
+        total += written;
     }
-    return L"rb";
+    return static_cast<int64_t>(total);
+}
+
+int64_t HostFile::size() const {
+    struct _stati64 sb;
+    if (_fstati64(static_cast<int>(handle), &sb) < 0)
+        return -1;
+    return sb.st_size;
+}
+
+int HostFile::truncate(const int64_t size) const {
+    return _chsize_s(static_cast<int>(handle), size);
 }
 #else
-const char *translate_open_mode(const int flags) {
-    if (flags & SCE_O_WRONLY) {
-        if (flags & SCE_O_RDONLY) {
-            if (flags & SCE_O_APPEND) {
-                return "ab+";
-            }
-            return "rb+";
+FilePtr create_shared_file(const fs::path &path, const int open_mode) {
+    const int fd = ::open(path.generic_path().string().c_str(), translate_open_mode(open_mode) | O_CLOEXEC);
+    if (fd < 0)
+        return FilePtr();
+
+    return std::make_shared<HostFile>(fd);
+}
+
+HostFile::~HostFile() {
+    ::close(static_cast<int>(handle));
+}
+
+int64_t HostFile::pread(void *data, const uint64_t size, const int64_t offset) const {
+    uint64_t total = 0;
+    while (total < size) {
+        const ssize_t read = ::pread(static_cast<int>(handle), static_cast<uint8_t *>(data) + total, size - total, offset + total);
+        if (read < 0 && errno == EINTR)
+            continue;
+        if (read < 0 && errno == EFAULT) {
+            const int64_t bounced = pread_bounced(static_cast<uint8_t *>(data) + total, size - total, offset + total);
+            return (bounced < 0 && total) ? static_cast<int64_t>(total) : static_cast<int64_t>(total) + bounced;
         }
-        if (flags & SCE_O_APPEND) {
-            return "ab";
+        if (read < 0)
+            return total ? static_cast<int64_t>(total) : -errno;
+        if (read == 0)
+            break;
+        total += read;
+    }
+    return static_cast<int64_t>(total);
+}
+
+int64_t HostFile::pwrite(const void *data, const uint64_t size, const int64_t offset) const {
+    uint64_t total = 0;
+    while (total < size) {
+        const ssize_t written = ::pwrite(static_cast<int>(handle), static_cast<const uint8_t *>(data) + total, size - total, offset + total);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0 && errno == EFAULT) {
+            const int64_t bounced = pwrite_bounced(static_cast<const uint8_t *>(data) + total, size - total, offset + total);
+            return (bounced < 0 && total) ? static_cast<int64_t>(total) : static_cast<int64_t>(total) + bounced;
         }
-        return "rb+";
+        if (written < 0)
+            return total ? static_cast<int64_t>(total) : -errno;
+        if (written == 0)
+            break;
+        total += written;
     }
-    return "rb";
+    return static_cast<int64_t>(total);
+}
+
+int64_t HostFile::size() const {
+    struct stat sb;
+    if (fstat(static_cast<int>(handle), &sb) < 0)
+        return -1;
+    return sb.st_size;
+}
+
+int HostFile::truncate(const int64_t size) const {
+    return ftruncate(static_cast<int>(handle), size);
 }
 #endif
@@ -36,9 +36,9 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
-#include <iterator>
 #include <string>
 
 // ****************************
@@ -58,18 +58,29 @@ constexpr bool log_file_read = false;
 constexpr bool log_file_seek = false;
 constexpr bool log_file_stat = false;
 
+// the resolve cache is simply dropped when it reaches this size
+constexpr size_t MAX_OVERLAY_RESOLVE_CACHE_SIZE = 4096;
+constexpr size_t MAX_TRANSLATED_PATH_CACHE_SIZE = 4096;
+// smaller files are read with a syscall, which is cheaper than mapping them
+constexpr size_t MIN_MAPPED_FILE_SIZE = 64 * 1024;
+
 namespace vfs {
 
 bool read_file(const VitaIoDevice device, FileBuffer &buf, const std::wstring &pref_path, const fs::path &vfs_file_path) {
     const auto host_file_path = device::construct_emulated_path(device, vfs_file_path, pref_path).generic_path();
 
-    fs::ifstream f{ host_file_path, fs::ifstream::binary };
+    fs::ifstream f{ host_file_path, fs::ifstream::binary | fs::ifstream::ate };
     if (!f)
         return false;
 
-    f.unsetf(fs::ifstream::skipws);
-    buf.reserve(fs::file_size(host_file_path));
-    buf.insert(buf.begin(), std::istream_iterator<uint8_t>(f), std::istream_iterator<uint8_t>());
+    const auto file_size = static_cast<size_t>(f.tellg());
+    f.seekg(0);
+    const auto offset = buf.size();
+    buf.resize(offset + file_size);
+    if (!f.read(reinterpret_cast<char *>(buf.data() + offset), file_size)) {
+        buf.resize(offset);
+        return false;
+    }
     return true;
 }
 
@@ -77,6 +88,15 @@ bool read_app_file(FileBuffer &buf, const std::wstring &pref_path, const std::st
     return read_file(VitaIoDevice::ux0, buf, pref_path, fs::path("app") / app_path / vfs_file_path);
 }
 
+bool map_file(const VitaIoDevice device, MappedFile &file, const std::wstring &pref_path, const fs::path &vfs_file_path, const MappedFile::Access access) {
+    const auto host_file_path = device::construct_emulated_path(device, vfs_file_path, pref_path).generic_path();
+    return file.open(host_file_path, access);
+}
+
+bool map_app_file(MappedFile &file, const std::wstring &pref_path, const std::string &app_path, const fs::path &vfs_file_path, const MappedFile::Access access) {
+    return map_file(VitaIoDevice::ux0, file, pref_path, fs::path("app") / app_path / vfs_file_path, access);
+}
+
 SpaceInfo get_space_info(const VitaIoDevice device, const std::string &vfs_path, const std::wstring &pref_path) {
     SpaceInfo space_info;
     const auto emuenv_path = device::construct_emulated_path(device, vfs_path, pref_path);
@@ -129,6 +149,7 @@ bool init(IOState &io, const fs::path &base_path, const fs::path &pref_path, boo
     fs::create_directory(base_path / "texturelog");
 
     io.redirect_stdio = redirect_stdio;
+    io.path_index_dir = base_path / "cache/path_index";
 
 #ifndef WIN32
     io.case_isens_find_enabled = true;
@@ -141,6 +162,9 @@ void init_device_paths(IOState &io) {
     io.device_paths.savedata0 = "user/" + io.user_id + "/savedata/" + io.savedata;
     io.device_paths.app0 = "app/" + io.app_path;
     io.device_paths.addcont0 = "addcont/" + io.addcont;
+
+    const std::lock_guard<std::mutex> lock(io.translated_path_mutex);
+    io.translated_path_cache.clear();
 }
 
 bool init_savedata_app_path(IOState &io, const fs::path &pref_path) {
@@ -158,43 +182,141 @@ bool init_savedata_app_path(IOState &io, const fs::path &pref_path) {
     return true;
 }
 
-bool find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &translated_path, const fs::path &system_path) {
-    std::string final_path{};
+static std::string get_path_index_key(const fs::path &root) {
+    std::string key = root.generic_path().string();
+    while (key.size() > 1 && key.back() == '/')
+        key.pop_back();
+    return key;
+}
+
+// <pref>/ux0/app/<title id> is saved as app_<title id>.bin
+static fs::path get_path_index_file(const IOState &io, const PathIndex &index) {
+    const fs::path &root = index.get_root();
+    return io.path_index_dir / (root.parent_path().filename().string() + '_' + root.filename().string() + ".bin");
+}
+
+// must be called with the path index mutex locked
+static void save_path_index(const IOState &io, const PathIndex &index) {
+    if (io.path_index_dir.empty())
+        return;
+
+    const auto index_file = get_path_index_file(io, index);
+    if (!index.save(index_file))
+        LOG_WARN("Failed to save the path index of {} to {}", index.get_root().string(), index_file.string());
+}
+
+// must be called with the path index mutex locked
+static PathIndex &get_path_index(IOState &io, const fs::path &root) {
+    const auto key = get_path_index_key(root);
+    const auto existing = io.path_indexes.find(key);
+    if (existing != io.path_indexes.end())
+        return existing->second;
+
+    auto &index = io.path_indexes.emplace(key, PathIndex(key)).first->second;
+    if (!io.path_index_dir.empty() && index.load(get_path_index_file(io, index))) {
+        if (index.refresh())
+            save_path_index(io, index);
+    } else {
+        index.build();
+        save_path_index(io, index);
+        LOG_INFO("Indexed {} paths of {} for case-insensitive search", index.size(), key);
+    }
+
+    return index;
+}
+
+fs::path find_case_isens_path(IOState &io, VitaIoDevice &device, const fs::path &translated_path, const fs::path &system_path) {
+    std::string content_id{};
 
     switch (device) {
     case +VitaIoDevice::app0: {
-        std::string app_id = translated_path.string().substr(0, 14);
-        final_path = system_path.string().substr(0, system_path.string().find(app_id)) + app_id;
+        content_id = translated_path.string().substr(0, 14);
         break;
     }
     case +VitaIoDevice::addcont0: {
-        std::string addcont_id = translated_path.string().substr(0, 18);
-        final_path = system_path.string().substr(0, system_path.string().find(addcont_id)) + addcont_id;
+        content_id = translated_path.string().substr(0, 18);
         break;
     }
     default: {
-        return false;
+        return fs::path{};
     }
     }
 
-    if (!fs::exists(final_path))
-        return false;
+    const auto system_path_string = system_path.string();
+    const auto content_pos = system_path_string.find(content_id);
+    if (content_pos == std::string::npos)
+        return fs::path{};
 
-    for (const auto &file : fs::recursive_directory_iterator(final_path)) {
-        io.cachemap.insert(std::make_pair(string_utils::tolower(file.path().string()), file.path().string()));
+    const auto root = system_path_string.substr(0, content_pos) + content_id;
+    if (!fs::exists(root))
+        return fs::path{};
+
+    auto relative_path = system_path_string.substr(root.size());
+    string_utils::replace(relative_path, "\\", "/");
+    while (!relative_path.empty() && relative_path.front() == '/')
+        relative_path.erase(0, 1);
+    while (!relative_path.empty() && relative_path.back() == '/')
+        relative_path.pop_back();
+    const auto lower_path = string_utils::tolower(relative_path);
+
+    std::string real_path;
+    {
+        const std::lock_guard<std::mutex> lock(io.path_index_mutex);
+        auto &index = get_path_index(io, root);
+        auto found = index.find(lower_path);
+        // the file may have been created since the index was made
+        if (!found && index.refresh_parent(lower_path)) {
+            save_path_index(io, index);
+            found = index.find(lower_path);
+        }
+        if (!found)
+            return fs::path{};
+
+        real_path = *found;
     }
 
-    return true;
+    const fs::path root_path{ get_path_index_key(root) };
+    return real_path.empty() ? root_path : root_path / real_path;
 }
 
-fs::path find_in_cache(IOState &io, const std::string &system_path) {
-    const auto find_path = io.cachemap.find(system_path);
+void index_installed_content(IOState &io, const std::wstring &pref_path, const std::string &app_title_id, const std::string &app_category) {
+    if (!io.case_isens_find_enabled)
+        return;
+
+    fs::path root;
+    if (app_category == "ac")
+        root = fs::path(pref_path) / "ux0/addcont" / app_title_id;
+    else if ((app_category.find("gd") != std::string::npos) || (app_category.find("gp") != std::string::npos))
+        root = fs::path(pref_path) / "ux0/app" / app_title_id;
+    else
+        return;
+
+    if (!fs::exists(root))
+        return;
+
+    const std::lock_guard<std::mutex> lock(io.path_index_mutex);
+    const auto key = get_path_index_key(root);
+    auto &index = io.path_indexes.insert_or_assign(key, PathIndex(key)).first->second;
+    index.build();
+    save_path_index(io, index);
+    LOG_INFO("Indexed {} paths of {} for case-insensitive search", index.size(), key);
+}
 
-    if (find_path != io.cachemap.end()) {
-        return fs::path{ find_path->second.c_str() };
-    } else {
-        return fs::path{};
+// translate_path with a cache, device must be the device of the path
+static std::string translate_path_cached(IOState &io, const char *path, VitaIoDevice &device) {
+    const std::lock_guard<std::mutex> lock(io.translated_path_mutex);
+    const auto cached = io.translated_path_cache.find(path);
+    if (cached != io.translated_path_cache.end()) {
+        device = cached->second.first;
+        return cached->second.second;
     }
+
+    auto translated_path = translate_path(path, device, io.device_paths);
+    if (io.translated_path_cache.size() >= MAX_TRANSLATED_PATH_CACHE_SIZE)
+        io.translated_path_cache.clear();
+    io.translated_path_cache.emplace(path, std::make_pair(device, translated_path));
+
+    return translated_path;
 }
 
 std::string translate_path(const char *path, VitaIoDevice &device, const IOState::DevicePaths &device_paths) {
@@ -265,7 +387,7 @@ std::string translate_path(const char *path, VitaIoDevice &device, const IOState
 std::string expand_path(IOState &io, const char *path, const std::wstring &pref_path) {
     auto device = device::get_device(path);
 
-    const auto translated_path = translate_path(path, device, io.device_paths);
+    const auto translated_path = translate_path_cached(io, path, device);
     return device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio).string();
 }
 
@@ -286,14 +408,15 @@ SceUID open_file(IOState &io, const char *path, const int flags, const std::wstr
         if (flags & SCE_O_WRONLY)
             tty_type |= TTY_OUT;
 
-        const auto fd = io.next_fd++;
-        io.tty_files.emplace(fd, tty_type);
+        const auto fd = io.fds.emplace(tty_type);
+        if (fd < 0)
+            return IO_ERROR(SCE_ERROR_ERRNO_EMFILE);
 
         LOG_TRACE_IF(log_file_op, "{}: Opening terminal {}:", export_name, device._to_string());
         return fd;
     }
 
-    const auto translated_path = translate_path(path, device, io.device_paths);
+    const auto translated_path = translate_path_cached(io, path, device);
     if (translated_path.empty()) {
         LOG_ERROR("Cannot translate path: {}", path);
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
@@ -305,20 +428,13 @@ SceUID open_file(IOState &io, const char *path, const int flags, const std::wstr
         if (!(flags & SCE_O_CREAT)) {
             if (io.case_isens_find_enabled) {
                 // Attempt a case-insensitive file search.
-                const auto original_system_path = system_path;
-                const auto cached_path = find_in_cache(io, string_utils::tolower(system_path.string()));
-                if (!cached_path.empty()) {
-                    system_path = cached_path;
-                    LOG_TRACE("Found cached filepath at {}", system_path.string());
+                const auto found_path = find_case_isens_path(io, device_for_icase, translated_path, system_path);
+                if (!found_path.empty()) {
+                    LOG_TRACE("Found file on case-sensitive filesystem at {}", found_path.string());
+                    system_path = found_path;
                 } else {
-                    const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, system_path);
-                    system_path = find_in_cache(io, string_utils::tolower(system_path.string()));
-                    if (!system_path.empty() && path_found) {
-                        LOG_TRACE("Found file on case-sensitive filesystem at {}", system_path.string());
-                    } else {
-                        LOG_ERROR("Missing file at {} (target path: {})", original_system_path.string(), path);
-                        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-                    }
+                    LOG_ERROR("Missing file at {} (target path: {})", system_path.string(), path);
+                    return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
                 }
             } else {
                 LOG_ERROR("Missing file at {} (target path: {})", system_path.string(), path);
@@ -334,9 +450,16 @@ SceUID open_file(IOState &io, const char *path, const int flags, const std::wstr
 
     const auto normalized_path = device::construct_normalized_path(device, translated_path);
 
-    FileStats f{ path, normalized_path, system_path, flags };
-    const auto fd = io.next_fd++;
-    io.std_files.emplace(fd, f);
+    FileStats file_stats{ path, normalized_path, system_path, flags };
+    // large files of the read-only devices are read from a mapping, sharing the pages with the host cache
+    if (device_for_icase == VitaIoDevice::app0 || device_for_icase == VitaIoDevice::vs0 || device_for_icase == VitaIoDevice::os0)
+        file_stats.map_read_only(MIN_MAPPED_FILE_SIZE);
+
+    const auto fd = io.fds.emplace(std::move(file_stats));
+    if (fd < 0) {
+        LOG_ERROR("Too many opened files, cannot open {}", path);
+        return IO_ERROR(SCE_ERROR_ERRNO_EMFILE);
+    }
 
     LOG_TRACE_IF(log_file_op, "{}: Opening file {} ({}), fd: {}", export_name, path, normalized_path, log_hex(fd));
     return fd;
@@ -346,16 +469,20 @@ int read_file(void *data, IOState &io, const SceUID fd, const SceSize size, cons
     assert(data != nullptr);
     assert(size >= 0);
 
-    const auto file = io.std_files.find(fd);
-    if (file != io.std_files.end()) {
-        const auto read = file->second.read(data, 1, size);
+    const auto descriptor = io.fds.find(fd);
+    if (!descriptor)
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    if (const auto file = descriptor->get_file()) {
+        const auto read = file->read(data, 1, size);
+        if (read < 0)
+            return IO_ERROR(static_cast<int>(read));
         LOG_TRACE_IF(log_file_op && log_file_read, "{}: Reading {} bytes of fd {}", export_name, read, log_hex(fd));
         return static_cast<int>(read);
     }
 
-    const auto tty_file = io.tty_files.find(fd);
-    if (tty_file != io.tty_files.end()) {
-        if (tty_file->second == TTY_IN) {
+    if (const auto tty_file = descriptor->get_tty()) {
+        if (*tty_file == TTY_IN) {
             std::cin.read(reinterpret_cast<char *>(data), size);
             LOG_TRACE_IF(log_file_op && log_file_read, "{}: Reading terminal fd: {}, size: {}", export_name, log_hex(fd), size);
             return size;
@@ -375,9 +502,12 @@ int write_file(SceUID fd, const void *data, const SceSize size, const IOState &i
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
     }
 
-    const auto tty_file = io.tty_files.find(fd);
-    if (tty_file != io.tty_files.end()) {
-        if (tty_file->second & TTY_OUT) {
+    const auto descriptor = io.fds.find(fd);
+    if (!descriptor)
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    if (const auto tty_file = descriptor->get_tty()) {
+        if (*tty_file & TTY_OUT) {
             std::string s(reinterpret_cast<char const *>(data), size);
 
             // trim newline
@@ -394,16 +524,18 @@ int write_file(SceUID fd, const void *data, const SceSize size, const IOState &i
         return IO_ERROR_UNK();
     }
 
-    const auto file = io.std_files.find(fd);
-    if (file == io.std_files.end())
+    const auto file = descriptor->get_file();
+    if (!file)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-    if (!fs::is_directory(file->second.get_system_location().parent_path())) {
+    if (!fs::is_directory(file->get_system_location().parent_path())) {
         return IO_ERROR(SCE_ERROR_ERRNO_ENOENT); // TODO: Is it the right error code?
     }
 
-    if (file->second.can_write_file()) {
-        const auto written = file->second.write(data, 1, size);
+    if (file->can_write_file()) {
+        const auto written = file->write(data, 1, size);
+        if (written < 0)
+            return IO_ERROR(static_cast<int>(written));
         LOG_TRACE_IF(log_file_op, "{}: Writing to fd: {}, size: {}", export_name, log_hex(fd), size);
         return static_cast<int>(written);
     }
@@ -411,14 +543,50 @@ int write_file(SceUID fd, const void *data, const SceSize size, const IOState &i
     return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 }
 
+int pread_file(void *data, IOState &io, const SceUID fd, const SceSize size, const SceOff offset, const char *export_name) {
+    assert(data != nullptr);
+
+    const auto descriptor = io.fds.find(fd);
+    const auto file = descriptor ? descriptor->get_file() : nullptr;
+    if (!file) {
+        // terminals have no position
+        return read_file(data, io, fd, size, export_name);
+    }
+
+    const auto read = file->pread(data, size, offset);
+    if (read < 0)
+        return IO_ERROR(static_cast<int>(read));
+    LOG_TRACE_IF(log_file_op && log_file_read, "{}: Reading {} bytes of fd {} at offset {}", export_name, read, log_hex(fd), offset);
+    return static_cast<int>(read);
+}
+
+int pwrite_file(const SceUID fd, const void *data, const SceSize size, const SceOff offset, const IOState &io, const char *export_name) {
+    assert(data != nullptr);
+
+    const auto descriptor = io.fds.find(fd);
+    const auto file = descriptor ? descriptor->get_file() : nullptr;
+    if (!file)
+        return write_file(fd, data, size, io, export_name);
+
+    if (!file->can_write_file())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    const auto written = file->pwrite(data, size, offset);
+    if (written < 0)
+        return IO_ERROR(static_cast<int>(written));
+    LOG_TRACE_IF(log_file_op, "{}: Writing to fd: {}, size: {}, offset: {}", export_name, log_hex(fd), size, offset);
+    return static_cast<int>(written);
+}
+
 int truncate_file(const SceUID fd, unsigned long long length, const IOState &io, const char *export_name) {
     if (fd < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-    const auto file = io.std_files.find(fd);
-    if (file == io.std_files.end())
+    const auto descriptor = io.fds.find(fd);
+    const auto file = descriptor ? descriptor->get_file() : nullptr;
+    if (!file)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
-    auto trunc = file->second.truncate(length);
+    auto trunc = file->truncate(length);
     LOG_TRACE_IF(log_file_op, "{}: Truncating fd: {}, to size: {}", export_name, log_hex(fd), length);
     return trunc;
 }
@@ -430,10 +598,11 @@ SceOff seek_file(const SceUID fd, const SceOff offset, const SceIoSeekMode whenc
     if (fd < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-    const auto file = io.std_files.find(fd);
-    if (file == io.std_files.end())
+    const auto descriptor = io.fds.find(fd);
+    const auto file = descriptor ? descriptor->get_file() : nullptr;
+    if (!file)
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
-    if (!file->second.seek(offset, whence))
+    if (!file->seek(offset, whence))
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
     const auto log_mode = [](const SceIoSeekMode whence) -> const char * {
@@ -447,20 +616,20 @@ SceOff seek_file(const SceUID fd, const SceOff offset, const SceIoSeekMode whenc
     };
 
     LOG_TRACE_IF(log_file_op && log_file_seek, "{}: Seeking fd: {}, offset: {}, whence: {}", export_name, log_hex(fd), log_hex(offset), log_mode(whence));
-    return file->second.tell();
+    return file->tell();
 }
 
 SceOff tell_file(IOState &io, const SceUID fd, const char *export_name) {
     if (fd < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EMFILE);
 
-    const auto std_file = io.std_files.find(fd);
-
-    if (std_file == io.std_files.end()) {
+    const auto descriptor = io.fds.find(fd);
+    const auto file = descriptor ? descriptor->get_file() : nullptr;
+    if (!file) {
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
     }
 
-    return std_file->second.tell();
+    return file->tell();
 }
 
 int stat_file(IOState &io, const char *file, SceIoStat *statp, const std::wstring &pref_path, const char *export_name,
@@ -478,26 +647,19 @@ int stat_file(IOState &io, const char *file, SceIoStat *statp, const std::wstrin
             return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
         }
 
-        const auto translated_path = translate_path(file, device, io.device_paths);
+        const auto translated_path = translate_path_cached(io, file, device);
         file_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio);
 
         if (!fs::exists(file_path)) {
             if (io.case_isens_find_enabled) {
                 // Attempt a case-insensitive file search.
-                const auto original_file_path = file_path;
-                const auto cached_path = find_in_cache(io, string_utils::tolower(file_path.string()));
-                if (!cached_path.empty()) {
-                    file_path = cached_path;
-                    LOG_TRACE("Found cached filepath at {}", file_path.string());
+                const auto found_path = find_case_isens_path(io, device_for_icase, translated_path, file_path);
+                if (!found_path.empty()) {
+                    LOG_TRACE("Found file on case-sensitive filesystem at {}", found_path.string());
+                    file_path = found_path;
                 } else {
-                    const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, file_path);
-                    file_path = find_in_cache(io, string_utils::tolower(file_path.string()));
-                    if (!file_path.empty() && path_found) {
-                        LOG_TRACE("Found file on case-sensitive filesystem at {}", file_path.string());
-                    } else {
-                        LOG_ERROR("Missing file at {} (target path: {})", original_file_path.string(), file);
-                        return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-                    }
+                    LOG_ERROR("Missing file at {} (target path: {})", file_path.string(), file);
+                    return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
                 }
             } else {
                 LOG_ERROR("Missing file at {} (target path: {})", file_path.string(), file);
@@ -506,14 +668,15 @@ int stat_file(IOState &io, const char *file, SceIoStat *statp, const std::wstrin
         }
         LOG_TRACE_IF(log_file_op && log_file_stat, "{}: Statting file: {} ({})", export_name, file, device::construct_normalized_path(device, translated_path));
     } else { // We have previously opened and defined the location
-        const auto fd_file = io.std_files.find(fd);
-        if (fd_file == io.std_files.end())
+        const auto descriptor = io.fds.find(fd);
+        const auto fd_file = descriptor ? descriptor->get_file() : nullptr;
+        if (!fd_file)
             return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-        file_path = fd_file->second.get_system_location();
+        file_path = fd_file->get_system_location();
         LOG_TRACE_IF(log_file_op && log_file_stat, "{}: Statting fd: {}", export_name, log_hex(fd));
 
-        statp->st_attr = fd_file->second.get_file_mode();
+        statp->st_attr = fd_file->get_file_mode();
     }
 
     std::uint64_t last_access_time_ticks;
@@ -563,12 +726,13 @@ int stat_file_by_fd(IOState &io, const SceUID fd, SceIoStat *statp, const std::w
     assert(statp != nullptr);
     memset(statp, '\0', sizeof(SceIoStat));
 
-    const auto std_file = io.std_files.find(fd);
-    if (std_file == io.std_files.end()) {
+    const auto descriptor = io.fds.find(fd);
+    const auto std_file = descriptor ? descriptor->get_file() : nullptr;
+    if (!std_file) {
         return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
     }
 
-    return stat_file(io, std_file->second.get_vita_loc(), statp, pref_path, export_name, fd);
+    return stat_file(io, std_file->get_vita_loc(), statp, pref_path, export_name, fd);
 }
 
 int close_file(IOState &io, const SceUID fd, const char *export_name) {
@@ -577,12 +741,23 @@ int close_file(IOState &io, const SceUID fd, const char *export_name) {
 
     LOG_TRACE_IF(log_file_op, "{}: Closing file fd: {}", export_name, log_hex(fd));
 
-    io.tty_files.erase(fd);
-    io.std_files.erase(fd);
+    // directories are closed by close_dir
+    const auto descriptor = io.fds.find(fd);
+    if (descriptor && !descriptor->get_dir())
+        io.fds.erase(fd);
 
     return 0;
 }
 
+std::optional<FileStats> get_file_stats(const IOState &io, const SceUID fd) {
+    const auto descriptor = io.fds.find(fd);
+    const auto file = descriptor ? descriptor->get_file() : nullptr;
+    if (!file)
+        return std::nullopt;
+
+    return *file;
+}
+
 int remove_file(IOState &io, const char *file, const std::wstring &pref_path, const char *export_name) {
     auto device = device::get_device(file);
     if (device == VitaIoDevice::_INVALID) {
@@ -618,26 +793,19 @@ int remove_file(IOState &io, const char *file, const std::wstring &pref_path, co
 SceUID open_dir(IOState &io, const char *path, const std::wstring &pref_path, const char *export_name) {
     auto device = device::get_device(path);
     auto device_for_icase = device;
-    const auto translated_path = translate_path(path, device, io.device_paths);
+    const auto translated_path = translate_path_cached(io, path, device);
 
     auto dir_path = device::construct_emulated_path(device, translated_path, pref_path, io.redirect_stdio) / "/";
     if (!fs::exists(dir_path)) {
         if (io.case_isens_find_enabled) {
             // Attempt a case-insensitive file search.
-            const auto original_dir_path = dir_path;
-            const auto cached_path = find_in_cache(io, string_utils::tolower(dir_path.string()));
-            if (!cached_path.empty()) {
-                dir_path = cached_path;
-                LOG_TRACE("Found cached directory path at {}", dir_path.string());
+            const auto found_path = find_case_isens_path(io, device_for_icase, translated_path, dir_path);
+            if (!found_path.empty() && fs::is_directory(found_path)) {
+                LOG_TRACE("Found directory on case-sensitive filesystem at {}", found_path.string());
+                dir_path = found_path / "/";
             } else {
-                const bool path_found = find_case_isens_path(io, device_for_icase, translated_path, dir_path);
-                dir_path = find_in_cache(io, string_utils::tolower(dir_path.string().substr(0, dir_path.string().size() - 1)));
-                if (!dir_path.empty() && path_found) {
-                    LOG_TRACE("Found directory on case-sensitive filesystem at {}", dir_path.string());
-                } else {
-                    LOG_ERROR("Directory does not exist at {} (target path: {})", original_dir_path.string(), path);
-                    return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
-                }
+                LOG_ERROR("Directory does not exist at {} (target path: {})", dir_path.string(), path);
+                return IO_ERROR(SCE_ERROR_ERRNO_ENOENT);
             }
         } else {
             LOG_ERROR("Directory does not exist at: {} (target path: {})", dir_path.string(), path);
@@ -652,9 +820,11 @@ SceUID open_dir(IOState &io, const char *path, const std::wstring &pref_path, co
     }
 
     const auto normalized = device::construct_normalized_path(device, translated_path);
-    const DirStats d{ path, normalized, dir_path, opened };
-    const auto fd = io.next_fd++;
-    io.dir_entries.emplace(fd, d);
+    const auto fd = io.fds.emplace(DirStats{ path, normalized, dir_path, opened });
+    if (fd < 0) {
+        LOG_ERROR("Too many opened files, cannot open directory {}", path);
+        return IO_ERROR(SCE_ERROR_ERRNO_EMFILE);
+    }
 
     LOG_TRACE_IF(log_file_op, "{}: Opening dir {} ({}), fd: {}", export_name, path, normalized, log_hex(fd));
 
@@ -666,23 +836,25 @@ SceUID read_dir(IOState &io, const SceUID fd, SceIoDirent *dent, const std::wstr
 
     memset(dent->d_name, '\0', sizeof(dent->d_name));
 
-    const auto dir = io.dir_entries.find(fd);
-
-    if (dir != io.dir_entries.end()) {
-        // Refuse any fd that is not explicitly a directory
-        if (!dir->second.is_directory())
-            return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+    const auto descriptor = io.fds.find(fd);
+    const auto dir = descriptor ? descriptor->get_dir() : nullptr;
+    // Refuse any fd that is not explicitly a directory
+    if (!dir || !dir->is_directory())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
-        const auto d = dir->second.get_dir_ptr();
+    // readdir is not thread-safe on the same stream
+    const std::lock_guard<std::mutex> lock(descriptor->mutex);
+    while (true) {
+        const auto d = dir->get_dir_ptr();
         if (!d)
             return 0;
 
         const auto d_name_utf8 = get_file_in_dir(d);
         strncpy(dent->d_name, d_name_utf8.c_str(), sizeof(dent->d_name));
 
-        const auto cur_path = dir->second.get_system_location() / d_name_utf8;
+        const auto cur_path = dir->get_system_location() / d_name_utf8;
         if (!(cur_path.filename_is_dot() || cur_path.filename_is_dot_dot())) {
-            const auto file_path = std::string(dir->second.get_vita_loc()) + '/' + d_name_utf8;
+            const auto file_path = std::string(dir->get_vita_loc()) + '/' + d_name_utf8;
 
             LOG_TRACE_IF(log_file_op, "{}: Reading entry {} of fd: {}", export_name, file_path, log_hex(fd));
             if (stat_file(io, file_path.c_str(), &dent->d_stat, pref_path, export_name) < 0)
@@ -690,10 +862,7 @@ SceUID read_dir(IOState &io, const SceUID fd, SceIoDirent *dent, const std::wstr
             else
                 return 1; // move to the next file
         }
-        return read_dir(io, fd, dent, pref_path, export_name);
     }
-
-    return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 }
 
 bool copy_directories(const fs::path &src_path, const fs::path &dst_path) {
@@ -766,12 +935,13 @@ int close_dir(IOState &io, const SceUID fd, const char *export_name) {
     if (fd < 0)
         return IO_ERROR(SCE_ERROR_ERRNO_EMFILE);
 
-    const auto erased_entries = io.dir_entries.erase(fd);
+    const auto descriptor = io.fds.find(fd);
+    if (!descriptor || !descriptor->get_dir())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
 
     LOG_TRACE_IF(log_file_op, "{}: Closing dir fd: {}", export_name, log_hex(fd));
 
-    if (erased_entries == 0)
-        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+    io.fds.erase(fd);
 
     return 0;
 }
@@ -799,32 +969,137 @@ int remove_dir(IOState &io, const char *dir, const std::wstring &pref_path, cons
     return 0;
 }
 
-SceUID create_overlay(IOState &io, SceFiosProcessOverlay *fios_overlay) {
-    std::lock_guard<std::mutex> lock(io.overlay_mutex);
+int get_io_priority(const IOState &io, const SceUID thread_id, const SceUID fd) {
+    const auto descriptor = io.fds.find(fd);
+    if (descriptor) {
+        const int fd_priority = descriptor->priority.load(std::memory_order_relaxed);
+        if (fd_priority != 0)
+            return fd_priority;
+    }
 
-    FiosOverlay overlay{
-        .id = io.next_overlay_id++,
-        .type = fios_overlay->type,
-        .order = fios_overlay->order,
-        .process_id = fios_overlay->process_id,
-        .dst = std::string(fios_overlay->dst),
-        .src = std::string(fios_overlay->src)
-    };
+    return get_thread_default_io_priority(io, thread_id);
+}
 
-    // find location where to put it
-    int overlay_index = 0;
+int get_thread_default_io_priority(const IOState &io, const SceUID thread_id) {
+    const std::lock_guard<std::mutex> lock(io.thread_default_priorities_mutex);
+    const auto thread_priority = io.thread_default_priorities.find(thread_id);
+    if (thread_priority != io.thread_default_priorities.end())
+        return thread_priority->second;
+
+    return io.process_default_priority;
+}
+
+void set_thread_default_io_priority(IOState &io, const SceUID thread_id, const int priority) {
+    const std::lock_guard<std::mutex> lock(io.thread_default_priorities_mutex);
+    io.thread_default_priorities[thread_id] = priority;
+}
+
+int get_fd_io_priority(const IOState &io, const SceUID thread_id, const SceUID fd, const char *export_name) {
+    const auto descriptor = io.fds.find(fd);
+    if (!descriptor || descriptor->get_dir())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    return get_io_priority(io, thread_id, fd);
+}
+
+int set_fd_io_priority(IOState &io, const SceUID fd, const int priority, const char *export_name) {
+    const auto descriptor = io.fds.find(fd);
+    if (!descriptor || descriptor->get_dir())
+        return IO_ERROR(SCE_ERROR_ERRNO_EBADFD);
+
+    LOG_TRACE_IF(log_file_op, "{}: Setting priority of fd {} to {}", export_name, log_hex(fd), priority);
+    descriptor->priority.store(priority, std::memory_order_relaxed);
+    return 0;
+}
+
+// must be called with the overlay mutex locked
+static void insert_overlay(IOState &io, FiosOverlay &&overlay) {
     // lower order first and in case of equality, last one inserted first
-    while (overlay_index < io.overlays.size() && overlay.order < io.overlays[overlay_index].order)
+    int overlay_index = 0;
+    while (overlay_index < io.overlays.size() && io.overlays[overlay_index].order < overlay.order)
         overlay_index++;
 
     io.overlays.insert(io.overlays.begin() + overlay_index, std::move(overlay));
+    io.overlay_resolve_cache.clear();
+}
+
+SceUID create_overlay(IOState &io, SceFiosProcessOverlay *fios_overlay) {
+    std::lock_guard<std::mutex> lock(io.overlay_mutex);
+
+    const SceUID id = io.next_overlay_id++;
+    insert_overlay(io, FiosOverlay{
+                           .id = id,
+                           .type = fios_overlay->type,
+                           .order = fios_overlay->order,
+                           .process_id = fios_overlay->process_id,
+                           .dst = std::string(fios_overlay->dst),
+                           .src = std::string(fios_overlay->src) });
+
+    return id;
+}
+
+bool remove_overlay(IOState &io, const SceUID id) {
+    std::lock_guard<std::mutex> lock(io.overlay_mutex);
+
+    const auto overlay = std::find_if(io.overlays.begin(), io.overlays.end(), [&](const FiosOverlay &overlay) { return overlay.id == id; });
+    if (overlay == io.overlays.end())
+        return false;
+
+    io.overlays.erase(overlay);
+    io.overlay_resolve_cache.clear();
+    return true;
+}
 
-    return overlay.id;
+bool modify_overlay(IOState &io, const SceUID id, const SceFiosProcessOverlay *fios_overlay) {
+    std::lock_guard<std::mutex> lock(io.overlay_mutex);
+
+    const auto overlay = std::find_if(io.overlays.begin(), io.overlays.end(), [&](const FiosOverlay &overlay) { return overlay.id == id; });
+    if (overlay == io.overlays.end())
+        return false;
+
+    // the order may change, so insert it again
+    io.overlays.erase(overlay);
+    insert_overlay(io, FiosOverlay{
+                           .id = id,
+                           .type = fios_overlay->type,
+                           .order = fios_overlay->order,
+                           .process_id = fios_overlay->process_id,
+                           .dst = std::string(fios_overlay->dst),
+                           .src = std::string(fios_overlay->src) });
+
+    return true;
+}
+
+bool get_overlay_info(IOState &io, const SceUID id, SceFiosProcessOverlay *fios_overlay) {
+    std::lock_guard<std::mutex> lock(io.overlay_mutex);
+
+    const auto overlay = std::find_if(io.overlays.begin(), io.overlays.end(), [&](const FiosOverlay &overlay) { return overlay.id == id; });
+    if (overlay == io.overlays.end())
+        return false;
+
+    *fios_overlay = {};
+    fios_overlay->type = overlay->type;
+    fios_overlay->order = overlay->order;
+    fios_overlay->process_id = overlay->process_id;
+    fios_overlay->dst_size = static_cast<int16_t>(std::min<size_t>(overlay->dst.size(), SCE_FIOS_OVERLAY_POINT_MAX - 1));
+    fios_overlay->src_size = static_cast<int16_t>(std::min<size_t>(overlay->src.size(), SCE_FIOS_OVERLAY_POINT_MAX - 1));
+    overlay->dst.copy(fios_overlay->dst, fios_overlay->dst_size);
+    overlay->src.copy(fios_overlay->src, fios_overlay->src_size);
+    return true;
 }
 
 std::string resolve_path(IOState &io, const char *input, const bool is_write, const SceUInt32 min_order, const SceUInt32 max_order) {
     std::lock_guard<std::mutex> lock(io.overlay_mutex);
 
+    if (io.overlays.empty())
+        return std::string(input);
+
+    // the same few paths are resolved over and over, so remember the results until the overlays change
+    std::string cache_key = fmt::format("{}:{}:{}:{}", min_order, max_order, is_write, input);
+    const auto cached = io.overlay_resolve_cache.find(cache_key);
+    if (cached != io.overlay_resolve_cache.end())
+        return cached->second;
+
     std::string curr_path = std::string(input);
 
     int overlay_idx = 0;
@@ -845,5 +1120,9 @@ std::string resolve_path(IOState &io, const char *input, const bool is_write, co
         curr_path = overlay.src + curr_path.substr(overlay.dst.size());
     }
 
+    if (io.overlay_resolve_cache.size() >= MAX_OVERLAY_RESOLVE_CACHE_SIZE)
+        io.overlay_resolve_cache.clear();
+    io.overlay_resolve_cache.emplace(std::move(cache_key), curr_path);
+
     return curr_path;
 }
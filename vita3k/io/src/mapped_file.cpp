@@ -0,0 +1,148 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/mapped_file.h>
+
+#include <utility>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : opened(std::exchange(other.opened, false))
+    , view(std::exchange(other.view, nullptr))
+    , view_size(std::exchange(other.view_size, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        opened = std::exchange(other.opened, false);
+        view = std::exchange(other.view, nullptr);
+        view_size = std::exchange(other.view_size, 0);
+    }
+    return *this;
+}
+
+#ifdef WIN32
+bool MappedFile::open(const fs::path &path, const Access access) {
+    close();
+
+    const DWORD flags = access == Access::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+    const HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    if (file_size.QuadPart == 0) {
+        CloseHandle(file);
+        opened = true;
+        return true;
+    }
+
+    // the view keeps a reference to the mapping, which keeps one to the file
+    const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+
+    const void *mapped = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!mapped)
+        return false;
+
+    if (access == Access::Sequential) {
+        WIN32_MEMORY_RANGE_ENTRY range{ const_cast<void *>(mapped), static_cast<SIZE_T>(file_size.QuadPart) };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+
+    view = static_cast<const uint8_t *>(mapped);
+    view_size = static_cast<size_t>(file_size.QuadPart);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (view)
+        UnmapViewOfFile(view);
+
+    opened = false;
+    view = nullptr;
+    view_size = 0;
+}
+#else
+bool MappedFile::open(const fs::path &path, const Access access) {
+    close();
+
+    const int fd = ::open(path.string().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat sb;
+    if (fstat(fd, &sb) < 0 || !S_ISREG(sb.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    if (sb.st_size == 0) {
+        ::close(fd);
+        opened = true;
+        return true;
+    }
+
+    const size_t file_size = static_cast<size_t>(sb.st_size);
+    void *mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+
+    if (access == Access::Sequential) {
+        madvise(mapped, file_size, MADV_SEQUENTIAL);
+        madvise(mapped, file_size, MADV_WILLNEED);
+    }
+
+    view = static_cast<const uint8_t *>(mapped);
+    view_size = file_size;
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (view)
+        munmap(const_cast<uint8_t *>(view), view_size);
+
+    opened = false;
+    view = nullptr;
+    view_size = 0;
+}
+#endif
@@ -0,0 +1,255 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/path_index.h>
+
+#include <util/string_utils.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+
+namespace {
+
+constexpr char INDEX_MAGIC[8] = { 'V', '3', 'K', 'P', 'I', 'D', 'X', '\0' };
+constexpr uint32_t INDEX_VERSION = 1;
+
+// The file is made of the header, the entry records sorted by lowercase path and the strings they point to
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t root_size;
+    uint32_t strings_size;
+};
+
+struct IndexRecord {
+    uint32_t lower_offset;
+    uint32_t lower_size;
+    uint32_t real_offset;
+    uint32_t real_size;
+    int64_t mtime;
+};
+
+int64_t get_directory_time(const fs::path &path) {
+    boost::system::error_code error_code;
+    const auto time = fs::last_write_time(path, error_code);
+    return error_code ? -1 : static_cast<int64_t>(time);
+}
+
+bool is_inside(const std::string &path, const std::string &dir) {
+    return dir.empty() || path == dir || (path.size() > dir.size() && path[dir.size()] == '/' && path.starts_with(dir));
+}
+
+} // namespace
+
+void PathIndex::scan(const std::string &real_dir, const int64_t scan_start, std::vector<Entry> &result) const {
+    const fs::path dir_path = real_dir.empty() ? root : root / real_dir;
+    // mtime has a precision of one second, a directory modified during the same second may still change unnoticed
+    const int64_t mtime = get_directory_time(dir_path);
+    result.push_back({ string_utils::tolower(real_dir), real_dir, mtime < scan_start ? mtime : UNKNOWN_TIME });
+
+    boost::system::error_code error_code;
+    for (fs::directory_iterator it(dir_path, error_code), end; !error_code && it != end; it.increment(error_code)) {
+        const std::string name = it->path().filename().string();
+        const std::string real_path = real_dir.empty() ? name : real_dir + '/' + name;
+
+        // links are indexed but not followed, a link to a parent directory would make the scan endless
+        if (fs::is_directory(it->symlink_status()))
+            scan(real_path, scan_start, result);
+        else
+            result.push_back({ string_utils::tolower(real_path), real_path, NOT_A_DIRECTORY });
+    }
+}
+
+void PathIndex::sort() {
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.lower < b.lower; });
+}
+
+void PathIndex::build() {
+    entries.clear();
+    if (fs::is_directory(root))
+        scan({}, std::time(nullptr), entries);
+    sort();
+}
+
+void PathIndex::rescan(const std::vector<std::string> &real_dirs) {
+    const int64_t scan_start = std::time(nullptr);
+    for (const auto &real_dir : real_dirs) {
+        std::erase_if(entries, [&](const Entry &entry) { return is_inside(entry.real, real_dir); });
+
+        if (fs::is_directory(real_dir.empty() ? root : root / real_dir))
+            scan(real_dir, scan_start, entries);
+    }
+    sort();
+}
+
+bool PathIndex::is_stale(const Entry &entry) const {
+    if (entry.mtime == UNKNOWN_TIME)
+        return true;
+
+    const int64_t mtime = get_directory_time(entry.real.empty() ? root : root / entry.real);
+    return mtime != entry.mtime;
+}
+
+bool PathIndex::refresh() {
+    std::vector<std::string> stale_dirs;
+    for (const auto &entry : entries) {
+        if (entry.mtime != NOT_A_DIRECTORY && is_stale(entry))
+            stale_dirs.push_back(entry.real);
+    }
+
+    if (entries.empty() && fs::is_directory(root))
+        stale_dirs.emplace_back();
+
+    if (stale_dirs.empty())
+        return false;
+
+    // a directory is scanned with its subdirectories, so drop the ones inside another stale directory
+    std::sort(stale_dirs.begin(), stale_dirs.end());
+    std::vector<std::string> dirs_to_scan;
+    for (auto &dir : stale_dirs) {
+        const bool covered = std::any_of(dirs_to_scan.begin(), dirs_to_scan.end(), [&](const std::string &scanned) { return is_inside(dir, scanned); });
+        if (!covered)
+            dirs_to_scan.push_back(std::move(dir));
+    }
+
+    rescan(dirs_to_scan);
+    return true;
+}
+
+bool PathIndex::refresh_parent(const std::string &lower_path) {
+    // look for the closest indexed directory
+    std::string lower_dir = lower_path;
+    const Entry *dir = nullptr;
+    while (!dir) {
+        if (lower_dir.empty())
+            return refresh();
+
+        const auto separator = lower_dir.rfind('/');
+        lower_dir.resize(separator == std::string::npos ? 0 : separator);
+
+        const auto it = std::lower_bound(entries.begin(), entries.end(), lower_dir, [](const Entry &entry, const std::string &path) { return entry.lower < path; });
+        if (it != entries.end() && it->lower == lower_dir && it->mtime != NOT_A_DIRECTORY)
+            dir = &*it;
+    }
+
+    if (!is_stale(*dir))
+        return false;
+
+    rescan({ dir->real });
+    return true;
+}
+
+const std::string *PathIndex::find(const std::string &lower_path) const {
+    const auto it = std::lower_bound(entries.begin(), entries.end(), lower_path, [](const Entry &entry, const std::string &path) { return entry.lower < path; });
+    if (it == entries.end() || it->lower != lower_path)
+        return nullptr;
+
+    return &it->real;
+}
+
+bool PathIndex::save(const fs::path &index_file) const {
+    const std::string root_string = root.generic_path().string();
+
+    std::vector<IndexRecord> records;
+    records.reserve(entries.size());
+    std::string strings = root_string;
+    for (const auto &entry : entries) {
+        IndexRecord record;
+        record.lower_offset = static_cast<uint32_t>(strings.size());
+        record.lower_size = static_cast<uint32_t>(entry.lower.size());
+        strings += entry.lower;
+        // most paths only differ from their lowercase version by their case, do not store them twice
+        if (entry.real == entry.lower) {
+            record.real_offset = record.lower_offset;
+        } else {
+            record.real_offset = static_cast<uint32_t>(strings.size());
+            strings += entry.real;
+        }
+        record.real_size = static_cast<uint32_t>(entry.real.size());
+        record.mtime = entry.mtime;
+        records.push_back(record);
+    }
+
+    IndexHeader header;
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.entry_count = static_cast<uint32_t>(records.size());
+    header.root_size = static_cast<uint32_t>(root_string.size());
+    header.strings_size = static_cast<uint32_t>(strings.size());
+
+    boost::system::error_code error_code;
+    fs::create_directories(index_file.parent_path(), error_code);
+
+    fs::ofstream file(index_file, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(IndexRecord));
+    file.write(strings.data(), strings.size());
+    return file.good();
+}
+
+bool PathIndex::load(const fs::path &index_file) {
+    fs::ifstream file(index_file, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    const auto file_size = static_cast<size_t>(file.tellg());
+    std::vector<char> data(file_size);
+    file.seekg(0);
+    if (!file.read(data.data(), file_size))
+        return false;
+
+    IndexHeader header;
+    if (file_size < sizeof(header))
+        return false;
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 || header.version != INDEX_VERSION)
+        return false;
+
+    const size_t records_offset = sizeof(header);
+    const size_t strings_offset = records_offset + static_cast<size_t>(header.entry_count) * sizeof(IndexRecord);
+    if (strings_offset + header.strings_size != file_size || header.root_size > header.strings_size)
+        return false;
+
+    const char *strings = data.data() + strings_offset;
+    if (std::string_view(strings, header.root_size) != root.generic_path().string())
+        return false;
+
+    std::vector<Entry> loaded;
+    loaded.reserve(header.entry_count);
+    for (uint32_t i = 0; i < header.entry_count; i++) {
+        IndexRecord record;
+        memcpy(&record, data.data() + records_offset + i * sizeof(IndexRecord), sizeof(record));
+        if (static_cast<uint64_t>(record.lower_offset) + record.lower_size > header.strings_size
+            || static_cast<uint64_t>(record.real_offset) + record.real_size > header.strings_size)
+            return false;
+
+        loaded.push_back({ std::string(strings + record.lower_offset, record.lower_size),
+            std::string(strings + record.real_offset, record.real_size), record.mtime });
+    }
+
+    if (!std::is_sorted(loaded.begin(), loaded.end(), [](const Entry &a, const Entry &b) { return a.lower < b.lower; }))
+        return false;
+
+    entries = std::move(loaded);
+    return true;
+}
@@ -15,72 +15,149 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
-#ifdef _WIN32
-#include <io.h>
-#else
-#define _FILE_OFFSET_BITS 64
-#include <stdio.h>
-#include <sys/types.h>
-#include <unistd.h>
-#endif
-
+#include <io/io.h>
 #include <io/state.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+// Guest error for the negated host errno returned by HostFile
+static SceOff translate_host_error(const int64_t error) {
+    switch (-error) {
+    case ENOENT: return SCE_ERROR_ERRNO_ENOENT;
+    case EACCES:
+    case EPERM: return SCE_ERROR_ERRNO_EACCES;
+    case EFAULT: return SCE_ERROR_ERRNO_EFAULT;
+    case EISDIR: return SCE_ERROR_ERRNO_EISDIR;
+    case EINVAL: return SCE_ERROR_ERRNO_EINVAL;
+    case EFBIG: return SCE_ERROR_ERRNO_EFBIG;
+    case ENOSPC: return SCE_ERROR_ERRNO_ENOSPC;
+    case EROFS: return SCE_ERROR_ERRNO_EROFS;
+    case EBADF: return SCE_ERROR_ERRNO_EBADFD;
+    default: return SCE_ERROR_ERRNO_EIO;
+    }
+}
+
+bool FileStats::map_read_only(const size_t min_size) {
+    if (!wrapped_file || can_write(file_info.open_mode))
+        return false;
+
+    const int64_t file_size = wrapped_file->size();
+    if (file_size < 0 || static_cast<size_t>(file_size) < min_size)
+        return false;
+
+    auto mapping = std::make_shared<MappedFile>();
+    if (!mapping->open(file_info.sys_loc))
+        return false;
+
+    mapped_file = std::move(mapping);
+    return true;
+}
+
+// Copy at most size bytes of the mapping from offset
+static SceOff read_mapping(const MappedFile &mapping, void *data, const uint64_t size, const SceOff offset) {
+    if (offset < 0)
+        return -EINVAL;
+    if (static_cast<uint64_t>(offset) >= mapping.size())
+        return 0;
+
+    const uint64_t read = std::min<uint64_t>(size, mapping.size() - offset);
+    memcpy(data, mapping.data() + offset, read);
+    return static_cast<SceOff>(read);
+}
+
 SceOff FileStats::read(void *input_data, const int element_size, const SceSize element_count) const {
-    if (!wrapped_file)
-        return -1;
+    if (!wrapped_file || element_size <= 0)
+        return SCE_ERROR_ERRNO_EBADFD;
 
-    return fread(input_data, element_size, element_count, wrapped_file.get());
+    const std::lock_guard<std::mutex> lock(wrapped_file->position_mutex);
+    const uint64_t size = static_cast<uint64_t>(element_size) * element_count;
+    const int64_t read = mapped_file ? read_mapping(*mapped_file, input_data, size, wrapped_file->position)
+                                     : wrapped_file->pread(input_data, size, wrapped_file->position);
+    if (read < 0)
+        return translate_host_error(read);
+
+    wrapped_file->position += read;
+    return read / element_size;
 }
 
 SceOff FileStats::write(const void *data, const SceSize size, const int count) const {
+    if (!can_write_file() || size == 0)
+        return SCE_ERROR_ERRNO_EBADFD;
+
+    const std::lock_guard<std::mutex> lock(wrapped_file->position_mutex);
+    if (file_info.open_mode & SCE_O_APPEND) {
+        const int64_t file_size = wrapped_file->size();
+        if (file_size < 0)
+            return SCE_ERROR_ERRNO_EIO;
+        wrapped_file->position = file_size;
+    }
+
+    const int64_t written = wrapped_file->pwrite(data, static_cast<uint64_t>(size) * count, wrapped_file->position);
+    if (written < 0)
+        return translate_host_error(written);
+
+    wrapped_file->position += written;
+    return written / size;
+}
+
+SceOff FileStats::pread(void *data, const SceSize size, const SceOff offset) const {
+    if (!wrapped_file)
+        return SCE_ERROR_ERRNO_EBADFD;
+
+    const int64_t read = mapped_file ? read_mapping(*mapped_file, data, size, offset) : wrapped_file->pread(data, size, offset);
+    return read < 0 ? translate_host_error(read) : read;
+}
+
+SceOff FileStats::pwrite(const void *data, const SceSize size, const SceOff offset) const {
     if (!can_write_file())
-        return -1;
+        return SCE_ERROR_ERRNO_EBADFD;
 
-    return fwrite(data, size, count, get_file_pointer());
+    const int64_t written = wrapped_file->pwrite(data, size, offset);
+    return written < 0 ? translate_host_error(written) : written;
 }
 
 int FileStats::truncate(const SceSize size) const {
-#ifdef _WIN32
-    return _chsize_s(_fileno(get_file_pointer()), size);
-#else
-    return ftruncate(fileno(get_file_pointer()), size);
-#endif
+    if (!wrapped_file)
+        return -1;
+
+    return wrapped_file->truncate(size);
 }
 
 bool FileStats::seek(const SceOff offset, const SceIoSeekMode seek_mode) const {
     if (!wrapped_file)
         return false;
 
-    auto base = SEEK_SET;
+    const std::lock_guard<std::mutex> lock(wrapped_file->position_mutex);
+    SceOff base;
     switch (seek_mode) {
     case SCE_SEEK_SET:
-        base = SEEK_SET;
+        base = 0;
         break;
     case SCE_SEEK_CUR:
-        base = SEEK_CUR;
+        base = wrapped_file->position;
         break;
     case SCE_SEEK_END:
-        base = SEEK_END;
+        base = wrapped_file->size();
+        if (base < 0)
+            return false;
         break;
     default:
         return false;
     }
 
-#ifdef _WIN32
-    return _fseeki64(wrapped_file.get(), offset, base) == 0;
-#else
-    return fseeko(wrapped_file.get(), offset, base) == 0;
-#endif
+    if (base + offset < 0)
+        return false;
+
+    wrapped_file->position = base + offset;
+    return true;
 }
 
 SceOff FileStats::tell() const {
     if (!wrapped_file)
         return -1;
 
-#ifdef _WIN32
-    return _ftelli64(wrapped_file.get());
-#else
-    return ftello(wrapped_file.get());
-#endif
+    const std::lock_guard<std::mutex> lock(wrapped_file->position_mutex);
+    return wrapped_file->position;
 }
@@ -0,0 +1,150 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/async.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Keeps the operations using it running until it is opened
+struct Gate {
+    std::promise<void> promise;
+    std::shared_future<void> future = promise.get_future().share();
+    std::atomic<int> started = 0;
+
+    AsyncIoEngine::Operation hold(SceInt64 result) {
+        return [this, result]() {
+            started++;
+            future.wait();
+            return result;
+        };
+    }
+
+    void open() {
+        promise.set_value();
+    }
+};
+
+AsyncIoEngine::Operation returning(SceInt64 result) {
+    return [result]() { return result; };
+}
+
+} // namespace
+
+TEST(async_io, submit_runs_the_operation_and_completes_it) {
+    AsyncIoEngine engine;
+    std::atomic<SceInt64> completed = 0;
+    engine.submit(1, AsyncIoEngine::NO_KEY, 0, returning(42), [&](SceInt64 result) { completed = result; });
+
+    SceInt64 result = 0;
+    ASSERT_TRUE(engine.wait(1, result));
+    EXPECT_EQ(result, 42);
+    EXPECT_EQ(completed, 42);
+
+    EXPECT_TRUE(engine.release(1));
+    EXPECT_FALSE(engine.wait(1, result));
+    EXPECT_FALSE(engine.release(1));
+}
+
+TEST(async_io, complete_records_the_result) {
+    AsyncIoEngine engine;
+    engine.complete(7, -5);
+
+    SceInt64 result = 0;
+    ASSERT_TRUE(engine.wait(7, result));
+    EXPECT_EQ(result, -5);
+    EXPECT_TRUE(engine.release(7));
+}
+
+TEST(async_io, operations_with_the_same_key_run_in_order) {
+    AsyncIoEngine engine;
+    std::mutex order_mutex;
+    std::vector<int> order;
+    const auto record = [&](int value) {
+        return [&, value]() -> SceInt64 {
+            const std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(value);
+            return value;
+        };
+    };
+
+    // the lower priority value would run first if the key did not order them
+    for (int i = 0; i < 8; i++)
+        engine.submit(i + 1, 3, 8 - i, record(i), [](SceInt64) {});
+
+    for (int i = 0; i < 8; i++) {
+        SceInt64 result;
+        ASSERT_TRUE(engine.wait(i + 1, result));
+    }
+    EXPECT_EQ(order, (std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7 }));
+}
+
+TEST(async_io, cancel_removes_pending_operations_only) {
+    AsyncIoEngine engine;
+    Gate gate;
+    std::atomic<bool> second_run = false;
+    std::atomic<SceInt64> second_completed = 0;
+
+    // the second operation waits for the first one as they have the same key
+    engine.submit(1, 3, 0, gate.hold(10), [](SceInt64) {});
+    engine.submit(2, 3, 0, [&]() -> SceInt64 { second_run = true; return 20; }, [&](SceInt64 result) { second_completed = result; });
+
+    EXPECT_EQ(engine.cancel(2, -1), AsyncIoEngine::CancelResult::Canceled);
+    EXPECT_EQ(second_completed, -1);
+    EXPECT_EQ(engine.cancel(2, -1), AsyncIoEngine::CancelResult::NotFound);
+    EXPECT_EQ(engine.cancel(3, -1), AsyncIoEngine::CancelResult::NotFound);
+
+    while (gate.started == 0)
+        std::this_thread::yield();
+    EXPECT_EQ(engine.cancel(1, -1), AsyncIoEngine::CancelResult::Running);
+
+    gate.open();
+    SceInt64 result = 0;
+    ASSERT_TRUE(engine.wait(1, result));
+    EXPECT_EQ(result, 10);
+    EXPECT_EQ(engine.cancel(1, -1), AsyncIoEngine::CancelResult::NotFound);
+
+    ASSERT_TRUE(engine.wait(2, result));
+    EXPECT_EQ(result, -1);
+    EXPECT_FALSE(second_run);
+}
+
+TEST(async_io, finished_operations_are_kept_until_released) {
+    AsyncIoEngine engine;
+    // games may queue a lot of reads before calling sceIoComplete on any of them
+    constexpr SceUID COUNT = 4096;
+    for (SceUID op_id = 1; op_id <= COUNT; op_id++) {
+        if (op_id % 2)
+            engine.submit(op_id, AsyncIoEngine::NO_KEY, 0, returning(op_id), [](SceInt64) {});
+        else
+            engine.complete(op_id, op_id);
+    }
+
+    for (SceUID op_id = 1; op_id <= COUNT; op_id++) {
+        SceInt64 result = 0;
+        ASSERT_TRUE(engine.wait(op_id, result)) << "operation " << op_id;
+        EXPECT_EQ(result, op_id);
+        EXPECT_TRUE(engine.release(op_id));
+    }
+}
@@ -0,0 +1,219 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/fd_table.h>
+#include <io/filesystem.h>
+#include <io/types.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Tracked {
+    explicit Tracked(int value, std::atomic<int> &alive)
+        : value(value)
+        , alive(alive) {
+        alive++;
+    }
+    ~Tracked() {
+        alive--;
+    }
+
+    int value;
+    std::atomic<int> &alive;
+};
+
+} // namespace
+
+TEST(io_fd_table, find_and_erase) {
+    std::atomic<int> alive = 0;
+    FdTable<Tracked> table;
+
+    const SceUID fd = table.emplace(42, alive);
+    ASSERT_GT(fd, 0);
+    EXPECT_EQ(table.find(fd)->value, 42);
+
+    EXPECT_TRUE(table.erase(fd));
+    EXPECT_FALSE(table.find(fd));
+    EXPECT_FALSE(table.erase(fd));
+    EXPECT_EQ(alive, 0);
+
+    EXPECT_FALSE(table.find(-1));
+    EXPECT_FALSE(table.find(0));
+}
+
+TEST(io_fd_table, reused_slot_gets_a_new_fd) {
+    std::atomic<int> alive = 0;
+    FdTable<Tracked> table;
+
+    const SceUID first = table.emplace(1, alive);
+    table.erase(first);
+    const SceUID second = table.emplace(2, alive);
+
+    EXPECT_NE(first, second);
+    EXPECT_FALSE(table.find(first));
+    EXPECT_EQ(table.find(second)->value, 2);
+}
+
+TEST(io_fd_table, wrapped_generation_never_gives_fd_0) {
+    std::atomic<int> alive = 0;
+    FdTable<Tracked> table;
+
+    // every generation of slot 0, 1 to 2^19 - 1, until it wraps
+    const SceUID first = table.emplace(0, alive);
+    SceUID fd = first;
+    for (std::uint32_t i = 0; i < (1u << 19) - 1; i++) {
+        ASSERT_GT(fd, 0) << "reuse " << i;
+        table.erase(fd);
+        fd = table.emplace(0, alive);
+    }
+
+    EXPECT_EQ(fd, first);
+    EXPECT_EQ(table.find(fd)->value, 0);
+    EXPECT_FALSE(table.find(0));
+}
+
+TEST(io_fd_table, reference_keeps_the_descriptor_alive) {
+    std::atomic<int> alive = 0;
+    FdTable<Tracked> table;
+
+    const SceUID fd = table.emplace(7, alive);
+    {
+        const auto ref = table.find(fd);
+        table.erase(fd);
+        EXPECT_FALSE(table.find(fd));
+        EXPECT_EQ(alive, 1);
+        EXPECT_EQ(ref->value, 7);
+    }
+    EXPECT_EQ(alive, 0);
+}
+
+TEST(io_fd_table, full_table) {
+    std::atomic<int> alive = 0;
+    FdTable<Tracked> table;
+
+    std::vector<SceUID> fds;
+    while (true) {
+        const SceUID fd = table.emplace(0, alive);
+        if (fd < 0)
+            break;
+        fds.push_back(fd);
+    }
+    EXPECT_FALSE(fds.empty());
+    EXPECT_EQ(std::set<SceUID>(fds.begin(), fds.end()).size(), fds.size());
+
+    table.erase(fds.back());
+    EXPECT_GT(table.emplace(0, alive), 0);
+}
+
+TEST(io_fd_table, concurrent_open_find_close) {
+    std::atomic<int> alive = 0;
+    {
+        FdTable<Tracked> table;
+        std::atomic<bool> failed = false;
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; t++) {
+            threads.emplace_back([&, t] {
+                std::vector<SceUID> opened;
+                for (int i = 0; i < 20000; i++) {
+                    const int value = t * 100000 + i;
+                    const SceUID fd = table.emplace(value, alive);
+                    if (fd < 0) {
+                        failed = true;
+                        return;
+                    }
+                    opened.push_back(fd);
+
+                    const auto ref = table.find(fd);
+                    if (!ref || ref->value != value)
+                        failed = true;
+
+                    // look up the fds of the other threads, which can be closed at any time
+                    const auto other = table.find(fd ^ 1);
+                    if (other && other->value < 0)
+                        failed = true;
+
+                    if (opened.size() > 16) {
+                        table.erase(opened.front());
+                        opened.erase(opened.begin());
+                    }
+                }
+                for (const SceUID fd : opened)
+                    table.erase(fd);
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        EXPECT_FALSE(failed);
+        EXPECT_EQ(alive, 0);
+    }
+    EXPECT_EQ(alive, 0);
+}
+
+TEST(io_host_file, concurrent_positional_reads) {
+    const auto path = fs::temp_directory_path() / "vita3k_io_host_file_test.bin";
+    constexpr int size = 1 << 16;
+    {
+        std::ofstream out(path.string(), std::ios::binary);
+        for (int i = 0; i < size; i++)
+            out.put(static_cast<char>(i * 7));
+    }
+
+    {
+        const FilePtr file = create_shared_file(path, SCE_O_RDONLY);
+        ASSERT_TRUE(file);
+        EXPECT_EQ(file->size(), size);
+
+        std::atomic<bool> failed = false;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&, t] {
+                std::uint8_t buffer[251];
+                for (int offset = t; offset + sizeof(buffer) <= size; offset += 997) {
+                    if (file->pread(buffer, sizeof(buffer), offset) != sizeof(buffer)) {
+                        failed = true;
+                        return;
+                    }
+                    for (int i = 0; i < sizeof(buffer); i++) {
+                        if (buffer[i] != static_cast<std::uint8_t>((offset + i) * 7))
+                            failed = true;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        EXPECT_FALSE(failed);
+
+        // reading past the end returns what is left
+        std::uint8_t tail[16];
+        EXPECT_EQ(file->pread(tail, sizeof(tail), size - 4), 4);
+        EXPECT_EQ(file->pread(tail, sizeof(tail), size), 0);
+    }
+
+    fs::remove(path);
+}
@@ -0,0 +1,116 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/filesystem.h>
+#include <io/types.h>
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <vector>
+
+#ifndef WIN32
+#include <csignal>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+class HostFileTest : public testing::Test {
+protected:
+    void SetUp() override {
+        dir = fs::temp_directory_path() / fs::unique_path("vita3k-host-file-%%%%-%%%%");
+        fs::create_directories(dir);
+
+        content.resize(3 * 4096 + 17);
+        for (size_t i = 0; i < content.size(); i++)
+            content[i] = static_cast<uint8_t>(i * 7);
+        path = dir / "data.bin";
+        fs::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(content.data()), content.size());
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir);
+    }
+
+    fs::path dir;
+    fs::path path;
+    std::vector<uint8_t> content;
+};
+
+#ifndef WIN32
+// Stands for the write tracker: the first write to the protected pages unprotects them
+uint8_t *protected_pages = nullptr;
+size_t protected_size = 0;
+volatile sig_atomic_t fault_count = 0;
+
+void unprotect_on_fault(int, siginfo_t *info, void *) {
+    uint8_t *const addr = static_cast<uint8_t *>(info->si_addr);
+    if (addr < protected_pages || addr >= protected_pages + protected_size) {
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+    fault_count = fault_count + 1;
+    mprotect(protected_pages, protected_size, PROT_READ | PROT_WRITE);
+}
+#endif
+
+} // namespace
+
+TEST_F(HostFileTest, errors_are_returned_as_negated_errno) {
+    const FilePtr file = create_shared_file(path, SCE_O_RDONLY);
+    ASSERT_TRUE(file);
+
+    const uint8_t data = 0;
+    const int64_t written = file->pwrite(&data, 1, 0);
+    ASSERT_LT(written, 0);
+#ifndef WIN32
+    EXPECT_EQ(written, -EBADF);
+#endif
+}
+
+#ifndef WIN32
+TEST_F(HostFileTest, reads_to_protected_memory_go_through_the_fault_handler) {
+    const FilePtr file = create_shared_file(path, SCE_O_RDONLY);
+    ASSERT_TRUE(file);
+
+    protected_size = 4 * sysconf(_SC_PAGESIZE);
+    void *const pages = mmap(nullptr, protected_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(pages, MAP_FAILED);
+    protected_pages = static_cast<uint8_t *>(pages);
+    fault_count = 0;
+
+    struct sigaction action = {};
+    struct sigaction previous_action = {};
+    action.sa_sigaction = unprotect_on_fault;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    ASSERT_EQ(sigaction(SIGSEGV, &action, &previous_action), 0);
+
+    // the kernel can't write there (EFAULT), the copy from the host buffer does
+    const int64_t read = file->pread(protected_pages, content.size(), 0);
+
+    sigaction(SIGSEGV, &previous_action, nullptr);
+    EXPECT_EQ(read, static_cast<int64_t>(content.size()));
+    EXPECT_EQ(fault_count, 1);
+    EXPECT_EQ(std::vector<uint8_t>(protected_pages, protected_pages + content.size()), content);
+    munmap(pages, protected_size);
+}
+#endif
@@ -0,0 +1,93 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/mapped_file.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace {
+
+class MappedFileTest : public testing::Test {
+protected:
+    void SetUp() override {
+        dir = fs::temp_directory_path() / fs::unique_path("vita3k-mapped-file-%%%%-%%%%");
+        fs::create_directories(dir);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir);
+    }
+
+    fs::path write_file(const std::string &name, const std::vector<uint8_t> &content) {
+        const auto path = dir / name;
+        fs::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(content.data()), content.size());
+        return path;
+    }
+
+    fs::path dir;
+};
+
+} // namespace
+
+TEST_F(MappedFileTest, maps_the_whole_file) {
+    std::vector<uint8_t> content(3 * 4096 + 17);
+    for (size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<uint8_t>(i * 13);
+    const auto path = write_file("module.suprx", content);
+
+    for (const auto access : { MappedFile::Access::Normal, MappedFile::Access::Sequential }) {
+        MappedFile file;
+        ASSERT_TRUE(file.open(path, access));
+        ASSERT_EQ(file.size(), content.size());
+        EXPECT_TRUE(std::equal(content.begin(), content.end(), file.data()));
+    }
+}
+
+TEST_F(MappedFileTest, empty_and_missing_files) {
+    MappedFile file;
+    EXPECT_TRUE(file.open(write_file("empty.bin", {})));
+    EXPECT_TRUE(file.is_open());
+    EXPECT_EQ(file.size(), 0);
+
+    EXPECT_FALSE(file.open(dir / "missing.bin"));
+    EXPECT_FALSE(file.is_open());
+    EXPECT_FALSE(file.open(dir));
+}
+
+TEST_F(MappedFileTest, move) {
+    const auto path = write_file("eboot.bin", { 1, 2, 3, 4 });
+
+    MappedFile file;
+    ASSERT_TRUE(file.open(path));
+    const uint8_t *data = file.data();
+
+    MappedFile moved = std::move(file);
+    EXPECT_FALSE(file.is_open());
+    EXPECT_EQ(file.data(), nullptr);
+    EXPECT_EQ(moved.data(), data);
+    EXPECT_EQ(moved.size(), 4);
+    EXPECT_EQ(moved.data()[3], 4);
+
+    moved.close();
+    EXPECT_FALSE(moved.is_open());
+}
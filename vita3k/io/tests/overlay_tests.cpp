@@ -0,0 +1,73 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/functions.h>
+#include <io/state.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace {
+
+SceUID add_overlay(IOState &io, uint8_t order, const char *dst, const char *src) {
+    SceFiosProcessOverlay overlay{};
+    overlay.type = SCE_FIOS_OVERLAY_TYPE_OPAQUE;
+    overlay.order = order;
+    std::strcpy(overlay.dst, dst);
+    std::strcpy(overlay.src, src);
+    return create_overlay(io, &overlay);
+}
+
+} // namespace
+
+TEST(overlay, paths_are_returned_as_is_without_overlays) {
+    IOState io;
+    EXPECT_EQ(resolve_path(io, "app0:/data/level1.bin", false), "app0:/data/level1.bin");
+    EXPECT_TRUE(io.overlay_resolve_cache.empty());
+}
+
+TEST(overlay, overlays_are_applied_from_the_lowest_order) {
+    IOState io;
+    // inserted in the reverse order, the second one only matches once the first one is applied
+    add_overlay(io, 2, "ux0:/patch/", "ux0:/patch_v2/");
+    add_overlay(io, 1, "app0:/", "ux0:/patch/");
+
+    EXPECT_EQ(resolve_path(io, "app0:/data/level1.bin", false), "ux0:/patch_v2/data/level1.bin");
+    // the overlays below min_order and above max_order are skipped
+    EXPECT_EQ(resolve_path(io, "app0:/data/level1.bin", false, 2), "app0:/data/level1.bin");
+    EXPECT_EQ(resolve_path(io, "app0:/data/level1.bin", false, 0, 1), "ux0:/patch/data/level1.bin");
+}
+
+TEST(overlay, cached_paths_follow_the_overlay_changes) {
+    IOState io;
+    const SceUID id = add_overlay(io, 1, "app0:/", "ux0:/patch/");
+    EXPECT_EQ(resolve_path(io, "app0:/data/level1.bin", false), "ux0:/patch/data/level1.bin");
+    EXPECT_EQ(resolve_path(io, "app0:/data/level1.bin", false), "ux0:/patch/data/level1.bin");
+    EXPECT_EQ(io.overlay_resolve_cache.size(), 1u);
+
+    SceFiosProcessOverlay modified{};
+    ASSERT_TRUE(get_overlay_info(io, id, &modified));
+    std::strcpy(modified.src, "ux0:/mod/");
+    ASSERT_TRUE(modify_overlay(io, id, &modified));
+    EXPECT_EQ(resolve_path(io, "app0:/data/level1.bin", false), "ux0:/mod/data/level1.bin");
+
+    // the only overlay is gone, so nothing is cached anymore
+    ASSERT_TRUE(remove_overlay(io, id));
+    EXPECT_EQ(resolve_path(io, "app0:/data/level1.bin", false), "app0:/data/level1.bin");
+    EXPECT_FALSE(remove_overlay(io, id));
+}
@@ -0,0 +1,119 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <io/path_index.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+class PathIndexTest : public testing::Test {
+protected:
+    void SetUp() override {
+        root = fs::temp_directory_path() / fs::unique_path("vita3k-path-index-%%%%-%%%%");
+        fs::create_directories(root / "Data/Sound");
+        create_file("eboot.bin");
+        create_file("Data/Level1.DAT");
+        create_file("Data/Sound/BGM.at9");
+    }
+
+    void TearDown() override {
+        fs::remove_all(root);
+    }
+
+    void create_file(const std::string &path) {
+        fs::ofstream file(root / path);
+        file << path;
+    }
+
+    static std::string find(const PathIndex &index, const std::string &lower_path) {
+        const auto found = index.find(lower_path);
+        return found ? *found : "<missing>";
+    }
+
+    fs::path root;
+};
+
+} // namespace
+
+TEST_F(PathIndexTest, finds_paths_without_case) {
+    PathIndex index(root);
+    index.build();
+
+    EXPECT_EQ(index.size(), 6);
+    EXPECT_EQ(find(index, ""), "");
+    EXPECT_EQ(find(index, "eboot.bin"), "eboot.bin");
+    EXPECT_EQ(find(index, "data"), "Data");
+    EXPECT_EQ(find(index, "data/level1.dat"), "Data/Level1.DAT");
+    EXPECT_EQ(find(index, "data/sound/bgm.at9"), "Data/Sound/BGM.at9");
+    EXPECT_EQ(find(index, "data/level2.dat"), "<missing>");
+}
+
+TEST_F(PathIndexTest, save_and_load) {
+    const auto index_file = root.parent_path() / (root.filename().string() + ".bin");
+    {
+        PathIndex index(root);
+        index.build();
+        ASSERT_TRUE(index.save(index_file));
+    }
+
+    PathIndex loaded(root);
+    ASSERT_TRUE(loaded.load(index_file));
+    EXPECT_EQ(loaded.size(), 6);
+    EXPECT_EQ(find(loaded, "data/sound/bgm.at9"), "Data/Sound/BGM.at9");
+
+    // an index is only valid for the root it was made for
+    PathIndex other(root / "Data");
+    EXPECT_FALSE(other.load(index_file));
+
+    fs::remove(index_file);
+}
+
+TEST_F(PathIndexTest, refresh_finds_new_and_removed_paths) {
+    PathIndex index(root);
+    index.build();
+
+    create_file("Data/Sound/SE.at9");
+    fs::remove_all(root / "Data/Sound/BGM.at9");
+    fs::create_directories(root / "Patch/Movie");
+    create_file("Patch/Movie/Intro.MP4");
+
+    // the directories created during the same second as the scan are always checked again
+    EXPECT_TRUE(index.refresh_parent("data/sound/se.at9"));
+    EXPECT_EQ(find(index, "data/sound/se.at9"), "Data/Sound/SE.at9");
+    EXPECT_EQ(find(index, "data/sound/bgm.at9"), "<missing>");
+
+    index.refresh();
+    EXPECT_EQ(find(index, "patch/movie/intro.mp4"), "Patch/Movie/Intro.MP4");
+    EXPECT_EQ(find(index, "data/level1.dat"), "Data/Level1.DAT");
+}
+
+#ifndef WIN32
+TEST_F(PathIndexTest, directory_links_are_not_followed) {
+    // a loop back to the root
+    fs::create_directory_symlink(root, root / "Data/Loop");
+
+    PathIndex index(root);
+    index.build();
+
+    EXPECT_EQ(index.size(), 7);
+    EXPECT_EQ(find(index, "data/loop"), "Data/Loop");
+    EXPECT_EQ(find(index, "data/loop/eboot.bin"), "<missing>");
+}
+#endif
@@ -17,14 +17,29 @@
 
 #pragma once
 
+#include <mem/ptr.h>
 #include <util/types.h>
 
 #include <string>
+#include <vector>
 
 struct Config;
 struct KernelState;
 struct MemState;
-template <class T>
-class Ptr;
 
 SceUID load_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &mem, const void *self, const std::string &path);
+
+struct SelfToLoad {
+    const void *self;
+    std::string path;
+    Ptr<const void> entry_point;
+    SceUID uid = -1;
+};
+
+/**
+ * \brief Load several modules, like calling load_self on each of them in order until one fails.
+ *
+ * The segments of all the modules are inflated in parallel, while the allocation, relocation and linking stay in order.
+ * \return Number of modules loaded
+ */
+size_t load_selfs(std::vector<SelfToLoad> &selfs, KernelState &kernel, MemState &mem);
@@ -26,6 +26,7 @@
 #include <mem/allocator.h>
 #include <mem/ptr.h>
 #include <mem/util.h>
+#include <rtc/clock.h>
 #include <rtc/rtc.h>
 #include <util/pool.h>
 
@@ -61,6 +62,8 @@ typedef std::shared_ptr<SceKernelModuleInfo> SceKernelModuleInfoPtr;
 typedef std::map<SceUID, SceKernelModuleInfoPtr> SceKernelModuleInfoPtrs;
 typedef std::map<SceUID, CallbackPtr> CallbackPtrs;
 typedef std::unordered_map<uint32_t, Address> ExportNids;
+// metrics counter of the library importing each HLE function, indexed by import_function_index
+typedef std::unique_ptr<std::atomic<uint32_t>[]> ImportCounters;
 typedef std::map<Address, uint32_t> NotFoundVars;
 typedef std::unique_ptr<CPUProtocol> CPUProtocolPtr;
 
@@ -148,6 +151,7 @@ struct KernelState {
     SceKernelModuleInfoPtrs loaded_modules;
     LoadedSysmodules loaded_sysmodules;
     ExportNids export_nids;
+    ImportCounters import_counters;
     std::shared_mutex export_nids_mutex;
     VarLateBindingInfos late_binding_infos;
     ModuleUidByNid module_uid_by_nid;
@@ -160,7 +164,9 @@ struct KernelState {
 
     ObjectStore obj_store;
 
+    EmuClock clock;
     uint64_t start_tick;
+    // rtc ticks at the origin of the clock
     SceRtcTick base_tick;
     TimerStates timers;
     Ptr<SceProcessParam> process_param;
@@ -171,7 +177,7 @@ struct KernelState {
         return next_uid++;
     }
 
-    bool init(MemState &mem, CallImportFunc call_import, CPUBackend cpu_backend, bool cpu_opt);
+    bool init(MemState &mem, CallImportFunc call_import, CPUBackend cpu_backend, bool cpu_opt, ClockMode clock_mode, float clock_scale);
     void load_process_param(MemState &mem, Ptr<uint32_t> ptr);
     ThreadStatePtr create_thread(MemState &mem, const char *name, Ptr<const void> entry_point = Ptr<const void>(0));
     ThreadStatePtr create_thread(MemState &mem, const char *name, Ptr<const void> entry_point, int init_priority, SceInt32 affinity_mask, int stack_size, const SceKernelThreadOptParam *option);
@@ -30,6 +30,7 @@
 
 struct CPUState;
 struct CPUContext;
+class EmuClock;
 
 struct ThreadState;
 struct ThreadParams;
@@ -136,6 +137,8 @@ private:
     int call_level = 0;
 
     MemState &mem;
+    // counts the running threads, set by init
+    EmuClock *clock = nullptr;
 };
 
 typedef std::shared_ptr<ThreadState> ThreadStatePtr;
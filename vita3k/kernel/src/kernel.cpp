@@ -25,10 +25,12 @@
 
 #include <cpu/functions.h>
 #include <mem/ptr.h>
+#include <nids/functions.h>
 #include <util/align.h>
 #include <util/arm.h>
 #include <util/find.h>
 #include <util/log.h>
+#include <util/metrics.h>
 
 #include <SDL_thread.h>
 #include <spdlog/fmt/fmt.h>
@@ -83,16 +85,20 @@ static int SDLCALL thread_function(void *data) {
 }
 
 KernelState::KernelState()
-    : debugger(*this) {
+    : import_counters(std::make_unique<std::atomic<uint32_t>[]>(import_function_count()))
+    , debugger(*this) {
+    for (uint32_t i = 0; i < import_function_count(); i++)
+        import_counters[i] = metrics::INVALID_COUNTER;
 }
 
-bool KernelState::init(MemState &mem, CallImportFunc call_import, CPUBackend cpu_backend, bool cpu_opt) {
+bool KernelState::init(MemState &mem, CallImportFunc call_import, CPUBackend cpu_backend, bool cpu_opt, ClockMode clock_mode, float clock_scale) {
     constexpr std::size_t MAX_CORE_COUNT = 150;
 
     corenum_allocator.set_max_core_count(MAX_CORE_COUNT);
     exclusive_monitor = new_exclusive_monitor(MAX_CORE_COUNT);
-    start_tick = rtc_get_ticks(rtc_base_ticks());
+    clock.init(clock_mode, clock_scale);
     base_tick = { rtc_base_ticks() };
+    start_tick = rtc_get_ticks(clock, base_tick.tick);
     cpu_protocol = std::make_unique<CPUProtocol>(*this, mem, call_import);
     this->cpu_backend = cpu_backend;
     this->cpu_opt = cpu_opt;
@@ -25,6 +25,8 @@
 #include <util/arm.h>
 #include <util/fs.h>
 #include <util/log.h>
+#include <util/metrics.h>
+#include <util/worker_pool.h>
 
 #include <spdlog/fmt/fmt.h>
 #include <util/elf.h>
@@ -36,11 +38,16 @@
 #include <miniz.h>
 #include <self.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #define NID_MODULE_STOP 0x79F8E492
 #define NID_MODULE_EXIT 0x913482A9
@@ -180,9 +187,8 @@ static bool load_imports(const sce_module_info_raw &module, Ptr<const void> segm
             var_entry_table = long_imports->var_entry_table;
         }
 
-        std::string lib_name;
+        const std::string lib_name = library_name ? Ptr<const char>(library_name).get(mem) : "unknown";
         if (kernel.debugger.log_imports) {
-            lib_name = Ptr<const char>(library_name).get(mem);
             LOG_INFO("Loading func imports from {}", lib_name);
         }
 
@@ -194,6 +200,15 @@ static bool load_imports(const sce_module_info_raw &module, Ptr<const void> segm
             return false;
         }
 
+        // the HLE calls are also counted for each library, the first library importing a function keeps it
+        const metrics::CounterId counter = metrics::add_counter("hle_" + lib_name);
+        for (size_t i = 0; i < num_syms_funcs; ++i) {
+            const uint32_t index = import_function_index(nids[i]);
+            uint32_t unbound = metrics::INVALID_COUNTER;
+            if (index < import_function_count())
+                kernel.import_counters[index].compare_exchange_strong(unbound, counter, std::memory_order_relaxed);
+        }
+
         const uint32_t *const var_nids = Ptr<const uint32_t>(var_nid_table).get(mem);
         const Ptr<uint32_t> *const var_entries = Ptr<Ptr<uint32_t>>(var_entry_table).get(mem);
 
@@ -362,13 +377,51 @@ static bool load_exports(Ptr<const void> &entry_point, const sce_module_info_raw
     return true;
 }
 
+namespace {
+
+// Segment to copy from the SELF, inflating it if it is compressed
+struct SegmentCopy {
+    Elf_Half seg_index;
+    const uint8_t *src;
+    uint32_t src_size;
+    uint8_t *dest;
+    uint32_t dest_size;
+    bool compressed;
+    bool done = false;
+};
+
+struct RelocationSegment {
+    const uint8_t *data;
+    uint32_t size;
+    // buffer data points to if the segment is compressed
+    std::unique_ptr<uint8_t[]> inflated;
+};
+
+// SELF whose segments are allocated in guest memory but not filled yet
+struct PreparedSelf {
+    const void *self;
+    std::string self_path;
+    SegmentInfosForReloc segment_reloc_info;
+    std::vector<SegmentCopy> copies;
+    // in segment order
+    std::vector<RelocationSegment> relocations;
+};
+
+} // namespace
+
+static void free_segments(MemState &mem, const SegmentInfosForReloc &segs_info) {
+    for (const auto &[seg_index, segment] : segs_info)
+        free(mem, segment.addr);
+}
+
 /**
+ * \brief Check the headers of the SELF and allocate its loadable segments.
  * \return Negative on failure
  */
-SceUID load_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &mem, const void *self, const std::string &self_path) {
-    // TODO: use raw I/O from path when io becomes less bad
-    const uint8_t *const self_bytes = static_cast<const uint8_t *>(self);
-    const SCE_header &self_header = *static_cast<const SCE_header *>(self);
+static SceUID prepare_self(PreparedSelf &prepared, MemState &mem) {
+    const std::string &self_path = prepared.self_path;
+    const uint8_t *const self_bytes = static_cast<const uint8_t *>(prepared.self);
+    const SCE_header &self_header = *static_cast<const SCE_header *>(prepared.self);
 
     // assumes little endian host
     if (self_header.magic != 0x00454353) {
@@ -460,14 +513,7 @@ SceUID load_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &me
         }
     };
 
-    SegmentInfosForReloc segment_reloc_info;
-
-    auto free_all_segments = [](MemState &mem, SegmentInfosForReloc &segs_info) {
-        for (auto _seg : segs_info) {
-            const SegmentInfoForReloc &segment = _seg.second;
-            free(mem, segment.addr);
-        }
-    };
+    SegmentInfosForReloc &segment_reloc_info = prepared.segment_reloc_info;
 
     for (Elf_Half seg_index = 0; seg_index < elf.e_phnum; ++seg_index) {
         const Elf32_Phdr &seg_header = segments[seg_index];
@@ -477,10 +523,14 @@ SceUID load_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &me
 
         if (seg_infos[seg_index].encryption != 2) { // 0 should also be valid?
             LOG_ERROR("Cannot load ELF {}: invalid segment encryption status {}.", self_path, seg_infos[seg_index].encryption);
-            free_all_segments(mem, segment_reloc_info);
+            free_segments(mem, segment_reloc_info);
             return -1;
         }
 
+        const bool compressed = seg_infos[seg_index].compression == 2;
+        const uint8_t *const compressed_segment_bytes = self_bytes + seg_infos[seg_index].offset;
+        const auto compressed_size = static_cast<uint32_t>(seg_infos[seg_index].length);
+
         if (seg_header.p_type == PT_NULL) {
             // Nothing to do.
         } else if (seg_header.p_type == PT_LOAD) {
@@ -500,7 +550,7 @@ SceUID load_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &me
 
                     if (!isRelocatable || !segment_address) {
                         LOG_CRITICAL("Loading {} ELF {} failed: Could not allocate {} bytes @ {} for segment {}.", (isRelocatable) ? "relocatable" : "fixed", self_path, log_hex(seg_header.p_memsz), log_hex(seg_header.p_vaddr), seg_index);
-                        free_all_segments(mem, segment_reloc_info);
+                        free_segments(mem, segment_reloc_info);
                         return SCE_KERNEL_ERROR_NO_MEMORY; //TODO is this correct?
                     }
                 }
@@ -514,39 +564,26 @@ SceUID load_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &me
 
                 if (!segment_address) {
                     LOG_CRITICAL("Loading {} ELF {} failed: Could not allocate {} bytes @ {} for segment {}.", (isRelocatable) ? "relocatable" : "fixed", self_path, log_hex(seg_header.p_memsz), log_hex(seg_header.p_vaddr), seg_index);
-                    free_all_segments(mem, segment_reloc_info);
+                    free_segments(mem, segment_reloc_info);
                     return SCE_KERNEL_ERROR_NO_MEMORY; // TODO is this correct?
                 }
 
                 const Ptr<uint8_t> seg_ptr(segment_address);
-                if (seg_infos[seg_index].compression == 2) {
-                    unsigned long dest_bytes = seg_header.p_filesz;
-                    const uint8_t *const compressed_segment_bytes = self_bytes + seg_infos[seg_index].offset;
-
-                    int res = mz_uncompress(reinterpret_cast<uint8_t *>(seg_ptr.get(mem)), &dest_bytes, compressed_segment_bytes, static_cast<mz_ulong>(seg_infos[seg_index].length));
-                    assert(res == MZ_OK);
-                } else {
-                    memcpy(seg_ptr.get(mem), seg_bytes, seg_header.p_filesz);
-                }
+                if (compressed)
+                    prepared.copies.push_back({ seg_index, compressed_segment_bytes, compressed_size, seg_ptr.get(mem), seg_header.p_filesz, true });
+                else
+                    prepared.copies.push_back({ seg_index, seg_bytes, seg_header.p_filesz, seg_ptr.get(mem), seg_header.p_filesz, false });
 
                 segment_reloc_info[seg_index] = { segment_address, seg_header.p_vaddr, seg_header.p_memsz };
             }
         } else if (seg_header.p_type == PT_SCE_RELA) {
-            if (seg_infos[seg_index].compression == 2) {
-                unsigned long dest_bytes = seg_header.p_filesz;
-                const uint8_t *const compressed_segment_bytes = self_bytes + seg_infos[seg_index].offset;
-                std::unique_ptr<uint8_t[]> uncompressed(new uint8_t[dest_bytes]);
-
-                int res = mz_uncompress(uncompressed.get(), &dest_bytes, compressed_segment_bytes, static_cast<mz_ulong>(seg_infos[seg_index].length));
-                assert(res == MZ_OK);
-                if (!relocate(uncompressed.get(), seg_header.p_filesz, segment_reloc_info, mem)) {
-                    return -1;
-                }
-
+            if (compressed) {
+                RelocationSegment relocation{ nullptr, seg_header.p_filesz, std::make_unique<uint8_t[]>(seg_header.p_filesz) };
+                relocation.data = relocation.inflated.get();
+                prepared.copies.push_back({ seg_index, compressed_segment_bytes, compressed_size, relocation.inflated.get(), seg_header.p_filesz, true });
+                prepared.relocations.push_back(std::move(relocation));
             } else {
-                if (!relocate(seg_bytes, seg_header.p_filesz, segment_reloc_info, mem)) {
-                    return -1;
-                }
+                prepared.relocations.push_back({ seg_bytes, seg_header.p_filesz, nullptr });
             }
         } else if ((seg_header.p_type == PT_SCE_COMMENT) || (seg_header.p_type == PT_SCE_VERSION)
             || (seg_header.p_type == PT_ARM_EXIDX) /* TODO: this may be important and require being loaded */) {
@@ -556,6 +593,56 @@ SceUID load_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &me
         }
     }
 
+    return 0;
+}
+
+static bool copy_segment(const SegmentCopy &copy) {
+    if (!copy.compressed) {
+        memcpy(copy.dest, copy.src, copy.dest_size);
+        return true;
+    }
+
+    mz_ulong dest_bytes = copy.dest_size;
+    return mz_uncompress(copy.dest, &dest_bytes, copy.src, static_cast<mz_ulong>(copy.src_size)) == MZ_OK;
+}
+
+// Copy and inflate the segments, in parallel when possible
+static void fill_segments(std::vector<SegmentCopy *> &copies) {
+    // start with the largest segments so the last ones to finish are short
+    std::sort(copies.begin(), copies.end(), [](const SegmentCopy *a, const SegmentCopy *b) { return a->src_size > b->src_size; });
+
+    util::parallel_for(copies.size(), [&](std::size_t i) {
+        copies[i]->done = copy_segment(*copies[i]);
+    });
+}
+
+/**
+ * \brief Relocate the filled segments, then link and register the module.
+ * \return Negative on failure
+ */
+static SceUID link_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &mem, PreparedSelf &prepared) {
+    const std::string &self_path = prepared.self_path;
+    const uint8_t *const self_bytes = static_cast<const uint8_t *>(prepared.self);
+    const SCE_header &self_header = *static_cast<const SCE_header *>(prepared.self);
+    const Elf32_Ehdr &elf = *reinterpret_cast<const Elf32_Ehdr *>(self_bytes + self_header.elf_offset);
+    const uint32_t module_info_offset = elf.e_entry & 0x3fffffff;
+    const Elf32_Phdr *const segments = reinterpret_cast<const Elf32_Phdr *>(self_bytes + self_header.phdr_offset);
+    SegmentInfosForReloc &segment_reloc_info = prepared.segment_reloc_info;
+
+    for (const auto &copy : prepared.copies) {
+        if (!copy.done) {
+            LOG_ERROR("Cannot load ELF {}: segment {} could not be inflated.", self_path, copy.seg_index);
+            free_segments(mem, segment_reloc_info);
+            return -1;
+        }
+    }
+
+    for (const auto &relocation : prepared.relocations) {
+        if (!relocate(relocation.data, relocation.size, segment_reloc_info, mem)) {
+            return -1;
+        }
+    }
+
     if (kernel.debugger.dump_elfs) {
         // Dump elf
         std::vector<uint8_t> dump_elf(self_bytes + self_header.header_len, self_bytes + self_header.self_filesize);
@@ -665,3 +752,66 @@ SceUID load_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &me
     }
     return uid;
 }
+
+/**
+ * \return Negative on failure
+ */
+SceUID load_self(Ptr<const void> &entry_point, KernelState &kernel, MemState &mem, const void *self, const std::string &self_path) {
+    PreparedSelf prepared{ self, self_path };
+    const SceUID res = prepare_self(prepared, mem);
+    if (res < 0)
+        return res;
+
+    std::vector<SegmentCopy *> copies;
+    for (auto &copy : prepared.copies)
+        copies.push_back(&copy);
+    fill_segments(copies);
+
+    return link_self(entry_point, kernel, mem, prepared);
+}
+
+size_t load_selfs(std::vector<SelfToLoad> &selfs, KernelState &kernel, MemState &mem) {
+    using clock = std::chrono::steady_clock;
+    const auto to_ms = [](clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+    const auto start = clock::now();
+
+    // the segments are allocated in order, so they are at the same place on each boot
+    std::vector<PreparedSelf> prepared;
+    prepared.reserve(selfs.size());
+    for (auto &self : selfs) {
+        auto &current = prepared.emplace_back(PreparedSelf{ self.self, self.path });
+        self.uid = prepare_self(current, mem);
+        if (self.uid < 0) {
+            prepared.pop_back();
+            break;
+        }
+    }
+    const auto allocated = clock::now();
+
+    std::vector<SegmentCopy *> copies;
+    for (auto &self : prepared) {
+        for (auto &copy : self.copies)
+            copies.push_back(&copy);
+    }
+    fill_segments(copies);
+    const auto filled = clock::now();
+
+    size_t loaded = 0;
+    while (loaded < prepared.size()) {
+        selfs[loaded].uid = link_self(selfs[loaded].entry_point, kernel, mem, prepared[loaded]);
+        if (selfs[loaded].uid < 0)
+            break;
+        loaded++;
+    }
+
+    // like with load_self, the modules after a failed one are not loaded
+    for (size_t i = loaded + 1; i < prepared.size(); i++) {
+        free_segments(mem, prepared[i].segment_reloc_info);
+        selfs[i].uid = -1;
+    }
+
+    LOG_INFO("Loaded {} of {} modules in {:.1f} ms (allocation: {:.1f} ms, copy and inflate: {:.1f} ms on {} segments, relocation and linking: {:.1f} ms)",
+        loaded, selfs.size(), to_ms(clock::now() - start), to_ms(allocated - start), to_ms(filled - allocated), copies.size(), to_ms(clock::now() - filled));
+
+    return loaded;
+}
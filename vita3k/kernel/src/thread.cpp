@@ -28,6 +28,7 @@
 
 #include <spdlog/fmt/fmt.h>
 #include <util/log.h>
+#include <util/trace.h>
 
 #include <cassert>
 #include <cstring>
@@ -70,7 +71,8 @@ int ThreadState::init(KernelState &kernel, const char *name, Ptr<const void> ent
     }
     this->affinity_mask = affinity_mask;
     this->stack_size = stack_size;
-    start_tick = rtc_get_ticks(kernel.base_tick.tick);
+    clock = &kernel.clock;
+    start_tick = rtc_get_ticks(kernel.clock, kernel.base_tick.tick);
     last_vblank_waited = 0;
 
     cpu = init_cpu(kernel.cpu_backend, kernel.cpu_opt, id, static_cast<std::size_t>(core_num), mem, kernel.cpu_protocol.get());
@@ -117,9 +119,7 @@ int ThreadState::init(KernelState &kernel, const char *name, Ptr<const void> ent
 void ThreadState::raise_waiting_threads() {
     for (auto t : waiting_threads) {
         const std::unique_lock<std::mutex> lock(t->mutex);
-        assert(t->status == ThreadStatus::wait);
-        t->status = ThreadStatus::run;
-        t->status_cond.notify_all();
+        t->update_status(ThreadStatus::run, ThreadStatus::wait);
     }
     waiting_threads.clear();
 }
@@ -332,6 +332,17 @@ void ThreadState::update_status(ThreadStatus status, std::optional<ThreadStatus>
     if (expected)
         assert(expected.value() == this->status);
 
+    // the virtual clock only skips time when no thread is running
+    if (clock && (this->status == ThreadStatus::run) != (status == ThreadStatus::run)) {
+        if (status == ThreadStatus::run)
+            clock->add_runner();
+        else
+            clock->remove_runner();
+    }
+
+    if (trace::is_enabled())
+        trace::record(trace::EventType::THREAD_STATUS, static_cast<uint32_t>(status), id, { static_cast<uint32_t>(this->status) });
+
     this->status = status;
     status_cond.notify_all();
 
@@ -375,7 +375,18 @@ struct LangState {
         { "fps", "FPS" },
         { "avg", "Avg" },
         { "min", "Min" },
-        { "max", "Max" }
+        { "max", "Max" },
+        { "frame", "Frame" },
+        { "render", "Render" },
+        { "draws", "Draws" },
+        { "lists", "Lists" },
+        { "textures", "Tex hit/miss/up" },
+        { "compiles", "Shader/Pipeline" },
+        { "hle", "HLE" },
+        { "jit", "JIT" },
+        { "faults", "Faults" },
+        { "underruns", "Underruns" },
+        { "ngs", "NGS" }
     };
     struct Settings {
         std::map<std::string, std::string> main = { { "title", "Settings" } };
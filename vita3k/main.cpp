@@ -30,12 +30,16 @@
 #include <packages/functions.h>
 #include <packages/pkg.h>
 #include <packages/sfo.h>
+#include <renderer/capture.h>
 #include <renderer/functions.h>
 #include <renderer/shaders.h>
 #include <renderer/state.h>
 #include <shader/spirv_recompiler.h>
+#include <util/lock_and_find.h>
 #include <util/log.h>
+#include <util/metrics.h>
 #include <util/string_utils.h>
+#include <util/trace.h>
 
 #if USE_DISCORD
 #include <app/discord.h>
@@ -50,9 +54,16 @@
 #include <SDL.h>
 #include <chrono>
 #include <cstdlib>
+#include <ctime>
 #include <thread>
 
 static void run_execv(char *argv[], EmuEnvState &emuenv) {
+    // nothing is written by the background threads once the process is replaced
+    trace::stop();
+    metrics::stop_dump();
+    renderer::capture::stop();
+    logging::flush();
+
     char *args[10];
     args[0] = argv[0];
     args[1] = (char *)"-a";
@@ -81,6 +92,90 @@ static void run_execv(char *argv[], EmuEnvState &emuenv) {
 #endif
 };
 
+static bool is_app_running(EmuEnvState &emuenv) {
+    const auto main_thread = lock_and_find(emuenv.main_thread_id, emuenv.kernel.threads, emuenv.kernel.mutex);
+    if (!main_thread)
+        return false;
+
+    const std::lock_guard<std::mutex> lock(main_thread->mutex);
+    return main_thread->status != ThreadStatus::dormant;
+}
+
+// Run the app without window nor GUI until it exits, is closed or has shown enough frames, then write the report
+static ExitCode run_headless(EmuEnvState &emuenv) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::clock_t cpu_start = std::clock();
+
+    // normally selected by the GUI, the first user created by it is 00
+    emuenv.io.user_id = emuenv.cfg.user_id.empty() ? "00" : emuenv.cfg.user_id;
+
+    Ptr<const void> entry_point;
+    if (const auto err = load_app(entry_point, emuenv, string_utils::utf_to_wide(emuenv.io.app_path)); err != Success)
+        return err;
+
+    emuenv.renderer->base_path = emuenv.base_path.c_str();
+    emuenv.renderer->title_id = emuenv.io.title_id.c_str();
+    emuenv.renderer->self_name = emuenv.self_name.c_str();
+    if (renderer::get_shaders_cache_hashs(*emuenv.renderer) && emuenv.cfg.shader_cache) {
+        for (const auto &hash : emuenv.renderer->shaders_cache_hashs)
+            emuenv.renderer->precompile_shader(hash);
+    }
+
+    if (const auto err = run_app(emuenv, entry_point); err != Success)
+        return err;
+
+    const std::size_t frame_limit = emuenv.cfg.headless_frames;
+    bool quit = false;
+    while (!quit && !emuenv.load_exec && is_app_running(emuenv)) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_QUIT)
+                quit = true;
+        }
+
+        // Driver acto!
+        renderer::process_batches(*emuenv.renderer.get(), emuenv.renderer->features, emuenv.mem, emuenv.cfg);
+
+        bool presented;
+        {
+            const std::lock_guard<std::mutex> guard(emuenv.display.display_info_mutex);
+            presented = emuenv.renderer->should_display;
+            if (presented) {
+                const SceFVector2 viewport_pos = { emuenv.viewport_pos.x, emuenv.viewport_pos.y };
+                const SceFVector2 viewport_size = { emuenv.viewport_size.x, emuenv.viewport_size.y };
+                emuenv.renderer->render_frame(viewport_pos, viewport_size, emuenv.display, emuenv.gxm, emuenv.mem);
+            }
+        }
+
+        if (presented) {
+            FrameMark; // Tracy - Frame end mark for headless loop
+        } else {
+            // process_batches returns right away until the app creates a gxm context, don't spin on it
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (frame_limit && (emuenv.frame_count >= frame_limit))
+            quit = true;
+    }
+
+    const std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - start;
+    const double cpu_time = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    emuenv.kernel.exit_delete_all_threads();
+    emuenv.gxm.display_queue.abort();
+    emuenv.display.abort = true;
+    if (emuenv.display.vblank_thread)
+        emuenv.display.vblank_thread->join();
+
+    emuenv.renderer->preclose_action();
+    trace::stop();
+    metrics::stop_dump();
+    renderer::capture::stop();
+    app::write_headless_report(emuenv, emuenv.cfg.headless_report, wall_time.count(), cpu_time);
+
+    return Success;
+}
+
 int main(int argc, char *argv[]) {
     ZoneScoped; // Tracy - Track main function scope
     Root root_paths;
@@ -170,11 +265,19 @@ int main(int argc, char *argv[]) {
         SDL_SetHint(SDL_HINT_JOYSTICK_HIDAPI_SWITCH, "1");
         SDL_SetHint(SDL_HINT_JOYSTICK_HIDAPI_JOY_CONS, "1");
 
-        if (SDL_Init(SDL_INIT_GAMECONTROLLER | SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
-            app::error_dialog("SDL initialisation failed.");
-            return SDLInitFailed;
+        if (cfg.headless) {
+            // audio is optional, machines running headless often have no device
+            if ((SDL_Init(SDL_INIT_EVENTS | SDL_INIT_AUDIO) < 0) && (SDL_Init(SDL_INIT_EVENTS) < 0)) {
+                LOG_ERROR("SDL initialisation failed: {}", SDL_GetError());
+                return SDLInitFailed;
+            }
+        } else {
+            if (SDL_Init(SDL_INIT_GAMECONTROLLER | SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
+                app::error_dialog("SDL initialisation failed.");
+                return SDLInitFailed;
+            }
+            SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
         }
-        SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     }
 
     LOG_INFO("{}", window_title);
@@ -193,7 +296,7 @@ int main(int argc, char *argv[]) {
     init_libraries(emuenv);
 
     GuiState gui;
-    if (!cfg.console) {
+    if (!cfg.console && !cfg.headless) {
         gui::pre_init(gui, emuenv);
         if (!emuenv.cfg.initial_setup) {
             while (!emuenv.cfg.initial_setup) {
@@ -212,7 +315,7 @@ int main(int argc, char *argv[]) {
     }
 
     if (cfg.content_path.has_value()) {
-        auto gui_ptr = cfg.console ? nullptr : &gui;
+        auto gui_ptr = (cfg.console || cfg.headless) ? nullptr : &gui;
         const auto extention = string_utils::tolower(cfg.content_path->extension().string());
         const auto is_archive = (extention == ".vpk") || (extention == ".zip");
         const auto is_rif = (extention == ".rif") || (extention == "work.bin");
@@ -239,21 +342,30 @@ int main(int argc, char *argv[]) {
                 LOG_ERROR("File dropped: [{}] is not supported.", cfg.content_path->string());
 
             emuenv.cfg.content_path.reset();
-            if (!cfg.console)
+            if (!cfg.console && !cfg.headless)
                 gui::init_home(gui, emuenv);
         }
     }
 
     if (run_type == app::AppRunType::Extracted) {
         emuenv.io.app_path = cfg.run_app_path ? *cfg.run_app_path : emuenv.app_info.app_title_id;
-        gui::init_user_app(gui, emuenv, emuenv.io.app_path);
+        // the headless mode only needs the parameters of the app, not its icon
+        if (cfg.headless)
+            gui::get_app_param(gui, emuenv, emuenv.io.app_path);
+        else
+            gui::init_user_app(gui, emuenv, emuenv.io.app_path);
         if (emuenv.cfg.run_app_path.has_value())
             emuenv.cfg.run_app_path.reset();
         else if (emuenv.cfg.content_path.has_value())
             emuenv.cfg.content_path.reset();
     }
 
-    if (!cfg.console) {
+    if (cfg.headless && (run_type == app::AppRunType::Unknown)) {
+        LOG_ERROR("Headless mode has no app to run.");
+        return InvalidApplicationPath;
+    }
+
+    if (!cfg.console && !cfg.headless) {
 #if USE_DISCORD
         auto discord_rich_presence_old = emuenv.cfg.discord_rich_presence;
 #endif
@@ -321,6 +433,9 @@ int main(int argc, char *argv[]) {
     if (emuenv.io.title_id.find("PCS") != std::string::npos)
         emuenv.app_sku_flag = get_license_sku_flag(emuenv, emuenv.app_info.app_content_id);
 
+    if (cfg.headless)
+        return run_headless(emuenv);
+
     if (cfg.console) {
         auto main_thread = emuenv.kernel.threads.at(emuenv.main_thread_id);
         auto lock = std::unique_lock<std::mutex>(main_thread->mutex);
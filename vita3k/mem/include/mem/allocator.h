@@ -21,12 +21,28 @@
 #include <mutex>
 #include <vector>
 
+// Allocates runs of slots in a bitmap where a set bit is a free slot, the lowest bit of a word is the lowest offset.
+// Summary levels with a bit per word of the level below let the searches skip the used and the free areas.
 struct BitmapAllocator {
-    std::vector<std::uint32_t> words;
-    std::size_t max_offset;
+    typedef std::vector<std::vector<std::uint64_t>> SummaryLevels;
+
+    std::vector<std::uint64_t> words;
+    std::size_t max_offset = 0;
+
+    // A bit is set for the words with at least one free slot
+    SummaryLevels free_levels;
+    // A bit is set for the words with all their slots free
+    SummaryLevels full_levels;
+    // A bit is set for the words with at least one used slot
+    SummaryLevels used_levels;
 
 protected:
-    int force_fill(const std::uint32_t offset, const int size, const bool or_mode = false);
+    void fill(const std::uint32_t offset, const int size, const bool free_mode);
+    void update_summaries(const std::size_t word_index);
+    void rebuild_summaries();
+
+    std::size_t find_free(const std::size_t offset) const;
+    std::size_t find_used(const std::size_t offset) const;
 
 public:
     BitmapAllocator() = default;
@@ -41,4 +57,10 @@ public:
 
     // Count free bits in [offset, offset_end) (exclusive)
     int free_slot_count(const std::uint32_t offset, const std::uint32_t offset_end) const;
+
+    // Check that no bit of [offset, offset_end) (exclusive) is free
+    bool is_allocated(const std::uint32_t offset, const std::uint32_t offset_end) const;
+
+    // Count the used bits from offset to the first free one
+    std::size_t allocated_count(const std::uint32_t offset) const;
 };
@@ -21,6 +21,8 @@
 #include <mem/util.h>
 
 struct MemState;
+struct ProtectStats;
+enum class WriteTrackerType;
 
 typedef std::function<bool(uint8_t *addr, bool write)> AccessViolationHandler;
 
@@ -31,17 +33,24 @@ enum {
     MEM_PERM_READWRITE = MEM_PERM_READONLY | MEM_PERM_WRITE
 };
 
-bool init(MemState &state);
+bool init(MemState &state, WriteTrackerType tracker_type);
 Address alloc(MemState &state, size_t size, const char *name);
 Address alloc(MemState &state, size_t size, const char *name, unsigned int alignment);
 void protect_inner(MemState &state, Address addr, size_t size, const std::uint32_t perm);
 void unprotect_inner(MemState &state, Address addr, size_t size);
+// The protection is only applied on the next flush_protect call
 bool add_protect(MemState &state, Address addr, const size_t size, const std::uint32_t perm, ProtectCallback callback);
+void flush_protect(MemState &state);
 void open_access_parent_protect_segment(MemState &mem, Address addr);
 void close_access_parent_protect_segment(MemState &mem, Address addr);
 bool is_protecting(MemState &state, Address addr, std::uint32_t *perm = nullptr);
+ProtectStats get_protect_stats(MemState &state);
 bool is_valid_addr(const MemState &state, Address addr);
 bool is_valid_addr_range(const MemState &state, Address start, Address end);
+// Bytes from addr to the first page not allocated, 0 if addr is not valid
+size_t get_valid_size(const MemState &state, Address addr);
+// Run the write watchers of the range before the host writes to it, so the write does not fault on their pages
+void notify_host_write(MemState &state, Address addr, size_t size);
 bool handle_access_violation(MemState &state, uint8_t *addr, bool write) noexcept;
 Block alloc_block(MemState &mem, size_t size, const char *name);
 Address alloc_at(MemState &state, Address address, size_t size, const char *name);
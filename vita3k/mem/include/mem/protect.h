@@ -0,0 +1,144 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/util.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Range of pages to protect or unprotect on the host
+struct ProtectRange {
+    std::uint32_t first_page = 0;
+    std::uint32_t page_count = 0;
+    std::uint32_t perm = 0;
+};
+
+struct ProtectStats {
+    std::uint64_t fault_count = 0;
+    std::uint64_t fault_time_ns = 0;
+    // batches of written pages read back from the write tracker
+    std::uint64_t collect_count = 0;
+    std::uint64_t collect_time_ns = 0;
+    std::uint64_t collected_page_count = 0;
+    // protection changes done on the host memory
+    std::uint64_t host_protect_count = 0;
+    std::size_t watcher_count = 0;
+};
+
+struct ProtectWatcher {
+    Address addr = 0;
+    std::size_t size = 0;
+    std::uint32_t perm = 0;
+    ProtectCallback callback;
+    std::uint32_t next_free = 0;
+};
+
+// Entry of a page list, ids are indexes in ProtectTable::links and 0 ends a list
+struct ProtectLink {
+    std::uint32_t watcher = 0;
+    std::uint32_t next = 0;
+};
+
+struct ProtectPage {
+    // read without the lock by the fault handler
+    std::atomic<std::uint32_t> watcher_count = 0;
+    std::uint32_t first_link = 0;
+    // strictest permission of the watchers
+    std::uint32_t perm = 0;
+    // number of open_access_parent_protect_segment calls covering the page, the page is not protected meanwhile
+    std::int32_t ref_count = 0;
+    // protection currently applied on the host
+    bool host_protected = false;
+    std::uint32_t host_perm = 0;
+    // in the list of pages to protect at the next flush
+    bool pending = false;
+};
+
+/**
+ * \brief Watchers of the accesses to the guest memory, indexed by page.
+ *
+ * Each page has the list of the watchers covering it, stored in a pooled array, so a fault only looks at its page.
+ * The pages are allocated by chunks when first watched and the watcher count of a page can be read without the lock.
+ * New protections are only queued, they are applied on the host by batches when flushing.
+ * Everything else must be called with mutex held.
+ */
+struct ProtectTable {
+    static constexpr std::uint32_t CHUNK_PAGES = 1024;
+
+    std::mutex mutex;
+
+    std::size_t page_size = 0;
+    std::uint32_t page_count = 0;
+    std::unique_ptr<std::atomic<ProtectPage *>[]> chunks;
+    std::vector<std::unique_ptr<ProtectPage[]>> chunk_storage;
+
+    std::vector<ProtectWatcher> watchers;
+    std::uint32_t free_watcher = 0;
+    std::size_t watcher_total = 0;
+    std::vector<ProtectLink> links;
+    std::uint32_t free_link = 0;
+
+    std::vector<std::uint32_t> pending_pages;
+
+    // page ranges locked by open_access_parent_protect_segment, by their first page
+    struct OpenRange {
+        std::uint32_t first_page = 0;
+        std::uint32_t page_count = 0;
+        std::int32_t open_count = 0;
+    };
+    std::unordered_map<std::uint32_t, OpenRange> open_ranges;
+
+    std::atomic<std::uint64_t> fault_count = 0;
+    std::atomic<std::uint64_t> fault_time_ns = 0;
+    std::atomic<std::uint64_t> host_protect_count = 0;
+    std::uint64_t collect_count = 0;
+    std::uint64_t collect_time_ns = 0;
+    std::uint64_t collected_page_count = 0;
+
+    void init(std::size_t page_size, std::size_t memory_size);
+
+    // Lock-free, nullptr if the page has never been watched
+    ProtectPage *find_page(std::uint32_t page) const;
+    ProtectPage &get_page(std::uint32_t page);
+    std::uint32_t watcher_count(std::uint32_t page) const;
+
+    // Register a watcher on the pages covering the range and queue the pages needing a stricter protection
+    std::uint32_t add_watcher(Address addr, std::size_t size, std::uint32_t perm, ProtectCallback callback);
+    // Remove the watcher from all its pages, the pages left without watcher are added to released_pages
+    void remove_watcher(std::uint32_t id, std::vector<std::uint32_t> &released_pages);
+    std::vector<std::uint32_t> get_page_watchers(std::uint32_t page) const;
+    // Queue a watched page to protect again at the next flush
+    void queue_page(std::uint32_t page);
+
+    // Take the queued pages still needing protection, merged into ranges of the same permission
+    std::vector<ProtectRange> take_pending_ranges();
+    // Ranges of the watched pages currently protected on the host with the permission
+    std::vector<ProtectRange> get_host_ranges(std::uint32_t perm) const;
+
+    // Lock the run of watched pages around the page of addr, returns its first page and size
+    OpenRange open_range(Address addr);
+    // Unlock a run locked by open_range, returns the pages of the run to protect again
+    std::vector<ProtectRange> close_range(Address addr);
+
+    ProtectStats get_stats() const;
+};
@@ -18,12 +18,13 @@
 #pragma once
 
 #include <mem/allocator.h>
+#include <mem/protect.h>
+#include <mem/tracker.h>
 #include <mem/util.h>
 
 #include <array>
 #include <map>
 #include <mutex>
-#include <set>
 
 struct MemPage {
     uint32_t allocated : 4;
@@ -36,48 +37,15 @@ typedef std::unique_ptr<uint8_t[], std::function<void(uint8_t *)>> Memory;
 typedef std::unique_ptr<MemPage[], std::function<void(MemPage *)>> PageTable;
 typedef std::map<int, std::string> PageNameMap;
 
-struct ProtectBlockInfo {
-    Address addr = 0;
-    size_t size = 0;
-    ProtectCallback callback;
-
-    bool operator<(const ProtectBlockInfo &other) const {
-        return this->addr < other.addr;
-    }
-};
-
-struct ProtectSegmentInfo {
-    Address addr = 0;
-    size_t size = 0;
-    std::set<ProtectBlockInfo> blocks;
-    std::int32_t ref_count = 0; // When reference count is active, we don't interfere protection.
-    std::uint32_t perm = 0;
-
-    ProtectSegmentInfo() = delete;
-    explicit ProtectSegmentInfo(Address addr)
-        : addr(addr) {}
-    explicit ProtectSegmentInfo(Address addr, size_t size, std::uint32_t perm)
-        : addr(addr)
-        , size(size)
-        , perm(perm) {
-    }
-
-    bool operator<(const ProtectSegmentInfo &other) const {
-        return this->addr < other.addr;
-    }
-};
-
-typedef std::set<ProtectSegmentInfo> ProtectSegmentTrees;
-
 struct MemState {
     std::mutex generation_mutex;
-    std::mutex protect_mutex;
 
     size_t page_size = 0;
     Memory memory;
     PageTable page_table;
     BitmapAllocator allocator;
-    ProtectSegmentTrees protect_tree;
+    ProtectTable protect;
+    WriteTrackerPtr tracker;
 
     PageNameMap page_name_map;
 };
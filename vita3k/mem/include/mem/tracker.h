@@ -0,0 +1,61 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/protect.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class WriteTrackerType {
+    // userfaultfd when the host supports it, mprotect otherwise
+    AUTO,
+    // host protection, every first write to a watched page raises a signal
+    MPROTECT,
+    // userfaultfd asynchronous write-protection, the written pages are read back with PAGEMAP_SCAN (Linux 6.7+)
+    USERFAULTFD,
+    // soft-dirty bits of /proc/self/pagemap, re-arming clears the bits of the whole process
+    SOFT_DIRTY,
+};
+
+/**
+ * \brief Host mechanism collecting by batches the guest pages written since they were armed, without any signal.
+ *
+ * Only the write watchers (MEM_PERM_READONLY) use it, the mprotect path stays in place for the others.
+ * Called with the protection table mutex held.
+ */
+struct WriteTracker {
+    virtual ~WriteTracker() = default;
+
+    virtual WriteTrackerType type() const = 0;
+
+    // Start tracking the writes to the ranges
+    virtual void arm(const std::vector<ProtectRange> &ranges) = 0;
+    // Append the pages of the ranges written since they were armed, these pages are not tracked anymore
+    virtual void collect(const std::vector<ProtectRange> &ranges, std::vector<std::uint32_t> &written_pages) = 0;
+};
+
+typedef std::unique_ptr<WriteTracker> WriteTrackerPtr;
+
+// Returns nullptr for MPROTECT or when the host does not support the backend
+WriteTrackerPtr create_write_tracker(WriteTrackerType type, std::uint8_t *memory, std::size_t memory_size, std::size_t page_size);
+
+WriteTrackerType get_write_tracker_type(const std::string &name);
+const char *get_write_tracker_name(WriteTrackerType type);
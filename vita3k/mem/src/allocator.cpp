@@ -15,77 +15,183 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+
 #include <mem/allocator.h>
 
-BitmapAllocator::BitmapAllocator(const std::size_t total_bits)
-    : words((total_bits >> 5) + ((total_bits % 32 != 0) ? 1 : 0), 0xFFFFFFFF)
-    , max_offset(total_bits) {
+#include <algorithm>
+#include <bit>
+
+constexpr std::size_t NOT_FOUND = SIZE_MAX;
+
+// A run at least this long always has a word with all its slots free
+constexpr int LARGE_RUN_SIZE = 127;
+
+static std::size_t word_count(const std::size_t total_bits) {
+    return (total_bits + 63) >> 6;
 }
 
-void BitmapAllocator::set_maximum(const std::size_t total_bits) {
-    const std::size_t total_before = words.size();
-    const std::size_t total_after = (total_bits >> 5) + ((total_bits % 32 != 0) ? 1 : 0);
+// Mask of count bits from the bit first of a word
+static std::uint64_t range_mask(const std::size_t first, const std::size_t count) {
+    return (count >= 64 ? ~0ULL : ((1ULL << count) - 1)) << first;
+}
+
+template <typename Predicate>
+static void build_levels(BitmapAllocator::SummaryLevels &levels, const std::vector<std::uint64_t> &words, Predicate predicate) {
+    levels.clear();
+
+    std::vector<std::uint64_t> bits(word_count(words.size()), 0);
+    for (std::size_t i = 0; i < words.size(); i++) {
+        if (predicate(words[i]))
+            bits[i >> 6] |= 1ULL << (i & 63);
+    }
+    levels.push_back(std::move(bits));
+
+    // Stop at the level with a single word
+    while (levels.back().size() > 1) {
+        const std::vector<std::uint64_t> &below = levels.back();
+        std::vector<std::uint64_t> above(word_count(below.size()), 0);
+        for (std::size_t i = 0; i < below.size(); i++) {
+            if (below[i] != 0)
+                above[i >> 6] |= 1ULL << (i & 63);
+        }
+        levels.push_back(std::move(above));
+    }
+}
+
+static void set_level_bit(BitmapAllocator::SummaryLevels &levels, std::size_t index, const bool set) {
+    for (std::vector<std::uint64_t> &bits : levels) {
+        std::uint64_t &word = bits[index >> 6];
+        const bool was_empty = word == 0;
+        if (set) {
+            word |= 1ULL << (index & 63);
+        } else {
+            word &= ~(1ULL << (index & 63));
+        }
 
-    words.resize(total_after);
+        // The level above only changes when the word becomes empty or stops being empty
+        if ((word == 0) == was_empty)
+            return;
+        index >>= 6;
+    }
+}
 
-    if (total_after > total_before) {
-        for (std::size_t i = total_before; i < total_after; i++) {
-            words[i] = 0xFFFFFFFFU;
+// Index of the first word from index with its bit set in the first level, or NOT_FOUND
+static std::size_t find_level_bit(const BitmapAllocator::SummaryLevels &levels, std::size_t index) {
+    std::size_t level = 0;
+    for (; level < levels.size(); level++) {
+        const std::vector<std::uint64_t> &bits = levels[level];
+        const std::size_t word = index >> 6;
+        if (word >= bits.size())
+            return NOT_FOUND;
+
+        const std::uint64_t masked = bits[word] & (~0ULL << (index & 63));
+        if (masked != 0) {
+            index = (word << 6) + std::countr_zero(masked);
+            break;
         }
+
+        // Nothing left in this word, go on with the next one from the level above
+        index = word + 1;
     }
 
+    if (level == levels.size())
+        return NOT_FOUND;
+
+    while (level-- > 0)
+        index = (index << 6) + std::countr_zero(levels[level][index]);
+
+    return index;
+}
+
+BitmapAllocator::BitmapAllocator(const std::size_t total_bits) {
+    set_maximum(total_bits);
+}
+
+void BitmapAllocator::set_maximum(const std::size_t total_bits) {
+    const std::size_t total_before = std::min(max_offset, words.size() << 6);
+
+    words.resize(word_count(total_bits), 0);
     max_offset = total_bits;
+
+    // The bits past the maximum are kept used, so no run goes past it
+    if (total_bits < total_before && (total_bits & 63) != 0)
+        words.back() &= range_mask(0, total_bits & 63);
+
+    rebuild_summaries();
+
+    if (total_bits > total_before)
+        fill(static_cast<std::uint32_t>(total_before), static_cast<int>(total_bits - total_before), true);
 }
 
 void BitmapAllocator::reset() {
     words.clear();
+    max_offset = 0;
+    rebuild_summaries();
+}
+
+void BitmapAllocator::rebuild_summaries() {
+    build_levels(free_levels, words, [](const std::uint64_t word) { return word != 0; });
+    build_levels(full_levels, words, [](const std::uint64_t word) { return word == ~0ULL; });
+    build_levels(used_levels, words, [](const std::uint64_t word) { return word != ~0ULL; });
 }
 
-int BitmapAllocator::force_fill(const std::uint32_t offset, const int size, const bool or_mode) {
-    std::uint32_t *word = &words[0] + (offset >> 5);
-    const std::uint32_t set_bit = offset & 31;
-    int end_bit = static_cast<int>(set_bit + size);
+void BitmapAllocator::update_summaries(const std::size_t word_index) {
+    const std::uint64_t word = words[word_index];
+    set_level_bit(free_levels, word_index, word != 0);
+    set_level_bit(full_levels, word_index, word == ~0ULL);
+    set_level_bit(used_levels, word_index, word != ~0ULL);
+}
 
-    std::uint32_t wval = *word;
+void BitmapAllocator::fill(const std::uint32_t offset, const int size, const bool free_mode) {
+    const std::size_t end = std::min<std::size_t>(static_cast<std::size_t>(offset) + std::max(size, 0), max_offset);
 
-    if (end_bit <= 32) {
-        // The bit we need to allocate is in single word
-        const std::uint32_t mask = size == 32 ? 0xFFFFFFFFU : ((~(0xFFFFFFFFU >> size)) >> set_bit);
+    std::size_t bit = offset;
+    while (bit < end) {
+        const std::size_t index = bit >> 6;
+        const std::size_t word_end = std::min((index + 1) << 6, end);
+        const std::uint64_t mask = range_mask(bit & 63, word_end - bit);
 
-        if (or_mode) {
-            *word = wval | mask;
+        if (free_mode) {
+            words[index] |= mask;
         } else {
-            *word = wval & (~mask);
+            words[index] &= ~mask;
         }
+        update_summaries(index);
 
-        return std::min<int>(size, static_cast<int>((words.size() << 5) - set_bit));
+        bit = word_end;
     }
+}
 
-    // All the bits trails across some other words
-    std::uint32_t mask = 0xFFFFFFFFU >> set_bit;
-
-    while (end_bit > 0 && (word != words.data() + words.size())) {
-        wval = *word;
-
-        if (or_mode) {
-            *word = wval | mask;
-        } else {
-            *word = wval & (~mask);
-        }
-
-        word += 1;
+std::size_t BitmapAllocator::find_free(const std::size_t offset) const {
+    if (offset >= max_offset)
+        return NOT_FOUND;
+
+    std::size_t index = offset >> 6;
+    std::uint64_t masked = words[index] & (~0ULL << (offset & 63));
+    if (masked == 0) {
+        index = find_level_bit(free_levels, index + 1);
+        if (index == NOT_FOUND)
+            return NOT_FOUND;
+        masked = words[index];
+    }
 
-        // We only need to be careful with the first word, since it only fills
-        // some first bits. We should fully fill with other word, so set the mask full
-        mask = 0xFFFFFFFFU;
-        end_bit -= 32;
+    return (index << 6) + std::countr_zero(masked);
+}
 
-        if (end_bit < 32) {
-            mask = ~(mask >> static_cast<std::uint32_t>(end_bit));
-        }
+std::size_t BitmapAllocator::find_used(const std::size_t offset) const {
+    if (offset >= max_offset)
+        return max_offset;
+
+    std::size_t index = offset >> 6;
+    std::uint64_t masked = ~words[index] & (~0ULL << (offset & 63));
+    if (masked == 0) {
+        index = find_level_bit(used_levels, index + 1);
+        if (index == NOT_FOUND)
+            return max_offset;
+        masked = ~words[index];
     }
 
-    return std::min<int>(size, static_cast<int>((words.size() << 5) - set_bit));
+    return std::min((index << 6) + std::countr_zero(masked), max_offset);
 }
 
 void BitmapAllocator::free(const std::uint32_t offset, const int size) {
@@ -93,87 +199,56 @@ void BitmapAllocator::free(const std::uint32_t offset, const int size) {
         return;
     }
 
-    force_fill(offset, size, true);
+    fill(offset, size, true);
 }
 
 int BitmapAllocator::allocate_from(const std::uint32_t start_offset, int &size, const bool best_fit) {
-    if (words.empty()) {
+    if (words.empty() || size < 0) {
         return -1;
     }
 
-    std::uint32_t *word = &words[0] + (start_offset >> 5);
-
-    // We have arrived at le word that still have free position (bit 1)
-    std::uint32_t *word_end = &words[words.size() - 1];
-
-    int bflmin = 0xFFFFFF;
-    int bofmin = -1;
-    std::uint32_t *wordmin = nullptr;
-
-    // Keep finding
-    while (word <= word_end) {
-        std::uint32_t wv = *word;
-
-        if (wv != 0) {
-            // Still have free stuff
-            int bflen = 0;
-            int boff = 0;
-            std::uint32_t *bword = nullptr;
-
-            int cursor = 31;
-
-            while (cursor >= 0) {
-                if (((wv >> cursor) & 1) == 1) {
-                    boff = cursor;
-                    bflen = 0;
-                    bword = word;
-
-                    while (cursor >= 0 && (((wv >> cursor) & 1) == 1)) {
-                        bflen++;
-                        cursor--;
-
-                        if (cursor < 0 && (word + 1 <= word_end)) {
-                            cursor = 31;
-                            word++;
-                            wv = *word;
-                        }
-                    }
-
-                    if (bflen >= size) {
-                        if (!best_fit) {
-                            // Force allocate and then return
-                            const int offset = static_cast<int>(31 - boff + ((bword - &words[0]) << 5));
-                            if ((static_cast<std::size_t>(offset) + size) <= max_offset) {
-                                size = force_fill(static_cast<const std::uint32_t>(offset), size, false);
-                                return offset;
-                            }
-                        } else {
-                            if (bflen < bflmin) {
-                                bflmin = bflen;
-                                bofmin = boff;
-                                wordmin = bword;
-                            }
-                        }
-                    }
-                }
-
-                cursor--;
-            }
+    const std::size_t wanted = size;
+    std::size_t best_offset = NOT_FOUND;
+    std::size_t best_length = NOT_FOUND;
+
+    // Go through the free runs from the start offset, the large sizes only look at the runs with a full word
+    std::size_t offset = start_offset;
+    while (offset < max_offset) {
+        std::size_t run_start;
+        if (size >= LARGE_RUN_SIZE) {
+            const std::size_t index = find_level_bit(full_levels, (offset + 63) >> 6);
+            if (index == NOT_FOUND)
+                break;
+
+            // The first full word is past the start of the run only by the free bits at the end of the word before it
+            run_start = index << 6;
+            if (index > 0)
+                run_start -= std::countl_one(words[index - 1]);
+            run_start = std::max(run_start, offset);
+        } else {
+            run_start = find_free(offset);
+            if (run_start == NOT_FOUND)
+                break;
         }
 
-        word++;
+        const std::size_t run_end = find_used(run_start);
+        const std::size_t length = run_end - run_start;
+        if (length >= wanted && length < best_length) {
+            best_offset = run_start;
+            best_length = length;
+            if (!best_fit || length == wanted)
+                break;
+        }
+
+        offset = run_end;
     }
 
-    if (best_fit && bofmin != -1) {
-        // Force allocate and then return
-        const int offset = static_cast<int>(31 - bofmin + ((wordmin - &words[0]) << 5));
-        if ((static_cast<std::size_t>(offset) + size) <= max_offset) {
-            size = force_fill(static_cast<std::uint32_t>(offset), size, false);
-            return offset;
-        }
+    if (best_offset == NOT_FOUND) {
+        return -1;
     }
 
-    return -1;
+    fill(static_cast<std::uint32_t>(best_offset), size, false);
+    return static_cast<int>(best_offset);
 }
 
 int BitmapAllocator::allocate_at(const std::uint32_t start_offset, int size) {
@@ -181,43 +256,44 @@ int BitmapAllocator::allocate_at(const std::uint32_t start_offset, int size) {
         return -1;
     }
 
-    force_fill(start_offset, size, false);
+    fill(start_offset, size, false);
     return 0;
 }
 
-static int number_of_set_bits(std::uint32_t i) {
-    i = i - ((i >> 1) & 0x55555555);
-    i = (i & 0x33333333) + ((i >> 2) & 0x33333333);
-    return (((i + (i >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
-}
-
 int BitmapAllocator::free_slot_count(const std::uint32_t offset, const std::uint32_t offset_end) const {
-    if (offset >= offset_end) {
+    if (offset >= offset_end || offset >= max_offset) {
         return -1;
     }
 
-    const std::uint32_t beg_off = (offset >> 5);
-    const std::uint32_t end_off = (offset_end >> 5);
+    const std::size_t end = std::min<std::size_t>(offset_end, max_offset);
 
-    if (beg_off >= words.size()) {
-        return -1;
+    int free_count = 0;
+    std::size_t bit = offset;
+    while (bit < end) {
+        const std::size_t index = bit >> 6;
+        const std::size_t word_end = std::min((index + 1) << 6, end);
+        free_count += std::popcount(words[index] & range_mask(bit & 63, word_end - bit));
+        bit = word_end;
     }
 
-    std::uint32_t start_bit = offset;
-    const std::uint32_t end_bit = end_off >= words.size() ? max_offset : offset_end;
+    return free_count;
+}
 
-    std::uint32_t free_count = 0;
+bool BitmapAllocator::is_allocated(const std::uint32_t offset, const std::uint32_t offset_end) const {
+    if (offset >= offset_end || offset >= max_offset) {
+        return false;
+    }
 
-    while (start_bit < end_bit) {
-        const std::uint32_t next_end_bit = std::min<std::uint32_t>(((start_bit + 32) >> 5) << 5, end_bit);
+    const std::size_t end = std::min<std::size_t>(offset_end, max_offset);
 
-        const int left_shift = start_bit & 31;
-        const int right_shift = (31 - (next_end_bit - 1) & 31);
-        std::uint32_t word_to_scan = words[start_bit >> 5] << left_shift >> right_shift >> left_shift;
-        free_count += number_of_set_bits(word_to_scan);
+    // A single page is checked in its word
+    const std::size_t index = offset >> 6;
+    if (((end - 1) >> 6) == index)
+        return (words[index] & range_mask(offset & 63, end - offset)) == 0;
 
-        start_bit = next_end_bit;
-    }
+    return find_free(offset) >= end;
+}
 
-    return free_count;
+std::size_t BitmapAllocator::allocated_count(const std::uint32_t offset) const {
+    return std::min(find_free(offset), max_offset) - std::min<std::size_t>(offset, max_offset);
 }
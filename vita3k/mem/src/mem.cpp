@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstring>
 
@@ -48,7 +49,7 @@ static Address alloc_inner(MemState &state, uint32_t start_page, int page_count,
 static void delete_memory(uint8_t *memory);
 static void delete_pagetable(MemPage *page_table);
 
-bool init(MemState &state) {
+bool init(MemState &state, WriteTrackerType tracker_type) {
 #ifdef WIN32
     SYSTEM_INFO system_info = {};
     GetSystemInfo(&system_info);
@@ -92,6 +93,14 @@ bool init(MemState &state) {
     memset(state.page_table.get(), 0, sizeof(MemPage) * table_length);
 
     state.allocator.set_maximum(table_length);
+    state.protect.init(state.page_size, TOTAL_MEM_SIZE);
+
+    if (tracker_type != WriteTrackerType::MPROTECT) {
+        state.tracker = create_write_tracker(tracker_type, state.memory.get(), TOTAL_MEM_SIZE, state.page_size);
+        if (!state.tracker && tracker_type != WriteTrackerType::AUTO)
+            LOG_WARN("The host does not support {} memory tracking, falling back to mprotect", get_write_tracker_name(tracker_type));
+    }
+    LOG_INFO("Memory write tracking: {}", get_write_tracker_name(state.tracker ? state.tracker->type() : WriteTrackerType::MPROTECT));
 
     const auto handler = [&state](uint8_t *addr, bool write) noexcept {
         return handle_access_violation(state, addr, write);
@@ -128,13 +137,21 @@ static void delete_pagetable(MemPage *page_table) {
 
 bool is_valid_addr(const MemState &state, Address addr) {
     const size_t page_num = addr / state.page_size;
-    return addr && state.allocator.free_slot_count(page_num, page_num + 1) == 0;
+    return addr && state.allocator.is_allocated(page_num, page_num + 1);
 }
 
 bool is_valid_addr_range(const MemState &state, Address start, Address end) {
     const uint32_t start_page = start / state.page_size;
     const uint32_t end_page = (end + state.page_size - 1) / state.page_size;
-    return state.allocator.free_slot_count(start_page, end_page) == 0;
+    return state.allocator.is_allocated(start_page, end_page);
+}
+
+size_t get_valid_size(const MemState &state, Address addr) {
+    if (!is_valid_addr(state, addr))
+        return 0;
+
+    const uint32_t page_num = addr / state.page_size;
+    return state.allocator.allocated_count(page_num) * state.page_size - addr % state.page_size;
 }
 
 static Address alloc_inner(MemState &state, uint32_t start_page, int page_count, const char *name, const bool force) {
@@ -199,22 +216,6 @@ Address alloc(MemState &state, size_t size, const char *name, unsigned int align
     return align_addr;
 }
 
-static void align_to_page(MemState &state, ProtectSegmentInfo &protect) {
-    const Address end = align(protect.addr + protect.size, state.page_size);
-    const Address addr = align_down(protect.addr, state.page_size);
-    const size_t size = end - addr;
-    protect.addr = addr;
-    protect.size = size;
-}
-
-static bool overlap_in_page(MemState &state, const ProtectSegmentInfo &a, const ProtectSegmentInfo &b) {
-    const Address a_start = align_down(a.addr, state.page_size);
-    const Address a_end = align(a.addr + a.size, state.page_size);
-    const Address b_start = align_down(b.addr, state.page_size);
-    const Address b_end = align(b.addr + b.size, state.page_size);
-    return a_start <= b_end && b_start <= a_end;
-}
-
 void unprotect_inner(MemState &state, Address addr, size_t size) {
     if (LOG_PROTECT) {
         fmt::print("Unprotect: {} {}\n", log_hex(addr), size);
@@ -239,11 +240,84 @@ void protect_inner(MemState &state, Address addr, size_t size, const std::uint32
 #endif
 }
 
-static ProtectSegmentTrees::iterator find_protect_segment(ProtectSegmentTrees &tree, Address addr) {
-    if (tree.empty()) {
-        return tree.end();
+static void protect_ranges(MemState &state, const std::vector<ProtectRange> &ranges) {
+    std::vector<ProtectRange> tracked_ranges;
+    for (const ProtectRange &range : ranges) {
+        // the write tracker takes the write watchers, the host protection is kept for the others
+        if (state.tracker && range.perm == MEM_PERM_READONLY)
+            tracked_ranges.push_back(range);
+        else
+            protect_inner(state, range.first_page * state.page_size, range.page_count * state.page_size, range.perm);
     }
-    return --tree.upper_bound(ProtectSegmentInfo(addr));
+    if (!tracked_ranges.empty())
+        state.tracker->arm(tracked_ranges);
+    state.protect.host_protect_count.fetch_add(ranges.size(), std::memory_order_relaxed);
+}
+
+// Call the watchers of the page, the ones done watching are removed and their pages left unwatched added to released_pages
+static void run_page_watchers(MemState &state, uint32_t page, Address vaddr, bool write, std::vector<uint32_t> &released_pages) {
+    for (const uint32_t id : state.protect.get_page_watchers(page)) {
+        if (state.protect.watchers[id].callback(vaddr, write))
+            state.protect.remove_watcher(id, released_pages);
+    }
+}
+
+// Only unprotect the pages no other watcher needs anymore, the faulting page is unprotected in any case
+static void release_pages(MemState &state, std::vector<uint32_t> &released_pages, uint32_t fault_page) {
+    std::sort(released_pages.begin(), released_pages.end());
+    released_pages.erase(std::unique(released_pages.begin(), released_pages.end()), released_pages.end());
+    uint32_t range_start = 0;
+    uint32_t range_count = 0;
+    for (const uint32_t released : released_pages) {
+        ProtectPage &entry = state.protect.get_page(released);
+        if (!entry.host_protected && released != fault_page)
+            continue;
+        entry.host_protected = false;
+        // the write tracker keeps its pages readable and writable, the writes to the released ones are ignored
+        if (state.tracker && entry.host_perm == MEM_PERM_READONLY && released != fault_page)
+            continue;
+
+        if (range_count != 0 && range_start + range_count == released) {
+            range_count++;
+            continue;
+        }
+        if (range_count != 0)
+            unprotect_inner(state, range_start * state.page_size, range_count * state.page_size);
+        range_start = released;
+        range_count = 1;
+    }
+    if (range_count != 0)
+        unprotect_inner(state, range_start * state.page_size, range_count * state.page_size);
+}
+
+// Run the watchers of the pages the write tracker saw written since the last flush
+static void collect_written_pages(MemState &state) {
+    const std::vector<ProtectRange> ranges = state.protect.get_host_ranges(MEM_PERM_READONLY);
+    if (ranges.empty())
+        return;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> written_pages;
+    state.tracker->collect(ranges, written_pages);
+
+    std::vector<uint32_t> released_pages;
+    for (const uint32_t page : written_pages) {
+        ProtectPage &entry = state.protect.get_page(page);
+        // a watcher of a previous page may have released this one
+        if (!entry.host_protected || entry.watcher_count.load(std::memory_order_relaxed) == 0)
+            continue;
+        entry.host_protected = false;
+        run_page_watchers(state, page, page * state.page_size, true, released_pages);
+        // the tracker does not watch the page anymore, arm it again for the remaining watchers
+        if (entry.watcher_count.load(std::memory_order_relaxed) != 0)
+            state.protect.queue_page(page);
+    }
+    release_pages(state, released_pages, UINT32_MAX);
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    state.protect.collect_count++;
+    state.protect.collect_time_ns += elapsed.count();
+    state.protect.collected_page_count += written_pages.size();
 }
 
 bool handle_access_violation(MemState &state, uint8_t *addr, bool write) noexcept {
@@ -260,138 +334,93 @@ bool handle_access_violation(MemState &state, uint8_t *addr, bool write) noexcep
         fmt::print("Access: {}\n", log_hex(vaddr));
     }
 
-    const std::unique_lock<std::mutex> lock(state.protect_mutex);
-    const auto it = find_protect_segment(state.protect_tree, vaddr);
-    if (it == state.protect_tree.end()) {
-        // HACK: keep going
-        unprotect_inner(state, vaddr, 4);
-        LOG_CRITICAL("Unhandled write protected region was valid. Address=0x{:X}", vaddr);
-        return true;
-    }
-
-    if (vaddr < it->addr || vaddr >= it->addr + it->size) {
+    // The page is looked up without the lock, most faults come from pages with a single watcher
+    const uint32_t page = vaddr / state.page_size;
+    if (state.protect.watcher_count(page) == 0) {
         // HACK: keep going
         unprotect_inner(state, vaddr, 4);
         LOG_CRITICAL("Unhandled write protected region was valid. Address=0x{:X}", vaddr);
         return true;
     }
 
-    Address previous_beg = it->addr;
-
-    for (auto ite = it->blocks.begin(); ite != it->blocks.end();) {
-        if (ite->callback(vaddr, write)) {
-            Address beg_unpr = align_down(ite->addr, state.page_size);
-            Address end_unpr = align(ite->addr + ite->size, state.page_size);
-            unprotect_inner(state, beg_unpr, end_unpr - beg_unpr);
-
-            ite = const_cast<std::set<ProtectBlockInfo> &>(it->blocks).erase(ite);
-        } else {
-            ite++;
-        }
+    const auto start = std::chrono::steady_clock::now();
+    {
+        const std::lock_guard<std::mutex> lock(state.protect.mutex);
+        std::vector<uint32_t> released_pages;
+        run_page_watchers(state, page, vaddr, write, released_pages);
+        release_pages(state, released_pages, page);
     }
 
-    if ((it->blocks.size() == 0) && (it->ref_count == 0)) {
-        unprotect_inner(state, it->addr, it->size);
-        state.protect_tree.erase(it);
-    } else {
-        Address beg_region = it->blocks.begin()->addr;
-        Address end_region = it->blocks.rbegin()->addr + it->blocks.rbegin()->size;
-
-        beg_region = align_down(beg_region, state.page_size);
-        end_region = align(end_region, state.page_size);
-
-        if (beg_region != previous_beg) {
-            ProtectSegmentInfo info = std::move(*it);
-            info.addr = beg_region;
-            info.size = end_region - beg_region;
-
-            state.protect_tree.erase(it);
-            state.protect_tree.emplace(std::move(info));
-        } else {
-            const_cast<std::size_t &>(it->size) = end_region - beg_region;
-        }
-    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    state.protect.fault_count.fetch_add(1, std::memory_order_relaxed);
+    state.protect.fault_time_ns.fetch_add(elapsed.count(), std::memory_order_relaxed);
 
     return true;
 }
 
-bool add_protect(MemState &state, Address addr, const size_t size, const std::uint32_t perm, ProtectCallback callback) {
-    const std::lock_guard<std::mutex> lock(state.protect_mutex);
-    ProtectSegmentInfo protect(addr, size, perm);
-    align_to_page(state, protect);
-
-    ProtectBlockInfo block;
-    block.addr = addr;
-    block.size = size;
-    block.callback = callback;
-
-    protect.blocks.emplace(block);
-
-    auto it = find_protect_segment(state.protect_tree, protect.addr);
-    while (it != state.protect_tree.end() && overlap_in_page(state, *it, protect)) {
-        const Address start = std::min(it->addr, protect.addr);
-        protect.size = std::max(it->addr + it->size, protect.addr + protect.size) - start;
-        protect.addr = start;
-        protect.ref_count = it->ref_count; // Transfer access count to new block
-        protect.blocks.insert(it->blocks.begin(), it->blocks.end());
-
-        state.protect_tree.erase(it++);
-    }
-
-    if (protect.ref_count == 0) {
-        protect_inner(state, protect.addr, protect.size, perm);
+void notify_host_write(MemState &state, Address addr, size_t size) {
+    if (size == 0)
+        return;
+
+    const uint32_t first_page = addr / state.page_size;
+    const uint32_t last_page = (addr + size - 1) / state.page_size;
+
+    // The watcher counts are read without the lock, most ranges have no watcher
+    uint32_t page = first_page;
+    while (page <= last_page && state.protect.watcher_count(page) == 0)
+        page++;
+    if (page > last_page)
+        return;
+
+    const std::lock_guard<std::mutex> lock(state.protect.mutex);
+    std::vector<uint32_t> released_pages;
+    for (; page <= last_page; page++) {
+        if (state.protect.watcher_count(page) != 0)
+            run_page_watchers(state, page, std::max<Address>(addr, page * state.page_size), true, released_pages);
     }
+    release_pages(state, released_pages, UINT32_MAX);
+}
 
-    state.protect_tree.emplace(protect);
+bool add_protect(MemState &state, Address addr, const size_t size, const std::uint32_t perm, ProtectCallback callback) {
+    const std::lock_guard<std::mutex> lock(state.protect.mutex);
+    state.protect.add_watcher(addr, size, perm, std::move(callback));
     return true;
 }
 
-bool is_protecting(MemState &state, Address addr, std::uint32_t *perm) {
-    const std::lock_guard<std::mutex> lock(state.protect_mutex);
-    auto ite = find_protect_segment(state.protect_tree, addr);
+void flush_protect(MemState &state) {
+    const std::lock_guard<std::mutex> lock(state.protect.mutex);
+    // collected before arming the new pages, which would otherwise be reported as written
+    if (state.tracker)
+        collect_written_pages(state);
+    if (!state.protect.pending_pages.empty())
+        protect_ranges(state, state.protect.take_pending_ranges());
+}
 
-    if ((ite != state.protect_tree.end()) && (addr >= ite->addr) && (addr < ite->addr + ite->size)) {
-        if (perm) {
-            *perm = ite->perm;
-        }
+bool is_protecting(MemState &state, Address addr, std::uint32_t *perm) {
+    const std::lock_guard<std::mutex> lock(state.protect.mutex);
+    const ProtectPage *page = state.protect.find_page(addr / state.page_size);
+    if (!page || page->watcher_count.load(std::memory_order_relaxed) == 0)
+        return false;
 
-        return true;
+    if (perm) {
+        *perm = page->perm;
     }
-
-    return false;
+    return true;
 }
 
 void open_access_parent_protect_segment(MemState &state, Address addr) {
-    const std::lock_guard<std::mutex> lock(state.protect_mutex);
-    auto ite = find_protect_segment(state.protect_tree, addr);
-
-    if ((ite != state.protect_tree.end()) && (addr >= ite->addr) && (addr < ite->addr + ite->size)) {
-        const_cast<std::int32_t &>(ite->ref_count)++;
-    } else {
-        ProtectSegmentInfo protect(align_down(addr, state.page_size), 0, 0);
-        protect.ref_count = 1;
-
-        state.protect_tree.emplace(protect);
-    }
+    const std::lock_guard<std::mutex> lock(state.protect.mutex);
+    state.protect.open_range(addr);
 }
 
 void close_access_parent_protect_segment(MemState &state, Address addr) {
-    const std::lock_guard<std::mutex> lock(state.protect_mutex);
-    auto ite = find_protect_segment(state.protect_tree, addr);
-
-    if (ite != state.protect_tree.end()) {
-        if (ite->ref_count > 0) {
-            const_cast<std::int32_t &>(ite->ref_count)--;
-        }
+    const std::lock_guard<std::mutex> lock(state.protect.mutex);
+    protect_ranges(state, state.protect.close_range(addr));
+}
 
-        if (ite->ref_count == 0) {
-            if ((ite->blocks.size() == 0) || (ite->size == 0)) {
-                state.protect_tree.erase(ite);
-            } else {
-                protect_inner(state, ite->addr, ite->size, ite->perm);
-            }
-        }
-    }
+ProtectStats get_protect_stats(MemState &state) {
+    const std::lock_guard<std::mutex> lock(state.protect.mutex);
+    return state.protect.get_stats();
 }
 
 Address alloc(MemState &state, size_t size, const char *name) {
@@ -0,0 +1,289 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <mem/functions.h>
+#include <mem/protect.h>
+
+#include <algorithm>
+#include <cassert>
+
+void ProtectTable::init(std::size_t page_size, std::size_t memory_size) {
+    this->page_size = page_size;
+    page_count = static_cast<std::uint32_t>(memory_size / page_size);
+
+    const std::uint32_t chunk_count = (page_count + CHUNK_PAGES - 1) / CHUNK_PAGES;
+    chunks = std::make_unique<std::atomic<ProtectPage *>[]>(chunk_count);
+    for (std::uint32_t i = 0; i < chunk_count; i++)
+        chunks[i].store(nullptr, std::memory_order_relaxed);
+    chunk_storage.clear();
+
+    // index 0 ends the lists
+    watchers.assign(1, ProtectWatcher{});
+    links.assign(1, ProtectLink{});
+    free_watcher = 0;
+    free_link = 0;
+    watcher_total = 0;
+    pending_pages.clear();
+    open_ranges.clear();
+}
+
+ProtectPage *ProtectTable::find_page(std::uint32_t page) const {
+    if (page >= page_count)
+        return nullptr;
+    ProtectPage *chunk = chunks[page / CHUNK_PAGES].load(std::memory_order_acquire);
+    return chunk ? &chunk[page % CHUNK_PAGES] : nullptr;
+}
+
+ProtectPage &ProtectTable::get_page(std::uint32_t page) {
+    assert(page < page_count);
+    std::atomic<ProtectPage *> &chunk = chunks[page / CHUNK_PAGES];
+    ProtectPage *pages = chunk.load(std::memory_order_relaxed);
+    if (!pages) {
+        chunk_storage.push_back(std::make_unique<ProtectPage[]>(CHUNK_PAGES));
+        pages = chunk_storage.back().get();
+        chunk.store(pages, std::memory_order_release);
+    }
+    return pages[page % CHUNK_PAGES];
+}
+
+std::uint32_t ProtectTable::watcher_count(std::uint32_t page) const {
+    const ProtectPage *entry = find_page(page);
+    return entry ? entry->watcher_count.load(std::memory_order_acquire) : 0;
+}
+
+// First and last page covered by a range, an empty range covers the page of its address
+static void get_page_span(const ProtectTable &table, Address addr, std::size_t size, std::uint32_t &first, std::uint32_t &last) {
+    const std::uint64_t end = static_cast<std::uint64_t>(addr) + std::max<std::size_t>(size, 1);
+    first = static_cast<std::uint32_t>(addr / table.page_size);
+    last = static_cast<std::uint32_t>(std::min<std::uint64_t>((end - 1) / table.page_size, table.page_count - 1));
+}
+
+std::uint32_t ProtectTable::add_watcher(Address addr, std::size_t size, std::uint32_t perm, ProtectCallback callback) {
+    std::uint32_t id = free_watcher;
+    if (id != 0) {
+        free_watcher = watchers[id].next_free;
+    } else {
+        id = static_cast<std::uint32_t>(watchers.size());
+        watchers.emplace_back();
+    }
+    ProtectWatcher &watcher = watchers[id];
+    watcher.addr = addr;
+    watcher.size = size;
+    watcher.perm = perm;
+    watcher.callback = std::move(callback);
+    watcher.next_free = 0;
+    watcher_total++;
+
+    std::uint32_t first, last;
+    get_page_span(*this, addr, size, first, last);
+    for (std::uint32_t page = first; page <= last; page++) {
+        std::uint32_t link = free_link;
+        if (link != 0) {
+            free_link = links[link].next;
+        } else {
+            link = static_cast<std::uint32_t>(links.size());
+            links.emplace_back();
+        }
+
+        ProtectPage &entry = get_page(page);
+        links[link] = { id, entry.first_link };
+        entry.first_link = link;
+
+        const std::uint32_t count = entry.watcher_count.load(std::memory_order_relaxed);
+        entry.perm = (count == 0) ? perm : std::min(entry.perm, perm);
+        entry.watcher_count.store(count + 1, std::memory_order_release);
+
+        const bool needs_protect = !entry.host_protected || entry.host_perm != entry.perm;
+        if (entry.ref_count == 0 && needs_protect)
+            queue_page(page);
+    }
+
+    return id;
+}
+
+void ProtectTable::remove_watcher(std::uint32_t id, std::vector<std::uint32_t> &released_pages) {
+    ProtectWatcher &watcher = watchers[id];
+
+    std::uint32_t first, last;
+    get_page_span(*this, watcher.addr, watcher.size, first, last);
+    for (std::uint32_t page = first; page <= last; page++) {
+        ProtectPage &entry = get_page(page);
+
+        // unlink the watcher and compute the permission of the remaining ones
+        std::uint32_t *previous = &entry.first_link;
+        std::uint32_t perm = MEM_PERM_READWRITE;
+        for (std::uint32_t link = entry.first_link; link != 0;) {
+            const std::uint32_t next = links[link].next;
+            if (links[link].watcher == id) {
+                *previous = next;
+                links[link] = { 0, free_link };
+                free_link = link;
+            } else {
+                perm = std::min(perm, watchers[links[link].watcher].perm);
+                previous = &links[link].next;
+            }
+            link = next;
+        }
+
+        const std::uint32_t count = entry.watcher_count.load(std::memory_order_relaxed) - 1;
+        entry.watcher_count.store(count, std::memory_order_release);
+        if (count == 0) {
+            entry.perm = 0;
+            released_pages.push_back(page);
+        } else {
+            entry.perm = perm;
+        }
+    }
+
+    watcher.callback = nullptr;
+    watcher.next_free = free_watcher;
+    free_watcher = id;
+    watcher_total--;
+}
+
+std::vector<std::uint32_t> ProtectTable::get_page_watchers(std::uint32_t page) const {
+    std::vector<std::uint32_t> ids;
+    const ProtectPage *entry = find_page(page);
+    if (entry) {
+        for (std::uint32_t link = entry->first_link; link != 0; link = links[link].next)
+            ids.push_back(links[link].watcher);
+    }
+    return ids;
+}
+
+void ProtectTable::queue_page(std::uint32_t page) {
+    ProtectPage &entry = get_page(page);
+    if (!entry.pending) {
+        entry.pending = true;
+        pending_pages.push_back(page);
+    }
+}
+
+// Merge sorted pages into ranges, a page is merged with the previous one when it follows it with the same permission
+static std::vector<ProtectRange> merge_pages(ProtectTable &table, const std::vector<std::uint32_t> &pages) {
+    std::vector<ProtectRange> ranges;
+    for (const std::uint32_t page : pages) {
+        const std::uint32_t perm = table.get_page(page).perm;
+        if (!ranges.empty() && ranges.back().first_page + ranges.back().page_count == page && ranges.back().perm == perm)
+            ranges.back().page_count++;
+        else
+            ranges.push_back({ page, 1, perm });
+    }
+    return ranges;
+}
+
+std::vector<ProtectRange> ProtectTable::take_pending_ranges() {
+    std::sort(pending_pages.begin(), pending_pages.end());
+
+    std::vector<std::uint32_t> pages;
+    for (const std::uint32_t page : pending_pages) {
+        ProtectPage &entry = get_page(page);
+        entry.pending = false;
+        // the watchers may have been removed or the page opened since it was queued
+        if (entry.watcher_count.load(std::memory_order_relaxed) == 0 || entry.ref_count != 0)
+            continue;
+        entry.host_protected = true;
+        entry.host_perm = entry.perm;
+        pages.push_back(page);
+    }
+    pending_pages.clear();
+
+    return merge_pages(*this, pages);
+}
+
+std::vector<ProtectRange> ProtectTable::get_host_ranges(std::uint32_t perm) const {
+    std::vector<ProtectRange> ranges;
+    const std::uint32_t chunk_count = (page_count + CHUNK_PAGES - 1) / CHUNK_PAGES;
+    for (std::uint32_t chunk = 0; chunk < chunk_count; chunk++) {
+        const ProtectPage *pages = chunks[chunk].load(std::memory_order_relaxed);
+        if (!pages)
+            continue;
+        for (std::uint32_t i = 0; i < CHUNK_PAGES; i++) {
+            const ProtectPage &entry = pages[i];
+            if (!entry.host_protected || entry.host_perm != perm || entry.watcher_count.load(std::memory_order_relaxed) == 0)
+                continue;
+            const std::uint32_t page = chunk * CHUNK_PAGES + i;
+            if (!ranges.empty() && ranges.back().first_page + ranges.back().page_count == page)
+                ranges.back().page_count++;
+            else
+                ranges.push_back({ page, 1, perm });
+        }
+    }
+    return ranges;
+}
+
+ProtectTable::OpenRange ProtectTable::open_range(Address addr) {
+    const std::uint32_t page = static_cast<std::uint32_t>(addr / page_size);
+    auto it = open_ranges.find(page);
+    if (it == open_ranges.end()) {
+        // the run of watched pages is what add_protect used to merge into a single segment
+        std::uint32_t first = page;
+        std::uint32_t end = page + 1;
+        if (watcher_count(page) != 0) {
+            while (first > 0 && watcher_count(first - 1) != 0)
+                first--;
+            while (end < page_count && watcher_count(end) != 0)
+                end++;
+        }
+        it = open_ranges.emplace(page, OpenRange{ first, end - first, 0 }).first;
+    }
+
+    OpenRange &range = it->second;
+    range.open_count++;
+    for (std::uint32_t i = range.first_page; i < range.first_page + range.page_count; i++) {
+        ProtectPage &entry = get_page(i);
+        entry.ref_count++;
+        // the caller unprotects what it accesses
+        entry.host_protected = false;
+    }
+    return range;
+}
+
+std::vector<ProtectRange> ProtectTable::close_range(Address addr) {
+    const auto it = open_ranges.find(static_cast<std::uint32_t>(addr / page_size));
+    if (it == open_ranges.end())
+        return {};
+
+    const OpenRange range = it->second;
+    if (--it->second.open_count == 0)
+        open_ranges.erase(it);
+
+    std::vector<std::uint32_t> pages;
+    for (std::uint32_t i = range.first_page; i < range.first_page + range.page_count; i++) {
+        ProtectPage &entry = get_page(i);
+        if (entry.ref_count > 0)
+            entry.ref_count--;
+        if (entry.ref_count == 0 && entry.watcher_count.load(std::memory_order_relaxed) != 0) {
+            entry.host_protected = true;
+            entry.host_perm = entry.perm;
+            pages.push_back(i);
+        }
+    }
+    return merge_pages(*this, pages);
+}
+
+ProtectStats ProtectTable::get_stats() const {
+    ProtectStats stats;
+    stats.fault_count = fault_count.load(std::memory_order_relaxed);
+    stats.fault_time_ns = fault_time_ns.load(std::memory_order_relaxed);
+    stats.collect_count = collect_count;
+    stats.collect_time_ns = collect_time_ns;
+    stats.collected_page_count = collected_page_count;
+    stats.host_protect_count = host_protect_count.load(std::memory_order_relaxed);
+    stats.watcher_count = watcher_total;
+    return stats;
+}
@@ -0,0 +1,295 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <mem/tracker.h>
+
+#include <util/log.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <linux/userfaultfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Not in the headers of older distributions, the kernel rejects them when it does not support them
+#ifndef UFFD_FEATURE_WP_UNPOPULATED
+#define UFFD_FEATURE_WP_UNPOPULATED (1 << 13)
+#endif
+#ifndef UFFD_FEATURE_WP_ASYNC
+#define UFFD_FEATURE_WP_ASYNC (1 << 15)
+#endif
+
+#ifndef PAGEMAP_SCAN
+#define PAGE_IS_WRITTEN (1 << 1)
+#define PM_SCAN_CHECK_WPASYNC (1 << 1)
+
+struct page_region {
+    __u64 start;
+    __u64 end;
+    __u64 categories;
+};
+
+struct pm_scan_arg {
+    __u64 size;
+    __u64 flags;
+    __u64 start;
+    __u64 end;
+    __u64 walk_end;
+    __u64 vec;
+    __u64 vec_len;
+    __u64 max_pages;
+    __u64 category_inverted;
+    __u64 category_mask;
+    __u64 category_anyof_mask;
+    __u64 return_mask;
+};
+
+#define PAGEMAP_SCAN _IOWR('f', 16, struct pm_scan_arg)
+#endif
+
+constexpr std::uint64_t PAGEMAP_SOFT_DIRTY = 1ULL << 55;
+
+namespace {
+
+class UserfaultfdTracker : public WriteTracker {
+public:
+    UserfaultfdTracker(std::uint8_t *memory, std::size_t page_size)
+        : memory(memory)
+        , page_size(page_size) {}
+
+    ~UserfaultfdTracker() override {
+        if (pagemap_fd >= 0)
+            close(pagemap_fd);
+        // closing the descriptor unregisters the memory and drops the write-protections
+        if (uffd >= 0)
+            close(uffd);
+    }
+
+    bool init(std::size_t memory_size) {
+        uffd = static_cast<int>(syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK));
+        // unprivileged processes may only handle the faults of user mode with vm.unprivileged_userfaultfd=0
+        if (uffd < 0)
+            uffd = static_cast<int>(syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY));
+        if (uffd < 0)
+            return false;
+
+        // in asynchronous mode the kernel resolves the write faults itself and only marks the pages as written
+        uffdio_api api = {};
+        api.api = UFFD_API;
+        api.features = UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED;
+        if (ioctl(uffd, UFFDIO_API, &api) != 0)
+            return false;
+
+        uffdio_register reg = {};
+        reg.range.start = reinterpret_cast<std::uintptr_t>(memory);
+        reg.range.len = memory_size;
+        reg.mode = UFFDIO_REGISTER_MODE_WP;
+        if (ioctl(uffd, UFFDIO_REGISTER, &reg) != 0)
+            return false;
+
+        pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+        if (pagemap_fd < 0)
+            return false;
+
+        // also checks that the kernel knows PAGEMAP_SCAN
+        std::vector<std::uint32_t> written;
+        return scan({ 0, 1, 0 }, written);
+    }
+
+    WriteTrackerType type() const override {
+        return WriteTrackerType::USERFAULTFD;
+    }
+
+    void arm(const std::vector<ProtectRange> &ranges) override {
+        for (const ProtectRange &range : ranges) {
+            uffdio_writeprotect wp = {};
+            wp.range.start = reinterpret_cast<std::uintptr_t>(memory + range.first_page * page_size);
+            wp.range.len = range.page_count * page_size;
+            wp.mode = UFFDIO_WRITEPROTECT_MODE_WP;
+            if (ioctl(uffd, UFFDIO_WRITEPROTECT, &wp) != 0)
+                LOG_ERROR("UFFDIO_WRITEPROTECT failed on page {} ({} pages): {}", range.first_page, range.page_count, strerror(errno));
+        }
+    }
+
+    void collect(const std::vector<ProtectRange> &ranges, std::vector<std::uint32_t> &written_pages) override {
+        for (const ProtectRange &range : ranges) {
+            if (!scan(range, written_pages))
+                LOG_ERROR("PAGEMAP_SCAN failed on page {} ({} pages): {}", range.first_page, range.page_count, strerror(errno));
+        }
+    }
+
+private:
+    bool scan(const ProtectRange &range, std::vector<std::uint32_t> &written_pages) {
+        const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(memory);
+        std::array<page_region, 64> regions;
+
+        pm_scan_arg arg = {};
+        arg.size = sizeof(arg);
+        arg.flags = PM_SCAN_CHECK_WPASYNC;
+        arg.start = base + range.first_page * page_size;
+        arg.end = arg.start + range.page_count * page_size;
+        arg.vec = reinterpret_cast<std::uintptr_t>(regions.data());
+        arg.vec_len = regions.size();
+        arg.category_mask = PAGE_IS_WRITTEN;
+        arg.return_mask = PAGE_IS_WRITTEN;
+
+        // the walk stops early when the region vector is full
+        while (arg.start < arg.end) {
+            const int count = ioctl(pagemap_fd, PAGEMAP_SCAN, &arg);
+            if (count < 0)
+                return false;
+            for (int i = 0; i < count; i++) {
+                for (std::uintptr_t addr = regions[i].start; addr < regions[i].end; addr += page_size)
+                    written_pages.push_back(static_cast<std::uint32_t>((addr - base) / page_size));
+            }
+            arg.start = arg.walk_end;
+        }
+        return true;
+    }
+
+    std::uint8_t *memory;
+    std::size_t page_size;
+    int uffd = -1;
+    int pagemap_fd = -1;
+};
+
+class SoftDirtyTracker : public WriteTracker {
+public:
+    SoftDirtyTracker(std::uint8_t *memory, std::size_t page_size)
+        : memory(memory)
+        , page_size(page_size) {}
+
+    ~SoftDirtyTracker() override {
+        if (pagemap_fd >= 0)
+            close(pagemap_fd);
+        if (clear_refs_fd >= 0)
+            close(clear_refs_fd);
+    }
+
+    bool init() {
+        host_page_size = sysconf(_SC_PAGESIZE);
+        pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+        clear_refs_fd = open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+        if (pagemap_fd < 0 || clear_refs_fd < 0)
+            return false;
+
+        // the bits are only maintained with CONFIG_MEM_SOFT_DIRTY, check them on a scratch page
+        void *scratch = mmap(nullptr, host_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (scratch == MAP_FAILED)
+            return false;
+        volatile std::uint8_t *byte = static_cast<std::uint8_t *>(scratch);
+        *byte = 1;
+        const bool cleared = clear() && !is_dirty(scratch);
+        *byte = 2;
+        const bool supported = cleared && is_dirty(scratch);
+        munmap(scratch, host_page_size);
+        return supported;
+    }
+
+    WriteTrackerType type() const override {
+        return WriteTrackerType::SOFT_DIRTY;
+    }
+
+    void arm(const std::vector<ProtectRange> &ranges) override {
+        // the bits can only be cleared for the whole process, which also re-arms the pages collected just before
+        if (!ranges.empty() && !clear())
+            LOG_ERROR("Failed to clear the soft-dirty bits: {}", strerror(errno));
+    }
+
+    void collect(const std::vector<ProtectRange> &ranges, std::vector<std::uint32_t> &written_pages) override {
+        const std::size_t entries_per_page = page_size / host_page_size;
+        for (const ProtectRange &range : ranges) {
+            const std::size_t first_entry = reinterpret_cast<std::uintptr_t>(memory + range.first_page * page_size) / host_page_size;
+            const std::size_t entry_count = range.page_count * entries_per_page;
+            entries.resize(entry_count);
+            const ssize_t read = pread(pagemap_fd, entries.data(), entry_count * sizeof(std::uint64_t), first_entry * sizeof(std::uint64_t));
+            if (read != static_cast<ssize_t>(entry_count * sizeof(std::uint64_t))) {
+                LOG_ERROR("Failed to read the pagemap of page {} ({} pages): {}", range.first_page, range.page_count, strerror(errno));
+                continue;
+            }
+
+            for (std::uint32_t i = 0; i < range.page_count; i++) {
+                const auto begin = entries.begin() + i * entries_per_page;
+                if (std::any_of(begin, begin + entries_per_page, [](std::uint64_t entry) { return entry & PAGEMAP_SOFT_DIRTY; }))
+                    written_pages.push_back(range.first_page + i);
+            }
+        }
+    }
+
+private:
+    bool clear() {
+        return pwrite(clear_refs_fd, "4", 1, 0) == 1;
+    }
+
+    bool is_dirty(const void *addr) {
+        std::uint64_t entry = 0;
+        const off_t offset = reinterpret_cast<std::uintptr_t>(addr) / host_page_size * sizeof(entry);
+        return pread(pagemap_fd, &entry, sizeof(entry), offset) == sizeof(entry) && (entry & PAGEMAP_SOFT_DIRTY);
+    }
+
+    std::uint8_t *memory;
+    std::size_t page_size;
+    std::size_t host_page_size = 0;
+    int pagemap_fd = -1;
+    int clear_refs_fd = -1;
+    std::vector<std::uint64_t> entries;
+};
+
+} // namespace
+#endif
+
+WriteTrackerPtr create_write_tracker(WriteTrackerType type, std::uint8_t *memory, std::size_t memory_size, std::size_t page_size) {
+#ifdef __linux__
+    if (type == WriteTrackerType::AUTO || type == WriteTrackerType::USERFAULTFD) {
+        auto tracker = std::make_unique<UserfaultfdTracker>(memory, page_size);
+        if (tracker->init(memory_size))
+            return tracker;
+    } else if (type == WriteTrackerType::SOFT_DIRTY) {
+        auto tracker = std::make_unique<SoftDirtyTracker>(memory, page_size);
+        if (tracker->init())
+            return tracker;
+    }
+#endif
+    return nullptr;
+}
+
+WriteTrackerType get_write_tracker_type(const std::string &name) {
+    if (name == "mprotect")
+        return WriteTrackerType::MPROTECT;
+    if (name == "userfaultfd")
+        return WriteTrackerType::USERFAULTFD;
+    if (name == "soft-dirty")
+        return WriteTrackerType::SOFT_DIRTY;
+    return WriteTrackerType::AUTO;
+}
+
+const char *get_write_tracker_name(WriteTrackerType type) {
+    switch (type) {
+    case WriteTrackerType::AUTO: return "Auto";
+    case WriteTrackerType::MPROTECT: return "mprotect";
+    case WriteTrackerType::USERFAULTFD: return "userfaultfd";
+    case WriteTrackerType::SOFT_DIRTY: return "soft-dirty";
+    }
+    return "unknown";
+}
@@ -21,18 +21,39 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <random>
+#include <vector>
+
+static int free_bit(const BitmapAllocator &allocator, int offset) {
+    return (allocator.words[offset >> 6] >> (offset & 63)) & 1;
+}
+
+// The tests from EKA2L1 write 32 bit words where the highest bit is the lowest offset
+static void set_word32(BitmapAllocator &allocator, int index, std::uint32_t value) {
+    allocator.free(index * 32, 32);
+    for (int i = 0; i < 32; ++i) {
+        if (((value >> (31 - i)) & 1) == 0)
+            allocator.allocate_at(index * 32 + i, 1);
+    }
+}
+
+static std::uint32_t get_word32(const BitmapAllocator &allocator, int index) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 32; ++i)
+        value |= static_cast<std::uint32_t>(free_bit(allocator, index * 32 + i)) << (31 - i);
+    return value;
+}
+
 TEST(bitmap_allocator, one_bit_allocation) {
     BitmapAllocator allocator(KiB(5));
 
     for (int i = 0; i < KiB(5); ++i) {
         int size = 1;
-        int inoffset = 31 - i & 31;
-        int bit = (allocator.words[i >> 5] & (1 << inoffset)) >> inoffset;
-        ASSERT_EQ(bit, 1);
+        ASSERT_EQ(free_bit(allocator, i), 1);
         int ret = allocator.allocate_from(i, size, false);
         ASSERT_EQ(ret, i);
-        bit = (allocator.words[i >> 5] & (1 << inoffset)) >> inoffset;
-        ASSERT_EQ(bit, 0);
+        ASSERT_EQ(free_bit(allocator, i), 0);
     }
 }
 
@@ -156,69 +177,69 @@ TEST(bitmap_allocator, no_best_fit_only_one_fit) {
     BitmapAllocator alloc(32);
 
     // Bitmap:              1000 0101 0001 0001 0101 0001 00[11 1]001
-    alloc.words[0] = 0b10000101000100010101000100111001;
+    set_word32(alloc, 0, 0b10000101000100010101000100111001);
 
     int to_alloc = 3;
     ASSERT_EQ(alloc.allocate_from(0, to_alloc), 26);
     ASSERT_EQ(to_alloc, 3);
 
     // After allocate:      1000 0101 0001 0001 0101 0001 00[00 0]001
-    ASSERT_EQ(alloc.words[0], 0b10000101000100010101000100000001);
+    ASSERT_EQ(get_word32(alloc, 0), 0b10000101000100010101000100000001);
 }
 
 TEST(bitmap_allocator, no_best_fit_multiple_fit) {
     BitmapAllocator alloc(32);
 
     // Bitmap 1:            1000 0[111] 1001 0001 0101 0001 0011 1001
-    alloc.words[0] = 0b10000111100100010101000100111001;
+    set_word32(alloc, 0, 0b10000111100100010101000100111001);
 
     int to_alloc = 3;
     ASSERT_EQ(alloc.allocate_from(0, to_alloc), 5);
     ASSERT_EQ(to_alloc, 3);
 
     // After allocate:      1000 0[000] 1001 0001 0101 0001 0011 1001
-    ASSERT_EQ(alloc.words[0], 0b10000000100100010101000100111001);
+    ASSERT_EQ(get_word32(alloc, 0), 0b10000000100100010101000100111001);
 }
 
 TEST(bitmap_allocator, no_best_fit_alloc_across) {
     BitmapAllocator alloc(64);
 
-    alloc.words[0] = 0b111;
-    alloc.words[1] = 0b11100000000000000000000000000000;
+    set_word32(alloc, 0, 0b111);
+    set_word32(alloc, 1, 0b11100000000000000000000000000000);
 
     int to_alloc = 5;
     ASSERT_EQ(alloc.allocate_from(0, to_alloc), 29);
     ASSERT_EQ(to_alloc, 5);
 
-    ASSERT_EQ(alloc.words[0], 0);
-    ASSERT_EQ(alloc.words[1], 0b00100000000000000000000000000000);
+    ASSERT_EQ(get_word32(alloc, 0), 0);
+    ASSERT_EQ(get_word32(alloc, 1), 0b00100000000000000000000000000000);
 }
 
 TEST(bitmap_allocator, best_fit_multiple_fit) {
     BitmapAllocator alloc(32);
 
     // Bitmap 1:            1000 0111 1001 0001 0101 0001 00[11 1]001
-    alloc.words[0] = 0b10000111100100010101000100111001;
+    set_word32(alloc, 0, 0b10000111100100010101000100111001);
 
     int to_alloc = 3;
     ASSERT_EQ(alloc.allocate_from(0, to_alloc, true), 26);
     ASSERT_EQ(to_alloc, 3);
 
     // After allocate:      1000 0111 1001 0001 0101 0001 00[00 0]001
-    ASSERT_EQ(alloc.words[0], 0b10000111100100010101000100000001);
+    ASSERT_EQ(get_word32(alloc, 0), 0b10000111100100010101000100000001);
 }
 
 TEST(bitmap_allocator, count_bit_aligned) {
     BitmapAllocator alloc(32 * 3);
 
     // Bitmap 1: All bit on
-    alloc.words[0] = 0xFFFFFFFF;
+    set_word32(alloc, 0, 0xFFFFFFFF);
 
     // Bitmap 2: 12 bits on
-    alloc.words[1] = 0xF00F00F0;
+    set_word32(alloc, 1, 0xF00F00F0);
 
     // Bitmap 3: 12 bits on
-    alloc.words[2] = 0x00F00F0F;
+    set_word32(alloc, 2, 0x00F00F0F);
 
     ASSERT_EQ(alloc.free_slot_count(0, 32 * 3), 56);
     ASSERT_EQ(alloc.free_slot_count(0, 32 * 3 - 1), 55);
@@ -230,16 +251,132 @@ TEST(bitmap_allocator, count_unaligned) {
     // Bitmap 1: 0b11 | 0011000011
     //      ignored ^
     // 4 valid bits on
-    alloc.words[0] = 0b110011000011;
+    set_word32(alloc, 0, 0b110011000011);
 
     // Bitmap 2: 12 bits on
-    alloc.words[1] = 0xF00F00F0;
+    set_word32(alloc, 1, 0xF00F00F0);
 
     // Bitmap 3: 0b1010111000 | 1111
     //                          ^ ignored
     // 5 valid bits on
-    alloc.words[2] = 0b10101110001111;
+    set_word32(alloc, 2, 0b10101110001111);
 
     // 4 valid bits + 12 bits + 5 valid bits = 21
     ASSERT_EQ(alloc.free_slot_count(22, 92), 21);
 }
+
+TEST(bitmap_allocator, set_maximum_grow_and_shrink) {
+    BitmapAllocator allocator(100);
+    int size = 100;
+    ASSERT_EQ(allocator.allocate_from(0, size), 0);
+
+    allocator.set_maximum(300);
+    ASSERT_EQ(allocator.free_slot_count(0, 300), 200);
+    size = 200;
+    ASSERT_EQ(allocator.allocate_from(0, size), 100);
+
+    allocator.free(0, 300);
+    allocator.set_maximum(70);
+    ASSERT_EQ(allocator.free_slot_count(0, 300), 70);
+    size = 71;
+    ASSERT_EQ(allocator.allocate_from(0, size), -1);
+}
+
+TEST(bitmap_allocator, is_allocated) {
+    BitmapAllocator allocator(KiB(5));
+    ASSERT_TRUE(allocator.allocate_at(100, 1000) == 0);
+
+    ASSERT_TRUE(allocator.is_allocated(100, 101));
+    ASSERT_TRUE(allocator.is_allocated(100, 1100));
+    ASSERT_TRUE(allocator.is_allocated(1099, 1100));
+    ASSERT_FALSE(allocator.is_allocated(99, 100));
+    ASSERT_FALSE(allocator.is_allocated(99, 1100));
+    ASSERT_FALSE(allocator.is_allocated(100, 1101));
+    ASSERT_FALSE(allocator.is_allocated(100, 100));
+    ASSERT_FALSE(allocator.is_allocated(KiB(5), KiB(5) + 1));
+}
+
+// Same layout as the allocator benchmarks of vita3k-bench: one bit per 4 KiB page of the guest address space,
+// filled with blocks of 1 to 64 pages and one block out of two freed, checked against a plain scan of the bits
+class bitmap_allocator_large : public ::testing::Test {
+protected:
+    static constexpr int PAGE_COUNT = 1024 * 1024;
+
+    BitmapAllocator allocator{ PAGE_COUNT };
+    std::vector<bool> reference = std::vector<bool>(PAGE_COUNT, true);
+    std::mt19937 random{ 0x12345678 };
+
+    void SetUp() override {
+        std::vector<std::pair<int, int>> blocks;
+        int used = 0;
+        while (used < PAGE_COUNT * 3 / 4) {
+            int size = 1 + random() % 64;
+            const int offset = allocator.allocate_from(0, size);
+            ASSERT_GE(offset, 0);
+            std::fill_n(reference.begin() + offset, size, false);
+            blocks.emplace_back(offset, size);
+            used += size;
+        }
+        for (std::size_t i = 0; i < blocks.size(); i += 2) {
+            allocator.free(blocks[i].first, blocks[i].second);
+            std::fill_n(reference.begin() + blocks[i].first, blocks[i].second, true);
+        }
+    }
+
+    int reference_allocate(int size, bool best_fit) {
+        int best_offset = -1;
+        int best_length = PAGE_COUNT + 1;
+        for (int offset = 0; offset < PAGE_COUNT;) {
+            if (!reference[offset]) {
+                offset++;
+                continue;
+            }
+            int end = offset;
+            while (end < PAGE_COUNT && reference[end])
+                end++;
+            const int length = end - offset;
+            if (length >= size && length < best_length) {
+                best_offset = offset;
+                best_length = length;
+                if (!best_fit)
+                    break;
+            }
+            offset = end;
+        }
+        if (best_offset >= 0)
+            std::fill_n(reference.begin() + best_offset, size, false);
+        return best_offset;
+    }
+};
+
+TEST_F(bitmap_allocator_large, first_fit) {
+    for (int i = 0; i < 200; ++i) {
+        int size = 1 + random() % 64;
+        ASSERT_EQ(allocator.allocate_from(0, size), reference_allocate(size, false));
+    }
+}
+
+TEST_F(bitmap_allocator_large, best_fit) {
+    for (int i = 0; i < 200; ++i) {
+        int size = 1 + random() % 64;
+        ASSERT_EQ(allocator.allocate_from(0, size, true), reference_allocate(size, true));
+    }
+}
+
+TEST_F(bitmap_allocator_large, large_runs) {
+    for (int i = 0; i < 50; ++i) {
+        int size = 100 + random() % 4000;
+        const bool best_fit = i % 2 == 1;
+        ASSERT_EQ(allocator.allocate_from(0, size, best_fit), reference_allocate(size, best_fit));
+    }
+}
+
+TEST_F(bitmap_allocator_large, free_slot_count) {
+    for (int i = 0; i < 200; ++i) {
+        const int offset = random() % PAGE_COUNT;
+        const int offset_end = std::min(PAGE_COUNT, offset + 1 + static_cast<int>(random() % 5000));
+        const int expected = std::count(reference.begin() + offset, reference.begin() + offset_end, true);
+        ASSERT_EQ(allocator.free_slot_count(offset, offset_end), expected);
+        ASSERT_EQ(allocator.is_allocated(offset, offset_end), expected == 0);
+    }
+}
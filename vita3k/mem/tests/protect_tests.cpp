@@ -0,0 +1,228 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <mem/functions.h>
+#include <mem/protect.h>
+#include <mem/ptr.h>
+#include <mem/state.h>
+#include <mem/tracker.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+static constexpr std::size_t PAGE_SIZE = 4096;
+
+TEST(protect_table, pages_of_a_watcher) {
+    ProtectTable table;
+    table.init(PAGE_SIZE, GiB(4));
+
+    // 3 pages, starting in the middle of one
+    const uint32_t id = table.add_watcher(0x10800, 0x2000, MEM_PERM_READONLY, [](Address, bool) { return true; });
+    EXPECT_EQ(table.watcher_count(0x0F), 0u);
+    EXPECT_EQ(table.watcher_count(0x10), 1u);
+    EXPECT_EQ(table.watcher_count(0x12), 1u);
+    EXPECT_EQ(table.watcher_count(0x13), 0u);
+    EXPECT_EQ(table.get_page_watchers(0x11), std::vector<uint32_t>{ id });
+
+    std::vector<uint32_t> released;
+    table.remove_watcher(id, released);
+    EXPECT_EQ(released, (std::vector<uint32_t>{ 0x10, 0x11, 0x12 }));
+    EXPECT_EQ(table.watcher_count(0x11), 0u);
+    EXPECT_EQ(table.get_stats().watcher_count, 0u);
+}
+
+TEST(protect_table, overlapping_watchers) {
+    ProtectTable table;
+    table.init(PAGE_SIZE, GiB(4));
+
+    const uint32_t first = table.add_watcher(0x10000, 0x2000, MEM_PERM_READONLY, [](Address, bool) { return true; });
+    const uint32_t second = table.add_watcher(0x11000, 0x1000, MEM_PERM_NONE, [](Address, bool) { return true; });
+    EXPECT_EQ(table.watcher_count(0x11), 2u);
+    EXPECT_EQ(table.get_page(0x10).perm, static_cast<uint32_t>(MEM_PERM_READONLY));
+    EXPECT_EQ(table.get_page(0x11).perm, static_cast<uint32_t>(MEM_PERM_NONE));
+
+    // the shared page stays watched by the other watcher
+    std::vector<uint32_t> released;
+    table.remove_watcher(second, released);
+    EXPECT_TRUE(released.empty());
+    EXPECT_EQ(table.get_page(0x11).perm, static_cast<uint32_t>(MEM_PERM_READONLY));
+
+    // the ids and list entries are reused
+    const uint32_t third = table.add_watcher(0x20000, 0x1000, MEM_PERM_READONLY, [](Address, bool) { return true; });
+    EXPECT_EQ(third, second);
+    table.remove_watcher(first, released);
+    EXPECT_EQ(released, (std::vector<uint32_t>{ 0x10, 0x11 }));
+}
+
+TEST(protect_table, pending_pages_are_merged) {
+    ProtectTable table;
+    table.init(PAGE_SIZE, GiB(4));
+
+    table.add_watcher(0x12000, 0x1000, MEM_PERM_READONLY, [](Address, bool) { return true; });
+    table.add_watcher(0x10000, 0x2000, MEM_PERM_READONLY, [](Address, bool) { return true; });
+    table.add_watcher(0x13000, 0x1000, MEM_PERM_NONE, [](Address, bool) { return true; });
+    table.add_watcher(0x30000, 0x1000, MEM_PERM_READONLY, [](Address, bool) { return true; });
+
+    const std::vector<ProtectRange> ranges = table.take_pending_ranges();
+    ASSERT_EQ(ranges.size(), 3u);
+    EXPECT_EQ(ranges[0].first_page, 0x10u);
+    EXPECT_EQ(ranges[0].page_count, 3u);
+    EXPECT_EQ(ranges[1].first_page, 0x13u);
+    EXPECT_EQ(ranges[1].perm, static_cast<uint32_t>(MEM_PERM_NONE));
+    EXPECT_EQ(ranges[2].first_page, 0x30u);
+
+    // already protected pages are not queued again
+    table.add_watcher(0x10000, 0x1000, MEM_PERM_READONLY, [](Address, bool) { return true; });
+    EXPECT_TRUE(table.take_pending_ranges().empty());
+}
+
+TEST(protect_table, open_range) {
+    ProtectTable table;
+    table.init(PAGE_SIZE, GiB(4));
+
+    table.add_watcher(0x10000, 0x3000, MEM_PERM_READONLY, [](Address, bool) { return true; });
+    table.take_pending_ranges();
+
+    // the whole run of watched pages is locked, and not protected by new watchers meanwhile
+    const ProtectTable::OpenRange range = table.open_range(0x11000);
+    EXPECT_EQ(range.first_page, 0x10u);
+    EXPECT_EQ(range.page_count, 3u);
+    table.add_watcher(0x12000, 0x1000, MEM_PERM_READONLY, [](Address, bool) { return true; });
+    EXPECT_TRUE(table.take_pending_ranges().empty());
+
+    const std::vector<ProtectRange> ranges = table.close_range(0x11000);
+    ASSERT_EQ(ranges.size(), 1u);
+    EXPECT_EQ(ranges[0].first_page, 0x10u);
+    EXPECT_EQ(ranges[0].page_count, 3u);
+    EXPECT_EQ(table.get_page(0x10).ref_count, 0);
+    EXPECT_TRUE(table.close_range(0x11000).empty());
+}
+
+TEST(protect, write_fault_calls_watchers) {
+    MemState mem;
+    ASSERT_TRUE(init(mem, WriteTrackerType::MPROTECT));
+    const Address addr = alloc(mem, PAGE_SIZE * 4, "protect test");
+    // volatile so every write is done
+    volatile uint8_t *data = Ptr<uint8_t>(addr).get(mem);
+
+    int calls = 0;
+    add_protect(mem, addr + PAGE_SIZE, PAGE_SIZE * 2, MEM_PERM_READONLY, [&](Address fault, bool write) {
+        EXPECT_EQ(fault, addr + PAGE_SIZE * 2 + 8);
+        EXPECT_TRUE(write);
+        calls++;
+        return true;
+    });
+
+    // nothing is protected before the flush
+    data[PAGE_SIZE * 2] = 1;
+    EXPECT_EQ(calls, 0);
+
+    flush_protect(mem);
+    data[PAGE_SIZE * 2 + 8] = 2;
+    data[PAGE_SIZE + 8] = 3;
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(get_protect_stats(mem).fault_count, 1u);
+    EXPECT_FALSE(is_protecting(mem, addr + PAGE_SIZE));
+}
+
+TEST(protect, host_write_runs_watchers_first) {
+    MemState mem;
+    ASSERT_TRUE(init(mem, WriteTrackerType::MPROTECT));
+    const Address addr = alloc(mem, PAGE_SIZE * 4, "protect test");
+
+    std::vector<Address> calls;
+    add_protect(mem, addr + PAGE_SIZE, PAGE_SIZE * 2, MEM_PERM_READONLY, [&](Address fault, bool write) {
+        EXPECT_TRUE(write);
+        calls.push_back(fault);
+        return true;
+    });
+    flush_protect(mem);
+
+    // the watcher is called once for the first page of the range it covers, then the copy does not fault
+    notify_host_write(mem, addr + 8, PAGE_SIZE * 3);
+    EXPECT_EQ(calls, std::vector<Address>{ static_cast<Address>(addr + PAGE_SIZE) });
+    EXPECT_FALSE(is_protecting(mem, addr + PAGE_SIZE));
+    std::memset(Ptr<uint8_t>(addr + 8).get(mem), 1, PAGE_SIZE * 3);
+    EXPECT_EQ(get_protect_stats(mem).fault_count, 0u);
+}
+
+TEST(protect, valid_size) {
+    MemState mem;
+    ASSERT_TRUE(init(mem, WriteTrackerType::MPROTECT));
+    const Address addr = alloc(mem, PAGE_SIZE * 3, "protect test");
+
+    EXPECT_EQ(get_valid_size(mem, addr + 16), PAGE_SIZE * 3 - 16);
+    EXPECT_EQ(get_valid_size(mem, 0), 0u);
+    free(mem, addr);
+    EXPECT_EQ(get_valid_size(mem, addr), 0u);
+}
+
+static void test_write_tracker(WriteTrackerType type) {
+    MemState mem;
+    ASSERT_TRUE(init(mem, type));
+    if (!mem.tracker)
+        GTEST_SKIP() << get_write_tracker_name(type) << " is not supported by the host";
+    const Address addr = alloc(mem, PAGE_SIZE * 8, "tracker test");
+    volatile uint8_t *data = Ptr<uint8_t>(addr).get(mem);
+
+    std::vector<Address> done_calls, kept_calls;
+    int untouched_calls = 0;
+    add_protect(mem, addr + PAGE_SIZE, PAGE_SIZE * 2, MEM_PERM_READONLY, [&](Address fault, bool write) {
+        EXPECT_TRUE(write);
+        done_calls.push_back(fault);
+        return true;
+    });
+    add_protect(mem, addr + PAGE_SIZE * 4, PAGE_SIZE, MEM_PERM_READONLY, [&](Address fault, bool) {
+        kept_calls.push_back(fault);
+        return false;
+    });
+    add_protect(mem, addr + PAGE_SIZE * 6, PAGE_SIZE, MEM_PERM_READONLY, [&](Address, bool) {
+        untouched_calls++;
+        return true;
+    });
+    flush_protect(mem);
+
+    // the writes are only seen when flushing, without any fault
+    data[PAGE_SIZE * 2 + 8] = 1;
+    data[PAGE_SIZE * 4] = 2;
+    EXPECT_TRUE(done_calls.empty());
+    flush_protect(mem);
+    EXPECT_EQ(done_calls, std::vector<Address>{ static_cast<Address>(addr + PAGE_SIZE * 2) });
+    EXPECT_EQ(kept_calls, std::vector<Address>{ static_cast<Address>(addr + PAGE_SIZE * 4) });
+    EXPECT_EQ(untouched_calls, 0);
+    EXPECT_FALSE(is_protecting(mem, addr + PAGE_SIZE));
+    EXPECT_EQ(get_protect_stats(mem).fault_count, 0u);
+    EXPECT_EQ(get_protect_stats(mem).collected_page_count, 2u);
+
+    // the page of the remaining watcher is tracked again
+    data[PAGE_SIZE * 4 + 8] = 3;
+    data[PAGE_SIZE * 2] = 4;
+    flush_protect(mem);
+    EXPECT_EQ(done_calls.size(), 1u);
+    EXPECT_EQ(kept_calls.size(), 2u);
+    EXPECT_EQ(untouched_calls, 0);
+}
+
+TEST(protect, userfaultfd_collects_written_pages) {
+    test_write_tracker(WriteTrackerType::USERFAULTFD);
+}
+
+TEST(protect, soft_dirty_collects_written_pages) {
+    test_write_tracker(WriteTrackerType::SOFT_DIRTY);
+}
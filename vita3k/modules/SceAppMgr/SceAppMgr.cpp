@@ -398,8 +398,8 @@ EXPORT(SceInt32, _sceAppMgrLoadExec, const char *appPath, Ptr<char> const argv[]
     LOG_INFO("sceAppMgrLoadExec run self: {}", appPath);
 
     // Load exec executable
-    vfs::FileBuffer exec_buffer;
-    if (vfs::read_app_file(exec_buffer, emuenv.pref_path, emuenv.io.app_path, exec_path)) {
+    MappedFile exec_file;
+    if (vfs::map_app_file(exec_file, emuenv.pref_path, emuenv.io.app_path, exec_path)) {
         if (argv && argv->get(emuenv.mem)) {
             size_t args = 0;
             emuenv.load_exec_argv = "\"";
@@ -130,6 +130,7 @@ EXPORT(int, sceAudioOutOpenPort, SceAudioOutPortType type, int len, int freq, Sc
     const std::lock_guard<std::mutex> lock(emuenv.audio.mutex);
     const int port_id = emuenv.audio.next_port_id++;
     emuenv.audio.out_ports.emplace(port_id, port);
+    emuenv.audio.update_active_ports();
 
     return port_id;
 }
@@ -158,10 +159,7 @@ EXPORT(int, sceAudioOutGetRestSample, int port) {
         return RET_ERROR(SCE_AUDIO_OUT_ERROR_INVALID_PORT);
     }
 
-    const int bytes_available = SDL_AudioStreamAvailable(prt->stream.get());
-
-    // we have the number of bytes left, we can convert it back to the number of samples left
-    return bytes_available / (2 * sizeof(int16_t));
+    return emuenv.audio.get_rest_sample(*prt);
 }
 
 EXPORT(int, sceAudioOutOpenExtPort) {
@@ -172,10 +170,19 @@ EXPORT(int, sceAudioOutOpenExtPort) {
 EXPORT(int, sceAudioOutReleasePort, int port) {
     TRACY_FUNC(sceAudioOutReleasePort, port);
     const std::lock_guard<std::mutex> guard(emuenv.audio.mutex);
-    if (!emuenv.audio.out_ports.erase(port)) {
+    const auto it = emuenv.audio.out_ports.find(port);
+    if (it == emuenv.audio.out_ports.end()) {
         return RET_ERROR(SCE_AUDIO_OUT_ERROR_INVALID_PORT);
     }
 
+    const uint64_t underruns = it->second->underruns;
+    if (underruns > 0)
+        LOG_DEBUG("Audio port {} ran out of data {} times", port, underruns);
+    emuenv.audio.underruns += underruns;
+
+    emuenv.audio.out_ports.erase(it);
+    emuenv.audio.update_active_ports();
+
     return 0;
 }
 
@@ -23,6 +23,8 @@
 #include <util/lock_and_find.h>
 #include <util/tracy.h>
 
+#include <set>
+
 TRACY_MODULE_NAME(SceAudiodecUser);
 
 enum {
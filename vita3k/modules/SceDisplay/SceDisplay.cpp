@@ -23,6 +23,7 @@
 #include <packages/functions.h>
 #include <renderer/state.h>
 #include <util/lock_and_find.h>
+#include <util/metrics.h>
 #include <util/types.h>
 
 #include <util/tracy.h>
@@ -144,6 +145,7 @@ EXPORT(SceInt32, _sceDisplaySetFrameBuf, const SceDisplayFrameBuf *pFrameBuf, Sc
     }
 
     emuenv.frame_count++;
+    metrics::end_frame();
 
 #ifdef TRACY_ENABLE
     FrameMarkNamed("SCE frame buffer"); // Tracy - Secondary frame end mark for the emulated frame buffer
@@ -43,9 +43,15 @@ EXPORT(int, sceFiosOverlayAddForProcess02, SceUID processId, SceFiosProcessOverl
     return SCE_FIOS_OK;
 }
 
-EXPORT(int, sceFiosOverlayGetInfoForProcess02) {
-    TRACY_FUNC(sceFiosOverlayGetInfoForProcess02);
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayGetInfoForProcess02, SceUID processId, SceFiosOverlayID id, SceFiosProcessOverlay *pOutOverlay) {
+    TRACY_FUNC(sceFiosOverlayGetInfoForProcess02, processId, id, pOutOverlay);
+    if (!pOutOverlay)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    if (!get_overlay_info(emuenv.io, id, pOutOverlay))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OVERLAY);
+
+    return SCE_FIOS_OK;
 }
 
 EXPORT(int, sceFiosOverlayGetList02, SceUID processId, uint32_t minOrder, uint32_t maxOrder, SceFiosOverlayID *pOutIDs, SceUInt32 maxIDs, SceUInt32 *pActualIDs) {
@@ -80,23 +86,42 @@ EXPORT(int, sceFiosOverlayGetRecommendedScheduler02, int param1, const char *pat
     return static_cast<int>(memcmp(path, "host", 4) == 0 && path[4] <= '9' && path[5] == ':');
 }
 
-EXPORT(int, sceFiosOverlayModifyForProcess02) {
-    TRACY_FUNC(sceFiosOverlayModifyForProcess02);
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayModifyForProcess02, SceUID processId, SceFiosOverlayID id, const SceFiosProcessOverlay *pNewValue) {
+    TRACY_FUNC(sceFiosOverlayModifyForProcess02, processId, id, pNewValue);
+    if (!pNewValue)
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_PTR);
+
+    if (!modify_overlay(emuenv.io, id, pNewValue))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OVERLAY);
+
+    return SCE_FIOS_OK;
 }
 
-EXPORT(int, sceFiosOverlayRemoveForProcess02) {
-    TRACY_FUNC(sceFiosOverlayRemoveForProcess02);
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayRemoveForProcess02, SceUID processId, SceFiosOverlayID id) {
+    TRACY_FUNC(sceFiosOverlayRemoveForProcess02, processId, id);
+    if (!remove_overlay(emuenv.io, id))
+        return RET_ERROR(SCE_FIOS_ERROR_BAD_OVERLAY);
+
+    return SCE_FIOS_OK;
 }
 
-EXPORT(int, sceFiosOverlayResolveSync02) {
-    TRACY_FUNC(sceFiosOverlayResolveSync02);
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayResolveSync02, SceUID processId, SceFiosOverlayResolveMode resolveFlag, const char *pInPath, char *pOutPath, SceUInt32 maxPath) {
+    TRACY_FUNC(sceFiosOverlayResolveSync02, processId, resolveFlag, pInPath, pOutPath, maxPath);
+    return CALL_EXPORT(sceFiosOverlayResolveWithRangeSync02, processId, resolveFlag, pInPath, pOutPath, maxPath, 0, SCE_FIOS_OVERLAY_ORDER_MAX);
 }
 
 EXPORT(int, sceFiosOverlayResolveWithRangeSync02, SceUID processId, SceFiosOverlayResolveMode resolveFlag, const char *pInPath, char *pOutPath, SceUInt32 maxPath, SceUInt32 min_order, SceUInt32 max_order) {
     TRACY_FUNC(sceFiosOverlayResolveWithRangeSync02, processId, resolveFlag, pInPath, pOutPath, maxPath, min_order, max_order);
+    bool is_disabled;
+    {
+        const std::lock_guard<std::mutex> guard(emuenv.io.overlay_mutex);
+        is_disabled = emuenv.io.overlay_disabled_threads.contains(thread_id);
+    }
+    if (is_disabled) {
+        strncpy(pOutPath, pInPath, maxPath);
+        return SCE_FIOS_OK;
+    }
+
     const std::string resolved = resolve_path(emuenv.io, pInPath, resolveFlag == SCE_FIOS_OVERLAY_RESOLVE_FOR_WRITE, min_order, max_order);
     strncpy(pOutPath, resolved.c_str(), maxPath);
 
@@ -105,12 +130,20 @@ EXPORT(int, sceFiosOverlayResolveWithRangeSync02, SceUID processId, SceFiosOverl
 
 EXPORT(int, sceFiosOverlayThreadIsDisabled02) {
     TRACY_FUNC(sceFiosOverlayThreadIsDisabled02);
-    return UNIMPLEMENTED();
+    const std::lock_guard<std::mutex> guard(emuenv.io.overlay_mutex);
+    return emuenv.io.overlay_disabled_threads.contains(thread_id);
 }
 
-EXPORT(int, sceFiosOverlayThreadSetDisabled02) {
-    TRACY_FUNC(sceFiosOverlayThreadSetDisabled02);
-    return UNIMPLEMENTED();
+EXPORT(int, sceFiosOverlayThreadSetDisabled02, SceInt32 disabled) {
+    TRACY_FUNC(sceFiosOverlayThreadSetDisabled02, disabled);
+    const std::lock_guard<std::mutex> guard(emuenv.io.overlay_mutex);
+    const bool was_disabled = emuenv.io.overlay_disabled_threads.contains(thread_id);
+    if (disabled)
+        emuenv.io.overlay_disabled_threads.insert(thread_id);
+    else
+        emuenv.io.overlay_disabled_threads.erase(thread_id);
+
+    return was_disabled;
 }
 
 BRIDGE_IMPL(sceFiosOverlayAddForProcess02)
@@ -20,9 +20,13 @@
 #include <module/module.h>
 
 enum SceFiosErrorCode {
-    SCE_FIOS_OK = 0
+    SCE_FIOS_OK = 0,
+    SCE_FIOS_ERROR_BAD_PTR = 0x80820005,
+    SCE_FIOS_ERROR_BAD_OVERLAY = 0x80820011
 };
 
+constexpr SceUInt32 SCE_FIOS_OVERLAY_ORDER_MAX = 0x7F;
+
 typedef SceUID SceFiosOverlayID;
 
 enum SceFiosOverlayResolveMode {
@@ -30,6 +34,8 @@ enum SceFiosOverlayResolveMode {
     SCE_FIOS_OVERLAY_RESOLVE_FOR_WRITE = 1
 };
 
+EXPORT(int, sceFiosOverlayResolveWithRangeSync02, SceUID processId, SceFiosOverlayResolveMode resolveFlag, const char *pInPath, char *pOutPath, SceUInt32 maxPath, SceUInt32 min_order, SceUInt32 max_order);
+
 BRIDGE_DECL(sceFiosOverlayAddForProcess02)
 BRIDGE_DECL(sceFiosOverlayGetInfoForProcess02)
 BRIDGE_DECL(sceFiosOverlayGetList02)
@@ -18,11 +18,51 @@
 #include "SceIofilemgr.h"
 
 #include <io/functions.h>
+#include <io/io.h>
+#include <kernel/state.h>
+#include <kernel/sync_primitives.h>
 #include <kernel/types.h>
 
 #include <util/tracy.h>
 TRACY_MODULE_NAME(SceIofilemgr);
 
+// Pattern set on the event of an asynchronous operation when it is done, the user data is the result
+constexpr SceUInt32 ASYNC_OP_DONE_PATTERN = 1;
+
+static AsyncIoEngine::Completion make_async_completion(EmuEnvState &emuenv, const SceUID thread_id, const char *export_name, const SceUID op_id, const Ptr<SceIoAsyncParam> param) {
+    return [&emuenv, thread_id, export_name, op_id, param](const SceInt64 result) {
+        if (param)
+            param.get(emuenv.mem)->result = static_cast<SceInt32>(result);
+        simple_event_setorpulse(emuenv.kernel, export_name, thread_id, op_id, ASYNC_OP_DONE_PATTERN, static_cast<SceUInt64>(result), true);
+    };
+}
+
+// Run the operation on the async I/O workers, the operations on the same fd are run in submission order
+static SceUID submit_async_op(EmuEnvState &emuenv, const SceUID thread_id, const char *export_name, const SceUID fd, const Ptr<SceIoAsyncParam> param, AsyncIoEngine::Operation operation) {
+    const SceUID op_id = simple_event_create(emuenv.kernel, emuenv.mem, export_name, "SceIoAsyncOp", thread_id, SCE_KERNEL_ATTR_TH_FIFO | SCE_KERNEL_EVENT_ATTR_MANUAL_RESET, 0);
+    if (op_id < 0)
+        return op_id;
+
+    const int priority = get_io_priority(emuenv.io, thread_id, fd);
+    emuenv.io.async_io.submit(op_id, fd, priority, std::move(operation), make_async_completion(emuenv, thread_id, export_name, op_id, param));
+    return op_id;
+}
+
+// The operations changing the fd table are done by the caller, only their completion is asynchronous
+static SceUID complete_async_op(EmuEnvState &emuenv, const SceUID thread_id, const char *export_name, const Ptr<SceIoAsyncParam> param, const SceInt64 result) {
+    const SceUID op_id = simple_event_create(emuenv.kernel, emuenv.mem, export_name, "SceIoAsyncOp", thread_id, SCE_KERNEL_ATTR_TH_FIFO | SCE_KERNEL_EVENT_ATTR_MANUAL_RESET, 0);
+    if (op_id < 0)
+        return op_id;
+
+    make_async_completion(emuenv, thread_id, export_name, op_id, param)(result);
+    emuenv.io.async_io.complete(op_id, result);
+    return op_id;
+}
+
+static bool is_valid_io_priority(const int priority) {
+    return priority >= SCE_IO_PRIORITY_HIGHEST && priority <= SCE_IO_PRIORITY_LOWEST;
+}
+
 EXPORT(int, _sceIoChstat) {
     TRACY_FUNC(_sceIoChstat);
     return UNIMPLEMENTED();
@@ -71,9 +111,9 @@ EXPORT(int, _sceIoGetstat, const char *file, SceIoStat *stat) {
     return stat_file(emuenv.io, file, stat, emuenv.pref_path, export_name);
 }
 
-EXPORT(int, _sceIoGetstatAsync) {
-    TRACY_FUNC(_sceIoGetstatAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, _sceIoGetstatAsync, const char *file, SceIoStat *stat, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(_sceIoGetstatAsync, file, stat, param);
+    return complete_async_op(emuenv, thread_id, export_name, param, stat_file(emuenv.io, file, stat, emuenv.pref_path, export_name));
 }
 
 EXPORT(int, _sceIoGetstatByFd, const SceUID fd, SceIoStat *stat) {
@@ -96,9 +136,20 @@ EXPORT(SceOff, _sceIoLseek, const SceUID fd, Ptr<_sceIoLseekOpt> opt) {
     return seek_file(fd, opt.get(emuenv.mem)->offset, opt.get(emuenv.mem)->whence, emuenv.io, export_name);
 }
 
-EXPORT(int, _sceIoLseekAsync) {
-    TRACY_FUNC(_sceIoLseekAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, _sceIoLseekAsync, const SceUID fd, Ptr<_sceIoLseekAsyncOpt> opt) {
+    TRACY_FUNC(_sceIoLseekAsync, fd, opt);
+    const _sceIoLseekAsyncOpt *options = opt.get(emuenv.mem);
+    const auto file = get_file_stats(emuenv.io, fd);
+    if (!file)
+        return complete_async_op(emuenv, thread_id, export_name, options->async_param, seek_file(fd, options->offset, options->whence, emuenv.io, export_name));
+
+    const SceOff offset = options->offset;
+    const SceIoSeekMode whence = options->whence;
+    return submit_async_op(emuenv, thread_id, export_name, fd, options->async_param, [file = *file, offset, whence]() -> SceInt64 {
+        if (!file.seek(offset, whence))
+            return SCE_ERROR_ERRNO_EINVAL;
+        return file.tell();
+    });
 }
 
 EXPORT(int, _sceIoMkdir, const char *dir, const SceMode mode) {
@@ -106,9 +157,9 @@ EXPORT(int, _sceIoMkdir, const char *dir, const SceMode mode) {
     return create_dir(emuenv.io, dir, mode, emuenv.pref_path, export_name);
 }
 
-EXPORT(int, _sceIoMkdirAsync) {
-    TRACY_FUNC(_sceIoMkdirAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, _sceIoMkdirAsync, const char *dir, const SceMode mode, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(_sceIoMkdirAsync, dir, mode, param);
+    return complete_async_op(emuenv, thread_id, export_name, param, create_dir(emuenv.io, dir, mode, emuenv.pref_path, export_name));
 }
 
 EXPORT(int, _sceIoOpen, const char *file, const int flags, const SceMode mode) {
@@ -120,29 +171,61 @@ EXPORT(int, _sceIoOpen, const char *file, const int flags, const SceMode mode) {
     return open_file(emuenv.io, file, flags, emuenv.pref_path, export_name);
 }
 
-EXPORT(int, _sceIoOpenAsync) {
-    TRACY_FUNC(_sceIoOpenAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, _sceIoOpenAsync, const char *file, const int flags, const SceMode mode, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(_sceIoOpenAsync, file, flags, mode, param);
+    if (file == nullptr) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+    LOG_INFO("Opening file: {}", file);
+    return complete_async_op(emuenv, thread_id, export_name, param, open_file(emuenv.io, file, flags, emuenv.pref_path, export_name));
 }
 
-EXPORT(int, _sceIoPread) {
-    TRACY_FUNC(_sceIoPread);
-    return UNIMPLEMENTED();
+EXPORT(SceSSize, _sceIoPread, const SceUID fd, void *data, const SceSize size, Ptr<_sceIoPreadOpt> opt) {
+    TRACY_FUNC(_sceIoPread, fd, data, size, opt);
+    if (data == nullptr) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_ADDR);
+    }
+    return pread_file(data, emuenv.io, fd, size, opt.get(emuenv.mem)->offset, export_name);
 }
 
-EXPORT(int, _sceIoPreadAsync) {
-    TRACY_FUNC(_sceIoPreadAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, _sceIoPreadAsync, const SceUID fd, void *data, const SceSize size, Ptr<_sceIoPreadAsyncOpt> opt) {
+    TRACY_FUNC(_sceIoPreadAsync, fd, data, size, opt);
+    if (data == nullptr) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_ADDR);
+    }
+    const _sceIoPreadAsyncOpt *options = opt.get(emuenv.mem);
+    const auto file = get_file_stats(emuenv.io, fd);
+    if (!file)
+        return complete_async_op(emuenv, thread_id, export_name, options->async_param, pread_file(data, emuenv.io, fd, size, options->offset, export_name));
+
+    const SceOff offset = options->offset;
+    return submit_async_op(emuenv, thread_id, export_name, fd, options->async_param, [file = *file, data, size, offset]() -> SceInt64 {
+        return file.pread(data, size, offset);
+    });
 }
 
-EXPORT(int, _sceIoPwrite) {
-    TRACY_FUNC(_sceIoPwrite);
-    return UNIMPLEMENTED();
+EXPORT(SceSSize, _sceIoPwrite, const SceUID fd, const void *data, const SceSize size, Ptr<_sceIoPreadOpt> opt) {
+    TRACY_FUNC(_sceIoPwrite, fd, data, size, opt);
+    if (data == nullptr) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_ADDR);
+    }
+    return pwrite_file(fd, data, size, opt.get(emuenv.mem)->offset, emuenv.io, export_name);
 }
 
-EXPORT(int, _sceIoPwriteAsync) {
-    TRACY_FUNC(_sceIoPwriteAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, _sceIoPwriteAsync, const SceUID fd, const void *data, const SceSize size, Ptr<_sceIoPreadAsyncOpt> opt) {
+    TRACY_FUNC(_sceIoPwriteAsync, fd, data, size, opt);
+    if (data == nullptr) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_ADDR);
+    }
+    const _sceIoPreadAsyncOpt *options = opt.get(emuenv.mem);
+    const auto file = get_file_stats(emuenv.io, fd);
+    if (!file || !file->can_write_file())
+        return complete_async_op(emuenv, thread_id, export_name, options->async_param, pwrite_file(fd, data, size, options->offset, emuenv.io, export_name));
+
+    const SceOff offset = options->offset;
+    return submit_async_op(emuenv, thread_id, export_name, fd, options->async_param, [file = *file, data, size, offset]() -> SceInt64 {
+        return file.pwrite(data, size, offset);
+    });
 }
 
 EXPORT(int, _sceIoRemove) {
@@ -150,9 +233,12 @@ EXPORT(int, _sceIoRemove) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, _sceIoRemoveAsync) {
-    TRACY_FUNC(_sceIoRemoveAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, _sceIoRemoveAsync, const char *file, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(_sceIoRemoveAsync, file, param);
+    if (file == nullptr) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+    return complete_async_op(emuenv, thread_id, export_name, param, remove_file(emuenv.io, file, emuenv.pref_path, export_name));
 }
 
 EXPORT(int, _sceIoRename) {
@@ -170,9 +256,12 @@ EXPORT(int, _sceIoRmdir) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, _sceIoRmdirAsync) {
-    TRACY_FUNC(_sceIoRmdirAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, _sceIoRmdirAsync, const char *dir, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(_sceIoRmdirAsync, dir, param);
+    if (dir == nullptr) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+    return complete_async_op(emuenv, thread_id, export_name, param, remove_dir(emuenv.io, dir, emuenv.pref_path, export_name));
 }
 
 EXPORT(int, _sceIoSync) {
@@ -185,9 +274,17 @@ EXPORT(int, _sceIoSyncAsync) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceIoCancel) {
-    TRACY_FUNC(sceIoCancel);
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoCancel, const SceUID op_id) {
+    TRACY_FUNC(sceIoCancel, op_id);
+    // only the operations which have not been started yet can be canceled
+    switch (emuenv.io.async_io.cancel(op_id, SCE_ERROR_ERRNO_ECANCELED)) {
+    case AsyncIoEngine::CancelResult::Canceled:
+        return SCE_KERNEL_OK;
+    case AsyncIoEngine::CancelResult::Running:
+        return RET_ERROR(SCE_ERROR_ERRNO_EBUSY);
+    default:
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_EVENT_ID);
+    }
 }
 
 EXPORT(int, sceIoChstatByFdAsync) {
@@ -200,14 +297,27 @@ EXPORT(int, sceIoClose, const SceUID fd) {
     return close_file(emuenv.io, fd, export_name);
 }
 
-EXPORT(int, sceIoCloseAsync) {
-    TRACY_FUNC(sceIoCloseAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoCloseAsync, const SceUID fd, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoCloseAsync, fd, param);
+    // The fd is removed right away, the pending operations keep the host file open until they are done.
+    // Completing the close after them keeps the order of the operations on this fd.
+    const int result = close_file(emuenv.io, fd, export_name);
+    if (result < 0)
+        return complete_async_op(emuenv, thread_id, export_name, param, result);
+
+    return submit_async_op(emuenv, thread_id, export_name, fd, param, [result]() -> SceInt64 {
+        return result;
+    });
 }
 
-EXPORT(int, sceIoComplete) {
-    TRACY_FUNC(sceIoComplete);
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoComplete, const SceUID op_id) {
+    TRACY_FUNC(sceIoComplete, op_id);
+    SceInt64 result;
+    if (!emuenv.io.async_io.wait(op_id, result))
+        return RET_ERROR(SCE_KERNEL_ERROR_UNKNOWN_EVENT_ID);
+
+    emuenv.io.async_io.release(op_id);
+    return simple_event_delete(emuenv.kernel, export_name, thread_id, op_id);
 }
 
 EXPORT(int, sceIoDclose, const SceUID fd) {
@@ -215,19 +325,22 @@ EXPORT(int, sceIoDclose, const SceUID fd) {
     return close_dir(emuenv.io, fd, export_name);
 }
 
-EXPORT(int, sceIoDcloseAsync) {
-    TRACY_FUNC(sceIoDcloseAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoDcloseAsync, const SceUID fd, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoDcloseAsync, fd, param);
+    return complete_async_op(emuenv, thread_id, export_name, param, close_dir(emuenv.io, fd, export_name));
 }
 
-EXPORT(int, sceIoDopenAsync) {
-    TRACY_FUNC(sceIoDopenAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoDopenAsync, const char *dir, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoDopenAsync, dir, param);
+    return complete_async_op(emuenv, thread_id, export_name, param, open_dir(emuenv.io, dir, emuenv.pref_path, export_name));
 }
 
-EXPORT(int, sceIoDreadAsync) {
-    TRACY_FUNC(sceIoDreadAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoDreadAsync, const SceUID fd, SceIoDirent *dir, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoDreadAsync, fd, dir, param);
+    if (dir == nullptr) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_ADDR);
+    }
+    return complete_async_op(emuenv, thread_id, export_name, param, read_dir(emuenv.io, fd, dir, emuenv.pref_path, export_name));
 }
 
 EXPORT(int, sceIoFlockForSystem) {
@@ -235,9 +348,9 @@ EXPORT(int, sceIoFlockForSystem) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceIoGetPriority) {
-    TRACY_FUNC(sceIoGetPriority);
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoGetPriority, const SceUID fd) {
+    TRACY_FUNC(sceIoGetPriority, fd);
+    return get_fd_io_priority(emuenv.io, thread_id, fd, export_name);
 }
 
 EXPORT(int, sceIoGetPriorityForSystem) {
@@ -247,12 +360,12 @@ EXPORT(int, sceIoGetPriorityForSystem) {
 
 EXPORT(int, sceIoGetProcessDefaultPriority) {
     TRACY_FUNC(sceIoGetProcessDefaultPriority);
-    return UNIMPLEMENTED();
+    return emuenv.io.process_default_priority;
 }
 
 EXPORT(int, sceIoGetThreadDefaultPriority) {
     TRACY_FUNC(sceIoGetThreadDefaultPriority);
-    return UNIMPLEMENTED();
+    return get_thread_default_io_priority(emuenv.io, thread_id);
 }
 
 EXPORT(int, sceIoGetThreadDefaultPriorityForSystem) {
@@ -260,9 +373,9 @@ EXPORT(int, sceIoGetThreadDefaultPriorityForSystem) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceIoGetstatByFdAsync) {
-    TRACY_FUNC(sceIoGetstatByFdAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoGetstatByFdAsync, const SceUID fd, SceIoStat *stat, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoGetstatByFdAsync, fd, stat, param);
+    return complete_async_op(emuenv, thread_id, export_name, param, stat_file_by_fd(emuenv.io, fd, stat, emuenv.pref_path, export_name));
 }
 
 EXPORT(int, sceIoLseek32, const SceUID fd, const int32_t offset, const SceIoSeekMode whence) {
@@ -275,14 +388,26 @@ EXPORT(int, sceIoRead, const SceUID fd, void *data, const SceSize size) {
     return read_file(data, emuenv.io, fd, size, export_name);
 }
 
-EXPORT(int, sceIoReadAsync) {
-    TRACY_FUNC(sceIoReadAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoReadAsync, const SceUID fd, void *data, const SceSize size, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoReadAsync, fd, data, size, param);
+    if (data == nullptr) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_ADDR);
+    }
+    const auto file = get_file_stats(emuenv.io, fd);
+    if (!file)
+        return complete_async_op(emuenv, thread_id, export_name, param, read_file(data, emuenv.io, fd, size, export_name));
+
+    return submit_async_op(emuenv, thread_id, export_name, fd, param, [file = *file, data, size]() -> SceInt64 {
+        return file.read(data, 1, size);
+    });
 }
 
-EXPORT(int, sceIoSetPriority) {
-    TRACY_FUNC(sceIoSetPriority);
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoSetPriority, const SceUID fd, const int priority) {
+    TRACY_FUNC(sceIoSetPriority, fd, priority);
+    if (!is_valid_io_priority(priority)) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+    return set_fd_io_priority(emuenv.io, fd, priority, export_name);
 }
 
 EXPORT(int, sceIoSetPriorityForSystem) {
@@ -290,14 +415,22 @@ EXPORT(int, sceIoSetPriorityForSystem) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, sceIoSetProcessDefaultPriority) {
-    TRACY_FUNC(sceIoSetProcessDefaultPriority);
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoSetProcessDefaultPriority, const int priority) {
+    TRACY_FUNC(sceIoSetProcessDefaultPriority, priority);
+    if (!is_valid_io_priority(priority)) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+    emuenv.io.process_default_priority = priority;
+    return SCE_KERNEL_OK;
 }
 
-EXPORT(int, sceIoSetThreadDefaultPriority) {
-    TRACY_FUNC(sceIoSetThreadDefaultPriority);
-    return UNIMPLEMENTED();
+EXPORT(int, sceIoSetThreadDefaultPriority, const int priority) {
+    TRACY_FUNC(sceIoSetThreadDefaultPriority, priority);
+    if (!is_valid_io_priority(priority)) {
+        return RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
+    }
+    set_thread_default_io_priority(emuenv.io, thread_id, priority);
+    return SCE_KERNEL_OK;
 }
 
 EXPORT(int, sceIoSetThreadDefaultPriorityForSystem) {
@@ -320,9 +453,18 @@ EXPORT(int, sceIoWrite, const SceUID fd, const void *data, const SceSize size) {
     return write_file(fd, data, size, emuenv.io, export_name);
 }
 
-EXPORT(int, sceIoWriteAsync) {
-    TRACY_FUNC(sceIoWriteAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoWriteAsync, const SceUID fd, const void *data, const SceSize size, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoWriteAsync, fd, data, size, param);
+    if (data == nullptr) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_ADDR);
+    }
+    const auto file = get_file_stats(emuenv.io, fd);
+    if (!file || !file->can_write_file())
+        return complete_async_op(emuenv, thread_id, export_name, param, write_file(fd, data, size, emuenv.io, export_name));
+
+    return submit_async_op(emuenv, thread_id, export_name, fd, param, [file = *file, data, size]() -> SceInt64 {
+        return file.write(data, 1, size);
+    });
 }
 
 BRIDGE_IMPL(_sceIoChstat)
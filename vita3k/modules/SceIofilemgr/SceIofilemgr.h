@@ -26,11 +26,40 @@ typedef struct _sceIoLseekOpt {
     uint32_t unk;
 } _sceIoLseekOpt;
 
+typedef struct _sceIoLseekAsyncOpt {
+    SceOff offset;
+    SceIoSeekMode whence;
+    Ptr<SceIoAsyncParam> async_param;
+} _sceIoLseekAsyncOpt;
+
+// Also used by _sceIoPwrite
+typedef struct _sceIoPreadOpt {
+    SceOff offset;
+    uint32_t unk[2];
+} _sceIoPreadOpt;
+
+// Also used by _sceIoPwriteAsync
+typedef struct _sceIoPreadAsyncOpt {
+    SceOff offset;
+    Ptr<SceIoAsyncParam> async_param;
+    uint32_t unk;
+} _sceIoPreadAsyncOpt;
+
 EXPORT(int, _sceIoDopen, const char *dir);
 EXPORT(int, _sceIoDread, const SceUID fd, SceIoDirent *dir);
 EXPORT(int, _sceIoMkdir, const char *dir, const SceMode mode);
 EXPORT(SceOff, _sceIoLseek, const SceUID fd, Ptr<_sceIoLseekOpt> opt);
 EXPORT(int, _sceIoGetstat, const char *file, SceIoStat *stat);
+EXPORT(SceUID, _sceIoGetstatAsync, const char *file, SceIoStat *stat, Ptr<SceIoAsyncParam> param);
+EXPORT(SceUID, _sceIoLseekAsync, const SceUID fd, Ptr<_sceIoLseekAsyncOpt> opt);
+EXPORT(SceUID, _sceIoMkdirAsync, const char *dir, const SceMode mode, Ptr<SceIoAsyncParam> param);
+EXPORT(SceUID, _sceIoOpenAsync, const char *file, const int flags, const SceMode mode, Ptr<SceIoAsyncParam> param);
+EXPORT(SceSSize, _sceIoPread, const SceUID fd, void *data, const SceSize size, Ptr<_sceIoPreadOpt> opt);
+EXPORT(SceUID, _sceIoPreadAsync, const SceUID fd, void *data, const SceSize size, Ptr<_sceIoPreadAsyncOpt> opt);
+EXPORT(SceSSize, _sceIoPwrite, const SceUID fd, const void *data, const SceSize size, Ptr<_sceIoPreadOpt> opt);
+EXPORT(SceUID, _sceIoPwriteAsync, const SceUID fd, const void *data, const SceSize size, Ptr<_sceIoPreadAsyncOpt> opt);
+EXPORT(SceUID, _sceIoRemoveAsync, const char *file, Ptr<SceIoAsyncParam> param);
+EXPORT(SceUID, _sceIoRmdirAsync, const char *dir, Ptr<SceIoAsyncParam> param);
 
 BRIDGE_DECL(_sceIoChstat)
 BRIDGE_DECL(_sceIoChstatAsync)
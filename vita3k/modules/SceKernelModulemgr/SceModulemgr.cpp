@@ -52,28 +52,17 @@ static bool load_module(SceUID &mod_id, Ptr<const void> &entry_point, SceKernelM
             error_val = RET_ERROR(file);
             return false;
         }
-        const auto size = seek_file(file, 0, SCE_SEEK_END, emuenv.io, export_name);
-        if (size < 0) {
+        // map the host file instead of copying it
+        const auto file_stats = get_file_stats(emuenv.io, file);
+        MappedFile data;
+        const bool mapped = file_stats && data.open(file_stats->get_system_location(), MappedFile::Access::Sequential);
+        close_file(emuenv.io, file, export_name);
+        if (!mapped || data.size() == 0) {
             error_val = RET_ERROR(SCE_ERROR_ERRNO_EINVAL);
             return false;
         }
 
-        if (seek_file(file, 0, SCE_SEEK_SET, emuenv.io, export_name) < 0) {
-            error_val = RET_ERROR(static_cast<int>(size));
-            return false;
-        }
-
-        std::vector<char> data(static_cast<int>(size) + 1); // null-terminated char array
-        if (read_file(data.data(), emuenv.io, file, SceSize(size), export_name) < 0) {
-            data.clear();
-            error_val = RET_ERROR(static_cast<int>(size));
-            return false;
-        }
-
         mod_id = load_self(entry_point, emuenv.kernel, emuenv.mem, data.data(), path);
-
-        close_file(emuenv.io, file, export_name);
-        data.clear();
         if (mod_id < 0) {
             error_val = RET_ERROR(mod_id);
             return false;
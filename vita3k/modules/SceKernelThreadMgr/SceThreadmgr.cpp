@@ -26,18 +26,9 @@
 
 #include <util/lock_and_find.h>
 
-#include <chrono>
-#include <thread>
-
 #include <util/tracy.h>
 TRACY_MODULE_NAME(SceThreadmgr);
 
-inline uint64_t get_current_time() {
-    return std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch())
-        .count();
-}
-
 EXPORT(int, __sceKernelCreateLwMutex, Ptr<SceKernelLwMutexWork> workarea, const char *name, unsigned int attr, Ptr<SceKernelCreateLwMutex_opt> opt) {
     TRACY_FUNC(__sceKernelCreateLwMutex, workarea, name, attr, opt);
     assert(name != nullptr);
@@ -943,37 +934,36 @@ EXPORT(int, sceKernelCreateThreadForUser, const char *name, SceKernelThreadEntry
     return thread->id;
 }
 
-int delay_thread(SceUInt delay_us) {
+int delay_thread(KernelState &kernel, SceUInt delay_us) {
     if (delay_us == 0)
         return SCE_KERNEL_ERROR_INVALID_ARGUMENT;
 
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+    kernel.clock.sleep_for(delay_us);
 
     return SCE_KERNEL_OK;
 }
 
 int delay_thread_cb(EmuEnvState &emuenv, SceUID thread_id, SceUInt delay_us) {
-    auto start = std::chrono::high_resolution_clock::now(); // Meseaure the time taken to process callbacks
+    const uint64_t start = emuenv.kernel.clock.now(); // Meseaure the time taken to process callbacks
     process_callbacks(emuenv.kernel, thread_id);
-    auto end = std::chrono::high_resolution_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    const uint64_t elapsed = emuenv.kernel.clock.now() - start;
 
-    if (delay_us > elapsed.count()) // If we spent less time than requested processing callbacks, sleep the remaining time
-        return delay_thread(delay_us - elapsed.count());
+    if (delay_us > elapsed) // If we spent less time than requested processing callbacks, sleep the remaining time
+        return delay_thread(emuenv.kernel, static_cast<SceUInt>(delay_us - elapsed));
     else // Else return directly
         return SCE_KERNEL_OK;
 }
 
 EXPORT(int, sceKernelDelayThread, SceUInt delay) {
     TRACY_FUNC(sceKernelDelayThread, delay);
-    return delay_thread(delay);
+    return delay_thread(emuenv.kernel, delay);
 }
 
 EXPORT(int, sceKernelDelayThread200, SceUInt delay) {
     TRACY_FUNC(sceKernelDelayThread200, delay);
     if (delay < 201)
         delay = 201;
-    return delay_thread(delay);
+    return delay_thread(emuenv.kernel, delay);
 }
 
 EXPORT(int, sceKernelDelayThreadCB, SceUInt delay) {
@@ -1077,7 +1067,7 @@ EXPORT(int, sceKernelGetProcessId) {
 
 EXPORT(uint64_t, sceKernelGetSystemTimeWide) {
     TRACY_FUNC(sceKernelGetSystemTimeWide);
-    return get_current_time();
+    return emuenv.kernel.clock.now();
 }
 
 EXPORT(SceInt32, sceKernelGetThreadCpuAffinityMask, SceUID thid) {
@@ -1117,7 +1107,7 @@ EXPORT(uint64_t, sceKernelGetTimerTimeWide, SceUID timer_handle) {
     if (!timer_info)
         return -1;
 
-    return get_current_time() - timer_info->time;
+    return emuenv.kernel.clock.now() - timer_info->time;
 }
 
 EXPORT(SceInt32, sceKernelNotifyCallback, SceUID callbackId, SceInt32 notifyArg) {
@@ -1290,7 +1280,7 @@ EXPORT(int, sceKernelStartTimer, SceUID timer_handle) {
         return RET_ERROR(SCE_KERNEL_ERROR_TIMER_COUNTING);
 
     timer_info->is_started = true;
-    timer_info->time = get_current_time();
+    timer_info->time = emuenv.kernel.clock.now();
 
     return 0;
 }
@@ -1306,7 +1296,7 @@ EXPORT(int, sceKernelStopTimer, SceUID timer_handle) {
         return RET_ERROR(SCE_KERNEL_ERROR_TIMER_STOPPED);
 
     timer_info->is_started = false;
-    timer_info->time = get_current_time();
+    timer_info->time = emuenv.kernel.clock.now();
 
     return 0;
 }
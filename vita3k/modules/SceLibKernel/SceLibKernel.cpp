@@ -56,12 +56,6 @@ enum class TimerFlags : uint32_t {
 
 TRACY_MODULE_NAME(SceLibKernel);
 
-inline uint64_t get_current_time() {
-    return std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch())
-        .count();
-}
-
 VAR_EXPORT(__sce_libcparam) {
     // This variable almost newer used. So I return something that looks good, but not exacly correct.
     return (emuenv.kernel.process_param ? emuenv.kernel.process_param.get(emuenv.mem)->sce_libc_param.address() : 0);
@@ -534,9 +528,9 @@ EXPORT(int, sceIoGetstat, const char *file, SceIoStat *stat) {
     return CALL_EXPORT(_sceIoGetstat, file, stat);
 }
 
-EXPORT(int, sceIoGetstatAsync) {
-    TRACY_FUNC(sceIoGetstatAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoGetstatAsync, const char *file, SceIoStat *stat, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoGetstatAsync, file, stat, param);
+    return CALL_EXPORT(_sceIoGetstatAsync, file, stat, param);
 }
 
 EXPORT(int, sceIoGetstatByFd, const SceUID fd, SceIoStat *stat) {
@@ -566,9 +560,17 @@ EXPORT(SceOff, sceIoLseek, const SceUID fd, const SceOff offset, const SceIoSeek
     return res;
 }
 
-EXPORT(int, sceIoLseekAsync) {
-    TRACY_FUNC(sceIoLseekAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoLseekAsync, const SceUID fd, const SceOff offset, const SceIoSeekMode whence, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoLseekAsync, fd, offset, whence, param);
+    const ThreadStatePtr thread = lock_and_find(thread_id, emuenv.kernel.threads, emuenv.kernel.mutex);
+
+    Ptr<_sceIoLseekAsyncOpt> options = Ptr<_sceIoLseekAsyncOpt>(stack_alloc(*thread->cpu, sizeof(_sceIoLseekAsyncOpt)));
+    options.get(emuenv.mem)->offset = offset;
+    options.get(emuenv.mem)->whence = whence;
+    options.get(emuenv.mem)->async_param = param;
+    const SceUID res = CALL_EXPORT(_sceIoLseekAsync, fd, options);
+    stack_free(*thread->cpu, sizeof(_sceIoLseekAsyncOpt));
+    return res;
 }
 
 EXPORT(int, sceIoMkdir, const char *dir, const SceMode mode) {
@@ -576,9 +578,9 @@ EXPORT(int, sceIoMkdir, const char *dir, const SceMode mode) {
     return CALL_EXPORT(_sceIoMkdir, dir, mode);
 }
 
-EXPORT(int, sceIoMkdirAsync) {
-    TRACY_FUNC(sceIoMkdirAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoMkdirAsync, const char *dir, const SceMode mode, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoMkdirAsync, dir, mode, param);
+    return CALL_EXPORT(_sceIoMkdirAsync, dir, mode, param);
 }
 
 EXPORT(SceUID, sceIoOpen, const char *file, const int flags, const SceMode mode) {
@@ -590,43 +592,49 @@ EXPORT(SceUID, sceIoOpen, const char *file, const int flags, const SceMode mode)
     return open_file(emuenv.io, file, flags, emuenv.pref_path, export_name);
 }
 
-EXPORT(int, sceIoOpenAsync) {
-    TRACY_FUNC(sceIoOpenAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoOpenAsync, const char *file, const int flags, const SceMode mode, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoOpenAsync, file, flags, mode, param);
+    return CALL_EXPORT(_sceIoOpenAsync, file, flags, mode, param);
 }
 
 EXPORT(SceSSize, sceIoPread, SceUID fd, void *buf, SceSize nbyte, SceOff offset) {
     TRACY_FUNC(sceIoPread, fd, buf, nbyte, offset);
-    auto pos = tell_file(emuenv.io, fd, export_name);
-    if (pos < 0) {
-        return static_cast<SceSSize>(pos);
+    if (buf == nullptr) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_ADDR);
     }
-    seek_file(fd, offset, SCE_SEEK_SET, emuenv.io, export_name);
-    const auto res = read_file(buf, emuenv.io, fd, nbyte, export_name);
-    seek_file(fd, pos, SCE_SEEK_SET, emuenv.io, export_name);
-    return res;
+    return pread_file(buf, emuenv.io, fd, nbyte, offset, export_name);
 }
 
-EXPORT(int, sceIoPreadAsync) {
-    TRACY_FUNC(sceIoPreadAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoPreadAsync, const SceUID fd, void *buf, const SceSize nbyte, const SceOff offset, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoPreadAsync, fd, buf, nbyte, offset, param);
+    const ThreadStatePtr thread = lock_and_find(thread_id, emuenv.kernel.threads, emuenv.kernel.mutex);
+
+    Ptr<_sceIoPreadAsyncOpt> options = Ptr<_sceIoPreadAsyncOpt>(stack_alloc(*thread->cpu, sizeof(_sceIoPreadAsyncOpt)));
+    options.get(emuenv.mem)->offset = offset;
+    options.get(emuenv.mem)->async_param = param;
+    const SceUID res = CALL_EXPORT(_sceIoPreadAsync, fd, buf, nbyte, options);
+    stack_free(*thread->cpu, sizeof(_sceIoPreadAsyncOpt));
+    return res;
 }
 
 EXPORT(SceSSize, sceIoPwrite, SceUID fd, const void *buf, SceSize nbyte, SceOff offset) {
     TRACY_FUNC(sceIoPwrite, fd, buf, nbyte, offset);
-    auto pos = tell_file(emuenv.io, fd, export_name);
-    if (pos < 0) {
-        return static_cast<SceSSize>(pos);
+    if (buf == nullptr) {
+        return RET_ERROR(SCE_KERNEL_ERROR_ILLEGAL_ADDR);
     }
-    seek_file(fd, offset, SCE_SEEK_SET, emuenv.io, export_name);
-    const auto res = write_file(fd, buf, nbyte, emuenv.io, export_name);
-    seek_file(fd, pos, SCE_SEEK_SET, emuenv.io, export_name);
-    return res;
+    return pwrite_file(fd, buf, nbyte, offset, emuenv.io, export_name);
 }
 
-EXPORT(int, sceIoPwriteAsync) {
-    TRACY_FUNC(sceIoPwriteAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoPwriteAsync, const SceUID fd, const void *buf, const SceSize nbyte, const SceOff offset, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoPwriteAsync, fd, buf, nbyte, offset, param);
+    const ThreadStatePtr thread = lock_and_find(thread_id, emuenv.kernel.threads, emuenv.kernel.mutex);
+
+    Ptr<_sceIoPreadAsyncOpt> options = Ptr<_sceIoPreadAsyncOpt>(stack_alloc(*thread->cpu, sizeof(_sceIoPreadAsyncOpt)));
+    options.get(emuenv.mem)->offset = offset;
+    options.get(emuenv.mem)->async_param = param;
+    const SceUID res = CALL_EXPORT(_sceIoPwriteAsync, fd, buf, nbyte, options);
+    stack_free(*thread->cpu, sizeof(_sceIoPreadAsyncOpt));
+    return res;
 }
 
 EXPORT(int, sceIoRead2) {
@@ -642,9 +650,9 @@ EXPORT(int, sceIoRemove, const char *path) {
     return remove_file(emuenv.io, path, emuenv.pref_path, export_name);
 }
 
-EXPORT(int, sceIoRemoveAsync) {
-    TRACY_FUNC(sceIoRemoveAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoRemoveAsync, const char *path, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoRemoveAsync, path, param);
+    return CALL_EXPORT(_sceIoRemoveAsync, path, param);
 }
 
 EXPORT(int, sceIoRename) {
@@ -665,9 +673,9 @@ EXPORT(int, sceIoRmdir, const char *path) {
     return remove_dir(emuenv.io, path, emuenv.pref_path, export_name);
 }
 
-EXPORT(int, sceIoRmdirAsync) {
-    TRACY_FUNC(sceIoRmdirAsync);
-    return UNIMPLEMENTED();
+EXPORT(SceUID, sceIoRmdirAsync, const char *path, Ptr<SceIoAsyncParam> param) {
+    TRACY_FUNC(sceIoRmdirAsync, path, param);
+    return CALL_EXPORT(_sceIoRmdirAsync, path, param);
 }
 
 EXPORT(int, sceIoSync) {
@@ -1358,19 +1366,19 @@ EXPORT(int, sceKernelGetPMUSERENR) {
 EXPORT(int, sceKernelGetProcessTime, SceUInt64 *time) {
     TRACY_FUNC(sceKernelGetProcessTime, time);
     if (time) {
-        *time = rtc_get_ticks(emuenv.kernel.base_tick.tick) - emuenv.kernel.start_tick;
+        *time = rtc_get_ticks(emuenv.kernel.clock, emuenv.kernel.base_tick.tick) - emuenv.kernel.start_tick;
     }
     return 0;
 }
 
 EXPORT(SceUInt32, sceKernelGetProcessTimeLow) {
     TRACY_FUNC(sceKernelGetProcessTimeLow);
-    return static_cast<SceUInt32>(rtc_get_ticks(emuenv.kernel.base_tick.tick) - emuenv.kernel.start_tick);
+    return static_cast<SceUInt32>(rtc_get_ticks(emuenv.kernel.clock, emuenv.kernel.base_tick.tick) - emuenv.kernel.start_tick);
 }
 
 EXPORT(SceUInt64, sceKernelGetProcessTimeWide) {
     TRACY_FUNC(sceKernelGetProcessTimeWide);
-    return rtc_get_ticks(emuenv.kernel.base_tick.tick) - emuenv.kernel.start_tick;
+    return rtc_get_ticks(emuenv.kernel.clock, emuenv.kernel.base_tick.tick) - emuenv.kernel.start_tick;
 }
 
 EXPORT(int, sceKernelGetRWLockInfo) {
@@ -1491,7 +1499,7 @@ EXPORT(int, sceKernelGetTimerTime, SceUID timer_handle, SceKernelSysClock *time)
     if (!timer_info)
         return SCE_KERNEL_ERROR_UNKNOWN_TIMER_ID;
 
-    *time = get_current_time() - timer_info->time;
+    *time = emuenv.kernel.clock.now() - timer_info->time;
 
     return 0;
 }
@@ -19,6 +19,7 @@
 
 #include <io/functions.h>
 #include <kernel/state.h>
+#include <mem/functions.h>
 #include <util/lock_and_find.h>
 #include <util/log.h>
 #include <util/tracy.h>
@@ -30,6 +31,53 @@ TRACY_MODULE_NAME(SceLibc);
 
 Ptr<void> g_dso;
 
+// The guest ranges of the string and memory functions are checked once per call, the host functions then work on them directly
+static bool check_read(EmuEnvState &emuenv, const char *export_name, Address addr, uint32_t size) {
+    if (size == 0 || (addr != 0 && is_valid_addr_range(emuenv.mem, addr, addr + size)))
+        return true;
+
+    LOG_ERROR("{}: {} bytes at {} are not allocated", export_name, size, log_hex(addr));
+    return false;
+}
+
+// The write watchers of the destination run first, so the copy does not fault in the middle
+static bool check_write(EmuEnvState &emuenv, const char *export_name, Address addr, uint32_t size) {
+    if (!check_read(emuenv, export_name, addr, size))
+        return false;
+
+    notify_host_write(emuenv.mem, addr, size);
+    return true;
+}
+
+// Length of the string without reading past max_length or the allocated pages
+static bool get_string_length(EmuEnvState &emuenv, const char *export_name, Ptr<const char> str, uint32_t &length, uint32_t max_length = UINT32_MAX) {
+    const size_t limit = std::min<size_t>(get_valid_size(emuenv.mem, str.address()), max_length);
+    const char *data = str.get(emuenv.mem);
+    const void *end = limit != 0 ? memchr(data, 0, limit) : nullptr;
+    if (end) {
+        length = static_cast<uint32_t>(static_cast<const char *>(end) - data);
+        return true;
+    }
+    if (limit == max_length) {
+        length = max_length;
+        return true;
+    }
+
+    LOG_ERROR("{}: the string at {} is not terminated in allocated memory", export_name, log_hex(str.address()));
+    return false;
+}
+
+// Compare the string str1 of length length1 with str2, which is read as far as the comparison needs it
+static bool compare_strings(EmuEnvState &emuenv, const char *export_name, Ptr<const char> str1, uint32_t length1, Ptr<const char> str2, int &result) {
+    const size_t count = std::min<size_t>(static_cast<size_t>(length1) + 1, get_valid_size(emuenv.mem, str2.address()));
+    result = count != 0 ? memcmp(str1.get(emuenv.mem), str2.get(emuenv.mem), count) : 0;
+    if (result != 0 || count == static_cast<size_t>(length1) + 1)
+        return true;
+
+    LOG_ERROR("{}: the string at {} is not terminated in allocated memory", export_name, log_hex(str2.address()));
+    return false;
+}
+
 EXPORT(int, _Assert) {
     TRACY_FUNC(_Assert);
     return UNIMPLEMENTED();
@@ -845,19 +893,33 @@ EXPORT(Ptr<void>, memalign, uint32_t alignment, uint32_t size) {
     return Ptr<void>(address);
 }
 
-EXPORT(int, memchr) {
-    TRACY_FUNC(memchr);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<void>, memchr, Ptr<const void> str, int c, uint32_t n) {
+    TRACY_FUNC(memchr, str, c, n);
+    if (!check_read(emuenv, export_name, str.address(), n) || n == 0)
+        return Ptr<void>();
+
+    const uint8_t *data = str.cast<const uint8_t>().get(emuenv.mem);
+    const void *found = memchr(data, c, n);
+    if (!found)
+        return Ptr<void>();
+    return Ptr<void>(str.address() + static_cast<uint32_t>(static_cast<const uint8_t *>(found) - data));
 }
 
-EXPORT(int, memcmp) {
-    TRACY_FUNC(memcmp);
-    return UNIMPLEMENTED();
+EXPORT(int, memcmp, Ptr<const void> str1, Ptr<const void> str2, uint32_t n) {
+    TRACY_FUNC(memcmp, str1, str2, n);
+    if (n == 0 || !check_read(emuenv, export_name, str1.address(), n) || !check_read(emuenv, export_name, str2.address(), n))
+        return 0;
+
+    return memcmp(str1.get(emuenv.mem), str2.get(emuenv.mem), n);
 }
 
-EXPORT(void, memcpy, void *destination, const void *source, uint32_t num) {
+EXPORT(Ptr<void>, memcpy, Ptr<void> destination, Ptr<const void> source, uint32_t num) {
     TRACY_FUNC(memcpy, destination, source, num);
-    memcpy(destination, source, num);
+    if (num == 0 || !check_read(emuenv, export_name, source.address(), num) || !check_write(emuenv, export_name, destination.address(), num))
+        return destination;
+
+    memcpy(destination.get(emuenv.mem), source.get(emuenv.mem), num);
+    return destination;
 }
 
 EXPORT(int, memcpy_s) {
@@ -865,9 +927,13 @@ EXPORT(int, memcpy_s) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(void, memmove, void *destination, const void *source, uint32_t num) {
+EXPORT(Ptr<void>, memmove, Ptr<void> destination, Ptr<const void> source, uint32_t num) {
     TRACY_FUNC(memmove, destination, source, num);
-    memmove(destination, source, num);
+    if (num == 0 || !check_read(emuenv, export_name, source.address(), num) || !check_write(emuenv, export_name, destination.address(), num))
+        return destination;
+
+    memmove(destination.get(emuenv.mem), source.get(emuenv.mem), num);
+    return destination;
 }
 
 EXPORT(int, memmove_s) {
@@ -875,9 +941,13 @@ EXPORT(int, memmove_s) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(void, memset, Ptr<void> str, int c, uint32_t n) {
+EXPORT(Ptr<void>, memset, Ptr<void> str, int c, uint32_t n) {
     TRACY_FUNC(memset, str, c, n);
+    if (n == 0 || !check_write(emuenv, export_name, str.address(), n))
+        return str;
+
     memset(str.get(emuenv.mem), c, n);
+    return str;
 }
 
 EXPORT(int, mktime) {
@@ -1167,9 +1237,18 @@ EXPORT(int, strcasecmp) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(Ptr<char>, strcat, Ptr<char> destination, Ptr<char> source) {
+EXPORT(Ptr<char>, strcat, Ptr<char> destination, Ptr<const char> source) {
     TRACY_FUNC(strcat, destination, source);
-    strcat(destination.get(emuenv.mem), source.get(emuenv.mem));
+    uint32_t destination_length = 0;
+    uint32_t source_length = 0;
+    if (!get_string_length(emuenv, export_name, destination, destination_length) || !get_string_length(emuenv, export_name, source, source_length))
+        return destination;
+
+    const Address end = destination.address() + destination_length;
+    if (!check_write(emuenv, export_name, end, source_length + 1))
+        return destination;
+
+    memcpy(Ptr<char>(end).get(emuenv.mem), source.get(emuenv.mem), source_length + 1);
     return destination;
 }
 
@@ -1178,14 +1257,28 @@ EXPORT(int, strcat_s) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, strchr) {
-    TRACY_FUNC(strchr);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<char>, strchr, Ptr<const char> str, int ch) {
+    TRACY_FUNC(strchr, str, ch);
+    uint32_t length = 0;
+    if (!get_string_length(emuenv, export_name, str, length))
+        return Ptr<char>();
+
+    // The terminator is found too when looking for 0
+    const char *data = str.get(emuenv.mem);
+    const void *found = memchr(data, static_cast<char>(ch), length + 1);
+    if (!found)
+        return Ptr<char>();
+    return Ptr<char>(str.address() + static_cast<uint32_t>(static_cast<const char *>(found) - data));
 }
 
-EXPORT(int, strcmp) {
-    TRACY_FUNC(strcmp);
-    return UNIMPLEMENTED();
+EXPORT(int, strcmp, Ptr<const char> str1, Ptr<const char> str2) {
+    TRACY_FUNC(strcmp, str1, str2);
+    uint32_t length1 = 0;
+    int result = 0;
+    if (!get_string_length(emuenv, export_name, str1, length1) || !compare_strings(emuenv, export_name, str1, length1, str2, result))
+        return 0;
+
+    return result;
 }
 
 EXPORT(int, strcoll) {
@@ -1193,9 +1286,13 @@ EXPORT(int, strcoll) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(Ptr<char>, strcpy, Ptr<char> destination, Ptr<char> source) {
+EXPORT(Ptr<char>, strcpy, Ptr<char> destination, Ptr<const char> source) {
     TRACY_FUNC(strcpy, destination, source);
-    strcpy(destination.get(emuenv.mem), source.get(emuenv.mem));
+    uint32_t length = 0;
+    if (!get_string_length(emuenv, export_name, source, length) || !check_write(emuenv, export_name, destination.address(), length + 1))
+        return destination;
+
+    memcpy(destination.get(emuenv.mem), source.get(emuenv.mem), length + 1);
     return destination;
 }
 
@@ -1204,9 +1301,14 @@ EXPORT(int, strcpy_s) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, strcspn) {
-    TRACY_FUNC(strcspn);
-    return UNIMPLEMENTED();
+EXPORT(uint32_t, strcspn, Ptr<const char> str, Ptr<const char> reject) {
+    TRACY_FUNC(strcspn, str, reject);
+    uint32_t length = 0;
+    uint32_t reject_length = 0;
+    if (!get_string_length(emuenv, export_name, str, length) || !get_string_length(emuenv, export_name, reject, reject_length))
+        return 0;
+
+    return static_cast<uint32_t>(strcspn(str.get(emuenv.mem), reject.get(emuenv.mem)));
 }
 
 EXPORT(int, strdup) {
@@ -1234,9 +1336,13 @@ EXPORT(int, strftime) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, strlen, char *str) {
+EXPORT(uint32_t, strlen, Ptr<const char> str) {
     TRACY_FUNC(strlen, str);
-    return static_cast<int>(strlen(str));
+    uint32_t length = 0;
+    if (!get_string_length(emuenv, export_name, str, length))
+        return 0;
+
+    return length;
 }
 
 EXPORT(int, strncasecmp) {
@@ -1244,9 +1350,21 @@ EXPORT(int, strncasecmp) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, strncat) {
-    TRACY_FUNC(strncat);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<char>, strncat, Ptr<char> destination, Ptr<const char> source, SceSize num) {
+    TRACY_FUNC(strncat, destination, source, num);
+    uint32_t destination_length = 0;
+    uint32_t source_length = 0;
+    if (!get_string_length(emuenv, export_name, destination, destination_length) || !get_string_length(emuenv, export_name, source, source_length, num))
+        return destination;
+
+    const Address end = destination.address() + destination_length;
+    if (!check_write(emuenv, export_name, end, source_length + 1))
+        return destination;
+
+    char *data = Ptr<char>(end).get(emuenv.mem);
+    memcpy(data, source.get(emuenv.mem), source_length);
+    data[source_length] = '\0';
+    return destination;
 }
 
 EXPORT(int, strncat_s) {
@@ -1254,14 +1372,37 @@ EXPORT(int, strncat_s) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, strncmp, const char *str1, const char *str2, SceSize num) {
+EXPORT(int, strncmp, Ptr<const char> str1, Ptr<const char> str2, SceSize num) {
     TRACY_FUNC(strncmp, str1, str2, num);
-    return strncmp(str1, str2, num);
+    uint32_t length1 = 0;
+    if (num == 0 || !get_string_length(emuenv, export_name, str1, length1, num))
+        return 0;
+
+    // Past num characters, only the first num are compared
+    if (length1 == num) {
+        const size_t count = std::min<size_t>(num, get_valid_size(emuenv.mem, str2.address()));
+        const int result = count != 0 ? memcmp(str1.get(emuenv.mem), str2.get(emuenv.mem), count) : 0;
+        LOG_ERROR_IF(result == 0 && count != num, "{}: the string at {} is not terminated in allocated memory", export_name, log_hex(str2.address()));
+        return result;
+    }
+
+    int result = 0;
+    if (!compare_strings(emuenv, export_name, str1, length1, str2, result))
+        return 0;
+
+    return result;
 }
 
-EXPORT(Ptr<char>, strncpy, Ptr<char> destination, Ptr<char> source, SceSize size) {
+EXPORT(Ptr<char>, strncpy, Ptr<char> destination, Ptr<const char> source, SceSize size) {
     TRACY_FUNC(strncpy, destination, source, size);
-    strncpy(destination.get(emuenv.mem), source.get(emuenv.mem), size);
+    uint32_t length = 0;
+    if (size == 0 || !get_string_length(emuenv, export_name, source, length, size) || !check_write(emuenv, export_name, destination.address(), size))
+        return destination;
+
+    // The rest of the destination is filled with zeros
+    char *data = destination.get(emuenv.mem);
+    memcpy(data, source.get(emuenv.mem), length);
+    memset(data + length, 0, size - length);
     return destination;
 }
 
@@ -1270,39 +1411,67 @@ EXPORT(int, strncpy_s) {
     return UNIMPLEMENTED();
 }
 
-EXPORT(int, strnlen_s) {
-    TRACY_FUNC(strnlen_s);
-    return UNIMPLEMENTED();
+EXPORT(uint32_t, strnlen_s, Ptr<const char> str, SceSize maxsize) {
+    TRACY_FUNC(strnlen_s, str, maxsize);
+    uint32_t length = 0;
+    if (!str || !get_string_length(emuenv, export_name, str, length, maxsize))
+        return 0;
+
+    return length;
 }
 
-EXPORT(int, strpbrk) {
-    TRACY_FUNC(strpbrk);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<char>, strpbrk, Ptr<const char> str, Ptr<const char> accept) {
+    TRACY_FUNC(strpbrk, str, accept);
+    uint32_t length = 0;
+    uint32_t accept_length = 0;
+    if (!get_string_length(emuenv, export_name, str, length) || !get_string_length(emuenv, export_name, accept, accept_length))
+        return Ptr<char>();
+
+    const char *data = str.get(emuenv.mem);
+    const char *found = strpbrk(data, accept.get(emuenv.mem));
+    if (!found)
+        return Ptr<char>();
+    return Ptr<char>(str.address() + static_cast<uint32_t>(found - data));
 }
 
-EXPORT(Ptr<char>, strrchr, Ptr<char> str, char ch) {
+EXPORT(Ptr<char>, strrchr, Ptr<const char> str, int ch) {
     TRACY_FUNC(strrchr, str, ch);
-    Ptr<char> res = Ptr<char>();
-    char *_str = str.get(emuenv.mem);
-    for (int i = static_cast<int>(strlen(_str) - 1); i >= 0; i--) {
-        const char ch1 = _str[i];
-        if (ch1 == ch) {
-            res = str + i * sizeof(char);
-            break;
-        }
+    uint32_t length = 0;
+    if (!get_string_length(emuenv, export_name, str, length))
+        return Ptr<char>();
+
+    // The terminator is found too when looking for 0
+    const char *data = str.get(emuenv.mem);
+    for (int64_t i = length; i >= 0; i--) {
+        if (data[i] == static_cast<char>(ch))
+            return Ptr<char>(str.address() + static_cast<uint32_t>(i));
     }
 
-    return res;
+    return Ptr<char>();
 }
 
-EXPORT(int, strspn) {
-    TRACY_FUNC(strspn);
-    return UNIMPLEMENTED();
+EXPORT(uint32_t, strspn, Ptr<const char> str, Ptr<const char> accept) {
+    TRACY_FUNC(strspn, str, accept);
+    uint32_t length = 0;
+    uint32_t accept_length = 0;
+    if (!get_string_length(emuenv, export_name, str, length) || !get_string_length(emuenv, export_name, accept, accept_length))
+        return 0;
+
+    return static_cast<uint32_t>(strspn(str.get(emuenv.mem), accept.get(emuenv.mem)));
 }
 
-EXPORT(int, strstr) {
-    TRACY_FUNC(strstr);
-    return UNIMPLEMENTED();
+EXPORT(Ptr<char>, strstr, Ptr<const char> haystack, Ptr<const char> needle) {
+    TRACY_FUNC(strstr, haystack, needle);
+    uint32_t length = 0;
+    uint32_t needle_length = 0;
+    if (!get_string_length(emuenv, export_name, haystack, length) || !get_string_length(emuenv, export_name, needle, needle_length))
+        return Ptr<char>();
+
+    const char *data = haystack.get(emuenv.mem);
+    const char *found = strstr(data, needle.get(emuenv.mem));
+    if (!found)
+        return Ptr<char>();
+    return Ptr<char>(haystack.address() + static_cast<uint32_t>(found - data));
 }
 
 EXPORT(int, strtod) {
@@ -29,7 +29,10 @@
 #include <util/find.h>
 #include <util/lock_and_find.h>
 #include <util/log.h>
+#include <util/metrics.h>
+#include <util/trace.h>
 
+#include <iterator>
 #include <unordered_set>
 
 static constexpr bool LOG_UNK_NIDS_ALWAYS = false;
@@ -46,18 +49,17 @@ static constexpr bool LOG_UNK_NIDS_ALWAYS = false;
 
 struct EmuEnvState;
 
-static ImportFn resolve_import(uint32_t nid) {
-    switch (nid) {
+// indexed by import_function_index
+static const ImportFn *const import_fns[] = {
 #define VAR_NID(name, nid)
-#define NID(name, nid) \
-    case nid:          \
-        return import_##name;
+#define NID(name, nid) &import_##name,
 #include <nids/nids.inc>
 #undef NID
 #undef VAR_NID
-    }
+};
 
-    return ImportFn();
+static const ImportFn *resolve_import(uint32_t index) {
+    return index < std::size(import_fns) ? import_fns[index] : nullptr;
 }
 
 const std::array<VarExport, var_exports_size> &get_var_exports() {
@@ -113,9 +115,20 @@ void call_import(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid, SceUID thread
             auto lr = read_lr(cpu);
             log_import_call('H', nid, thread_id, hle_nid_blacklist, lr);
         }
-        const ImportFn fn = resolve_import(nid);
-        if (fn) {
-            fn(emuenv, cpu, thread_id);
+        const uint32_t index = import_function_index(nid);
+        const ImportFn *const fn = resolve_import(index);
+        if (fn && *fn) {
+            metrics::add(metrics::HLE_CALLS);
+            // bound when the module importing it was loaded
+            metrics::add(emuenv.kernel.import_counters[index].load(std::memory_order_relaxed));
+            if (trace::is_enabled()) {
+                trace::record(trace::EventType::HLE_CALL, nid, thread_id,
+                    { read_reg(cpu, 0), read_reg(cpu, 1), read_reg(cpu, 2), read_reg(cpu, 3), read_lr(cpu) });
+                (*fn)(emuenv, cpu, thread_id);
+                trace::record(trace::EventType::HLE_RETURN, nid, thread_id, { read_reg(cpu, 0) });
+            } else {
+                (*fn)(emuenv, cpu, thread_id);
+            }
         } else if (emuenv.missing_nids.count(nid) == 0 || LOG_UNK_NIDS_ALWAYS) {
             const ThreadStatePtr thread = lock_and_find(thread_id, emuenv.kernel.threads, emuenv.kernel.mutex);
             LOG_ERROR("Import function for NID {} not found (thread name: {}, thread ID: {})", log_hex(nid), thread->name, thread_id);
@@ -145,6 +158,8 @@ void call_import(EmuEnvState &emuenv, CPUState &cpu, uint32_t nid, SceUID thread
 
         const std::unordered_set<uint32_t> lle_nid_blacklist = {};
         log_import_call('L', nid, thread_id, lle_nid_blacklist, pc);
+        if (trace::is_enabled())
+            trace::record(trace::EventType::LLE_CALL, nid, thread_id, { pc });
         write_pc(cpu, export_pc);
         // TODO: invalidate cache for all threads. Now invalidate_jit_cache is not thread safe.
         invalidate_jit_cache(cpu, pc, 4 * 3);
@@ -162,11 +177,11 @@ bool load_module(EmuEnvState &emuenv, SceUID thread_id, SceSysmoduleModuleId mod
     for (std::string module_path : module_paths) {
         module_path = "sys/external/" + module_path + ".suprx";
 
-        vfs::FileBuffer module_buffer;
+        MappedFile module_file;
         Ptr<const void> lib_entry_point;
 
-        if (vfs::read_file(VitaIoDevice::vs0, module_buffer, emuenv.pref_path, module_path)) {
-            SceUID loaded_module_uid = load_self(lib_entry_point, emuenv.kernel, emuenv.mem, module_buffer.data(), module_path);
+        if (vfs::map_file(VitaIoDevice::vs0, module_file, emuenv.pref_path, module_path)) {
+            SceUID loaded_module_uid = load_self(lib_entry_point, emuenv.kernel, emuenv.mem, module_file.data(), module_path);
             if (loaded_module_uid < 0) {
                 LOG_ERROR("Error when loading module at \"{}\"", module_path);
                 return false;
@@ -0,0 +1,37 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <cstdint>
+
+// Sample processing kernels shared by the NGS modules, using SIMD instructions when available.
+// They give the same results whatever the instruction set used.
+namespace ngs::dsp {
+
+// data[i] *= gain
+void apply_gain(float *data, std::int32_t count, float gain);
+
+// Mix interleaved stereo frames into dest through a volume matrix, with the result clamped to [-1, 1]:
+// dest.l += src.l * matrix[0][0] + src.r * matrix[1][0]
+// dest.r += src.l * matrix[0][1] + src.r * matrix[1][1]
+void mix_stereo(float *dest, const float *src, std::int32_t nb_frames, const float matrix[2][2]);
+
+// Convert [-1, 1] float samples to S16 with saturation
+void convert_f32_to_s16(std::int16_t *dest, const float *src, std::int32_t count);
+
+} // namespace ngs::dsp
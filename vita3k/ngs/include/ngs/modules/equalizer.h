@@ -26,6 +26,7 @@ public:
 
     bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override;
     std::uint32_t module_id() const override { return 0x5CEC; }
+    bool is_thread_safe() const override { return true; }
     std::size_t get_buffer_parameter_size() const override;
 };
 } // namespace ngs::equalizer
@@ -26,6 +26,7 @@
 #include <condition_variable>
 #include <optional>
 #include <queue>
+#include <unordered_map>
 #include <vector>
 
 struct MemState;
@@ -58,7 +59,18 @@ struct OperationPending {
     };
 };
 
+struct VoiceUpdate {
+    Voice *voice;
+    // voices with the same level are not patched to each other and can be processed at the same time
+    std::uint32_t level;
+    bool on_worker;
+    bool finished;
+    std::uint32_t finished_module;
+};
+
 struct VoiceScheduler {
+    static constexpr std::uint32_t LAST_DELIVERY = UINT32_MAX;
+
     std::vector<Voice *> queue;
     std::queue<OperationPending> operations_pending;
 
@@ -67,9 +79,22 @@ struct VoiceScheduler {
     bool is_updating = false;
 
 protected:
+    // only used during update, kept here to avoid allocating them each time
+    std::vector<VoiceUpdate> updates_storage;
+    std::vector<VoiceUpdate *> worker_updates_storage;
+    std::unordered_map<Voice *, std::size_t> update_positions_storage;
+
     bool deque_voice_impl(Voice *voice);
     void deque_insert(const MemState &mem, Voice *voice);
 
+    // copy the queue to updates with the index of each voice in positions and compute their level, returns the highest level
+    std::uint32_t prepare_updates(const MemState &mem, std::vector<VoiceUpdate> &updates, std::unordered_map<Voice *, std::size_t> &positions);
+    void process_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, VoiceUpdate &update, std::unique_lock<std::recursive_mutex> &scheduler_lock);
+    void finish_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, VoiceUpdate &update, std::unique_lock<std::recursive_mutex> &scheduler_lock);
+    // mix the products of the processed voices into the inputs of the voices of dest_level, or with LAST_DELIVERY
+    // into the ones of the voices not updated or processed before their source
+    void deliver_products(const MemState &mem, const std::vector<VoiceUpdate> &updates, const std::unordered_map<Voice *, std::size_t> &positions, const std::uint32_t dest_level);
+
     bool resort_to_respect_dependencies(const MemState &mem, Voice *source);
 
     std::int32_t get_position(Voice *v);
@@ -142,6 +142,8 @@ struct Module {
 
     virtual bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) = 0;
     virtual std::uint32_t module_id() const { return 0; }
+    // true if process never runs guest code, in which case it can be called from a scheduler worker thread
+    virtual bool is_thread_safe() const { return false; }
     virtual std::size_t get_buffer_parameter_size() const = 0;
     virtual void on_state_change(ModuleData &v, const VoiceState previous) {}
     virtual void on_param_change(const MemState &mem, ModuleData &data) {}
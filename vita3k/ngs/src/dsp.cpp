@@ -0,0 +1,250 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/dsp.h>
+
+#include <util/instrset_detect.h>
+#include <util/log.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NGS_DSP_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define NGS_DSP_NEON
+#include <arm_neon.h>
+#endif
+
+// same as util.cpp: msvc allows to use AVX intrinsics without the architecture flag, which are only used after a runtime check
+#if defined(__AVX__) || (defined(_MSC_VER) && !defined(__clang__))
+#define NGS_DSP_AVX
+#include <immintrin.h>
+#endif
+
+namespace ngs::dsp {
+
+// The vectorized versions only process the beginning of the buffers and return how many elements were processed,
+// the scalar versions take care of the rest. The operations are done in the same order so the results are identical.
+
+static void apply_gain_scalar(float *data, std::int32_t start, std::int32_t count, float gain) {
+    for (std::int32_t i = start; i < count; i++)
+        data[i] *= gain;
+}
+
+static void mix_stereo_scalar(float *dest, const float *src, std::int32_t start, std::int32_t nb_frames, const float matrix[2][2]) {
+    for (std::int32_t k = start; k < nb_frames; k++) {
+        dest[k * 2] = std::clamp(dest[k * 2] + src[k * 2] * matrix[0][0] + src[k * 2 + 1] * matrix[1][0], -1.0f, 1.0f);
+        dest[k * 2 + 1] = std::clamp(dest[k * 2 + 1] + src[k * 2] * matrix[0][1] + src[k * 2 + 1] * matrix[1][1], -1.0f, 1.0f);
+    }
+}
+
+static void convert_f32_to_s16_scalar(std::int16_t *dest, const float *src, std::int32_t start, std::int32_t count) {
+    for (std::int32_t i = start; i < count; i++)
+        dest[i] = static_cast<std::int16_t>(std::clamp(src[i] * 32768.0f, -32768.0f, 32767.0f));
+}
+
+#if defined(NGS_DSP_SSE2)
+static std::int32_t apply_gain_sse2(float *data, std::int32_t count, float gain) {
+    const __m128 gain_v = _mm_set1_ps(gain);
+    std::int32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), gain_v));
+
+    return i;
+}
+
+static std::int32_t mix_stereo_sse2(float *dest, const float *src, std::int32_t nb_frames, const float matrix[2][2]) {
+    // max(lo, x) then min(hi, x) keeps NaN like std::clamp
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 left_gains = _mm_setr_ps(matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1]);
+    const __m128 right_gains = _mm_setr_ps(matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1]);
+
+    std::int32_t k = 0;
+    for (; k + 2 <= nb_frames; k += 2) {
+        const __m128 samples = _mm_loadu_ps(src + k * 2);
+        const __m128 left = _mm_shuffle_ps(samples, samples, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 right = _mm_shuffle_ps(samples, samples, _MM_SHUFFLE(3, 3, 1, 1));
+
+        __m128 result = _mm_add_ps(_mm_loadu_ps(dest + k * 2), _mm_mul_ps(left, left_gains));
+        result = _mm_add_ps(result, _mm_mul_ps(right, right_gains));
+        _mm_storeu_ps(dest + k * 2, _mm_min_ps(hi, _mm_max_ps(lo, result)));
+    }
+
+    return k;
+}
+
+static std::int32_t convert_f32_to_s16_sse2(std::int16_t *dest, const float *src, std::int32_t count) {
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 lo = _mm_set1_ps(-32768.0f);
+    const __m128 hi = _mm_set1_ps(32767.0f);
+
+    std::int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128 first = _mm_min_ps(hi, _mm_max_ps(lo, _mm_mul_ps(_mm_loadu_ps(src + i), scale)));
+        const __m128 second = _mm_min_ps(hi, _mm_max_ps(lo, _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_packs_epi32(_mm_cvttps_epi32(first), _mm_cvttps_epi32(second)));
+    }
+
+    return i;
+}
+#endif
+
+#if defined(NGS_DSP_AVX)
+static std::int32_t apply_gain_avx(float *data, std::int32_t count, float gain) {
+    const __m256 gain_v = _mm256_set1_ps(gain);
+    std::int32_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), gain_v));
+
+    return i;
+}
+
+static std::int32_t mix_stereo_avx(float *dest, const float *src, std::int32_t nb_frames, const float matrix[2][2]) {
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 left_gains = _mm256_setr_ps(matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1]);
+    const __m256 right_gains = _mm256_setr_ps(matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1]);
+
+    std::int32_t k = 0;
+    for (; k + 4 <= nb_frames; k += 4) {
+        // the shuffles are done inside each 128-bit lane, which is what we want
+        const __m256 samples = _mm256_loadu_ps(src + k * 2);
+        const __m256 left = _mm256_shuffle_ps(samples, samples, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m256 right = _mm256_shuffle_ps(samples, samples, _MM_SHUFFLE(3, 3, 1, 1));
+
+        __m256 result = _mm256_add_ps(_mm256_loadu_ps(dest + k * 2), _mm256_mul_ps(left, left_gains));
+        result = _mm256_add_ps(result, _mm256_mul_ps(right, right_gains));
+        _mm256_storeu_ps(dest + k * 2, _mm256_min_ps(hi, _mm256_max_ps(lo, result)));
+    }
+
+    return k;
+}
+
+static std::int32_t convert_f32_to_s16_avx(std::int16_t *dest, const float *src, std::int32_t count) {
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    const __m256 lo = _mm256_set1_ps(-32768.0f);
+    const __m256 hi = _mm256_set1_ps(32767.0f);
+
+    std::int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 clamped = _mm256_min_ps(hi, _mm256_max_ps(lo, _mm256_mul_ps(_mm256_loadu_ps(src + i), scale)));
+        // packing 256-bit integers needs AVX2, do it on the two halves
+        const __m256i converted = _mm256_cvttps_epi32(clamped);
+        const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(converted), _mm256_extractf128_si256(converted, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), packed);
+    }
+
+    return i;
+}
+#endif
+
+#if defined(NGS_DSP_NEON)
+static std::int32_t apply_gain_neon(float *data, std::int32_t count, float gain) {
+    std::int32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(data + i, vmulq_n_f32(vld1q_f32(data + i), gain));
+
+    return i;
+}
+
+static std::int32_t mix_stereo_neon(float *dest, const float *src, std::int32_t nb_frames, const float matrix[2][2]) {
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    const float left_values[4] = { matrix[0][0], matrix[0][1], matrix[0][0], matrix[0][1] };
+    const float right_values[4] = { matrix[1][0], matrix[1][1], matrix[1][0], matrix[1][1] };
+    const float32x4_t left_gains = vld1q_f32(left_values);
+    const float32x4_t right_gains = vld1q_f32(right_values);
+
+    std::int32_t k = 0;
+    for (; k + 2 <= nb_frames; k += 2) {
+        const float32x4_t samples = vld1q_f32(src + k * 2);
+        const float32x4_t left = vtrn1q_f32(samples, samples);
+        const float32x4_t right = vtrn2q_f32(samples, samples);
+
+        // no fused multiply-add, to give the same result as the scalar version
+        float32x4_t result = vaddq_f32(vld1q_f32(dest + k * 2), vmulq_f32(left, left_gains));
+        result = vaddq_f32(result, vmulq_f32(right, right_gains));
+        vst1q_f32(dest + k * 2, vminq_f32(hi, vmaxq_f32(lo, result)));
+    }
+
+    return k;
+}
+
+static std::int32_t convert_f32_to_s16_neon(std::int16_t *dest, const float *src, std::int32_t count) {
+    const float32x4_t lo = vdupq_n_f32(-32768.0f);
+    const float32x4_t hi = vdupq_n_f32(32767.0f);
+
+    std::int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t first = vminq_f32(hi, vmaxq_f32(lo, vmulq_n_f32(vld1q_f32(src + i), 32768.0f)));
+        const float32x4_t second = vminq_f32(hi, vmaxq_f32(lo, vmulq_n_f32(vld1q_f32(src + i + 4), 32768.0f)));
+        vst1q_s16(dest + i, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(first)), vqmovn_s32(vcvtq_s32_f32(second))));
+    }
+
+    return i;
+}
+#endif
+
+struct Kernels {
+    std::int32_t (*apply_gain)(float *data, std::int32_t count, float gain);
+    std::int32_t (*mix_stereo)(float *dest, const float *src, std::int32_t nb_frames, const float matrix[2][2]);
+    std::int32_t (*convert_f32_to_s16)(std::int16_t *dest, const float *src, std::int32_t count);
+};
+
+static Kernels select_kernels() {
+#if defined(NGS_DSP_AVX)
+    if (util::instrset::instrset_detect() >= util::instrset::instrset_AVX) {
+        LOG_INFO("Using AVX NGS kernels");
+        return { apply_gain_avx, mix_stereo_avx, convert_f32_to_s16_avx };
+    }
+#endif
+#if defined(NGS_DSP_SSE2)
+    return { apply_gain_sse2, mix_stereo_sse2, convert_f32_to_s16_sse2 };
+#elif defined(NGS_DSP_NEON)
+    return { apply_gain_neon, mix_stereo_neon, convert_f32_to_s16_neon };
+#else
+    return {
+        [](float *, std::int32_t, float) { return 0; },
+        [](float *, const float *, std::int32_t, const float[2][2]) { return 0; },
+        [](std::int16_t *, const float *, std::int32_t) { return 0; }
+    };
+#endif
+}
+
+static const Kernels &get_kernels() {
+    static const Kernels kernels = select_kernels();
+    return kernels;
+}
+
+void apply_gain(float *data, std::int32_t count, float gain) {
+    const std::int32_t done = get_kernels().apply_gain(data, count, gain);
+    apply_gain_scalar(data, done, count, gain);
+}
+
+void mix_stereo(float *dest, const float *src, std::int32_t nb_frames, const float matrix[2][2]) {
+    const std::int32_t done = get_kernels().mix_stereo(dest, src, nb_frames, matrix);
+    mix_stereo_scalar(dest, src, done, nb_frames, matrix);
+}
+
+void convert_f32_to_s16(std::int16_t *dest, const float *src, std::int32_t count) {
+    const std::int32_t done = get_kernels().convert_f32_to_s16(dest, src, count);
+    convert_f32_to_s16_scalar(dest, src, done, count);
+}
+
+} // namespace ngs::dsp
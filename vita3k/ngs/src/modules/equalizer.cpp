@@ -15,6 +15,7 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <ngs/dsp.h>
 #include <ngs/modules/equalizer.h>
 #include <util/log.h>
 
@@ -32,9 +33,7 @@ bool Module::process(KernelState &kern, const MemState &mem, const SceUID thread
         float *product_before = reinterpret_cast<float *>(data.parent->products[0].data);
 
         if (product_before) {
-            for (std::int32_t i = 0; i < data.parent->rack->system->granularity * 2; i++) {
-                product_before[i] *= 0.5f;
-            }
+            dsp::apply_gain(product_before, data.parent->rack->system->granularity * 2, 0.5f);
         }
     }
 
@@ -23,6 +23,7 @@
 #include <ngs/definitions/player.h>
 #include <ngs/definitions/scream.h>
 #include <ngs/definitions/simple.h>
+#include <ngs/dsp.h>
 #include <ngs/modules/atrac9.h>
 #include <ngs/modules/master.h>
 #include <ngs/modules/passthrough.h>
@@ -81,12 +82,7 @@ std::int32_t VoiceInputManager::receive(ngs::Patch *patch, const VoiceProduct &p
 
     // Try mixing, also with the use of this volume matrix
     // Dest is our voice to receive this data.
-    for (std::int32_t k = 0; k < patch->dest->rack->system->granularity; k++) {
-        dest_buffer[k * 2] = std::clamp(dest_buffer[k * 2] + data_to_mix_in[k * 2] * patch->volume_matrix[0][0]
-                + data_to_mix_in[k * 2 + 1] * patch->volume_matrix[1][0],
-            -1.0f, 1.0f);
-        dest_buffer[k * 2 + 1] = std::clamp(dest_buffer[k * 2 + 1] + data_to_mix_in[k * 2] * patch->volume_matrix[0][1] + data_to_mix_in[k * 2 + 1] * patch->volume_matrix[1][1], -1.0f, 1.0f);
-    }
+    dsp::mix_stereo(dest_buffer, data_to_mix_in, patch->dest->rack->system->granularity, patch->volume_matrix);
 
     return 0;
 }
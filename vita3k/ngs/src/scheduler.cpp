@@ -19,9 +19,12 @@
 #include <ngs/system.h>
 
 #include <kernel/state.h>
+#include <util/metrics.h>
+#include <util/worker_pool.h>
 
 #include <algorithm>
 #include <cstring>
+#include <mutex>
 
 namespace ngs {
 bool VoiceScheduler::deque_voice_impl(Voice *voice) {
@@ -128,57 +131,186 @@ bool VoiceScheduler::off(Voice *voice) {
     return true;
 }
 
-void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID thread_id) {
-    std::unique_lock<std::recursive_mutex> scheduler_lock(mutex);
-    is_updating = true;
+static bool can_process_on_worker(const Voice *voice) {
+    return std::all_of(voice->rack->modules.begin(), voice->rack->modules.end(), [](const std::unique_ptr<Module> &module) {
+        return !module || module->is_thread_safe();
+    });
+}
 
-    // make a copy of the queue, this way we have no issue if it is modified in a callbck
-    std::vector<ngs::Voice *> queue_copy = queue;
+std::uint32_t VoiceScheduler::prepare_updates(const MemState &mem, std::vector<VoiceUpdate> &updates, std::unordered_map<Voice *, std::size_t> &positions) {
+    // make a copy of the queue, this way we have no issue if it is modified in a callback
+    updates.clear();
+    positions.clear();
+    for (Voice *voice : queue) {
+        positions[voice] = updates.size();
+        updates.push_back({ voice, 0, false, false, 0 });
+    }
 
-    // Do a first routine to clear inputs from previous update session
-    for (ngs::Voice *voice : queue_copy) {
-        voice->inputs.reset_inputs();
+    // Two patched voices must be processed in the queue order, which is what the serial update does.
+    // The level of a voice is always higher than the one of the voices before it in the queue it is patched with.
+    // A finished callback may change any other voice, so like in the serial update it runs once the voices before it
+    // in the queue are processed and before the ones after it: the voice gets a level after all of them.
+    std::uint32_t max_level = 0;
+    std::uint32_t callback_barrier = 0;
+    for (std::size_t i = 0; i < updates.size(); i++) {
+        Voice *voice = updates[i].voice;
+        updates[i].level = std::max(updates[i].level, callback_barrier);
+
+        for (int pass = 0; pass < 2; pass++) {
+            for (const Voice::Patches &patches : voice->patches) {
+                for (const auto &patch : patches) {
+                    if (!patch)
+                        continue;
+
+                    const auto dest = positions.find(patch.get(mem)->dest);
+                    if (dest == positions.end() || dest->second == i)
+                        continue;
+
+                    // first pass: the level of this voice depends on the destinations before it
+                    // second pass: this voice is now final, propagate it to the destinations after it
+                    if (pass == 0 && dest->second < i)
+                        updates[i].level = std::max(updates[i].level, updates[dest->second].level + 1);
+                    else if (pass == 1 && dest->second > i)
+                        updates[dest->second].level = std::max(updates[dest->second].level, updates[i].level + 1);
+                }
+            }
+
+            if (pass == 0 && voice->finished_callback) {
+                updates[i].level = std::max(updates[i].level, max_level);
+                callback_barrier = updates[i].level + 1;
+            }
+        }
+
+        max_level = std::max(max_level, updates[i].level);
     }
 
-    for (ngs::Voice *voice : queue_copy) {
-        // Modify the state, in peace....
-        std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
-        std::memset(voice->products, 0, sizeof(voice->products));
+    return max_level;
+}
 
-        bool finished = false;
-        uint32_t finished_module = 0;
+void VoiceScheduler::process_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, VoiceUpdate &update, std::unique_lock<std::recursive_mutex> &scheduler_lock) {
+    Voice *voice = update.voice;
 
-        for (std::size_t i = 0; i < voice->rack->modules.size(); i++) {
-            if (voice->rack->modules[i]) {
-                if (voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i], scheduler_lock, voice_lock)) {
-                    finished = true;
-                    finished_module = voice->rack->modules[i]->module_id();
-                }
+    // Modify the state, in peace....
+    std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
+    std::memset(voice->products, 0, sizeof(voice->products));
+
+    for (std::size_t i = 0; i < voice->rack->modules.size(); i++) {
+        if (voice->rack->modules[i]) {
+            if (voice->rack->modules[i]->process(kern, mem, thread_id, voice->datas[i], scheduler_lock, voice_lock)) {
+                update.finished = true;
+                update.finished_module = voice->rack->modules[i]->module_id();
             }
         }
-        if (finished) {
-            voice->is_keyed_off = true;
-            voice->transition(VoiceState::VOICE_STATE_FINALIZING);
-            if (voice->finished_callback) {
-                voice_lock.unlock();
-                scheduler_lock.unlock();
-                voice->invoke_callback(kern, mem, thread_id, voice->finished_callback, voice->finished_callback_user_data, finished_module);
-                scheduler_lock.lock();
-                voice_lock.lock();
-            }
-            voice->is_keyed_off = false;
+    }
+}
 
-            stop(voice);
+void VoiceScheduler::finish_voice(KernelState &kern, const MemState &mem, const SceUID thread_id, VoiceUpdate &update, std::unique_lock<std::recursive_mutex> &scheduler_lock) {
+    Voice *voice = update.voice;
+    std::unique_lock<std::mutex> voice_lock(*voice->voice_mutex);
+
+    if (update.finished) {
+        voice->is_keyed_off = true;
+        voice->transition(VoiceState::VOICE_STATE_FINALIZING);
+        if (voice->finished_callback) {
+            voice_lock.unlock();
+            scheduler_lock.unlock();
+            voice->invoke_callback(kern, mem, thread_id, voice->finished_callback, voice->finished_callback_user_data, update.finished_module);
+            scheduler_lock.lock();
+            voice_lock.lock();
         }
+        voice->is_keyed_off = false;
+
+        stop(voice);
+    }
+
+    voice->frame_count++;
+}
+
+void VoiceScheduler::deliver_products(const MemState &mem, const std::vector<VoiceUpdate> &updates, const std::unordered_map<Voice *, std::size_t> &positions, const std::uint32_t dest_level) {
+    for (const VoiceUpdate &update : updates) {
+        if (update.level >= dest_level)
+            continue;
 
+        Voice *voice = update.voice;
         for (std::size_t i = 0; i < voice->rack->vdef->output_count(); i++) {
-            if (voice->products[i].data)
-                deliver_data(mem, voice, static_cast<std::uint8_t>(i), voice->products[i]);
+            const VoiceProduct &product = voice->products[i];
+            if (!product.data)
+                continue;
+
+            for (const Ptr<Patch> &patch_ptr : voice->patches[i]) {
+                Patch *patch = patch_ptr.get(mem);
+                if (!patch || patch->output_sub_index == -1)
+                    continue;
+
+                // the destinations processed after their source get the product right before their level
+                const auto dest = positions.find(patch->dest);
+                const std::uint32_t level = (dest != positions.end() && updates[dest->second].level > update.level) ? updates[dest->second].level : LAST_DELIVERY;
+                if (level != dest_level)
+                    continue;
+
+                const std::lock_guard<std::mutex> guard(*patch->dest->voice_mutex);
+                patch->dest->inputs.receive(patch, product);
+            }
+        }
+    }
+}
+
+void VoiceScheduler::update(KernelState &kern, const MemState &mem, const SceUID thread_id) {
+    const metrics::ScopedTimer timer(metrics::NGS_TICK_TIME);
+    std::unique_lock<std::recursive_mutex> scheduler_lock(mutex);
+    is_updating = true;
+
+    // taken from the storage, in case update is called again from a callback
+    std::vector<VoiceUpdate> updates = std::move(updates_storage);
+    std::vector<VoiceUpdate *> worker_updates = std::move(worker_updates_storage);
+    std::unordered_map<Voice *, std::size_t> positions = std::move(update_positions_storage);
+    const std::uint32_t max_level = prepare_updates(mem, updates, positions);
+
+    // Do a first routine to clear inputs from previous update session
+    for (VoiceUpdate &update : updates) {
+        update.voice->inputs.reset_inputs();
+    }
+
+    const util::WorkerPool::Job process_on_worker = [&](std::size_t i) {
+        // the voices processed here never touch the scheduler lock
+        std::unique_lock<std::recursive_mutex> no_scheduler_lock;
+        process_voice(kern, mem, thread_id, *worker_updates[i], no_scheduler_lock);
+    };
+
+    for (std::uint32_t level = 0; level <= max_level; level++) {
+        // The products are mixed in the inputs of a voice all at once, going through the sources in the queue order,
+        // so the float sums are done in the same order as in a serial update
+        if (level > 0)
+            deliver_products(mem, updates, positions, level);
+
+        // Voices which can't run guest code are processed on the workers, the other ones on this thread at the same time
+        worker_updates.clear();
+        for (VoiceUpdate &update : updates) {
+            update.on_worker = update.level == level && can_process_on_worker(update.voice);
+            if (update.on_worker)
+                worker_updates.push_back(&update);
         }
 
-        voice->frame_count++;
+        util::parallel_for(worker_updates.size(), process_on_worker, [&]() {
+            for (VoiceUpdate &update : updates) {
+                if (update.level == level && !update.on_worker)
+                    process_voice(kern, mem, thread_id, update, scheduler_lock);
+            }
+        });
+
+        for (VoiceUpdate &update : updates) {
+            if (update.level == level)
+                finish_voice(kern, mem, thread_id, update, scheduler_lock);
+        }
     }
 
+    // patches to voices outside of the update or processed before their source
+    deliver_products(mem, updates, positions, LAST_DELIVERY);
+
+    updates_storage = std::move(updates);
+    worker_updates_storage = std::move(worker_updates);
+    update_positions_storage = std::move(positions);
+
     while (!operations_pending.empty()) {
         OperationPending &op = operations_pending.front();
 
@@ -0,0 +1,88 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <ngs/dsp.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// The kernels must give exactly the same result as the scalar code they replaced, ngs and its tests are built without FP contraction
+
+static std::vector<float> make_samples(std::size_t count, float amplitude) {
+    // deterministic values covering negative, positive and out of range samples
+    std::vector<float> samples(count);
+    std::uint32_t seed = 0x12345678;
+    for (auto &sample : samples) {
+        seed = seed * 1664525 + 1013904223;
+        sample = (static_cast<float>(seed >> 8) / static_cast<float>(1 << 24) * 2.0f - 1.0f) * amplitude;
+    }
+    return samples;
+}
+
+TEST(ngs_dsp, apply_gain_matches_scalar) {
+    for (std::int32_t count : { 0, 1, 3, 4, 7, 8, 17, 256, 1023 }) {
+        std::vector<float> samples = make_samples(count, 1.5f);
+        std::vector<float> expected = samples;
+        for (auto &sample : expected)
+            sample *= 0.5f;
+
+        ngs::dsp::apply_gain(samples.data(), count, 0.5f);
+        EXPECT_EQ(samples, expected) << "count = " << count;
+    }
+}
+
+TEST(ngs_dsp, mix_stereo_matches_scalar) {
+    const float matrix[2][2] = { { 0.8f, 0.3f }, { -0.25f, 1.1f } };
+
+    for (std::int32_t nb_frames : { 0, 1, 2, 3, 5, 8, 13, 256, 511 }) {
+        const std::vector<float> src = make_samples(nb_frames * 2, 1.2f);
+        std::vector<float> dest = make_samples(nb_frames * 2, 0.9f);
+        std::vector<float> expected = dest;
+        for (std::int32_t k = 0; k < nb_frames; k++) {
+            expected[k * 2] = std::clamp(expected[k * 2] + src[k * 2] * matrix[0][0] + src[k * 2 + 1] * matrix[1][0], -1.0f, 1.0f);
+            expected[k * 2 + 1] = std::clamp(expected[k * 2 + 1] + src[k * 2] * matrix[0][1] + src[k * 2 + 1] * matrix[1][1], -1.0f, 1.0f);
+        }
+
+        ngs::dsp::mix_stereo(dest.data(), src.data(), nb_frames, matrix);
+        EXPECT_EQ(dest, expected) << "nb_frames = " << nb_frames;
+    }
+}
+
+TEST(ngs_dsp, convert_f32_to_s16_matches_scalar) {
+    for (std::int32_t count : { 0, 1, 7, 8, 9, 16, 255, 1024 }) {
+        const std::vector<float> src = make_samples(count, 1.3f);
+        std::vector<std::int16_t> expected(count);
+        for (std::int32_t i = 0; i < count; i++)
+            expected[i] = static_cast<std::int16_t>(std::clamp(src[i] * 32768.0f, -32768.0f, 32767.0f));
+
+        std::vector<std::int16_t> dest(count);
+        ngs::dsp::convert_f32_to_s16(dest.data(), src.data(), count);
+        EXPECT_EQ(dest, expected) << "count = " << count;
+    }
+}
+
+TEST(ngs_dsp, convert_f32_to_s16_saturates) {
+    const float src[8] = { -2.0f, -1.0f, -0.5f, 0.0f, 0.5f, 0.99999f, 1.0f, 2.0f };
+    const std::int16_t expected[8] = { -32768, -32768, -16384, 0, 16384, 32767, 32767, 32767 };
+    std::int16_t dest[8];
+
+    ngs::dsp::convert_f32_to_s16(dest, src, 8);
+    EXPECT_TRUE(std::equal(dest, dest + 8, expected));
+}
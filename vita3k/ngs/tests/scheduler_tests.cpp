@@ -0,0 +1,186 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <kernel/state.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <ngs/dsp.h>
+#include <ngs/system.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+constexpr std::int32_t GRANULARITY = 8;
+constexpr std::uint32_t RACK_MEMSPACE_SIZE = 4096;
+
+struct TestDefinition : ngs::VoiceDefinition {
+    void new_modules(std::vector<std::unique_ptr<ngs::Module>> &mods) override {}
+    std::size_t get_total_buffer_parameter_size() const override { return 0; }
+    std::uint32_t output_count() const override { return 1; }
+};
+
+// Gives the same stereo samples at each update, a value for each voice
+struct SourceModule : ngs::Module {
+    std::unordered_map<const ngs::Voice *, std::vector<float>> samples;
+
+    SourceModule()
+        : Module(ngs::BussType::BUSS_NORMAL_PLAYER) {}
+    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ngs::ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override {
+        data.parent->products[0].data = reinterpret_cast<std::uint8_t *>(const_cast<float *>(samples.at(data.parent).data()));
+        return false;
+    }
+    bool is_thread_safe() const override { return true; }
+    std::size_t get_buffer_parameter_size() const override { return 0; }
+};
+
+// Gives its input as its product
+struct PassthroughModule : ngs::Module {
+    PassthroughModule()
+        : Module(ngs::BussType::BUSS_NORMAL_PLAYER) {}
+    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ngs::ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override {
+        data.parent->products[0].data = data.parent->inputs.inputs[0].data();
+        return false;
+    }
+    bool is_thread_safe() const override { return true; }
+    std::size_t get_buffer_parameter_size() const override { return 0; }
+};
+
+// Keeps its input, processed on the updating thread
+struct SinkModule : ngs::Module {
+    SinkModule()
+        : Module(ngs::BussType::BUSS_MASTER) {}
+    bool process(KernelState &kern, const MemState &mem, const SceUID thread_id, ngs::ModuleData &data, std::unique_lock<std::recursive_mutex> &scheduler_lock, std::unique_lock<std::mutex> &voice_lock) override {
+        return false;
+    }
+    std::size_t get_buffer_parameter_size() const override { return 0; }
+};
+
+struct TestScheduler : ngs::VoiceScheduler {
+    using ngs::VoiceScheduler::prepare_updates;
+};
+
+// A -> X -> D, B -> D and C -> D, in the queue order A, X, B, C, D
+class ngs_scheduler : public ::testing::Test {
+protected:
+    MemState mem;
+    TestDefinition definition;
+    std::unique_ptr<ngs::System> system;
+    std::vector<std::unique_ptr<ngs::Rack>> racks;
+    SourceModule *source_module = nullptr;
+    ngs::Voice a, x, b, c, d;
+
+    ngs::Rack &add_rack(std::unique_ptr<ngs::Module> module) {
+        const Address memspace = alloc(mem, RACK_MEMSPACE_SIZE, "ngs scheduler test");
+        auto &rack = racks.emplace_back(std::make_unique<ngs::Rack>(system.get(), Ptr<void>(memspace), RACK_MEMSPACE_SIZE));
+        rack->vdef = &definition;
+        rack->patches_per_output = 1;
+        rack->modules.push_back(std::move(module));
+        return *rack;
+    }
+
+    static void init_voice(ngs::Voice &voice, ngs::Rack &rack) {
+        voice.init(&rack);
+        voice.datas[0].parent = &voice;
+    }
+
+    void SetUp() override {
+        ASSERT_TRUE(init(mem, WriteTrackerType::MPROTECT));
+        system = std::make_unique<ngs::System>(Ptr<void>(), 0);
+        system->granularity = GRANULARITY;
+
+        auto source = std::make_unique<SourceModule>();
+        source_module = source.get();
+        ngs::Rack &source_rack = add_rack(std::move(source));
+        ngs::Rack &passthrough_rack = add_rack(std::make_unique<PassthroughModule>());
+        ngs::Rack &sink_rack = add_rack(std::make_unique<SinkModule>());
+
+        init_voice(a, source_rack);
+        init_voice(b, source_rack);
+        init_voice(c, source_rack);
+        init_voice(x, passthrough_rack);
+        init_voice(d, sink_rack);
+
+        a.patch(mem, 0, -1, 0, &x);
+        x.patch(mem, 0, -1, 0, &d);
+        b.patch(mem, 0, -1, 0, &d);
+        c.patch(mem, 0, -1, 0, &d);
+        system->voice_scheduler.queue = { &a, &x, &b, &c, &d };
+    }
+};
+
+TEST_F(ngs_scheduler, levels_follow_the_patches) {
+    TestScheduler scheduler;
+    scheduler.queue = system->voice_scheduler.queue;
+    std::vector<ngs::VoiceUpdate> updates;
+    std::unordered_map<ngs::Voice *, std::size_t> positions;
+
+    EXPECT_EQ(scheduler.prepare_updates(mem, updates, positions), 2u);
+    ASSERT_EQ(updates.size(), 5u);
+    const std::uint32_t expected_levels[] = { 0, 1, 0, 0, 2 };
+    for (std::size_t i = 0; i < updates.size(); i++) {
+        EXPECT_EQ(updates[i].voice, scheduler.queue[i]);
+        EXPECT_EQ(updates[i].level, expected_levels[i]) << "voice " << i;
+    }
+}
+
+TEST_F(ngs_scheduler, finished_callbacks_split_the_levels) {
+    // the callback of B runs after A and X are processed and before C and D, like in the serial update
+    b.finished_callback = Ptr<void>(0x81000000);
+
+    TestScheduler scheduler;
+    scheduler.queue = system->voice_scheduler.queue;
+    std::vector<ngs::VoiceUpdate> updates;
+    std::unordered_map<ngs::Voice *, std::size_t> positions;
+
+    EXPECT_EQ(scheduler.prepare_updates(mem, updates, positions), 3u);
+    ASSERT_EQ(updates.size(), 5u);
+    const std::uint32_t expected_levels[] = { 0, 1, 1, 2, 3 };
+    for (std::size_t i = 0; i < updates.size(); i++)
+        EXPECT_EQ(updates[i].level, expected_levels[i]) << "voice " << i;
+}
+
+TEST_F(ngs_scheduler, inputs_are_mixed_in_the_queue_order) {
+    // 0.5 + 2^-25 rounds back to 0.5, the sum depends on the order
+    const float half = 0.5f;
+    const float tiny = 1.0f / (1 << 25);
+    source_module->samples[&a] = std::vector<float>(GRANULARITY * 2, half);
+    source_module->samples[&b] = std::vector<float>(GRANULARITY * 2, tiny);
+    source_module->samples[&c] = std::vector<float>(GRANULARITY * 2, tiny);
+
+    // the serial update delivers X, then B, then C to D
+    const float identity[2][2] = { { 1.0f, 0.0f }, { 0.0f, 1.0f } };
+    std::vector<float> expected(GRANULARITY * 2, 0.0f);
+    for (const ngs::Voice *source : { &a, &b, &c })
+        ngs::dsp::mix_stereo(expected.data(), source_module->samples[source].data(), GRANULARITY, identity);
+
+    // delivering by level would mix B and C before X
+    std::vector<float> by_level(GRANULARITY * 2, 0.0f);
+    for (const ngs::Voice *source : { &b, &c, &a })
+        ngs::dsp::mix_stereo(by_level.data(), source_module->samples[source].data(), GRANULARITY, identity);
+    ASSERT_NE(expected, by_level);
+
+    static KernelState kernel;
+    for (int i = 0; i < 3; i++) {
+        system->voice_scheduler.update(kernel, mem, 0);
+        const float *input = reinterpret_cast<const float *>(d.inputs.inputs[0].data());
+        EXPECT_EQ(std::vector<float>(input, input + GRANULARITY * 2), expected) << "update " << i;
+    }
+}
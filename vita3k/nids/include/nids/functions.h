@@ -20,3 +20,7 @@
 #include <cstdint>
 
 const char *import_name(uint32_t nid);
+
+// Index of a HLE function in nids.inc, import_function_count() if the NID is not a function
+uint32_t import_function_index(uint32_t nid);
+uint32_t import_function_count();
@@ -23,6 +23,15 @@
 #undef NID
 #undef VAR_NID
 
+enum ImportFunctionIndex : uint32_t {
+#define VAR_NID(name, nid)
+#define NID(name, nid) IMPORT_FUNCTION_##name,
+#include <nids/nids.inc>
+#undef NID
+#undef VAR_NID
+    IMPORT_FUNCTION_COUNT
+};
+
 const char *import_name(uint32_t nid) {
     switch (nid) {
 #define VAR_NID(name, nid) \
@@ -38,3 +47,21 @@ const char *import_name(uint32_t nid) {
         return "UNRECOGNISED";
     }
 }
+
+uint32_t import_function_index(uint32_t nid) {
+    switch (nid) {
+#define VAR_NID(name, nid)
+#define NID(name, nid) \
+    case nid:          \
+        return IMPORT_FUNCTION_##name;
+#include <nids/nids.inc>
+#undef NID
+#undef VAR_NID
+    default:
+        return IMPORT_FUNCTION_COUNT;
+    }
+}
+
+uint32_t import_function_count() {
+    return IMPORT_FUNCTION_COUNT;
+}
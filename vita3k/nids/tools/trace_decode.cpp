@@ -0,0 +1,118 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Print a trace written with --trace, with the NIDs symbolized: trace-decode <trace file> [--summary]
+
+#include <nids/functions.h>
+#include <util/trace.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <vector>
+
+struct CallStats {
+    std::uint64_t count = 0;
+    std::uint64_t total_ns = 0;
+    std::uint64_t max_ns = 0;
+};
+
+// same order as ThreadStatus
+static const char *thread_status_name(std::uint32_t status) {
+    static const char *const names[] = { "run", "dormant", "suspend", "wait" };
+    return status < std::size(names) ? names[status] : "unknown";
+}
+
+static void print_event(const trace::Event &event, std::uint64_t duration_ns) {
+    std::printf("%14.6f TID %-4d ", event.timestamp / 1e9, event.thread_id);
+    switch (event.type) {
+    case trace::EventType::HLE_CALL:
+        std::printf("HLE %s (0x%08X) r0=0x%X r1=0x%X r2=0x%X r3=0x%X lr=0x%X\n", import_name(event.id), event.id,
+            event.args[0], event.args[1], event.args[2], event.args[3], event.args[4]);
+        break;
+    case trace::EventType::HLE_RETURN:
+        std::printf("RET %s -> 0x%X (%" PRIu64 " us)\n", import_name(event.id), event.args[0], duration_ns / 1000);
+        break;
+    case trace::EventType::LLE_CALL:
+        std::printf("LLE %s (0x%08X) at 0x%X\n", import_name(event.id), event.id, event.args[0]);
+        break;
+    case trace::EventType::THREAD_STATUS:
+        std::printf("STATUS %s -> %s\n", thread_status_name(event.args[0]), thread_status_name(event.id));
+        break;
+    default:
+        std::printf("unknown event %d\n", static_cast<int>(event.type));
+        break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <trace file> [--summary]\n", argv[0]);
+        return 1;
+    }
+    const bool summary = (argc > 2) && (std::strcmp(argv[2], "--summary") == 0);
+
+    trace::FileHeader header;
+    std::vector<trace::Event> events;
+    if (!trace::read_file(argv[1], header, events))
+        return 1;
+
+    // the threads write their events to the file by batches
+    std::stable_sort(events.begin(), events.end(), [](const trace::Event &a, const trace::Event &b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    // start time of the HLE calls in progress on each thread, callbacks can nest them
+    std::map<std::int32_t, std::vector<std::uint64_t>> call_starts;
+    std::map<std::uint32_t, CallStats> stats;
+    for (const trace::Event &event : events) {
+        std::uint64_t duration_ns = 0;
+        if (event.type == trace::EventType::HLE_CALL) {
+            call_starts[event.thread_id].push_back(event.timestamp);
+        } else if (event.type == trace::EventType::HLE_RETURN) {
+            auto &starts = call_starts[event.thread_id];
+            if (!starts.empty()) {
+                duration_ns = event.timestamp - starts.back();
+                starts.pop_back();
+            }
+            CallStats &call = stats[event.id];
+            call.count++;
+            call.total_ns += duration_ns;
+            call.max_ns = std::max(call.max_ns, duration_ns);
+        }
+
+        if (!summary)
+            print_event(event, duration_ns);
+    }
+
+    if (summary) {
+        std::vector<std::pair<std::uint32_t, CallStats>> sorted(stats.begin(), stats.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+            return a.second.total_ns > b.second.total_ns;
+        });
+
+        std::printf("%-48s %10s %12s %12s\n", "function", "calls", "total (ms)", "max (us)");
+        for (const auto &[nid, call] : sorted)
+            std::printf("%-48s %10" PRIu64 " %12.3f %12" PRIu64 "\n", import_name(nid), call.count, call.total_ns / 1e6, call.max_ns / 1000);
+    }
+
+    std::printf("%zu events\n", events.size());
+    return 0;
+}
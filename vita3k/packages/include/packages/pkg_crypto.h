@@ -0,0 +1,36 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+/**
+ * @file pkg_crypto.h
+ * @brief Decryption of the `.pkg` contents, shared by the installer and vita3k-bench
+ */
+
+#pragma once
+
+#include <crypto/aes.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Size of the parts of a buffer decrypted in parallel, a multiple of the AES block size
+constexpr uint64_t PKG_DECRYPT_SLICE_SIZE = 256 * 1024;
+
+// XOR the data with the AES-128 CTR key stream starting at the given block, iv being the counter of block 0
+void aes128_ctr_xor(aes_context *ctx, const uint8_t *iv, uint64_t block, uint8_t *data, size_t size);
+
+// Same as aes128_ctr_xor from a byte offset multiple of the block size, large buffers are split into slices decrypted in parallel
+void aes128_ctr_xor_parallel(aes_context *ctx, const uint8_t *iv, uint64_t offset, uint8_t *data, uint64_t size);
@@ -658,7 +658,12 @@ public:
 void register_keys(KeyStore &SCE_KEYS, int type);
 void extract_fat(const std::wstring &partition_path, const std::string &partition, const std::wstring &pref_path);
 std::string decompress_segments(const std::vector<uint8_t> &decrypted_data, const uint64_t &size);
+bool self2elf(const std::vector<uint8_t> &self, std::vector<uint8_t> &elf, KeyStore &SCE_KEYS, unsigned char *klictxt);
 void self2elf(const std::string &infile, const std::string &outfile, KeyStore &SCE_KEYS, unsigned char *klictxt);
+std::vector<uint8_t> make_fself(const std::vector<uint8_t> &elf);
 void make_fself(const std::string &input_file, const std::string &output_file);
+// Decrypt a SELF and replace it by an unencrypted fake SELF, the conversion is done in memory
+bool self2fself(const fs::path &path, KeyStore &SCE_KEYS, unsigned char *klictxt);
 std::tuple<uint64_t, SelfType> get_key_type(std::ifstream &file, const SceHeader &sce_hdr);
+std::vector<SceSegment> get_segments(const std::vector<uint8_t> &self, const SceHeader &sce_hdr, KeyStore &SCE_KEYS, uint64_t sysver = -1, SelfType self_type = static_cast<SelfType>(0), int keytype = 0, unsigned char *klictxt = 0);
 std::vector<SceSegment> get_segments(std::ifstream &file, const SceHeader &sce_hdr, KeyStore &SCE_KEYS, uint64_t sysver = -1, SelfType self_type = static_cast<SelfType>(0), int keytype = 0, unsigned char *klictxt = 0);
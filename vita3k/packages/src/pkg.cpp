@@ -33,6 +33,7 @@
 #include <emuenv/state.h>
 #include <packages/functions.h>
 #include <packages/pkg.h>
+#include <packages/pkg_crypto.h>
 #include <packages/sce_types.h>
 #include <packages/sfo.h>
 
@@ -40,39 +41,86 @@
 #include <util/log.h>
 #include <util/string_utils.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
+
 // Credits to mmozeiko https://github.com/mmozeiko/pkg2zip
 
-static void ctr_add(uint8_t *counter, uint64_t n) {
-    for (int i = 15; i >= 0; i--) {
-        n = n + counter[i];
-        counter[i] = (uint8_t)n;
-        n >>= 8;
+// Size of the reads done while extracting, the next chunk is read while the current one is decrypted and written
+static constexpr uint64_t PKG_CHUNK_SIZE = 8 * 1024 * 1024;
+
+/**
+ * \brief Decrypt the data of a pkg file entry into outfile.
+ *
+ * The entry is read in large chunks, the next chunk is read while the current one is decrypted and written.
+ */
+static bool extract_pkg_file(fs::ifstream &infile, const uint64_t data_offset, aes_context *ctx, const uint8_t *iv, uint64_t offset, uint64_t size,
+    std::ofstream &outfile, std::array<std::vector<uint8_t>, 2> &buffers, const std::function<void(uint64_t)> &on_chunk_written) {
+    const auto read_chunk = [&infile, data_offset](std::vector<uint8_t> &buffer, uint64_t chunk_offset, uint64_t chunk_size) {
+        infile.seekg(data_offset + chunk_offset);
+        return static_cast<bool>(infile.read(reinterpret_cast<char *>(buffer.data()), chunk_size));
+    };
+
+    std::size_t current = 0;
+    uint64_t chunk_size = std::min(size, PKG_CHUNK_SIZE);
+    if (!read_chunk(buffers[current], offset, chunk_size))
+        return false;
+
+    while (chunk_size != 0) {
+        const uint64_t next_offset = offset + chunk_size;
+        const uint64_t next_size = std::min(size - chunk_size, PKG_CHUNK_SIZE);
+        std::future<bool> next_read;
+        if (next_size != 0)
+            next_read = std::async(std::launch::async, read_chunk, std::ref(buffers[current ^ 1]), next_offset, next_size);
+
+        aes128_ctr_xor_parallel(ctx, iv, offset, buffers[current].data(), chunk_size);
+        outfile.write(reinterpret_cast<const char *>(buffers[current].data()), chunk_size);
+        on_chunk_written(chunk_size);
+
+        if ((next_read.valid() && !next_read.get()) || !outfile)
+            return false;
+
+        size -= chunk_size;
+        offset = next_offset;
+        chunk_size = next_size;
+        current ^= 1;
     }
+
+    return true;
 }
 
-static void aes128_ctr_xor(aes_context *ctx, const uint8_t *iv, uint64_t block, uint8_t *input, size_t size) {
-    uint8_t tmp[16];
-    uint8_t counter[16];
-    for (uint32_t i = 0; i < 16; i++) {
-        counter[i] = iv[i];
-    }
-    ctr_add(counter, block);
+static void log_install_stage(const char *stage, uint64_t bytes, std::chrono::steady_clock::time_point start) {
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double mib = bytes / (1024.0 * 1024.0);
+    LOG_INFO("{}: {:.1f} MiB in {:.2f}s ({:.1f} MiB/s)", stage, mib, seconds, seconds > 0 ? mib / seconds : 0.0);
+}
 
-    while (size >= 16) {
-        aes_crypt_ecb(ctx, AES_ENCRYPT, counter, tmp);
-        for (uint32_t i = 0; i < 16; i++) {
-            *input++ ^= tmp[i];
-        }
-        ctr_add(counter, 1);
-        size -= 16;
+static bool is_self_file(const fs::path &path) {
+    return (path.extension() == ".suprx") || (path.extension() == ".self") || (path.filename() == "eboot.bin");
+}
+
+// Convert every SELF of the title to a decrypted fake SELF, each one is converted in memory and written once
+static void decrypt_title_selfs(const std::string &title_path, KeyStore &SCE_KEYS, std::vector<uint8_t> &klicensee, const std::function<void(float)> &on_progress) {
+    std::vector<fs::path> selfs;
+    for (const auto &file : fs::recursive_directory_iterator(title_path)) {
+        if (is_self_file(file.path()))
+            selfs.push_back(file.path());
     }
 
-    if (size != 0) {
-        aes_crypt_ecb(ctx, AES_ENCRYPT, counter, tmp);
-        for (size_t i = 0; i < size; i++) {
-            *input++ ^= tmp[i];
-        }
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t converted_bytes = 0;
+    for (std::size_t i = 0; i < selfs.size(); i++) {
+        converted_bytes += fs::file_size(selfs[i]);
+        if (self2fself(selfs[i], SCE_KEYS, klicensee.data()))
+            LOG_INFO("Decrypted {} with klicensee {}", selfs[i].string(), byte_array_to_string(klicensee.data(), 16));
+        else
+            LOG_ERROR("Failed to decrypt {}", selfs[i].string());
+        if (on_progress)
+            on_progress(static_cast<float>(i + 1) / selfs.size());
     }
+    log_install_stage("SELF decryption", converted_bytes, start);
 }
 
 bool decrypt_install_nonpdrm(EmuEnvState &emuenv, std::string &drmlicpath, const std::string &title_path) {
@@ -96,15 +144,7 @@ bool decrypt_install_nonpdrm(EmuEnvState &emuenv, std::string &drmlicpath, const
     register_keys(SCE_KEYS, 1);
     std::vector<uint8_t> temp_klicensee = get_temp_klicensee(zRIF);
 
-    for (const auto &file : fs::recursive_directory_iterator(title_id_src)) {
-        if ((file.path().extension() == ".suprx") || (file.path().extension() == ".self") || (file.path().filename() == "eboot.bin")) {
-            self2elf(file.path().string(), file.path().string() + "elf", SCE_KEYS, temp_klicensee.data());
-            fs::rename(file.path().string() + "elf", file.path().string());
-            make_fself(file.path().string(), file.path().string() + "fself");
-            fs::rename(file.path().string() + "fself", file.path().string());
-            LOG_INFO("Decrypted {} with klicensee {}", file.path().string(), byte_array_to_string(temp_klicensee.data(), 16));
-        }
-    }
+    decrypt_title_selfs(title_id_src, SCE_KEYS, temp_klicensee, nullptr);
 
     return true;
 }
@@ -125,12 +165,13 @@ bool install_pkg(const std::string &pkg, EmuEnvState &emuenv, std::string &p_zRI
         return false;
     }
 
-    if (fs::file_size(pkg_path) < byte_swap(pkg_header.total_size)) {
+    const uint64_t pkg_size = fs::file_size(pkg_path);
+    if (pkg_size < byte_swap(pkg_header.total_size)) {
         LOG_ERROR("The pkg file is too small");
         return false;
     }
 
-    if (fs::file_size(pkg_path) < byte_swap(pkg_header.data_offset) + byte_swap(pkg_header.file_count) * 32) {
+    if (pkg_size < byte_swap(pkg_header.data_offset) + byte_swap(pkg_header.file_count) * 32) {
         LOG_ERROR("The pkg file is too small");
         return false;
     }
@@ -250,21 +291,32 @@ bool install_pkg(const std::string &pkg, EmuEnvState &emuenv, std::string &p_zRI
         break;
     }
 
+    const uint64_t data_offset = byte_swap(pkg_header.data_offset);
+    const uint64_t total_data_size = std::max<uint64_t>(byte_swap(pkg_header.data_size), 1);
+    std::array<std::vector<uint8_t>, 2> buffers;
+    for (auto &buffer : buffers)
+        buffer.resize(PKG_CHUNK_SIZE);
+
+    const auto extract_start = std::chrono::steady_clock::now();
+    uint64_t extracted_bytes = 0;
+    const auto on_chunk_written = [&](uint64_t size) {
+        extracted_bytes += size;
+        progress_callback(std::min(extracted_bytes, total_data_size) * 60.f / total_data_size);
+    };
+
     for (uint32_t i = 0; i < byte_swap(pkg_header.file_count); i++) {
         PkgEntry entry;
         uint64_t file_offset = items_offset + i * 32;
-        infile.seekg(byte_swap(pkg_header.data_offset) + file_offset, std::ios_base::beg);
+        infile.seekg(data_offset + file_offset, std::ios_base::beg);
         infile.read(reinterpret_cast<char *>(&entry), sizeof(PkgEntry));
         aes128_ctr_xor(&aes_ctx, pkg_header.pkg_data_iv, file_offset / 16, reinterpret_cast<unsigned char *>(&entry), sizeof(PkgEntry));
 
-        if (fs::file_size(pkg_path) < byte_swap(pkg_header.data_offset) + byte_swap(entry.name_offset) + byte_swap(entry.name_size) || fs::file_size(pkg_path) < byte_swap(pkg_header.data_offset) + byte_swap(entry.data_offset) + byte_swap(entry.data_size)) {
+        if (pkg_size < data_offset + byte_swap(entry.name_offset) + byte_swap(entry.name_size) || pkg_size < data_offset + byte_swap(entry.data_offset) + byte_swap(entry.data_size)) {
             LOG_ERROR("The pkg file size is too small, possibly corrupted");
             return false;
         }
-        const auto file_count = (float)byte_swap(pkg_header.file_count);
-        progress_callback(i / file_count * 100.f * 0.6f);
         std::vector<unsigned char> name(byte_swap(entry.name_size));
-        infile.seekg(byte_swap(pkg_header.data_offset) + byte_swap(entry.name_offset));
+        infile.seekg(data_offset + byte_swap(entry.name_offset));
         infile.read((char *)&name[0], byte_swap(entry.name_size));
         aes128_ctr_xor(&aes_ctx, pkg_header.pkg_data_iv, byte_swap(entry.name_offset) / 16, &name[0], byte_swap(entry.name_size));
 
@@ -275,25 +327,14 @@ bool install_pkg(const std::string &pkg, EmuEnvState &emuenv, std::string &p_zRI
             fs::create_directories(path.string() + "/" + string_name);
         } else { // File
             std::ofstream outfile(path.string() + "/" + string_name, std::ios::binary);
-
-            auto offset = byte_swap(entry.data_offset);
-            auto data_size = byte_swap(entry.data_size);
-            while (data_size != 0) {
-                unsigned char buffer[0x10000];
-                auto size = data_size < sizeof(buffer) ? data_size : sizeof(buffer);
-                infile.seekg(byte_swap(pkg_header.data_offset) + offset);
-                infile.read((char *)buffer, size);
-
-                aes128_ctr_xor(&aes_ctx, pkg_header.pkg_data_iv, offset / 16, buffer, size);
-
-                outfile.write((char *)buffer, size);
-                offset += size;
-                data_size -= size;
+            if (!extract_pkg_file(infile, data_offset, &aes_ctx, pkg_header.pkg_data_iv, byte_swap(entry.data_offset), byte_swap(entry.data_size), outfile, buffers, on_chunk_written)) {
+                LOG_ERROR("Failed to extract {}", string_name);
+                return false;
             }
-            outfile.close();
         }
     }
     infile.close();
+    log_install_stage("Pkg extraction", extracted_bytes, extract_start);
 
     std::string title_id_src = path.string();
     std::string title_id_dst = path.string() + "_dec";
@@ -305,7 +346,8 @@ bool install_pkg(const std::string &pkg, EmuEnvState &emuenv, std::string &p_zRI
     register_keys(SCE_KEYS, 1);
     std::vector<uint8_t> temp_klicensee = get_temp_klicensee(zRIF);
 
-    progress_callback(80);
+    progress_callback(60);
+    const auto pfs_start = std::chrono::steady_clock::now();
     switch (type) {
     case PkgType::PKG_TYPE_VITA_APP:
     case PkgType::PKG_TYPE_VITA_PATCH:
@@ -315,16 +357,12 @@ bool install_pkg(const std::string &pkg, EmuEnvState &emuenv, std::string &p_zRI
         }
         fs::remove_all(fs::path(title_id_src));
         fs::rename(fs::path(title_id_dst), fs::path(title_id_src));
+        log_install_stage("PFS decryption", extracted_bytes, pfs_start);
+        progress_callback(80);
 
-        for (const auto &file : fs::recursive_directory_iterator(title_id_src)) {
-            if (file.path().extension() == ".suprx" || file.path().extension() == ".self" || file.path().filename() == "eboot.bin") {
-                self2elf(file.path().string(), file.path().string() + "elf", SCE_KEYS, temp_klicensee.data());
-                fs::rename(file.path().string() + "elf", file.path().string());
-                make_fself(file.path().string(), file.path().string() + "fself");
-                fs::rename(file.path().string() + "fself", file.path().string());
-                LOG_INFO("Decrypted {} with klicensee {}", file.path().string(), byte_array_to_string(temp_klicensee.data(), 16));
-            }
-        }
+        decrypt_title_selfs(title_id_src, SCE_KEYS, temp_klicensee, [&](float progress) {
+            progress_callback(80 + progress * 15.f);
+        });
         break;
     case PkgType::PKG_TYPE_VITA_DLC:
 
@@ -333,6 +371,7 @@ bool install_pkg(const std::string &pkg, EmuEnvState &emuenv, std::string &p_zRI
         } else {
             fs::remove_all(fs::path(title_id_src));
             fs::rename(fs::path(title_id_dst), fs::path(title_id_src));
+            log_install_stage("PFS decryption", extracted_bytes, pfs_start);
             return true;
         }
         break;
@@ -343,12 +382,18 @@ bool install_pkg(const std::string &pkg, EmuEnvState &emuenv, std::string &p_zRI
         execute(zRIF, title_id_src, title_id_dst, f00d_enc_type, f00d_arg);
         fs::remove_all(fs::path(title_id_src));
         fs::rename(fs::path(title_id_dst), fs::path(title_id_src));
+        log_install_stage("PFS decryption", extracted_bytes, pfs_start);
         return true;
         break;
     }
 
+    progress_callback(95);
+    const auto copy_start = std::chrono::steady_clock::now();
     if (!copy_path(title_id_src, emuenv.pref_path, emuenv.app_info.app_title_id, emuenv.app_info.app_category))
         return false;
+    log_install_stage("Copy", extracted_bytes, copy_start);
+
+    index_installed_content(emuenv.io, emuenv.pref_path, emuenv.app_info.app_title_id, emuenv.app_info.app_category);
 
     create_license(emuenv, zRIF);
     progress_callback(100);
@@ -0,0 +1,51 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+#include <packages/pkg_crypto.h>
+
+#include <util/worker_pool.h>
+
+#include <algorithm>
+#include <cstring>
+
+// Credits to mmozeiko https://github.com/mmozeiko/pkg2zip
+
+static void ctr_add(uint8_t *counter, uint64_t n) {
+    for (int i = 15; i >= 0; i--) {
+        n = n + counter[i];
+        counter[i] = (uint8_t)n;
+        n >>= 8;
+    }
+}
+
+void aes128_ctr_xor(aes_context *ctx, const uint8_t *iv, uint64_t block, uint8_t *data, size_t size) {
+    uint8_t counter[16];
+    uint8_t stream_block[16];
+    size_t nc_off = 0;
+    memcpy(counter, iv, sizeof(counter));
+    ctr_add(counter, block);
+
+    aes_crypt_ctr(ctx, size, &nc_off, counter, stream_block, data, data);
+}
+
+// CTR mode can start at any block, so the slices are independent
+void aes128_ctr_xor_parallel(aes_context *ctx, const uint8_t *iv, uint64_t offset, uint8_t *data, uint64_t size) {
+    const std::size_t slice_count = (size + PKG_DECRYPT_SLICE_SIZE - 1) / PKG_DECRYPT_SLICE_SIZE;
+    util::parallel_for(slice_count, [&](std::size_t i) {
+        const uint64_t start = i * PKG_DECRYPT_SLICE_SIZE;
+        aes128_ctr_xor(ctx, iv, (offset + start) / 16, data + start, std::min(size - start, PKG_DECRYPT_SLICE_SIZE));
+    });
+}
@@ -722,85 +722,80 @@ std::string decompress_segments(const std::vector<uint8_t> &decrypted_data, cons
     return decompressed_data;
 }
 
-void self2elf(const std::string &infile, const std::string &outfile, KeyStore &SCE_KEYS, unsigned char *klictxt) {
-    std::ifstream filein(infile, std::ios::binary);
-    std::ofstream fileout(outfile, std::ios::binary);
-
-    int npdrmtype = 0;
-
-    char sceheaderbuffer[SceHeader::Size];
-    char selfheaderbuffer[SelfHeader::Size];
-    char appinfobuffer[AppInfoHeader::Size];
-    char verinfobuffer[SceVersionInfo::Size];
-    char controlinfobuffer[SceControlInfo::Size];
+static bool read_binary_file(const fs::path &path, std::vector<uint8_t> &data) {
+    fs::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    data.resize(file.tellg());
+    file.seekg(0);
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(data.data()), data.size()));
+}
 
-    filein.read(sceheaderbuffer, SceHeader::Size);
-    filein.read(selfheaderbuffer, SelfHeader::Size);
+static bool write_binary_file(const fs::path &path, const std::vector<uint8_t> &data) {
+    fs::ofstream file(path, std::ios::binary | std::ios::trunc);
+    return static_cast<bool>(file.write(reinterpret_cast<const char *>(data.data()), data.size()));
+}
 
-    const SceHeader sce_hdr = SceHeader(sceheaderbuffer);
-    const SelfHeader self_hdr = SelfHeader(selfheaderbuffer);
+bool self2elf(const std::vector<uint8_t> &self, std::vector<uint8_t> &elf, KeyStore &SCE_KEYS, unsigned char *klictxt) {
+    const auto in_bounds = [&](uint64_t offset, uint64_t size) {
+        return (offset <= self.size()) && (size <= self.size() - offset);
+    };
+    const char *const data = reinterpret_cast<const char *>(self.data());
 
-    filein.seekg(self_hdr.appinfo_offset);
-    filein.read(appinfobuffer, AppInfoHeader::Size);
+    elf.clear();
+    if (!in_bounds(0, SceHeader::Size + SelfHeader::Size)) {
+        LOG_ERROR("SELF file is too small");
+        return false;
+    }
 
-    const AppInfoHeader appinfo_hdr = AppInfoHeader(appinfobuffer);
+    int npdrmtype = 0;
 
-    filein.seekg(self_hdr.sceversion_offset);
-    filein.read(verinfobuffer, SceVersionInfo::Size);
+    const SceHeader sce_hdr = SceHeader(data);
+    const SelfHeader self_hdr = SelfHeader(data + SceHeader::Size);
 
-    const SceVersionInfo verinfo_hdr = SceVersionInfo(verinfobuffer);
+    if (!in_bounds(self_hdr.appinfo_offset, AppInfoHeader::Size) || !in_bounds(self_hdr.controlinfo_offset, SceControlInfo::Size * 2 + SceControlInfoDigest256::Size + SceControlInfoDRM::Size)) {
+        LOG_ERROR("SELF headers are out of bounds");
+        return false;
+    }
 
-    filein.seekg(self_hdr.controlinfo_offset);
-    filein.read(controlinfobuffer, SceControlInfo::Size);
+    const AppInfoHeader appinfo_hdr = AppInfoHeader(data + self_hdr.appinfo_offset);
 
-    SceControlInfo controlinfo_hdr = SceControlInfo(controlinfobuffer);
+    SceControlInfo controlinfo_hdr = SceControlInfo(data + self_hdr.controlinfo_offset);
     auto ci_off = SceControlInfo::Size;
 
-    if (controlinfo_hdr.type == ControlType::DIGEST_SHA256) {
-        filein.seekg(self_hdr.controlinfo_offset + ci_off);
+    if (controlinfo_hdr.type == ControlType::DIGEST_SHA256)
         ci_off += SceControlInfoDigest256::Size;
-        char controldigest256buffer[SceControlInfoDigest256::Size];
-        filein.read(controldigest256buffer, SceControlInfoDigest256::Size);
-        const SceControlInfoDigest256 controldigest256 = SceControlInfoDigest256(controldigest256buffer);
-    }
-    filein.seekg(self_hdr.controlinfo_offset + ci_off);
-    filein.read(controlinfobuffer, SceControlInfo::Size);
-    controlinfo_hdr = SceControlInfo(controlinfobuffer);
+    controlinfo_hdr = SceControlInfo(data + self_hdr.controlinfo_offset + ci_off);
     ci_off += SceControlInfo::Size;
 
     if (controlinfo_hdr.type == ControlType::NPDRM_VITA) {
-        filein.seekg(self_hdr.controlinfo_offset + ci_off);
-        ci_off += SceControlInfoDRM::Size;
-        char controlnpdrmbuffer[SceControlInfoDRM::Size];
-        filein.read(controlnpdrmbuffer, SceControlInfoDRM::Size);
-        const SceControlInfoDRM controlnpdrm = SceControlInfoDRM(controlnpdrmbuffer);
+        const SceControlInfoDRM controlnpdrm = SceControlInfoDRM(data + self_hdr.controlinfo_offset + ci_off);
         npdrmtype = controlnpdrm.npdrm_type;
     }
 
-    filein.seekg(self_hdr.elf_offset);
-    char dat[ElfHeader::Size];
-    filein.read(dat, ElfHeader::Size);
-    fileout.write(dat, ElfHeader::Size);
+    if (!in_bounds(self_hdr.elf_offset, ElfHeader::Size)) {
+        LOG_ERROR("SELF ELF header is out of bounds");
+        return false;
+    }
+
+    const ElfHeader elf_hdr = ElfHeader(data + self_hdr.elf_offset);
+    elf.insert(elf.end(), self.begin() + self_hdr.elf_offset, self.begin() + self_hdr.elf_offset + ElfHeader::Size);
+
+    if (!in_bounds(self_hdr.phdr_offset, uint64_t(elf_hdr.e_phnum) * ElfPhdr::Size) || !in_bounds(self_hdr.segment_info_offset, uint64_t(elf_hdr.e_phnum) * SegmentInfo::Size)) {
+        LOG_ERROR("SELF program headers are out of bounds");
+        return false;
+    }
 
-    const ElfHeader elf_hdr = ElfHeader(dat);
     std::vector<ElfPhdr> elf_phdrs;
     std::vector<SegmentInfo> segment_infos;
     bool encrypted = false;
-    uint64_t at = ElfHeader::Size;
 
     for (uint16_t i = 0; i < elf_hdr.e_phnum; i++) {
-        filein.seekg(self_hdr.phdr_offset + i * ElfPhdr::Size);
-        char dat[ElfPhdr::Size];
-        filein.read(dat, ElfPhdr::Size);
-        const ElfPhdr phdr = ElfPhdr(dat);
-        elf_phdrs.push_back(phdr);
-        fileout.write(dat, ElfPhdr::Size);
-        at += ElfPhdr::Size;
-
-        filein.seekg(self_hdr.segment_info_offset + i * SegmentInfo::Size);
-        char segmentinfobuffer[SegmentInfo::Size];
-        filein.read(segmentinfobuffer, SegmentInfo::Size);
-        const SegmentInfo segment_info = SegmentInfo(segmentinfobuffer);
+        const auto phdr_offset = self_hdr.phdr_offset + i * ElfPhdr::Size;
+        elf_phdrs.emplace_back(data + phdr_offset);
+        elf.insert(elf.end(), self.begin() + phdr_offset, self.begin() + phdr_offset + ElfPhdr::Size);
+
+        const SegmentInfo segment_info = SegmentInfo(data + self_hdr.segment_info_offset + i * SegmentInfo::Size);
         segment_infos.push_back(segment_info);
 
         if (segment_info.plaintext == SecureBool::NO)
@@ -810,7 +805,11 @@ void self2elf(const std::string &infile, const std::string &outfile, KeyStore &S
     std::vector<SceSegment> scesegs;
 
     if (encrypted) {
-        scesegs = get_segments(filein, sce_hdr, SCE_KEYS, appinfo_hdr.sys_version, appinfo_hdr.self_type, npdrmtype, klictxt);
+        scesegs = get_segments(self, sce_hdr, SCE_KEYS, appinfo_hdr.sys_version, appinfo_hdr.self_type, npdrmtype, klictxt);
+        if (scesegs.size() < elf_hdr.e_phnum) {
+            LOG_ERROR("SELF metadata is missing segments");
+            return false;
+        }
     }
 
     for (uint16_t i = 0; i < elf_hdr.e_phnum; i++) {
@@ -823,59 +822,64 @@ void self2elf(const std::string &infile, const std::string &outfile, KeyStore &S
         if (elf_phdrs[idx].p_filesz == 0)
             continue;
 
-        const int pad_len = elf_phdrs[idx].p_offset - at;
-        if (pad_len < 0)
+        if (elf_phdrs[idx].p_offset < elf.size())
             LOG_ERROR("ELF p_offset Invalid");
+        else
+            elf.resize(elf_phdrs[idx].p_offset);
 
-        std::vector<char> padding;
-        for (int i = 0; i < pad_len; i++) {
-            padding.push_back('\0');
+        const SegmentInfo &segment_info = segment_infos[idx];
+        if (!in_bounds(segment_info.offset, segment_info.size)) {
+            LOG_ERROR("SELF segment {} is out of bounds", idx);
+            return false;
         }
 
-        fileout.write(padding.data(), pad_len);
-
-        at += pad_len;
-
-        filein.seekg(segment_infos[idx].offset);
-        std::vector<unsigned char> dat(segment_infos[idx].size);
-        filein.read((char *)&dat[0], segment_infos[idx].size);
-
-        std::vector<unsigned char> decrypted_data(segment_infos[idx].size);
-        if (segment_infos[idx].plaintext == SecureBool::NO) {
+        std::vector<uint8_t> decrypted_data(self.begin() + segment_info.offset, self.begin() + segment_info.offset + segment_info.size);
+        if (segment_info.plaintext == SecureBool::NO) {
             aes_context aes_ctx;
-            aes_setkey_enc(&aes_ctx, (unsigned char *)scesegs[i].key.c_str(), 128);
+            aes_setkey_enc(&aes_ctx, reinterpret_cast<const unsigned char *>(scesegs[i].key.c_str()), 128);
             size_t ctr_nc_off = 0;
+            unsigned char ctr_nonce[0x10];
             unsigned char ctr_stream_block[0x10];
-            aes_crypt_ctr(&aes_ctx, segment_infos[idx].size, &ctr_nc_off, (unsigned char *)scesegs[i].iv.c_str(), ctr_stream_block, &dat[0], &decrypted_data[0]);
+            memcpy(ctr_nonce, scesegs[i].iv.c_str(), sizeof(ctr_nonce));
+            aes_crypt_ctr(&aes_ctx, decrypted_data.size(), &ctr_nc_off, ctr_nonce, ctr_stream_block, decrypted_data.data(), decrypted_data.data());
         }
 
-        if (segment_infos[idx].compressed == SecureBool::YES) {
-            const std::string decompressed_data = decompress_segments(decrypted_data, segment_infos[idx].size);
-            segment_infos[idx].compressed = SecureBool::NO;
-            fileout.write(decompressed_data.c_str(), decompressed_data.length());
-            at += decompressed_data.length();
+        if (segment_info.compressed == SecureBool::YES) {
+            const std::string decompressed_data = decompress_segments(decrypted_data, segment_info.size);
+            elf.insert(elf.end(), decompressed_data.begin(), decompressed_data.end());
         } else {
-            fileout.write((char *)&decrypted_data[0], segment_infos[idx].size);
-            at += segment_infos[idx].size;
+            elf.insert(elf.end(), decrypted_data.begin(), decrypted_data.end());
         }
     }
-    filein.close();
-    fileout.close();
+
+    return true;
 }
 
-// Credits to the vitasdk team/contributors for vita-make-fself https://github.com/vitasdk/vita-toolchain/blob/master/src/vita-make-fself.c
+void self2elf(const std::string &infile, const std::string &outfile, KeyStore &SCE_KEYS, unsigned char *klictxt) {
+    std::vector<uint8_t> self;
+    std::vector<uint8_t> elf;
+    if (!read_binary_file(fs::path(infile), self))
+        LOG_ERROR("Failed to read {}", infile);
+    self2elf(self, elf, SCE_KEYS, klictxt);
+    write_binary_file(fs::path(outfile), elf);
+}
 
-void make_fself(const std::string &input_file, const std::string &output_file) {
-    std::ifstream filein(input_file, std::ios::binary);
-    std::ofstream fileout(output_file, std::ios::binary);
+// Credits to the vitasdk team/contributors for vita-make-fself https://github.com/vitasdk/vita-toolchain/blob/master/src/vita-make-fself.c
 
-    uint64_t file_size = fs::file_size(input_file);
+std::vector<uint8_t> make_fself(const std::vector<uint8_t> &elf) {
+    const uint64_t file_size = elf.size();
+    if (file_size < ElfHeader::Size) {
+        LOG_ERROR("ELF file is too small");
+        return {};
+    }
 
-    std::vector<char> input(file_size);
-    filein.read(&input[0], file_size);
-    filein.close();
+    const char *const input = reinterpret_cast<const char *>(elf.data());
+    ElfHeader ehdr = ElfHeader(input);
 
-    ElfHeader ehdr = ElfHeader(&input[0]);
+    if (ehdr.e_phoff + uint64_t(ehdr.e_phentsize) * ehdr.e_phnum > file_size) {
+        LOG_ERROR("ELF program headers are out of bounds");
+        return {};
+    }
 
     SCE_header hdr = { 0 };
     hdr.magic = SCE_MAGIC;
@@ -937,55 +941,78 @@ void make_fself(const std::string &input_file, const std::string &output_file) {
     myhdr.e_phentsize = 0x20;
     myhdr.e_phnum = ehdr.e_phnum;
 
-    fileout.seekp(hdr.appinfo_offset, std::ios_base::beg);
-    fileout.write((char *)&appinfo, sizeof(appinfo));
+    // the headers all fit before the ELF copy, the gaps are zero filled
+    std::vector<uint8_t> fself(offset_to_real_elf + file_size);
+    const auto put = [&](uint64_t offset, const void *src, size_t size) {
+        if (fself.size() < offset + size)
+            fself.resize(offset + size);
+        memcpy(&fself[offset], src, size);
+    };
 
-    fileout.seekp(hdr.elf_offset, std::ios_base::beg);
-    fileout.write((char *)&myhdr, ElfHeader::Size);
+    put(hdr.appinfo_offset, &appinfo, sizeof(appinfo));
+    put(hdr.elf_offset, &myhdr, ElfHeader::Size);
 
-    fileout.seekp(hdr.phdr_offset, std::ios_base::beg);
     for (int i = 0; i < ehdr.e_phnum; ++i) {
-        ElfPhdr phdr = ElfPhdr(&input[0] + ehdr.e_phoff + ehdr.e_phentsize * i);
+        ElfPhdr phdr = ElfPhdr(input + ehdr.e_phoff + ehdr.e_phentsize * i);
         if (phdr.p_align > 0x1000)
             phdr.p_align = 0x1000;
-        fileout.write((char *)&phdr, sizeof(phdr));
+        put(hdr.phdr_offset + i * sizeof(phdr), &phdr, sizeof(phdr));
     }
 
-    fileout.seekp(hdr.section_info_offset, std::ios_base::beg);
     for (int i = 0; i < ehdr.e_phnum; ++i) {
-        ElfPhdr phdr = ElfPhdr(&input[0] + ehdr.e_phoff + ehdr.e_phentsize * i);
+        ElfPhdr phdr = ElfPhdr(input + ehdr.e_phoff + ehdr.e_phentsize * i);
         segment_info segment_info = { 0 };
         segment_info.offset = offset_to_real_elf + phdr.p_offset;
         segment_info.length = phdr.p_filesz;
         segment_info.compression = 1;
         segment_info.encryption = 2;
-        fileout.write((char *)&segment_info, sizeof(segment_info));
+        put(hdr.section_info_offset + i * sizeof(segment_info), &segment_info, sizeof(segment_info));
     }
 
-    fileout.seekp(hdr.sceversion_offset, std::ios_base::beg);
-    fileout.write((char *)&ver, sizeof(ver));
+    put(hdr.sceversion_offset, &ver, sizeof(ver));
 
-    fileout.seekp(hdr.controlinfo_offset, std::ios_base::beg);
-    fileout.write((char *)&control_5, sizeof(control_5));
-    fileout.write((char *)&control_6, sizeof(control_6));
-    fileout.write((char *)&control_7, sizeof(control_7));
+    put(hdr.controlinfo_offset, &control_5, sizeof(control_5));
+    put(hdr.controlinfo_offset + sizeof(control_5), &control_6, sizeof(control_6));
+    put(hdr.controlinfo_offset + sizeof(control_5) + sizeof(control_6), &control_7, sizeof(control_7));
 
-    fileout.seekp(HEADER_LEN, std::ios_base::beg);
-    fileout.write((char *)&input[0], file_size);
+    put(offset_to_real_elf, input, file_size);
 
-    fileout.seekp(0, std::ios_base::end);
-    hdr.self_filesize = fileout.tellp();
-    fileout.seekp(0, std::ios_base::beg);
+    hdr.self_filesize = fself.size();
+    put(0, &hdr, sizeof(hdr));
 
-    fileout.write((char *)&hdr, sizeof(hdr));
+    return fself;
+}
 
-    fileout.close();
+void make_fself(const std::string &input_file, const std::string &output_file) {
+    std::vector<uint8_t> elf;
+    if (!read_binary_file(fs::path(input_file), elf))
+        LOG_ERROR("Failed to read {}", input_file);
+    write_binary_file(fs::path(output_file), make_fself(elf));
 }
 
-std::vector<SceSegment> get_segments(std::ifstream &file, const SceHeader &sce_hdr, KeyStore &SCE_KEYS, const uint64_t sysver, const SelfType self_type, int keytype, unsigned char *klictxt) {
-    file.seekg(sce_hdr.metadata_offset + 48);
-    std::vector<char> dat(sce_hdr.header_length - sce_hdr.metadata_offset - 48);
-    file.read(&dat[0], sce_hdr.header_length - sce_hdr.metadata_offset - 48);
+bool self2fself(const fs::path &path, KeyStore &SCE_KEYS, unsigned char *klictxt) {
+    std::vector<uint8_t> self;
+    if (!read_binary_file(path, self)) {
+        LOG_ERROR("Failed to read {}", path.string());
+        return false;
+    }
+
+    std::vector<uint8_t> elf;
+    if (!self2elf(self, elf, SCE_KEYS, klictxt))
+        return false;
+
+    const std::vector<uint8_t> fself = make_fself(elf);
+    if (fself.empty())
+        return false;
+
+    return write_binary_file(path, fself);
+}
+
+static std::vector<SceSegment> get_segments(const char *dat, uint64_t dat_size, const SceHeader &sce_hdr, KeyStore &SCE_KEYS, const uint64_t sysver, const SelfType self_type, int keytype, unsigned char *klictxt) {
+    if (dat_size < MetadataInfo::Size + MetadataHeader::Size) {
+        LOG_ERROR("SCE metadata is too small");
+        return {};
+    }
 
     const std::string key = SCE_KEYS.get(KeyType::METADATA, sce_hdr.sce_type, sysver, sce_hdr.key_revision, self_type).key;
     const std::string iv = SCE_KEYS.get(KeyType::METADATA, sce_hdr.sce_type, sysver, sce_hdr.key_revision, self_type).iv;
@@ -1025,11 +1052,11 @@ std::vector<SceSegment> get_segments(std::ifstream &file, const SceHeader &sce_h
 
     MetadataInfo metadata_info = MetadataInfo((char *)dec);
 
-    std::vector<unsigned char> dec1(sce_hdr.header_length - sce_hdr.metadata_offset - 48 - MetadataInfo::Size);
-    std::vector<unsigned char> input_data(sce_hdr.header_length - sce_hdr.metadata_offset - 48 - MetadataInfo::Size);
-    memcpy(&input_data[0], &dat[64], sce_hdr.header_length - sce_hdr.metadata_offset - 48 - MetadataInfo::Size);
+    std::vector<unsigned char> dec1(dat_size - MetadataInfo::Size);
+    std::vector<unsigned char> input_data(dat_size - MetadataInfo::Size);
+    memcpy(&input_data[0], &dat[64], dat_size - MetadataInfo::Size);
     aes_setkey_dec(&aes_ctx, metadata_info.key, 128);
-    aes_crypt_cbc(&aes_ctx, AES_DECRYPT, sce_hdr.header_length - sce_hdr.metadata_offset - 48 - MetadataInfo::Size, metadata_info.iv, &input_data[0], &dec1[0]);
+    aes_crypt_cbc(&aes_ctx, AES_DECRYPT, dat_size - MetadataInfo::Size, metadata_info.iv, &input_data[0], &dec1[0]);
 
     unsigned char dec2[MetadataHeader::Size];
     std::copy(&dec1[0], &dec1[MetadataHeader::Size], dec2);
@@ -1056,6 +1083,25 @@ std::vector<SceSegment> get_segments(std::ifstream &file, const SceHeader &sce_h
     return segs;
 }
 
+
+std::vector<SceSegment> get_segments(const std::vector<uint8_t> &self, const SceHeader &sce_hdr, KeyStore &SCE_KEYS, const uint64_t sysver, const SelfType self_type, int keytype, unsigned char *klictxt) {
+    const uint64_t metadata_offset = sce_hdr.metadata_offset + 48;
+    if ((sce_hdr.header_length < metadata_offset) || (self.size() < sce_hdr.header_length)) {
+        LOG_ERROR("SCE metadata is out of bounds");
+        return {};
+    }
+
+    return get_segments(reinterpret_cast<const char *>(&self[metadata_offset]), sce_hdr.header_length - metadata_offset, sce_hdr, SCE_KEYS, sysver, self_type, keytype, klictxt);
+}
+
+std::vector<SceSegment> get_segments(std::ifstream &file, const SceHeader &sce_hdr, KeyStore &SCE_KEYS, const uint64_t sysver, const SelfType self_type, int keytype, unsigned char *klictxt) {
+    file.seekg(sce_hdr.metadata_offset + 48);
+    std::vector<char> dat(sce_hdr.header_length - sce_hdr.metadata_offset - 48);
+    file.read(&dat[0], sce_hdr.header_length - sce_hdr.metadata_offset - 48);
+
+    return get_segments(dat.data(), dat.size(), sce_hdr, SCE_KEYS, sysver, self_type, keytype, klictxt);
+}
+
 std::tuple<uint64_t, SelfType> get_key_type(std::ifstream &file, const SceHeader &sce_hdr) {
     if (sce_hdr.sce_type == SceType::SELF) {
         file.seekg(32);
@@ -0,0 +1,120 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <mem/util.h>
+#include <renderer/commands.h>
+#include <util/fs.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Config;
+struct FeatureState;
+struct MemState;
+
+// Capture of the command lists executed by the renderer, with the guest memory they read,
+// to replay them without the emulator and measure the renderer alone.
+// The capture must start before the app creates its GXM contexts, they are created again from the captured commands.
+namespace renderer {
+struct RenderTarget;
+struct State;
+
+namespace capture {
+
+constexpr char FILE_MAGIC[8] = { 'V', '3', 'K', 'G', 'X', 'M', 'C', 'P' };
+constexpr std::uint32_t FILE_VERSION = 1;
+
+// Each record is its type, the size of its data then the data
+enum class RecordType : std::uint8_t {
+    // guest memory read by the renderer: address, size, then the bytes
+    MEMORY,
+    // guest memory only written by the renderer (surfaces, notifications): address, size
+    RESERVE,
+    // SceGxmSyncObject: address
+    SYNC_OBJECT,
+    // SceGxmFragmentProgram: address, program address, is_maskupdate, has_blend, SceGxmBlendInfo
+    FRAGMENT_PROGRAM,
+    // SceGxmVertexProgram: address, program address, stream count, streams, attribute count, attributes
+    VERTEX_PROGRAM,
+    // key of the context, command count, then for each command its opcode, whether it has a status,
+    // its data with the host pointers replaced by keys or guest addresses, and the size and bytes of the structures they pointed to
+    COMMAND_LIST,
+};
+
+extern std::atomic<bool> enabled;
+
+inline bool is_enabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+// Stops by itself after frame_count frames, or never if it is 0
+bool start(const fs::path &path, std::uint32_t frame_count);
+void stop();
+
+// Called by process_batch before executing the list
+void record_command_list(State &state, MemState &mem, const CommandList &command_list);
+
+struct Record {
+    RecordType type;
+    std::vector<std::uint8_t> data;
+};
+
+// Plays a capture back on a renderer, the memory it writes to must not be used by anything else
+class Replay {
+public:
+    ~Replay();
+
+    bool load(const fs::path &path);
+    const std::string &get_title_id() const {
+        return title_id;
+    }
+    const std::string &get_self_name() const {
+        return self_name;
+    }
+
+    // Executes the records until the end of the next frame, returns false when the capture ends before it
+    bool replay_frame(State &state, const FeatureState &features, MemState &mem, Config &config);
+
+private:
+    std::string title_id;
+    std::string self_name;
+    std::vector<Record> records;
+    std::size_t next_record = 0;
+
+    // by the key they had when captured
+    std::map<std::uint64_t, std::unique_ptr<Context>> contexts;
+    std::map<std::uint64_t, std::unique_ptr<RenderTarget>> render_targets;
+    // program objects built in the guest memory and whether they are fragment programs, destroyed with the replay
+    std::map<Address, bool> programs;
+    MemState *mem = nullptr;
+    // pointed to by commands which don't free them
+    std::vector<std::shared_ptr<void>> command_data;
+    int status = 0;
+
+    void create_program(State &state, const Record &record);
+    void destroy_program(Address address);
+    bool execute_command_list(State &state, const FeatureState &features, Config &config, const Record &record);
+};
+
+} // namespace capture
+} // namespace renderer
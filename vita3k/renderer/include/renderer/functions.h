@@ -57,7 +57,7 @@ int wait_for_status(State &state, int *status, int signal, bool wake_on_equal);
 void reset_command_list(CommandList &command_list);
 void submit_command_list(State &state, renderer::Context *context, CommandList &command_list);
 bool is_cmd_ready(MemState &mem, CommandList &command_list);
-void process_batch(State &state, MemState &mem, Config &config, CommandList &command_list);
+void process_batch(State &state, const FeatureState &features, MemState &mem, Config &config, CommandList &command_list);
 void process_batches(State &state, const FeatureState &features, MemState &mem, Config &config);
 bool init(SDL_Window *window, std::unique_ptr<State> &state, Backend backend, const Config &config, const char *base_path);
 
@@ -151,7 +151,7 @@ namespace texture {
 // Paletted textures.
 void palette_texture_to_rgba_4(uint32_t *dst, const uint8_t *src, size_t width, size_t height, const size_t stride, const uint32_t *palette);
 void palette_texture_to_rgba_8(uint32_t *dst, const uint8_t *src, size_t width, size_t height, const size_t stride, const uint32_t *palette);
-void yuv420_texture_to_rgb(uint8_t *dst, const uint8_t *src, size_t width, size_t height);
+void yuv420_texture_to_rgb(uint8_t *dst, const uint8_t *src, size_t width, size_t height, SceGxmTextureFormat format);
 const uint32_t *get_texture_palette(const SceGxmTexture &texture, const MemState &mem);
 
 /**
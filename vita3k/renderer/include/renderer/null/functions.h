@@ -0,0 +1,43 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <renderer/null/state.h>
+
+#include <gxm/types.h>
+
+#include <memory>
+
+struct Config;
+struct FeatureState;
+struct MemState;
+
+namespace renderer::null {
+
+bool create(std::unique_ptr<renderer::State> &state, const char *base_path, const bool hashless_texture_cache);
+bool create(std::unique_ptr<Context> &context);
+bool create(std::unique_ptr<RenderTarget> &rt);
+bool create(std::unique_ptr<FragmentProgram> &fp);
+bool create(std::unique_ptr<VertexProgram> &vp);
+
+void sync_texture(NullState &state, NullContext &context, MemState &mem, std::size_t index, SceGxmTexture texture);
+void set_uniform_buffer(NullState &state, NullContext &context, const bool vertex_shader, const int block_num, const int size, const uint8_t *data);
+void sync_surface_data(NullState &state);
+void draw(NullState &state, NullContext &context, const FeatureState &features, SceGxmIndexFormat format, size_t count, MemState &mem, const Config &config);
+
+} // namespace renderer::null
@@ -0,0 +1,80 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <renderer/state.h>
+#include <renderer/texture_cache_state.h>
+#include <renderer/types.h>
+
+#include <array>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace renderer::null {
+
+// Work done by the null renderer
+struct NullStats {
+    std::uint64_t frame_count = 0;
+    std::uint64_t draw_count = 0;
+    std::uint64_t draw_time_ns = 0;
+    std::uint64_t texture_upload_count = 0;
+    std::uint64_t texture_upload_size = 0;
+    std::uint64_t texture_time_ns = 0;
+    std::uint64_t shader_count = 0;
+    std::uint64_t shader_time_ns = 0;
+    std::uint64_t uniform_upload_size = 0;
+    std::uint64_t surface_sync_count = 0;
+};
+
+struct NullContext : public renderer::Context {
+    // copies of the uniform buffers, vertex ones first
+    std::array<std::vector<std::uint8_t>, 2 * (SCE_GXM_REAL_MAX_UNIFORM_BUFFER + 1)> uniform_buffers;
+};
+
+struct NullRenderTarget : public renderer::RenderTarget {
+};
+
+/**
+ * \brief Renderer running all the CPU side work of the others without any GPU.
+ *
+ * The textures are decoded, the shaders translated to SPIR-V and the uniforms copied, then everything is dropped.
+ * Used to measure the emulator on machines without GPU.
+ */
+struct NullState : public renderer::State {
+    TextureCacheState texture_cache;
+
+    // programs already translated
+    std::set<Sha256Hash> fragment_shaders;
+    std::set<Sha256Hash> vertex_shaders;
+
+    NullStats stats;
+
+    bool init(const char *base_path, const bool hashless_texture_cache) override;
+    void render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &viewport_size, const DisplayState &display,
+        const GxmState &gxm, MemState &mem) override;
+    void swap_window(SDL_Window *window) override;
+    void set_fxaa(bool enable_fxaa) override;
+    int get_max_anisotropic_filtering() override;
+    void set_anisotropic_filtering(int anisotropic_filtering) override;
+
+    void precompile_shader(const ShadersHash &hash) override;
+    void preclose_action() override;
+};
+
+} // namespace renderer::null
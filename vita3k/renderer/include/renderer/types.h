@@ -30,6 +30,7 @@
 #include <bit>
 #include <bitset>
 #include <map>
+#include <optional>
 #include <string>
 #include <thread>
 #include <tuple>
@@ -60,7 +61,8 @@ struct CommandBuffer;
 
 enum class Backend : uint32_t {
     OpenGL,
-    Vulkan
+    Vulkan,
+    Null
 };
 
 enum class GXMState : std::uint16_t {
@@ -195,6 +197,8 @@ struct ShaderProgram {
 };
 
 struct FragmentProgram : ShaderProgram {
+    // blending the program was patched with, to create it again when replaying a capture
+    std::optional<SceGxmBlendInfo> blend;
 };
 
 struct VertexProgram : ShaderProgram {
@@ -15,6 +15,7 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <renderer/capture.h>
 #include <renderer/commands.h>
 #include <renderer/driver_functions.h>
 #include <renderer/functions.h>
@@ -25,7 +26,9 @@
 
 #include <config/state.h>
 #include <functional>
+#include <mem/functions.h>
 #include <util/log.h>
+#include <util/metrics.h>
 #include <util/string_utils.h>
 
 struct FeatureState;
@@ -91,14 +94,31 @@ void process_batch(renderer::State &state, const FeatureState &features, MemStat
         { CommandOpcode::DestroyContext, cmd_handle_destroy_context }
     };
 
+    // saved before its commands are freed
+    if (capture::is_enabled())
+        capture::record_command_list(state, mem, command_list);
+
+    const metrics::ScopedTimer timer(metrics::RENDER_TIME);
+    metrics::add(metrics::COMMAND_LISTS);
+
     Command *cmd = command_list.first;
 
+    // Report the writes the tracker saw since the last batch before the texture cache looks at them
+    flush_protect(mem);
+
     // Take a batch, and execute it. Hope it's not too large
     do {
         if (cmd == nullptr) {
             break;
         }
 
+        // The textures uploaded so far must be protected before the game is told it can write to them again
+        if (cmd->opcode == CommandOpcode::SignalSyncObject || cmd->opcode == CommandOpcode::SignalNotification)
+            flush_protect(mem);
+
+        if (cmd->opcode == CommandOpcode::Draw)
+            metrics::add(metrics::DRAWS);
+
         auto handler = handlers.find(cmd->opcode);
         if (handler == handlers.end()) {
             LOG_ERROR("Unimplemented command opcode {}", static_cast<int>(cmd->opcode));
@@ -116,6 +136,8 @@ void process_batch(renderer::State &state, const FeatureState &features, MemStat
             generic_command_free(last_cmd);
         }
     } while (true);
+
+    flush_protect(mem);
 }
 
 void process_batches(renderer::State &state, const FeatureState &features, MemState &mem, Config &config) {
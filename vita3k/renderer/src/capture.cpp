@@ -0,0 +1,934 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/capture.h>
+
+#include <renderer/functions.h>
+#include <renderer/state.h>
+#include <renderer/types.h>
+
+#include <gxm/functions.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <util/align.h>
+#include <util/log.h>
+
+#include <xxh3.h>
+
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace renderer::capture {
+
+std::atomic<bool> enabled = false;
+
+// Host pointers in the data of a command, replaced by values which mean the same thing in another process
+enum class FieldType {
+    // std::unique_ptr<Context> *, its address when captured is used as a key
+    CONTEXT_HOLDER,
+    // std::unique_ptr<RenderTarget> *, same as the context
+    RENDER_TARGET_HOLDER,
+    // RenderTarget *, replaced by the key of its holder
+    RENDER_TARGET,
+    // host pointer to the guest memory, replaced by the guest address
+    GUEST_POINTER,
+    // structures allocated for the command, replaced by 1 if not null and appended to the command
+    COLOR_SURFACE,
+    DEPTH_STENCIL_SURFACE,
+    RENDER_TARGET_PARAMS,
+    TRANSFER_IMAGE,
+    // source and destination of a transfer copy
+    TRANSFER_IMAGES,
+};
+
+struct PointerField {
+    std::uint32_t offset;
+    FieldType type;
+};
+
+static_assert(sizeof(void *) == sizeof(std::uint64_t), "The host pointers are replaced by 64-bit values");
+
+// Follows the arguments pushed by the client functions of renderer.cpp
+static std::vector<PointerField> get_pointer_fields(const Command &cmd) {
+    Command copy = cmd;
+    CommandHelper helper(&copy);
+    std::vector<PointerField> fields;
+    const auto pointer = [&](FieldType type) {
+        fields.push_back({ helper.point, type });
+        helper.pop<void *>();
+    };
+
+    switch (cmd.opcode) {
+    case CommandOpcode::CreateContext:
+    case CommandOpcode::DestroyContext:
+        pointer(FieldType::CONTEXT_HOLDER);
+        break;
+
+    case CommandOpcode::CreateRenderTarget:
+        pointer(FieldType::RENDER_TARGET_HOLDER);
+        pointer(FieldType::RENDER_TARGET_PARAMS);
+        break;
+
+    case CommandOpcode::DestroyRenderTarget:
+        pointer(FieldType::RENDER_TARGET_HOLDER);
+        break;
+
+    case CommandOpcode::SetContext:
+        pointer(FieldType::RENDER_TARGET);
+        pointer(FieldType::COLOR_SURFACE);
+        pointer(FieldType::DEPTH_STENCIL_SURFACE);
+        break;
+
+    case CommandOpcode::SyncSurfaceData:
+        // the surface is only given when the command has a status
+        if (cmd.status) {
+            helper.pop<SceGxmNotification>();
+            helper.pop<SceGxmNotification>();
+            pointer(FieldType::COLOR_SURFACE);
+        }
+        break;
+
+    case CommandOpcode::Draw:
+        helper.pop<SceGxmPrimitiveType>();
+        helper.pop<SceGxmIndexFormat>();
+        pointer(FieldType::GUEST_POINTER);
+        break;
+
+    case CommandOpcode::TransferCopy:
+        helper.pop<uint32_t>();
+        helper.pop<uint32_t>();
+        helper.pop<SceGxmTransferColorKeyMode>();
+        pointer(FieldType::TRANSFER_IMAGES);
+        break;
+
+    case CommandOpcode::TransferDownscale:
+        pointer(FieldType::TRANSFER_IMAGE);
+        pointer(FieldType::TRANSFER_IMAGE);
+        break;
+
+    case CommandOpcode::TransferFill:
+        helper.pop<uint32_t>();
+        pointer(FieldType::TRANSFER_IMAGE);
+        break;
+
+    case CommandOpcode::WaitSyncObject:
+        helper.pop<Ptr<SceGxmSyncObject>>();
+        pointer(FieldType::RENDER_TARGET);
+        break;
+
+    default:
+        break;
+    }
+
+    return fields;
+}
+
+static std::size_t get_structure_size(FieldType type) {
+    switch (type) {
+    case FieldType::COLOR_SURFACE: return sizeof(SceGxmColorSurface);
+    case FieldType::DEPTH_STENCIL_SURFACE: return sizeof(SceGxmDepthStencilSurface);
+    case FieldType::RENDER_TARGET_PARAMS: return sizeof(SceGxmRenderTargetParams);
+    case FieldType::TRANSFER_IMAGE: return sizeof(SceGxmTransferImage);
+    case FieldType::TRANSFER_IMAGES: return 2 * sizeof(SceGxmTransferImage);
+    default: return 0;
+    }
+}
+
+// Range of the memory covered by the rows of a transfer image, the stride can be negative
+static std::pair<Address, std::uint32_t> get_image_range(const SceGxmTransferImage &image) {
+    if (image.height == 0)
+        return { 0, 0 };
+
+    const std::int64_t bytes_per_pixel = (gxm::get_bits_per_pixel(image.format) + 7) / 8;
+    const std::int64_t first_row = static_cast<std::int64_t>(image.stride) * image.y;
+    const std::int64_t last_row = static_cast<std::int64_t>(image.stride) * (image.y + image.height - 1);
+    const std::int64_t start = std::min(first_row, last_row) + image.x * bytes_per_pixel;
+    const std::int64_t end = std::max(first_row, last_row) + (image.x + image.width) * bytes_per_pixel;
+
+    return { static_cast<Address>(image.address.address() + start), static_cast<std::uint32_t>(end - start) };
+}
+
+struct RecordData {
+    std::vector<std::uint8_t> bytes;
+
+    template <typename T>
+    void write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        write_bytes(&value, sizeof(T));
+    }
+
+    void write_bytes(const void *data, std::size_t size) {
+        const std::uint8_t *begin = static_cast<const std::uint8_t *>(data);
+        bytes.insert(bytes.end(), begin, begin + size);
+    }
+};
+
+struct RecordReader {
+    const std::vector<std::uint8_t> &bytes;
+    std::size_t offset = 0;
+    bool failed = false;
+
+    template <typename T>
+    T read() {
+        T value{};
+        read_bytes(&value, sizeof(T));
+        return value;
+    }
+
+    void read_bytes(void *dest, std::size_t size) {
+        if (offset + size > bytes.size()) {
+            failed = true;
+            std::memset(dest, 0, size);
+            return;
+        }
+        std::memcpy(dest, bytes.data() + offset, size);
+        offset += size;
+    }
+};
+
+struct Session {
+    fs::ofstream file;
+    fs::path path;
+    bool header_written = false;
+    bool unknown_object_reported = false;
+    std::uint32_t frame_limit = 0;
+    std::uint32_t frame_count = 0;
+    std::uint64_t list_count = 0;
+    std::uint64_t memory_size = 0;
+
+    // hash of the bytes last written for each range
+    std::map<std::pair<Address, std::uint32_t>, std::uint64_t> memory;
+    std::set<std::pair<Address, std::uint32_t>> reserved;
+    std::unordered_set<Address> sync_objects;
+    // data of the record last written for each program object
+    std::unordered_map<Address, std::vector<std::uint8_t>> programs;
+    // holders of the objects created by the captured commands
+    std::vector<std::unique_ptr<Context> *> contexts;
+    std::vector<std::unique_ptr<RenderTarget> *> render_targets;
+
+    void write_header(const State &state);
+    void begin_record(RecordType type, std::uint32_t size);
+    void write_record(RecordType type, const RecordData &data);
+
+    void add_memory(MemState &mem, Address address, std::uint32_t size);
+    void add_reserve(Address address, std::uint32_t size);
+    void add_sync_object(Address address);
+    void add_program(MemState &mem, Address address, bool is_fragment);
+    void add_state_memory(MemState &mem, CommandHelper &helper);
+    void add_command_memory(MemState &mem, const Command &cmd);
+
+    std::uint64_t get_context_key(const Context *context);
+    std::uint64_t get_render_target_key(const RenderTarget *render_target);
+    void report_unknown_object();
+    void encode_command(MemState &mem, const Command &cmd, RecordData &list);
+};
+
+struct Recorder {
+    std::mutex mutex;
+    std::unique_ptr<Session> session;
+};
+
+static Recorder recorder;
+
+static void write_string(fs::ofstream &file, const char *str) {
+    const std::uint32_t length = str ? static_cast<std::uint32_t>(std::strlen(str)) : 0;
+    file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+    file.write(str, length);
+}
+
+void Session::write_header(const State &state) {
+    file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    file.write(reinterpret_cast<const char *>(&FILE_VERSION), sizeof(FILE_VERSION));
+    write_string(file, state.title_id);
+    write_string(file, state.self_name);
+    header_written = true;
+}
+
+void Session::begin_record(RecordType type, std::uint32_t size) {
+    file.put(static_cast<char>(type));
+    file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+}
+
+void Session::write_record(RecordType type, const RecordData &data) {
+    begin_record(type, static_cast<std::uint32_t>(data.bytes.size()));
+    file.write(reinterpret_cast<const char *>(data.bytes.data()), data.bytes.size());
+}
+
+void Session::add_memory(MemState &mem, Address address, std::uint32_t size) {
+    if (address == 0 || size == 0 || static_cast<std::uint64_t>(address) + size > std::numeric_limits<Address>::max()
+        || !is_valid_addr_range(mem, address, address + size))
+        return;
+
+    // most buffers and textures don't change between the frames
+    const std::uint8_t *data = mem.memory.get() + address;
+    const std::uint64_t hash = XXH3_64bits(data, size);
+    const auto [it, inserted] = memory.emplace(std::make_pair(address, size), hash);
+    if (!inserted) {
+        if (it->second == hash)
+            return;
+        it->second = hash;
+    }
+
+    begin_record(RecordType::MEMORY, sizeof(address) + sizeof(size) + size);
+    file.write(reinterpret_cast<const char *>(&address), sizeof(address));
+    file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    file.write(reinterpret_cast<const char *>(data), size);
+    memory_size += size;
+}
+
+void Session::add_reserve(Address address, std::uint32_t size) {
+    if (address == 0 || size == 0 || static_cast<std::uint64_t>(address) + size > std::numeric_limits<Address>::max())
+        return;
+    if (!reserved.emplace(address, size).second)
+        return;
+
+    RecordData record;
+    record.write(address);
+    record.write(size);
+    write_record(RecordType::RESERVE, record);
+}
+
+void Session::add_sync_object(Address address) {
+    if (address == 0 || !sync_objects.insert(address).second)
+        return;
+
+    RecordData record;
+    record.write(address);
+    write_record(RecordType::SYNC_OBJECT, record);
+}
+
+void Session::add_program(MemState &mem, Address address, bool is_fragment) {
+    if (address == 0)
+        return;
+
+    RecordData record;
+    record.write(address);
+    Ptr<const SceGxmProgram> program;
+    if (is_fragment) {
+        const SceGxmFragmentProgram &fragment_program = *Ptr<const SceGxmFragmentProgram>(address).get(mem);
+        const std::optional<SceGxmBlendInfo> &blend = fragment_program.renderer_data->blend;
+        program = fragment_program.program;
+        record.write(program.address());
+        record.write<std::uint8_t>(fragment_program.is_maskupdate);
+        record.write<std::uint8_t>(blend.has_value());
+        record.write(blend.value_or(SceGxmBlendInfo{}));
+    } else {
+        const SceGxmVertexProgram &vertex_program = *Ptr<const SceGxmVertexProgram>(address).get(mem);
+        program = vertex_program.program;
+        record.write(program.address());
+        record.write(static_cast<std::uint32_t>(vertex_program.streams.size()));
+        record.write_bytes(vertex_program.streams.data(), vertex_program.streams.size() * sizeof(SceGxmVertexStream));
+        record.write(static_cast<std::uint32_t>(vertex_program.attributes.size()));
+        record.write_bytes(vertex_program.attributes.data(), vertex_program.attributes.size() * sizeof(SceGxmVertexAttribute));
+    }
+
+    // the program is needed to create the object again
+    add_memory(mem, program.address(), program.get(mem)->size);
+
+    std::vector<std::uint8_t> &last_record = programs[address];
+    if (last_record == record.bytes)
+        return;
+
+    last_record = record.bytes;
+    write_record(is_fragment ? RecordType::FRAGMENT_PROGRAM : RecordType::VERTEX_PROGRAM, record);
+}
+
+// Follows the arguments pushed by the set functions of renderer.cpp
+void Session::add_state_memory(MemState &mem, CommandHelper &helper) {
+    switch (helper.pop<GXMState>()) {
+    case GXMState::Program: {
+        const Ptr<const void> program = helper.pop<Ptr<const void>>();
+        const bool is_fragment = helper.pop<bool>();
+        add_program(mem, program.address(), is_fragment);
+        break;
+    }
+
+    case GXMState::UniformBuffer: {
+        const Ptr<const void> buffer = helper.pop<Ptr<const void>>();
+        helper.pop<bool>();
+        helper.pop<int>();
+        const std::uint32_t size = helper.pop<std::uint32_t>();
+        add_memory(mem, buffer.address(), size);
+        break;
+    }
+
+    case GXMState::VertexStream: {
+        const Ptr<const void> stream = helper.pop<Ptr<const void>>();
+        helper.pop<std::size_t>();
+        const std::size_t size = helper.pop<std::size_t>();
+        add_memory(mem, stream.address(), static_cast<std::uint32_t>(size));
+        break;
+    }
+
+    case GXMState::Texture: {
+        helper.pop<std::uint32_t>();
+        const SceGxmTexture texture = helper.pop<SceGxmTexture>();
+        add_memory(mem, texture.data_addr << 2, static_cast<std::uint32_t>(texture::texture_size(texture)));
+
+        const SceGxmTextureBaseFormat base_format = gxm::get_base_format(gxm::get_format(&texture));
+        if (gxm::is_paletted_format(base_format)) {
+            const std::uint32_t palette_size = (base_format == SCE_GXM_TEXTURE_BASE_FORMAT_P4 ? 16 : 256) * sizeof(std::uint32_t);
+            add_memory(mem, texture.palette_addr << 6, palette_size);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+// Saves what the command reads from the guest memory and reserves what it writes to
+void Session::add_command_memory(MemState &mem, const Command &cmd) {
+    Command copy = cmd;
+    CommandHelper helper(&copy);
+
+    switch (cmd.opcode) {
+    case CommandOpcode::SetState:
+        add_state_memory(mem, helper);
+        break;
+
+    case CommandOpcode::Draw: {
+        helper.pop<SceGxmPrimitiveType>();
+        const SceGxmIndexFormat format = helper.pop<SceGxmIndexFormat>();
+        const std::uint8_t *indices = helper.pop<const std::uint8_t *>();
+        const std::uint32_t count = helper.pop<std::uint32_t>();
+        if (indices)
+            add_memory(mem, static_cast<Address>(indices - mem.memory.get()), count * static_cast<std::uint32_t>(gxm::index_element_size(format)));
+        break;
+    }
+
+    case CommandOpcode::SetContext: {
+        helper.pop<RenderTarget *>();
+        const SceGxmColorSurface *surface = helper.pop<SceGxmColorSurface *>();
+        if (surface && !surface->disabled)
+            add_reserve(surface->data.address(), static_cast<std::uint32_t>(gxm::get_stride_in_bytes(surface->colorFormat, surface->strideInPixels) * surface->height));
+        break;
+    }
+
+    case CommandOpcode::SyncSurfaceData:
+        for (int i = 0; i < 2; i++)
+            add_reserve(helper.pop<SceGxmNotification>().address.address(), sizeof(std::uint32_t));
+        break;
+
+    case CommandOpcode::SignalNotification:
+        add_reserve(helper.pop<SceGxmNotification>().address.address(), sizeof(std::uint32_t));
+        break;
+
+    case CommandOpcode::SignalSyncObject:
+    case CommandOpcode::WaitSyncObject:
+        add_sync_object(helper.pop<Ptr<SceGxmSyncObject>>().address());
+        break;
+
+    case CommandOpcode::MemoryMap: {
+        const Ptr<void> address = helper.pop<Ptr<void>>();
+        const std::uint32_t size = helper.pop<std::uint32_t>();
+        add_reserve(address.address(), size);
+        break;
+    }
+
+    case CommandOpcode::TransferCopy: {
+        helper.pop<uint32_t>();
+        helper.pop<uint32_t>();
+        helper.pop<SceGxmTransferColorKeyMode>();
+        const SceGxmTransferImage *images = helper.pop<SceGxmTransferImage *>();
+        const auto [src_address, src_size] = get_image_range(images[0]);
+        const auto [dest_address, dest_size] = get_image_range(images[1]);
+        add_memory(mem, src_address, src_size);
+        add_reserve(dest_address, dest_size);
+        break;
+    }
+
+    case CommandOpcode::TransferDownscale: {
+        const auto [src_address, src_size] = get_image_range(*helper.pop<SceGxmTransferImage *>());
+        const auto [dest_address, dest_size] = get_image_range(*helper.pop<SceGxmTransferImage *>());
+        add_memory(mem, src_address, src_size);
+        add_reserve(dest_address, dest_size);
+        break;
+    }
+
+    case CommandOpcode::TransferFill: {
+        helper.pop<uint32_t>();
+        const auto [dest_address, dest_size] = get_image_range(*helper.pop<SceGxmTransferImage *>());
+        add_reserve(dest_address, dest_size);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void Session::report_unknown_object() {
+    if (unknown_object_reported)
+        return;
+
+    LOG_ERROR("The GXM capture uses a context or render target created before it started, it will not replay. Start it with the app.");
+    unknown_object_reported = true;
+}
+
+std::uint64_t Session::get_context_key(const Context *context) {
+    if (!context)
+        return 0;
+
+    for (std::unique_ptr<Context> *holder : contexts) {
+        if (holder->get() == context)
+            return reinterpret_cast<std::uintptr_t>(holder);
+    }
+
+    report_unknown_object();
+    return 0;
+}
+
+std::uint64_t Session::get_render_target_key(const RenderTarget *render_target) {
+    if (!render_target)
+        return 0;
+
+    for (std::unique_ptr<RenderTarget> *holder : render_targets) {
+        if (holder->get() == render_target)
+            return reinterpret_cast<std::uintptr_t>(holder);
+    }
+
+    report_unknown_object();
+    return 0;
+}
+
+void Session::encode_command(MemState &mem, const Command &cmd, RecordData &list) {
+    std::uint8_t data[MAX_COMMAND_DATA_SIZE];
+    std::memcpy(data, cmd.data, sizeof(data));
+    RecordData structures;
+
+    for (const PointerField &field : get_pointer_fields(cmd)) {
+        void *pointer;
+        std::memcpy(&pointer, data + field.offset, sizeof(pointer));
+
+        std::uint64_t value = 0;
+        switch (field.type) {
+        case FieldType::CONTEXT_HOLDER: {
+            auto holder = static_cast<std::unique_ptr<Context> *>(pointer);
+            if (cmd.opcode == CommandOpcode::CreateContext)
+                contexts.push_back(holder);
+            else
+                std::erase(contexts, holder);
+            value = reinterpret_cast<std::uintptr_t>(holder);
+            break;
+        }
+
+        case FieldType::RENDER_TARGET_HOLDER: {
+            auto holder = static_cast<std::unique_ptr<RenderTarget> *>(pointer);
+            if (cmd.opcode == CommandOpcode::CreateRenderTarget)
+                render_targets.push_back(holder);
+            else
+                std::erase(render_targets, holder);
+            value = reinterpret_cast<std::uintptr_t>(holder);
+            break;
+        }
+
+        case FieldType::RENDER_TARGET:
+            value = get_render_target_key(static_cast<const RenderTarget *>(pointer));
+            break;
+
+        case FieldType::GUEST_POINTER:
+            value = pointer ? static_cast<const std::uint8_t *>(pointer) - mem.memory.get() : 0;
+            break;
+
+        default:
+            if (pointer) {
+                value = 1;
+                structures.write_bytes(pointer, get_structure_size(field.type));
+            }
+            break;
+        }
+
+        std::memcpy(data + field.offset, &value, sizeof(value));
+    }
+
+    list.write(cmd.opcode);
+    list.write<std::uint8_t>(cmd.status != nullptr);
+    list.write_bytes(data, sizeof(data));
+    list.write(static_cast<std::uint32_t>(structures.bytes.size()));
+    list.write_bytes(structures.bytes.data(), structures.bytes.size());
+}
+
+// Called with the recorder mutex held
+static void stop_session() {
+    if (!recorder.session)
+        return;
+
+    enabled = false;
+    const Session &session = *recorder.session;
+    LOG_INFO("GXM capture written to {}: {} frames, {} command lists, {} MiB of memory", session.path.string(), session.frame_count,
+        session.list_count, session.memory_size >> 20);
+    recorder.session.reset();
+}
+
+bool start(const fs::path &path, std::uint32_t frame_count) {
+    const std::lock_guard<std::mutex> lock(recorder.mutex);
+    if (recorder.session) {
+        LOG_WARN("A GXM capture is already running");
+        return false;
+    }
+
+    auto session = std::make_unique<Session>();
+    session->file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!session->file.is_open()) {
+        LOG_ERROR("Failed to create the GXM capture file {}", path.string());
+        return false;
+    }
+
+    session->path = path;
+    session->frame_limit = frame_count;
+    recorder.session = std::move(session);
+    enabled = true;
+    LOG_INFO("Capturing the GXM commands to {}", path.string());
+
+    return true;
+}
+
+void stop() {
+    const std::lock_guard<std::mutex> lock(recorder.mutex);
+    stop_session();
+}
+
+void record_command_list(State &state, MemState &mem, const CommandList &command_list) {
+    const std::lock_guard<std::mutex> lock(recorder.mutex);
+    if (!recorder.session)
+        return;
+
+    Session &session = *recorder.session;
+    if (!session.header_written)
+        session.write_header(state);
+
+    std::uint32_t command_count = 0;
+    for (const Command *cmd = command_list.first; cmd; cmd = cmd->next)
+        command_count++;
+
+    RecordData list;
+    list.write(session.get_context_key(command_list.context));
+    list.write(command_count);
+
+    std::uint32_t new_frames = 0;
+    for (const Command *cmd = command_list.first; cmd; cmd = cmd->next) {
+        // the memory must be restored before the list executes
+        session.add_command_memory(mem, *cmd);
+        session.encode_command(mem, *cmd, list);
+        if (cmd->opcode == CommandOpcode::NewFrame)
+            new_frames++;
+    }
+
+    session.write_record(RecordType::COMMAND_LIST, list);
+    session.list_count++;
+    session.frame_count += new_frames;
+
+    if (session.frame_limit > 0 && session.frame_count >= session.frame_limit)
+        stop_session();
+}
+
+static std::string read_string(fs::ifstream &file) {
+    std::uint32_t length = 0;
+    file.read(reinterpret_cast<char *>(&length), sizeof(length));
+    std::string str(length, '\0');
+    file.read(str.data(), length);
+    return str;
+}
+
+Replay::~Replay() {
+    while (!programs.empty())
+        destroy_program(programs.begin()->first);
+}
+
+bool Replay::load(const fs::path &path) {
+    fs::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open the GXM capture {}", path.string());
+        return false;
+    }
+
+    char magic[sizeof(FILE_MAGIC)];
+    std::uint32_t version = 0;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0
+        || !file.read(reinterpret_cast<char *>(&version), sizeof(version))) {
+        LOG_ERROR("{} is not a GXM capture", path.string());
+        return false;
+    }
+    if (version != FILE_VERSION) {
+        LOG_ERROR("Unsupported GXM capture version {}", version);
+        return false;
+    }
+
+    title_id = read_string(file);
+    self_name = read_string(file);
+
+    // everything is loaded first so the replay doesn't wait for the disk
+    while (true) {
+        char type;
+        std::uint32_t size = 0;
+        if (!file.get(type))
+            break;
+
+        Record record{ static_cast<RecordType>(type) };
+        if (file.read(reinterpret_cast<char *>(&size), sizeof(size))) {
+            record.data.resize(size);
+            file.read(reinterpret_cast<char *>(record.data.data()), size);
+        }
+        if (!file) {
+            LOG_WARN("The GXM capture {} is truncated", path.string());
+            break;
+        }
+
+        records.push_back(std::move(record));
+    }
+
+    return true;
+}
+
+static void map_range(MemState &mem, Address address, std::uint32_t size) {
+    const std::uint64_t end = static_cast<std::uint64_t>(address) + size;
+    for (std::uint64_t page = align_down(address, mem.page_size); page < end; page += mem.page_size) {
+        if (!is_valid_addr(mem, static_cast<Address>(page)))
+            alloc_at(mem, static_cast<Address>(page), mem.page_size, "gxm replay");
+    }
+}
+
+template <typename T>
+static T *read_structure(RecordReader &reader) {
+    T *structure = new T;
+    reader.read_bytes(structure, sizeof(T));
+    return structure;
+}
+
+void Replay::create_program(State &state, const Record &record) {
+    RecordReader reader{ record.data };
+    const Address address = reader.read<Address>();
+    const Ptr<const SceGxmProgram> program(reader.read<Address>());
+
+    destroy_program(address);
+    if (record.type == RecordType::FRAGMENT_PROGRAM) {
+        const bool is_maskupdate = reader.read<std::uint8_t>();
+        const bool has_blend = reader.read<std::uint8_t>();
+        const SceGxmBlendInfo blend = reader.read<SceGxmBlendInfo>();
+        if (reader.failed)
+            return;
+
+        map_range(*mem, address, sizeof(SceGxmFragmentProgram));
+        SceGxmFragmentProgram *fragment_program = new (Ptr<SceGxmFragmentProgram>(address).get(*mem)) SceGxmFragmentProgram();
+        fragment_program->program = program;
+        fragment_program->is_maskupdate = is_maskupdate;
+        programs[address] = true;
+        renderer::create(fragment_program->renderer_data, state, *program.get(*mem), has_blend ? &blend : nullptr, state.gxp_ptr_map, state.base_path, state.title_id);
+    } else {
+        std::vector<SceGxmVertexStream> streams(reader.read<std::uint32_t>());
+        reader.read_bytes(streams.data(), streams.size() * sizeof(SceGxmVertexStream));
+        std::vector<SceGxmVertexAttribute> attributes(reader.read<std::uint32_t>());
+        reader.read_bytes(attributes.data(), attributes.size() * sizeof(SceGxmVertexAttribute));
+        if (reader.failed)
+            return;
+
+        map_range(*mem, address, sizeof(SceGxmVertexProgram));
+        SceGxmVertexProgram *vertex_program = new (Ptr<SceGxmVertexProgram>(address).get(*mem)) SceGxmVertexProgram();
+        vertex_program->program = program;
+        vertex_program->streams = std::move(streams);
+        vertex_program->attributes = std::move(attributes);
+        programs[address] = false;
+        renderer::create(vertex_program->renderer_data, state, *program.get(*mem), state.gxp_ptr_map, state.base_path, state.title_id);
+    }
+}
+
+void Replay::destroy_program(Address address) {
+    const auto it = programs.find(address);
+    if (it == programs.end())
+        return;
+
+    if (it->second)
+        Ptr<SceGxmFragmentProgram>(address).get(*mem)->~SceGxmFragmentProgram();
+    else
+        Ptr<SceGxmVertexProgram>(address).get(*mem)->~SceGxmVertexProgram();
+    programs.erase(it);
+}
+
+bool Replay::execute_command_list(State &state, const FeatureState &features, Config &config, const Record &record) {
+    RecordReader reader{ record.data };
+    const std::uint64_t context_key = reader.read<std::uint64_t>();
+    const std::uint32_t command_count = reader.read<std::uint32_t>();
+
+    CommandList list;
+    list.context = nullptr;
+    if (context_key != 0) {
+        list.context = contexts[context_key].get();
+        if (!list.context) {
+            LOG_ERROR("The GXM capture uses a context it did not create");
+            next_record = records.size();
+            return false;
+        }
+        // the free function of the emulator gives the command back to its guest pool
+        if (!list.context->free_func)
+            list.context->free_func = generic_command_free;
+    }
+
+    bool new_frame = false;
+    for (std::uint32_t i = 0; i < command_count && !reader.failed; i++) {
+        Command *cmd = generic_command_allocate();
+        cmd->opcode = reader.read<CommandOpcode>();
+        cmd->status = reader.read<std::uint8_t>() ? &status : nullptr;
+        cmd->next = nullptr;
+        reader.read_bytes(cmd->data, sizeof(cmd->data));
+        const std::uint32_t structures_size = reader.read<std::uint32_t>();
+        const std::size_t structures_end = reader.offset + structures_size;
+
+        for (const PointerField &field : get_pointer_fields(*cmd)) {
+            std::uint64_t value;
+            std::memcpy(&value, cmd->data + field.offset, sizeof(value));
+
+            void *pointer = nullptr;
+            switch (field.type) {
+            case FieldType::CONTEXT_HOLDER:
+                pointer = &contexts[value];
+                break;
+            case FieldType::RENDER_TARGET_HOLDER:
+                pointer = &render_targets[value];
+                break;
+            case FieldType::RENDER_TARGET:
+                pointer = value ? render_targets[value].get() : nullptr;
+                break;
+            case FieldType::GUEST_POINTER:
+                pointer = value ? mem->memory.get() + value : nullptr;
+                break;
+            default:
+                if (!value)
+                    break;
+
+                // the same structures the client functions allocate, freed by the handlers which free them
+                if (field.type == FieldType::TRANSFER_IMAGES) {
+                    SceGxmTransferImage *images = new SceGxmTransferImage[2];
+                    reader.read_bytes(images, 2 * sizeof(SceGxmTransferImage));
+                    pointer = images;
+                } else if (field.type == FieldType::TRANSFER_IMAGE) {
+                    pointer = read_structure<SceGxmTransferImage>(reader);
+                } else if (field.type == FieldType::DEPTH_STENCIL_SURFACE) {
+                    pointer = read_structure<SceGxmDepthStencilSurface>(reader);
+                } else if (field.type == FieldType::COLOR_SURFACE) {
+                    SceGxmColorSurface *surface = read_structure<SceGxmColorSurface>(reader);
+                    if (cmd->opcode == CommandOpcode::SyncSurfaceData)
+                        command_data.emplace_back(surface);
+                    pointer = surface;
+                } else if (field.type == FieldType::RENDER_TARGET_PARAMS) {
+                    SceGxmRenderTargetParams *params = read_structure<SceGxmRenderTargetParams>(reader);
+                    command_data.emplace_back(params);
+                    pointer = params;
+                }
+                break;
+            }
+
+            std::memcpy(cmd->data + field.offset, &pointer, sizeof(pointer));
+        }
+        reader.offset = structures_end;
+
+        // the signals the wait was for may not be in the capture, and the replay is in order anyway
+        if (cmd->opcode == CommandOpcode::WaitSyncObject) {
+            generic_command_free(cmd);
+            continue;
+        }
+
+        if (cmd->opcode == CommandOpcode::NewFrame)
+            new_frame = true;
+
+        if (!list.first)
+            list.first = cmd;
+        else
+            list.last->next = cmd;
+        list.last = cmd;
+    }
+
+    if (reader.failed) {
+        LOG_ERROR("Corrupted command list in the GXM capture");
+        // the structures of the commands are leaked, the replay stops anyway
+        for (Command *cmd = list.first; cmd;) {
+            Command *next = cmd->next;
+            generic_command_free(cmd);
+            cmd = next;
+        }
+        next_record = records.size();
+        return false;
+    }
+
+    process_batch(state, features, *mem, config, list);
+
+    return new_frame;
+}
+
+bool Replay::replay_frame(State &state, const FeatureState &features, MemState &mem, Config &config) {
+    this->mem = &mem;
+
+    while (next_record < records.size()) {
+        const Record &record = records[next_record++];
+        RecordReader reader{ record.data };
+
+        switch (record.type) {
+        case RecordType::MEMORY: {
+            const Address address = reader.read<Address>();
+            const std::uint32_t size = reader.read<std::uint32_t>();
+            if (reader.failed || reader.offset + size > record.data.size())
+                break;
+            map_range(mem, address, size);
+            std::memcpy(mem.memory.get() + address, record.data.data() + reader.offset, size);
+            break;
+        }
+
+        case RecordType::RESERVE: {
+            const Address address = reader.read<Address>();
+            const std::uint32_t size = reader.read<std::uint32_t>();
+            if (!reader.failed)
+                map_range(mem, address, size);
+            break;
+        }
+
+        case RecordType::SYNC_OBJECT: {
+            const Address address = reader.read<Address>();
+            if (reader.failed)
+                break;
+            map_range(mem, address, sizeof(SceGxmSyncObject));
+            SceGxmSyncObject *sync = new (Ptr<SceGxmSyncObject>(address).get(mem)) SceGxmSyncObject();
+            renderer::create(sync, state);
+            // the timestamps were given to the app before the capture, they are all signaled in order anyway
+            sync->timestamp_ahead = std::numeric_limits<std::uint32_t>::max();
+            break;
+        }
+
+        case RecordType::FRAGMENT_PROGRAM:
+        case RecordType::VERTEX_PROGRAM:
+            create_program(state, record);
+            break;
+
+        case RecordType::COMMAND_LIST:
+            if (execute_command_list(state, features, config, record))
+                return true;
+            break;
+
+        default:
+            LOG_WARN("Unknown record {} in the GXM capture", static_cast<int>(record.type));
+            break;
+        }
+    }
+
+    return false;
+}
+
+} // namespace renderer::capture
@@ -23,6 +23,7 @@
 #include <renderer/types.h>
 
 #include <renderer/gl/functions.h>
+#include <renderer/null/functions.h>
 #include <renderer/texture_cache_state.h>
 #include <renderer/vulkan/functions.h>
 #include <renderer/vulkan/state.h>
@@ -30,6 +31,7 @@
 #include <gxm/functions.h>
 #include <gxm/types.h>
 #include <renderer/functions.h>
+#include <shader/spirv_optimizer.h>
 #include <util/log.h>
 #include <util/string_utils.h>
 #include <util/tracy.h>
@@ -68,6 +70,11 @@ COMMAND(handle_create_context) {
         break;
     }
 
+    case Backend::Null: {
+        result = null::create(*ctx);
+        break;
+    }
+
     default: {
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -111,6 +118,10 @@ COMMAND(handle_create_render_target) {
         result = vulkan::create(dynamic_cast<vulkan::VKState &>(renderer), *render_target, *params, features);
         break;
 
+    case Backend::Null:
+        result = null::create(*render_target);
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -133,6 +144,10 @@ COMMAND(handle_destroy_render_target) {
         vulkan::destroy(dynamic_cast<vulkan::VKState &>(renderer), *render_target);
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -178,11 +193,18 @@ bool create(std::unique_ptr<FragmentProgram> &fp, State &state, const SceGxmProg
         vulkan::create(fp, dynamic_cast<vulkan::VKState &>(state), program, blend);
         break;
 
+    case Backend::Null:
+        null::create(fp);
+        break;
+
     default:
         REPORT_MISSING(state.current_backend);
         return false;
     }
 
+    if (blend)
+        fp->blend = *blend;
+
     // Try to hash this shader
     fp->hash = sha256(&program, program.size);
     gxp_ptr_map.emplace(fp->hash, &program);
@@ -205,6 +227,10 @@ bool create(std::unique_ptr<VertexProgram> &vp, State &state, const SceGxmProgra
         vulkan::create(vp, dynamic_cast<vulkan::VKState &>(state), program);
         break;
 
+    case Backend::Null:
+        null::create(vp);
+        break;
+
     default:
         REPORT_MISSING(state.current_backend);
         return false;
@@ -255,6 +281,12 @@ bool init(SDL_Window *window, std::unique_ptr<State> &state, Backend backend, co
             return false;
         break;
 
+    case Backend::Null:
+        state = std::make_unique<null::NullState>();
+        if (!null::create(state, base_path, config.hashless_texture_cache))
+            return false;
+        break;
+
     default:
         LOG_ERROR("Cannot create a renderer with unsupported backend {}.", static_cast<int>(backend));
         return false;
@@ -262,6 +294,10 @@ bool init(SDL_Window *window, std::unique_ptr<State> &state, Backend backend, co
 
     state->current_backend = backend;
 
+    // each optimization level has its own shader cache
+    state->features.spirv_optimization_level = std::clamp(config.spirv_optimization_level, 0, shader::MAX_SPIRV_OPTIMIZATION_LEVEL);
+    state->shader_version += shader::get_spirv_optimization_suffix(state->features.spirv_optimization_level);
+
     // Can change this
     state->command_buffer_queue.maxPendingCount_ = 30;
 
@@ -24,6 +24,7 @@
 
 #include <gxm/types.h>
 #include <util/log.h>
+#include <util/metrics.h>
 
 #include <shader/spirv_recompiler.h>
 
@@ -44,6 +45,7 @@ static SharedGLObject compile_glsl(GLenum type, const std::string &source) {
     glShaderSource(shader->get(), 1, &source_glchar, &length);
 
     glCompileShader(shader->get());
+    metrics::add(metrics::SHADER_COMPILES);
 
     GLint log_length = 0;
     glGetShaderiv(shader->get(), GL_INFO_LOG_LENGTH, &log_length);
@@ -125,6 +127,7 @@ static SharedGLObject compile_program(ProgramCache &program_cache, const SharedG
     glAttachShader(program->get(), frag_shader->get());
     glAttachShader(program->get(), vert_shader->get());
     glLinkProgram(program->get());
+    metrics::add(metrics::PIPELINE_COMPILES);
 
     GLint log_length = 0;
     glGetProgramiv(program->get(), GL_INFO_LOG_LENGTH, &log_length);
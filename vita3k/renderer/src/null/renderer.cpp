@@ -0,0 +1,212 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <renderer/null/functions.h>
+
+#include <renderer/functions.h>
+#include <renderer/profile.h>
+#include <renderer/shaders.h>
+#include <renderer/types.h>
+
+#include <config/state.h>
+#include <gxm/functions.h>
+#include <mem/functions.h>
+#include <shader/spirv_recompiler.h>
+#include <util/log.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace renderer::null {
+
+static uint64_t elapsed_ns(const std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool create(std::unique_ptr<renderer::State> &state, const char *base_path, const bool hashless_texture_cache) {
+    auto &null_state = dynamic_cast<NullState &>(*state);
+
+    LOG_INFO("Using the null renderer, nothing will be displayed");
+
+    return null_state.init(base_path, hashless_texture_cache);
+}
+
+bool NullState::init(const char *base_path, const bool hashless_texture_cache) {
+    texture_cache.backend = &current_backend;
+    texture_cache.use_protect = hashless_texture_cache;
+    texture_cache.select_callback = [](std::size_t, const void *) {};
+    texture_cache.configure_texture_callback = [](TextureCacheState &, const void *) {};
+    texture_cache.upload_texture_callback = [this](SceGxmTextureBaseFormat base_format, uint32_t width, uint32_t height, uint32_t, const void *, int, bool is_compressed, size_t) {
+        stats.texture_upload_size += is_compressed ? texture::get_compressed_size(base_format, width, height)
+                                                   : width * height * texture::bits_per_pixel(base_format) / 8;
+    };
+    texture_cache.upload_done_callback = [this]() {
+        stats.texture_upload_count++;
+    };
+
+    // the shaders are not built for the same features as the ones of the other renderers
+    shader_version = fmt::format("null{}", shader::CURRENT_VERSION);
+
+    return true;
+}
+
+bool create(std::unique_ptr<Context> &context) {
+    context = std::make_unique<NullContext>();
+    return true;
+}
+
+bool create(std::unique_ptr<RenderTarget> &rt) {
+    rt = std::make_unique<NullRenderTarget>();
+    return true;
+}
+
+bool create(std::unique_ptr<FragmentProgram> &fp) {
+    fp = std::make_unique<FragmentProgram>();
+    return true;
+}
+
+bool create(std::unique_ptr<VertexProgram> &vp) {
+    vp = std::make_unique<VertexProgram>();
+    return true;
+}
+
+void sync_texture(NullState &state, NullContext &context, MemState &mem, std::size_t index, SceGxmTexture texture) {
+    const Address data_addr = texture.data_addr << 2;
+
+    const size_t texture_size = renderer::texture::texture_size(texture);
+    if (!is_valid_addr_range(mem, data_addr, data_addr + texture_size)) {
+        LOG_WARN("Texture has freed data.");
+        return;
+    }
+
+    const SceGxmTextureFormat format = gxm::get_format(&texture);
+    if (gxm::is_paletted_format(gxm::get_base_format(format)) && texture.palette_addr == 0) {
+        LOG_WARN("Ignoring null palette texture");
+        return;
+    }
+
+    if (index >= SCE_GXM_MAX_TEXTURE_UNITS) {
+        // Vertex textures
+        context.shader_hints.vertex_textures[index - SCE_GXM_MAX_TEXTURE_UNITS] = format;
+    } else {
+        context.shader_hints.fragment_textures[index] = format;
+    }
+
+    // the other renderers sample the color surface directly, there is nothing to decode
+    if (context.record.color_surface.data.address() == data_addr)
+        return;
+
+    const auto start = std::chrono::steady_clock::now();
+    renderer::texture::cache_and_bind_texture(state.texture_cache, texture, mem);
+    state.stats.texture_time_ns += elapsed_ns(start);
+}
+
+void set_uniform_buffer(NullState &state, NullContext &context, const bool vertex_shader, const int block_num, const int size, const uint8_t *data) {
+    const int base_binding = vertex_shader ? 0 : (SCE_GXM_REAL_MAX_UNIFORM_BUFFER + 1);
+    context.uniform_buffers[base_binding + block_num].assign(data, data + size);
+    state.stats.uniform_upload_size += size;
+}
+
+void sync_surface_data(NullState &state) {
+    state.stats.surface_sync_count++;
+}
+
+static void translate_shader(NullState &state, NullContext &context, const FeatureState &features, const SceGxmProgram &program, const Sha256Hash &hash,
+    std::set<Sha256Hash> &translated, const Config &config) {
+    if (translated.contains(hash))
+        return;
+
+    const auto start = std::chrono::steady_clock::now();
+    load_spirv_shader(program, features, true, context.shader_hints, context.record.is_maskupdate, state.base_path, state.title_id, state.self_name,
+        state.shader_version, config.shader_cache);
+    state.stats.shader_time_ns += elapsed_ns(start);
+    state.stats.shader_count++;
+    state.shaders_count_compiled++;
+
+    translated.insert(hash);
+}
+
+void draw(NullState &state, NullContext &context, const FeatureState &features, SceGxmIndexFormat format, size_t count, MemState &mem, const Config &config) {
+    R_PROFILE(__func__);
+
+    const auto start = std::chrono::steady_clock::now();
+    const GxmRecordState &record = context.record;
+    if (!record.fragment_program || !record.vertex_program)
+        return;
+
+    const SceGxmFragmentProgram &fragment_program_gxm = *record.fragment_program.get(mem);
+    const SceGxmVertexProgram &vertex_program_gxm = *record.vertex_program.get(mem);
+    const Sha256Hash &fragment_hash = fragment_program_gxm.renderer_data->hash;
+    const Sha256Hash &vertex_hash = vertex_program_gxm.renderer_data->hash;
+
+    // same hints as the other renderers when translating
+    context.shader_hints.color_format = record.color_surface.colorFormat;
+    context.shader_hints.attributes = &vertex_program_gxm.attributes;
+
+    translate_shader(state, context, features, *fragment_program_gxm.program.get(mem), fragment_hash, state.fragment_shaders, config);
+    translate_shader(state, context, features, *vertex_program_gxm.program.get(mem), vertex_hash, state.vertex_shaders, config);
+
+    const auto program_hash = std::find_if(state.shaders_cache_hashs.begin(), state.shaders_cache_hashs.end(), [&](const ShadersHash &hash) {
+        return (hash.frag == fragment_hash) && (hash.vert == vertex_hash);
+    });
+    if (program_hash == state.shaders_cache_hashs.end()) {
+        state.shaders_cache_hashs.push_back({ fragment_hash, vertex_hash });
+        save_shaders_cache_hashs(state, state.shaders_cache_hashs);
+    }
+
+    state.stats.draw_count++;
+    state.stats.draw_time_ns += elapsed_ns(start);
+}
+
+void NullState::render_frame(const SceFVector2 &viewport_pos, const SceFVector2 &viewport_size, const DisplayState &display,
+    const GxmState &gxm, MemState &mem) {
+    // only count the frames the app actually presented
+    if (should_display && display.frame.base)
+        stats.frame_count++;
+
+    should_display = false;
+}
+
+void NullState::swap_window(SDL_Window *window) {}
+
+void NullState::set_fxaa(bool enable_fxaa) {}
+
+int NullState::get_max_anisotropic_filtering() {
+    return 16;
+}
+
+void NullState::set_anisotropic_filtering(int anisotropic_filtering) {
+    texture_cache.anisotropic_filtering = anisotropic_filtering;
+}
+
+void NullState::precompile_shader(const ShadersHash &hash) {
+    const auto load = [this](const Sha256Hash &shader_hash, std::set<Sha256Hash> &translated) {
+        const std::string hash_ver = fmt::format("{}-{}", shader_version, hex_string(shader_hash));
+        if (!pre_load_shader_spirv(hash_ver.c_str(), "spv", base_path, title_id, self_name).empty())
+            translated.insert(shader_hash);
+    };
+
+    load(hash.frag, fragment_shaders);
+    load(hash.vert, vertex_shaders);
+
+    programs_count_pre_compiled++;
+    LOG_INFO("Program Compiled {}/{}", programs_count_pre_compiled, shaders_cache_hashs.size());
+}
+
+void NullState::preclose_action() {}
+
+} // namespace renderer::null
@@ -25,6 +25,8 @@
 #include <renderer/gl/functions.h>
 #include <renderer/gl/types.h>
 
+#include <renderer/null/functions.h>
+
 #include <renderer/vulkan/functions.h>
 
 #include <config/state.h>
@@ -82,6 +84,10 @@ COMMAND(handle_set_context) {
         vulkan::set_context(*reinterpret_cast<vulkan::VKContext *>(render_context), mem, reinterpret_cast<vulkan::VKRenderTarget *>(rt), features);
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -157,6 +163,10 @@ COMMAND(handle_sync_surface_data) {
         // not implemented for now
         break;
 
+    case Backend::Null:
+        null::sync_surface_data(dynamic_cast<null::NullState &>(renderer));
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -207,6 +217,11 @@ COMMAND(handle_draw) {
             count, instance_count, mem, config);
         break;
 
+    case Backend::Null:
+        null::draw(dynamic_cast<null::NullState &>(renderer), *reinterpret_cast<null::NullContext *>(render_context),
+            features, format, count * instance_count, mem, config);
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
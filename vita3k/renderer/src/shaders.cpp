@@ -32,9 +32,17 @@
 
 namespace renderer {
 
+static const char *get_hashs_file_suffix(Backend backend) {
+    switch (backend) {
+    case Backend::OpenGL: return "gl";
+    case Backend::Vulkan: return "vk";
+    default: return "null";
+    }
+}
+
 bool get_shaders_cache_hashs(State &renderer) {
     const auto shaders_path{ fs::path(renderer.base_path) / "cache/shaders" / renderer.title_id / renderer.self_name };
-    const std::string hash_file_name = fmt::format("hashs-{}.dat", (renderer.current_backend == Backend::OpenGL) ? "gl" : "vk");
+    const std::string hash_file_name = fmt::format("hashs-{}.dat", get_hashs_file_suffix(renderer.current_backend));
 
     if (renderer.current_backend == Backend::Vulkan) {
         // try to read pipeline cache
@@ -86,7 +94,7 @@ void save_shaders_cache_hashs(State &renderer, std::vector<ShadersHash> &shaders
     const auto shaders_path{ fs::path(renderer.base_path) / "cache/shaders" / renderer.title_id / renderer.self_name };
     if (!fs::exists(shaders_path))
         fs::create_directory(shaders_path);
-    std::string hash_file_name = fmt::format("hashs-{}.dat", (renderer.current_backend == Backend::OpenGL) ? "gl" : "vk");
+    std::string hash_file_name = fmt::format("hashs-{}.dat", get_hashs_file_suffix(renderer.current_backend));
     fs::ofstream shaders_hashs(shaders_path / hash_file_name, std::ios::out | std::ios::binary);
 
     if (shaders_hashs.is_open()) {
@@ -25,6 +25,8 @@
 #include <renderer/gl/state.h>
 #include <renderer/gl/types.h>
 
+#include <renderer/null/functions.h>
+
 #include <renderer/vulkan/functions.h>
 #include <renderer/vulkan/state.h>
 #include <renderer/vulkan/types.h>
@@ -67,6 +69,10 @@ COMMAND_SET_STATE(region_clip) {
         vulkan::sync_clipping(*reinterpret_cast<vulkan::VKContext *>(render_context));
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -92,6 +98,10 @@ COMMAND_SET_STATE(program) {
         case Backend::Vulkan:
             break;
 
+        case Backend::Null:
+            // nothing to do
+            break;
+
         default:
             REPORT_MISSING(renderer.current_backend);
             break;
@@ -126,6 +136,10 @@ COMMAND_SET_STATE(uniform_buffer) {
         vulkan::set_uniform_buffer(*reinterpret_cast<vulkan::VKContext *>(render_context), program, is_vertex, block_num, size, data);
         break;
 
+    case Backend::Null:
+        null::set_uniform_buffer(dynamic_cast<null::NullState &>(renderer), *reinterpret_cast<null::NullContext *>(render_context), is_vertex, block_num, size, data);
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         return;
@@ -182,6 +196,10 @@ COMMAND_SET_STATE(viewport) {
             vulkan::sync_viewport_real(*reinterpret_cast<vulkan::VKContext *>(render_context), xOffset, yOffset, zOffset, xScale, yScale, zScale);
             break;
 
+        case Backend::Null:
+            // nothing to do
+            break;
+
         default:
             REPORT_MISSING(renderer.current_backend);
             break;
@@ -203,6 +221,10 @@ COMMAND_SET_STATE(viewport) {
             vulkan::sync_viewport_flat(*reinterpret_cast<vulkan::VKContext *>(render_context));
             break;
 
+        case Backend::Null:
+            // nothing to do
+            break;
+
         default:
             REPORT_MISSING(renderer.current_backend);
             break;
@@ -222,6 +244,10 @@ COMMAND_SET_STATE(viewport) {
             vulkan::sync_clipping(*reinterpret_cast<vulkan::VKContext *>(render_context));
             break;
 
+        case Backend::Null:
+            // nothing to do
+            break;
+
         default:
             REPORT_MISSING(renderer.current_backend);
             break;
@@ -249,6 +275,10 @@ COMMAND_SET_STATE(depth_bias) {
             vulkan::sync_depth_bias(*reinterpret_cast<vulkan::VKContext *>(render_context));
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -275,6 +305,10 @@ COMMAND_SET_STATE(depth_func) {
         vulkan::refresh_pipeline(*reinterpret_cast<vulkan::VKContext *>(render_context));
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -300,6 +334,10 @@ COMMAND_SET_STATE(depth_write_enable) {
         vulkan::refresh_pipeline(*reinterpret_cast<vulkan::VKContext *>(render_context));
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -324,6 +362,10 @@ COMMAND_SET_STATE(polygon_mode) {
         vulkan::refresh_pipeline(*reinterpret_cast<vulkan::VKContext *>(render_context));
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -346,6 +388,10 @@ COMMAND_SET_STATE(point_line_width) {
         vulkan::refresh_pipeline(*reinterpret_cast<vulkan::VKContext *>(render_context));
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -387,6 +433,10 @@ COMMAND_SET_STATE(stencil_func) {
         vulkan::sync_stencil_func(dynamic_cast<vulkan::VKContext &>(*render_context), !is_front);
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -412,6 +462,10 @@ COMMAND_SET_STATE(stencil_ref) {
         vulkan::sync_stencil_func(dynamic_cast<vulkan::VKContext &>(*render_context), !is_front);
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -434,6 +488,10 @@ COMMAND_SET_STATE(texture) {
             config, base_path, title_id);
         break;
 
+    case Backend::Null:
+        null::sync_texture(dynamic_cast<null::NullState &>(renderer), *reinterpret_cast<null::NullContext *>(render_context), mem, texture_index, texture);
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -457,6 +515,10 @@ COMMAND_SET_STATE(two_sided) {
         vulkan::sync_stencil_func(dynamic_cast<vulkan::VKContext &>(*render_context), true);
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
@@ -476,6 +538,10 @@ COMMAND_SET_STATE(cull_mode) {
         vulkan::refresh_pipeline(*reinterpret_cast<vulkan::VKContext *>(render_context));
         break;
 
+    case Backend::Null:
+        // nothing to do
+        break;
+
     default:
         REPORT_MISSING(renderer.current_backend);
         break;
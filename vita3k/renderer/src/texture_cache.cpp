@@ -25,6 +25,7 @@
 #include <mem/ptr.h>
 #include <util/align.h>
 #include <util/log.h>
+#include <util/metrics.h>
 
 #include <algorithm> // find
 #include <cstring> // memcmp
@@ -420,7 +421,8 @@ uint16_t get_upload_mip(const uint16_t true_mip, const uint16_t width, const uin
 void upload_bound_texture(const TextureCacheState &cache, const SceGxmTexture &gxm_texture, const MemState &mem) {
     R_PROFILE(__func__);
 
-    bool is_vulkan = (*cache.backend == Backend::Vulkan);
+    // the null renderer decodes like the vulkan one, which needs the most work on the CPU
+    bool is_vulkan = (*cache.backend != Backend::OpenGL);
 
     const SceGxmTextureFormat fmt = gxm::get_format(&gxm_texture);
     const SceGxmTextureBaseFormat base_format = gxm::get_base_format(fmt);
@@ -661,7 +663,7 @@ void upload_bound_texture(const TextureCacheState &cache, const SceGxmTexture &g
             case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC1: {
                 yuv_texture_pixels.resize(width * height * 3);
                 renderer::texture::yuv420_texture_to_rgb(yuv_texture_pixels.data(),
-                    reinterpret_cast<const uint8_t *>(pixels), width, height);
+                    reinterpret_cast<const uint8_t *>(pixels), width, height, fmt);
                 pixels = yuv_texture_pixels.data();
                 pixels_per_stride = width;
                 bpp = 24;
@@ -748,6 +750,8 @@ void cache_and_bind_texture(TextureCacheState &cache, const SceGxmTexture &gxm_t
         }
     }
 
+    metrics::add(cached_gxm_texture_index == -1 ? metrics::TEXTURE_CACHE_MISSES : metrics::TEXTURE_CACHE_HITS);
+
     TextureCacheInfo *info;
     if (cached_gxm_texture_index == -1) {
         // Texture not found in cache.
@@ -800,6 +804,7 @@ void cache_and_bind_texture(TextureCacheState &cache, const SceGxmTexture &gxm_t
         cache.configure_texture_callback(cache, &gxm_texture);
     }
     if (upload) {
+        metrics::add(metrics::TEXTURE_UPLOADS);
         upload_bound_texture(cache, gxm_texture, mem);
         if (!info->use_hash) {
             info->dirty = false;
@@ -17,64 +17,39 @@
 
 #include <renderer/functions.h>
 
+#include <codec/colorspace.h>
 #include <util/log.h>
 
-#include <algorithm>
-
-extern "C" {
-#include <libswscale/swscale.h>
-}
-
 namespace renderer::texture {
 
-static SwsContext *s_render_sws_context{};
-static size_t res[2] = { 0, 0 };
-SwsContext *get_sws_context(size_t width, size_t height) {
-    bool recreate = false;
-    if (res[0] != width || res[1] != height) {
-        recreate = true;
-        res[0] = width;
-        res[1] = height;
-    } else if (s_render_sws_context == nullptr) {
-        recreate = true;
+// P2 formats have a plane with interleaved chroma, P3 formats have a plane per chroma component.
+// CSC0 uses the BT.601 matrix and CSC1 the BT.709 one.
+void yuv420_texture_to_rgb(uint8_t *dst, const uint8_t *src, size_t width, size_t height, SceGxmTextureFormat format) {
+    ColorspaceKey key;
+    key.width = static_cast<uint32_t>(width);
+    key.height = static_cast<uint32_t>(height);
+    key.dst = ColorspaceFormat::RGB24;
+
+    switch (format) {
+    case SCE_GXM_TEXTURE_FORMAT_YUV420P2_CSC0:
+    case SCE_GXM_TEXTURE_FORMAT_YUV420P2_CSC1: key.src = ColorspaceFormat::NV12; break;
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P2_CSC0:
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P2_CSC1: key.src = ColorspaceFormat::NV21; break;
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC0:
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC1: key.src = ColorspaceFormat::YVU420P; break;
+    default: key.src = ColorspaceFormat::YUV420P; break;
     }
 
-    if (recreate) {
-        if (s_render_sws_context != nullptr) {
-            sws_freeContext(s_render_sws_context);
-            s_render_sws_context = nullptr;
-        }
-        s_render_sws_context = sws_getContext(width, height, AV_PIX_FMT_YUV420P, width, height, AV_PIX_FMT_RGB24,
-            0, nullptr, nullptr, nullptr);
+    switch (format) {
+    case SCE_GXM_TEXTURE_FORMAT_YUV420P2_CSC1:
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P2_CSC1:
+    case SCE_GXM_TEXTURE_FORMAT_YUV420P3_CSC1:
+    case SCE_GXM_TEXTURE_FORMAT_YVU420P3_CSC1: key.matrix = ColorMatrix::BT709; break;
+    default: key.matrix = ColorMatrix::BT601; break;
     }
-    return s_render_sws_context;
-}
-
-void yuv420_texture_to_rgb(uint8_t *dst, const uint8_t *src, size_t width, size_t height) {
-    SwsContext *context = get_sws_context(width, height);
-    assert(context);
-
-    const uint8_t *slices[] = {
-        &src[0], // Y Slice
-        &src[width * height], // U Slice
-        &src[width * height + width * height / 4], // V Slice
-    };
-
-    int strides[] = {
-        static_cast<int>(width),
-        static_cast<int>(width / 2),
-        static_cast<int>(width / 2),
-    };
-
-    uint8_t *dst_slices[] = {
-        dst,
-    };
-
-    const int dst_strides[] = {
-        static_cast<int>(width * 3),
-    };
 
-    int error = sws_scale(context, slices, strides, 0, height, dst_slices, dst_strides);
-    assert(error == height);
+    const ColorspaceImage image = make_packed_yuv_image(key.src, src, key.width, key.height);
+    if (!convert_colorspace(key, image, dst, static_cast<int>(width * 3)))
+        LOG_ERROR("Failed to convert yuv texture of format {}.", log_hex(format));
 }
 } // namespace renderer::texture
@@ -26,11 +26,13 @@
 #include <gxm/functions.h>
 #include <gxm/types.h>
 #include <renderer/shaders.h>
+#include <shader/spirv_optimizer.h>
 #include <shader/spirv_recompiler.h>
 
 #include <util/align.h>
 #include <util/fs.h>
 #include <util/log.h>
+#include <util/metrics.h>
 
 namespace renderer::vulkan {
 PipelineCache::PipelineCache(VKState &state)
@@ -247,7 +249,7 @@ vk::PipelineShaderStageCreateInfo PipelineCache::retrieve_shader(const SceGxmPro
     const std::string hash_text = hex_string(hash);
 
     LOG_INFO("Generating vulkan spv shader {}", hash_text.data());
-    const std::string shader_version = fmt::format("vk{}", shader::CURRENT_VERSION);
+    const std::string shader_version = fmt::format("vk{}{}", shader::CURRENT_VERSION, shader::get_spirv_optimization_suffix(state.features.spirv_optimization_level));
 
     // update shader hints
     current_context->shader_hints.color_format = current_context->record.color_surface.colorFormat;
@@ -262,6 +264,7 @@ vk::PipelineShaderStageCreateInfo PipelineCache::retrieve_shader(const SceGxmPro
 
     vk::ShaderModule shader = current_context->state.device.createShaderModule(shader_info);
     shaders[hash] = shader;
+    metrics::add(metrics::SHADER_COMPILES);
 
     // Save shader cache haches
     // vertex and fragment shaders are not linked together so no need to associate them
@@ -623,6 +626,7 @@ vk::Pipeline PipelineCache::retrieve_pipeline(VKContext &context, SceGxmPrimitiv
     };
 
     const auto result = state.device.createGraphicsPipeline(pipeline_cache, pipeline_info);
+    metrics::add(metrics::PIPELINE_COMPILES);
     if (result.result != vk::Result::eSuccess) {
         LOG_CRITICAL("Failed to create pipeline.");
         return nullptr;
@@ -645,7 +649,7 @@ bool PipelineCache::precompile_shader(const Sha256Hash &hash) {
 
     Sha256Hash shader_hash;
     memcpy(shader_hash.data(), hash.data(), sizeof(Sha256Hash));
-    const std::string hash_ver = fmt::format("vk{}-{}", shader::CURRENT_VERSION, hex_string(shader_hash));
+    const std::string hash_ver = fmt::format("vk{}{}-{}", shader::CURRENT_VERSION, shader::get_spirv_optimization_suffix(state.features.spirv_optimization_level), hex_string(shader_hash));
 
     const std::vector<uint32_t> source = renderer::pre_load_shader_spirv(hash_ver.c_str(), "spv", state.base_path, state.title_id, state.self_name);
 
@@ -659,6 +663,7 @@ bool PipelineCache::precompile_shader(const Sha256Hash &hash) {
 
     vk::ShaderModule shader = state.device.createShaderModule(shader_info);
     shaders[hash] = shader;
+    metrics::add(metrics::SHADER_COMPILES);
 
     return true;
 }
@@ -0,0 +1,187 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+// Replay a capture written with --gxm-capture as fast as possible and print the time spent by the renderer on each frame:
+// gxm-replay <capture file> [--backend Null|Vulkan|OpenGL] [--base-path <dir>] [--shader-cache] [--summary]
+
+#include <config/state.h>
+#include <mem/functions.h>
+#include <mem/state.h>
+#include <mem/tracker.h>
+#include <renderer/capture.h>
+#include <renderer/functions.h>
+#include <renderer/state.h>
+#include <util/metrics.h>
+#include <util/string_utils.h>
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct FrameStats {
+    std::uint64_t total_ns;
+    metrics::Frame metrics;
+};
+
+static void print_usage() {
+    std::printf("Usage: gxm-replay <capture file> [--backend Null|Vulkan|OpenGL] [--base-path <dir>] [--shader-cache] [--summary]\n");
+}
+
+static double percentile_ms(std::vector<std::uint64_t> values, double percentile) {
+    std::sort(values.begin(), values.end());
+    const std::size_t index = std::min(values.size() - 1, static_cast<std::size_t>(percentile * values.size()));
+    return values[index] / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    const char *capture_path = nullptr;
+    std::string backend_name = "Null";
+    std::string base_path = "./";
+    bool shader_cache = false;
+    bool summary = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--backend") == 0 && i + 1 < argc)
+            backend_name = argv[++i];
+        else if (std::strcmp(argv[i], "--base-path") == 0 && i + 1 < argc)
+            base_path = argv[++i];
+        else if (std::strcmp(argv[i], "--shader-cache") == 0)
+            shader_cache = true;
+        else if (std::strcmp(argv[i], "--summary") == 0)
+            summary = true;
+        else if (!capture_path && argv[i][0] != '-')
+            capture_path = argv[i];
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (!capture_path) {
+        print_usage();
+        return 1;
+    }
+
+    renderer::Backend backend;
+    std::uint32_t window_flags = SDL_WINDOW_HIDDEN;
+    const std::string backend_upper = string_utils::toupper(backend_name);
+    if (backend_upper == "NULL") {
+        backend = renderer::Backend::Null;
+    } else if (backend_upper == "VULKAN") {
+        backend = renderer::Backend::Vulkan;
+        window_flags |= SDL_WINDOW_VULKAN;
+    } else if (backend_upper == "OPENGL") {
+        backend = renderer::Backend::OpenGL;
+        window_flags |= SDL_WINDOW_OPENGL;
+    } else {
+        std::printf("Unknown backend %s\n", backend_name.c_str());
+        return 1;
+    }
+
+    MemState mem;
+    if (!init(mem, WriteTrackerType::AUTO)) {
+        std::printf("Failed to initialize the guest memory\n");
+        return 1;
+    }
+
+    // the other renderers need a window even if nothing is presented
+    std::unique_ptr<SDL_Window, decltype(&SDL_DestroyWindow)> window(nullptr, SDL_DestroyWindow);
+    if (backend != renderer::Backend::Null) {
+        if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+            std::printf("Failed to initialize SDL: %s\n", SDL_GetError());
+            return 1;
+        }
+        window.reset(SDL_CreateWindow("gxm-replay", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, DEFAULT_RES_WIDTH, DEFAULT_RES_HEIGHT, window_flags));
+        if (!window) {
+            std::printf("Failed to create the window: %s\n", SDL_GetError());
+            return 1;
+        }
+    }
+
+    // the same shaders are translated on every run unless the cache is asked for
+    Config config;
+    config.shader_cache = shader_cache;
+
+    std::unique_ptr<renderer::State> state;
+    if (!renderer::init(window.get(), state, backend, config, base_path.c_str())) {
+        std::printf("Failed to create the %s renderer\n", backend_name.c_str());
+        return 1;
+    }
+
+    {
+        // destroyed before the renderer
+        renderer::capture::Replay replay;
+        if (!replay.load(capture_path))
+            return 1;
+
+        state->base_path = base_path.c_str();
+        state->title_id = replay.get_title_id().c_str();
+        state->self_name = replay.get_self_name().c_str();
+        state->res_multiplier = 1;
+        state->disable_surface_sync = false;
+        state->should_display = false;
+        state->context = nullptr;
+
+        // the counters of the initialization are not reported with the first frame
+        metrics::end_frame();
+
+        std::vector<FrameStats> frames;
+        while (true) {
+            const auto start = std::chrono::steady_clock::now();
+            const bool frame_ended = replay.replay_frame(*state, state->features, mem, config);
+            const std::uint64_t total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            metrics::end_frame();
+            if (!frame_ended)
+                break;
+
+            frames.push_back({ total_ns, metrics::get_last_frame() });
+            if (!summary) {
+                const metrics::Frame &frame = frames.back().metrics;
+                std::printf("frame %5zu: render %8.3f ms, total %8.3f ms, %5" PRIu64 " draws, %3" PRIu64 " texture uploads, %3" PRIu64 " shader compiles\n",
+                    frames.size() - 1, frame.get(metrics::RENDER_TIME) / 1e6, total_ns / 1e6, frame.get(metrics::DRAWS),
+                    frame.get(metrics::TEXTURE_UPLOADS), frame.get(metrics::SHADER_COMPILES));
+            }
+        }
+
+        state->preclose_action();
+
+        if (frames.empty()) {
+            std::printf("No frame in the capture\n");
+            return 1;
+        }
+
+        std::vector<std::uint64_t> render_times;
+        std::uint64_t render_ns = 0;
+        std::uint64_t total_ns = 0;
+        for (const FrameStats &frame : frames) {
+            render_times.push_back(frame.metrics.get(metrics::RENDER_TIME));
+            render_ns += render_times.back();
+            total_ns += frame.total_ns;
+        }
+
+        std::printf("%s: %zu frames replayed on %s in %.3f ms\n", replay.get_title_id().c_str(), frames.size(), backend_name.c_str(), total_ns / 1e6);
+        std::printf("render time per frame: mean %.3f ms, median %.3f ms, p99 %.3f ms, max %.3f ms\n", render_ns / 1e6 / frames.size(),
+            percentile_ms(render_times, 0.5), percentile_ms(render_times, 0.99), percentile_ms(render_times, 1.0));
+    }
+
+    return 0;
+}
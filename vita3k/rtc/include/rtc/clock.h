@@ -0,0 +1,73 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+
+enum class ClockMode {
+    // the guest time follows the host time
+    REAL_TIME,
+    // the guest time runs scale times faster than the host time (fast-forward)
+    SCALED,
+    // the guest time jumps to the next deadline as soon as no guest thread is running
+    VIRTUAL,
+};
+
+ClockMode get_clock_mode(const std::string &name);
+const char *get_clock_mode_name(ClockMode mode);
+
+/**
+ * \brief Time source of the emulated console, in microseconds since init was called.
+ *
+ * Every guest-visible time (rtc ticks, system time, timers, thread delays and vblanks) is read from it.
+ * In virtual mode the time still flows with the host time while a guest thread is running,
+ * and the time where all of them are blocked waiting for a deadline is skipped.
+ */
+class EmuClock {
+public:
+    void init(ClockMode mode, float scale);
+
+    ClockMode get_mode() const { return mode; }
+    std::uint64_t now() const;
+
+    // The caller must be counted as a runner, it is not counted while sleeping
+    void sleep_until(std::uint64_t deadline);
+    void sleep_for(std::uint64_t duration);
+
+    // Runners are the threads which can still make the guest progress, only used in virtual mode
+    void add_runner();
+    void remove_runner();
+
+private:
+    ClockMode mode = ClockMode::REAL_TIME;
+    double scale = 1.0;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    // guest time skipped by the virtual mode
+    std::atomic<std::uint64_t> skipped = 0;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    int runner_count = 0;
+    std::multiset<std::uint64_t> deadlines;
+};
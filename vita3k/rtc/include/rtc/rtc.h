@@ -23,6 +23,8 @@
 #include <cstdint>
 #include <string>
 
+class EmuClock;
+
 // This is the # of microseconds between January 1, 0001 and January 1, 1970.
 // Grabbed from JPSCP
 static constexpr auto RTC_OFFSET = 62135596800000000ULL;
@@ -92,8 +94,9 @@ inline time_t rtc_timegm(struct tm *tm) {
 }
 #endif
 
+// Ticks of the host date, to use as the base of the clock when it is initialized
 std::uint64_t rtc_base_ticks();
-std::uint64_t rtc_get_ticks(uint64_t base_tick);
+std::uint64_t rtc_get_ticks(const EmuClock &clock, uint64_t base_tick);
 void __RtcPspTimeToTm(tm *val, const SceDateTime *pt);
 void __RtcTicksToPspTime(SceDateTime *t, std::uint64_t ticks);
 std::uint64_t __RtcPspTimeToTicks(const SceDateTime *pt);
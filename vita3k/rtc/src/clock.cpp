@@ -0,0 +1,114 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <rtc/clock.h>
+
+#include <util/log.h>
+
+#include <thread>
+
+ClockMode get_clock_mode(const std::string &name) {
+    if (name == "Scaled")
+        return ClockMode::SCALED;
+    if (name == "Virtual")
+        return ClockMode::VIRTUAL;
+    return ClockMode::REAL_TIME;
+}
+
+const char *get_clock_mode_name(ClockMode mode) {
+    switch (mode) {
+    case ClockMode::REAL_TIME: return "Real-time";
+    case ClockMode::SCALED: return "Scaled";
+    case ClockMode::VIRTUAL: return "Virtual";
+    }
+    return "Unknown";
+}
+
+void EmuClock::init(ClockMode mode, float scale) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    if (mode == ClockMode::SCALED && scale <= 0.0f) {
+        LOG_WARN("Invalid clock scale {}, using the real time", scale);
+        mode = ClockMode::REAL_TIME;
+    }
+
+    this->mode = mode;
+    this->scale = (mode == ClockMode::SCALED) ? scale : 1.0;
+    origin = std::chrono::steady_clock::now();
+    skipped = 0;
+    runner_count = 0;
+    deadlines.clear();
+}
+
+std::uint64_t EmuClock::now() const {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+    return static_cast<std::uint64_t>(elapsed * scale) + skipped.load();
+}
+
+void EmuClock::sleep_until(std::uint64_t deadline) {
+    if (mode != ClockMode::VIRTUAL) {
+        const std::uint64_t current = now();
+        if (deadline > current)
+            std::this_thread::sleep_for(std::chrono::microseconds(static_cast<std::uint64_t>((deadline - current) / scale)));
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    const auto deadline_it = deadlines.insert(deadline);
+    if (--runner_count <= 0)
+        // a sleeper with an earlier deadline may be able to skip now
+        cond.notify_all();
+
+    while (true) {
+        const std::uint64_t current = now();
+        if (current >= deadline)
+            break;
+
+        if (runner_count <= 0 && *deadlines.begin() == deadline) {
+            // every guest thread is blocked, nothing can happen before this deadline
+            skipped += deadline - current;
+            cond.notify_all();
+            break;
+        }
+
+        cond.wait_for(lock, std::chrono::microseconds(deadline - current));
+    }
+
+    deadlines.erase(deadline_it);
+    // counted right away, so no other sleeper skips time before this one runs again
+    runner_count++;
+}
+
+void EmuClock::sleep_for(std::uint64_t duration) {
+    sleep_until(now() + duration);
+}
+
+void EmuClock::add_runner() {
+    if (mode != ClockMode::VIRTUAL)
+        return;
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    runner_count++;
+}
+
+void EmuClock::remove_runner() {
+    if (mode != ClockMode::VIRTUAL)
+        return;
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    if (--runner_count <= 0 && !deadlines.empty())
+        cond.notify_all();
+}
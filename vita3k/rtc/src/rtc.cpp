@@ -15,22 +15,17 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
+#include <rtc/clock.h>
 #include <rtc/rtc.h>
 
 #include <util/log.h>
 
-std::uint64_t rtc_ticks_since_epoch() {
-    const auto now = std::chrono::high_resolution_clock::now();
-    const auto now_timepoint = std::chrono::time_point_cast<VitaClocks>(now);
-    return now_timepoint.time_since_epoch().count();
-}
-
 std::uint64_t rtc_base_ticks() {
-    return RTC_OFFSET + std::time(nullptr) * VITA_CLOCKS_PER_SEC - rtc_ticks_since_epoch();
+    return RTC_OFFSET + std::time(nullptr) * VITA_CLOCKS_PER_SEC;
 }
 
-std::uint64_t rtc_get_ticks(uint64_t base_ticks) {
-    return base_ticks + rtc_ticks_since_epoch();
+std::uint64_t rtc_get_ticks(const EmuClock &clock, uint64_t base_ticks) {
+    return base_ticks + clock.now();
 }
 
 // The following functions are from PPSSPP
@@ -0,0 +1,125 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <rtc/clock.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+static std::uint64_t host_elapsed_us(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+TEST(clock, mode_names) {
+    EXPECT_EQ(get_clock_mode("Real-time"), ClockMode::REAL_TIME);
+    EXPECT_EQ(get_clock_mode("Scaled"), ClockMode::SCALED);
+    EXPECT_EQ(get_clock_mode("Virtual"), ClockMode::VIRTUAL);
+    EXPECT_EQ(get_clock_mode("unknown"), ClockMode::REAL_TIME);
+    EXPECT_STREQ(get_clock_mode_name(ClockMode::VIRTUAL), "Virtual");
+}
+
+TEST(clock, real_time_sleeps) {
+    EmuClock clock;
+    clock.init(ClockMode::REAL_TIME, 1.0f);
+
+    const auto start = std::chrono::steady_clock::now();
+    clock.sleep_for(20'000);
+    EXPECT_GE(clock.now(), 20'000u);
+    EXPECT_GE(host_elapsed_us(start), 20'000u);
+}
+
+TEST(clock, scaled_time_runs_faster) {
+    EmuClock clock;
+    clock.init(ClockMode::SCALED, 4.0f);
+
+    const auto start = std::chrono::steady_clock::now();
+    clock.sleep_for(200'000);
+    EXPECT_GE(clock.now(), 200'000u);
+    EXPECT_LT(host_elapsed_us(start), 200'000u);
+}
+
+TEST(clock, virtual_time_skips_when_nothing_runs) {
+    EmuClock clock;
+    clock.init(ClockMode::VIRTUAL, 1.0f);
+    clock.add_runner();
+
+    // one minute of guest time, without waiting for it
+    const auto start = std::chrono::steady_clock::now();
+    clock.sleep_for(60'000'000);
+    EXPECT_GE(clock.now(), 60'000'000u);
+    EXPECT_LT(host_elapsed_us(start), 10'000'000u);
+    clock.remove_runner();
+}
+
+TEST(clock, virtual_time_waits_for_the_runners) {
+    EmuClock clock;
+    clock.init(ClockMode::VIRTUAL, 1.0f);
+
+    // this thread stands for a guest thread which is still running
+    clock.add_runner();
+
+    std::atomic<bool> woken = false;
+    std::thread sleeper([&] {
+        clock.add_runner();
+        clock.sleep_for(60'000'000);
+        woken = true;
+        clock.remove_runner();
+    });
+
+    std::this_thread::sleep_for(50ms);
+    EXPECT_FALSE(woken.load());
+    EXPECT_LT(clock.now(), 60'000'000u);
+
+    clock.remove_runner();
+    sleeper.join();
+    EXPECT_TRUE(woken.load());
+    EXPECT_GE(clock.now(), 60'000'000u);
+}
+
+TEST(clock, virtual_sleepers_wake_in_order) {
+    EmuClock clock;
+    clock.init(ClockMode::VIRTUAL, 1.0f);
+
+    std::mutex order_mutex;
+    std::vector<int> order;
+    std::vector<std::thread> sleepers;
+    // all counted before any of them sleeps
+    for (int i = 0; i < 3; i++)
+        clock.add_runner();
+    for (int i = 3; i > 0; i--) {
+        sleepers.emplace_back([&, i] {
+            clock.sleep_until(i * 10'000'000ull);
+            {
+                const std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(i);
+            }
+            clock.remove_runner();
+        });
+    }
+
+    for (auto &sleeper : sleepers)
+        sleeper.join();
+    EXPECT_EQ(order, (std::vector<int>{ 1, 2, 3 }));
+    EXPECT_GE(clock.now(), 30'000'000u);
+}
@@ -0,0 +1,56 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <shader/usse_translator_types.h>
+
+#include <cstddef>
+#include <string>
+
+namespace shader {
+
+// Optimization levels applied on the SPIR-V generated by the recompiler:
+// 0: the module is left untouched
+// 1: unused functions, unused or write-only private/function variables (register banks) and dead instructions are removed
+// 2: same as 1, and loads are forwarded from a previous store or load to the same location in the same block,
+//    which also reuses the first load of a uniform. Uniforms are not folded to constants, their values are only known at draw time.
+static constexpr int MAX_SPIRV_OPTIMIZATION_LEVEL = 2;
+
+struct SpirvOptimizationReport {
+    std::size_t instructions_before = 0;
+    std::size_t instructions_after = 0;
+    std::size_t words_before = 0;
+    std::size_t words_after = 0;
+    std::size_t removed_variables = 0;
+    std::size_t removed_functions = 0;
+    std::size_t forwarded_loads = 0;
+
+    std::string to_string() const;
+};
+
+/**
+ * \brief Run the post-translation optimization passes on a SPIR-V module.
+ *
+ * The module is modified in place, nothing is done if level is 0.
+ */
+SpirvOptimizationReport optimize_spirv(usse::SpirvCode &spirv, int level);
+
+// Suffix added to the shader cache version so each optimization level has its own cache
+std::string get_spirv_optimization_suffix(int level);
+
+} // namespace shader
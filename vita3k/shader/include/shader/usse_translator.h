@@ -831,6 +831,8 @@ struct USSERecompiler final {
     const std::uint64_t *inst;
     std::size_t count;
     spv::Builder &b;
+    // Must be declared before the visitor, which already loads registers in its constructor
+    RegisterUsage register_usage;
     USSETranslatorVisitor visitor;
     std::uint64_t cur_instr;
     usse::USSEOffset cur_pc;
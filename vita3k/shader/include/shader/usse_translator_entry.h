@@ -36,6 +36,7 @@ namespace shader {
 namespace usse {
 struct SpirvShaderParameters;
 struct NonDependentTextureQueryCallInfo;
+struct RegisterUsage;
 
 namespace utils {
 struct SpirvUtilFunctions;
@@ -43,7 +44,8 @@ struct SpirvUtilFunctions;
 
 using NonDependentTextureQueryCallInfos = std::vector<NonDependentTextureQueryCallInfo>;
 
-void convert_gxp_usse_to_spirv(spv::Builder &b, const SceGxmProgram &program, const FeatureState &features, const SpirvShaderParameters &parameters, utils::SpirvUtilFunctions &utils,
+// Returns the registers read by the translated program
+RegisterUsage convert_gxp_usse_to_spirv(spv::Builder &b, const SceGxmProgram &program, const FeatureState &features, const SpirvShaderParameters &parameters, utils::SpirvUtilFunctions &utils,
     spv::Function *begin_hook_func, spv::Function *end_hook_func, const NonDependentTextureQueryCallInfos &queries, const uint32_t render_info_id);
 
 } // namespace usse
@@ -19,8 +19,11 @@
 
 #include <shader/usse_types.h>
 
+#include <algorithm>
+#include <bitset>
 #include <map>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace spv {
@@ -46,6 +49,72 @@ struct SamplerInfo {
 };
 using SamplerMap = std::unordered_map<std::uint32_t, SamplerInfo>;
 
+// Registers read by the program body, recorded while it is translated.
+// Each bit is a vec4 slot of the corresponding bank array.
+struct RegisterUsage {
+    static constexpr std::size_t MAX_VEC4_COUNT = 32;
+    using BankUsage = std::bitset<MAX_VEC4_COUNT>;
+
+    BankUsage ins_read;
+    BankUsage uniforms_read;
+    BankUsage temps_read;
+    BankUsage outs_read;
+
+    const BankUsage *get_bank_usage(RegisterBank bank) const {
+        switch (bank) {
+        case RegisterBank::PRIMATTR: return &ins_read;
+        case RegisterBank::SECATTR: return &uniforms_read;
+        case RegisterBank::TEMP: return &temps_read;
+        case RegisterBank::OUTPUT: return &outs_read;
+        default: return nullptr;
+        }
+    }
+
+    BankUsage *get_bank_usage(RegisterBank bank) {
+        return const_cast<BankUsage *>(std::as_const(*this).get_bank_usage(bank));
+    }
+
+    // Mark vec4 slots [first, last] as read
+    void mark_read(RegisterBank bank, int first, int last) {
+        BankUsage *usage = get_bank_usage(bank);
+        if (!usage)
+            return;
+
+        first = std::max(first, 0);
+        last = std::min(last, static_cast<int>(MAX_VEC4_COUNT) - 1);
+        for (int i = first; i <= last; i++)
+            usage->set(i);
+    }
+
+    // Used when the register is only known at runtime (indexed access)
+    void mark_all_read(RegisterBank bank) {
+        if (BankUsage *usage = get_bank_usage(bank))
+            usage->set();
+    }
+
+    bool is_read(RegisterBank bank, int vec4_idx) const {
+        const BankUsage *usage = get_bank_usage(bank);
+        return usage && vec4_idx >= 0 && vec4_idx < static_cast<int>(MAX_VEC4_COUNT) && usage->test(vec4_idx);
+    }
+
+    // Range [first, last) of the vec4 of a uniform block copied from sa register start that the program reads.
+    // Vec4 i of the block lands on registers [start + 4 * i, start + 4 * i + 3], so it can span two slots.
+    std::pair<int, int> get_uniform_read_range(int start, int vec4_count) const {
+        int first = vec4_count;
+        int last = -1;
+        for (int i = 0; i < vec4_count; i++) {
+            if (is_read(RegisterBank::SECATTR, (start + 4 * i) / 4) || is_read(RegisterBank::SECATTR, (start + 4 * i + 3) / 4)) {
+                first = std::min(first, i);
+                last = i;
+            }
+        }
+
+        if (last < first)
+            return { 0, 0 };
+        return { first, last + 1 };
+    }
+};
+
 struct SpirvShaderParameters {
     // Mapped to 'pa' (primary attribute) USSE registers
     // for vertex: vertex inputs (vertex attributes)
@@ -0,0 +1,629 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <shader/spirv_optimizer.h>
+
+#include <util/log.h>
+
+#include <SPIRV/GLSL.std.450.h>
+#include <SPIRV/spirv.hpp>
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace shader {
+
+// Size of the SPIR-V header, in words
+static constexpr std::size_t SPIRV_HEADER_SIZE = 5;
+
+struct SpirvInstruction {
+    std::uint32_t offset;
+    std::uint16_t opcode;
+    std::uint16_t word_count;
+    bool removed = false;
+};
+
+static bool is_annotation(const spv::Op op) {
+    switch (op) {
+    case spv::OpName:
+    case spv::OpMemberName:
+    case spv::OpDecorate:
+    case spv::OpMemberDecorate:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool is_access_chain(const spv::Op op) {
+    return op == spv::OpAccessChain || op == spv::OpInBoundsAccessChain;
+}
+
+// Variables forward_loads reasons about: the register banks, and the uniforms which the shader can't write to
+static bool is_tracked_storage(const spv::StorageClass storage) {
+    switch (storage) {
+    case spv::StorageClassPrivate:
+    case spv::StorageClassFunction:
+    case spv::StorageClassUniform:
+    case spv::StorageClassPushConstant:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool is_block_terminator(const spv::Op op) {
+    switch (op) {
+    case spv::OpBranch:
+    case spv::OpBranchConditional:
+    case spv::OpSwitch:
+    case spv::OpKill:
+    case spv::OpReturn:
+    case spv::OpReturnValue:
+    case spv::OpUnreachable:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Instructions with a result type and a result id where all the following words are ids
+static bool has_only_id_operands(const spv::Op op) {
+    if ((op >= spv::OpConvertFToU && op <= spv::OpBitcast) || (op >= spv::OpSNegate && op <= spv::OpDot)
+        || (op >= spv::OpAny && op <= spv::OpBitCount) || (op >= spv::OpDPdx && op <= spv::OpFwidthCoarse))
+        return true;
+
+    switch (op) {
+    case spv::OpAccessChain:
+    case spv::OpInBoundsAccessChain:
+    case spv::OpVectorExtractDynamic:
+    case spv::OpVectorInsertDynamic:
+    case spv::OpCompositeConstruct:
+    case spv::OpCopyObject:
+    case spv::OpSampledImage:
+    case spv::OpPhi:
+    case spv::OpFunctionCall:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * \brief Call f on the index (in words, relative to the instruction start) of every id operand of an instruction.
+ *
+ * The result type and the result id are not visited.
+ *
+ * \return False if the layout of the instruction is unknown, in which case nothing is visited and the caller
+ *         must assume any word of the instruction may be an id.
+ */
+template <typename F>
+static bool visit_id_operands(const spv::Op op, const std::uint16_t word_count, F &&f) {
+    const auto visit_range = [&](std::uint16_t first, std::uint16_t last) {
+        for (std::uint16_t i = first; i < std::min(last, word_count); i++)
+            f(i);
+    };
+
+    if (has_only_id_operands(op)) {
+        visit_range(3, word_count);
+        return true;
+    }
+
+    switch (op) {
+    case spv::OpLoad:
+    case spv::OpCompositeExtract:
+        visit_range(3, 4);
+        return true;
+    case spv::OpCompositeInsert:
+    case spv::OpVectorShuffle:
+        visit_range(3, 5);
+        return true;
+    case spv::OpExtInst:
+        visit_range(3, 4);
+        visit_range(5, word_count);
+        return true;
+    case spv::OpVariable:
+        visit_range(4, 5);
+        return true;
+    case spv::OpStore:
+        visit_range(1, 3);
+        return true;
+    case spv::OpBranch:
+    case spv::OpReturnValue:
+    case spv::OpSelectionMerge:
+    case spv::OpLine:
+        visit_range(1, 2);
+        return true;
+    case spv::OpLoopMerge:
+        visit_range(1, 3);
+        return true;
+    case spv::OpBranchConditional:
+        visit_range(1, 4);
+        return true;
+    case spv::OpFunction:
+        visit_range(4, 5);
+        return true;
+    case spv::OpLabel:
+    case spv::OpFunctionParameter:
+    case spv::OpFunctionEnd:
+    case spv::OpReturn:
+    case spv::OpKill:
+    case spv::OpUnreachable:
+    case spv::OpNoLine:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Instructions which can be removed without side effects if their result is not used
+static bool is_pure(const std::uint32_t *words, const spv::Op op) {
+    if (op == spv::OpFunctionCall)
+        return false;
+
+    if (op == spv::OpExtInst) {
+        // these two write to a pointer
+        const std::uint32_t ext_op = words[4];
+        return ext_op != GLSLstd450Modf && ext_op != GLSLstd450Frexp;
+    }
+
+    switch (op) {
+    case spv::OpLoad:
+    case spv::OpCompositeExtract:
+    case spv::OpCompositeInsert:
+    case spv::OpVectorShuffle:
+        return true;
+    default:
+        return has_only_id_operands(op);
+    }
+}
+
+class SpirvModule {
+public:
+    explicit SpirvModule(usse::SpirvCode &code)
+        : code(code) {
+        bound = code[3];
+        std::size_t offset = SPIRV_HEADER_SIZE;
+        while (offset < code.size()) {
+            const std::uint16_t word_count = code[offset] >> 16;
+            if (word_count == 0 || offset + word_count > code.size()) {
+                LOG_ERROR("Malformed SPIR-V instruction at word {}", offset);
+                valid = false;
+                return;
+            }
+
+            insts.push_back({ static_cast<std::uint32_t>(offset), static_cast<std::uint16_t>(code[offset] & 0xFFFF), word_count });
+            offset += word_count;
+        }
+    }
+
+    bool is_valid() const {
+        return valid;
+    }
+
+    std::size_t instruction_count() const {
+        return std::count_if(insts.begin(), insts.end(), [](const SpirvInstruction &inst) { return !inst.removed; });
+    }
+
+    // Returns the amount of removed functions
+    std::size_t remove_unused_functions();
+    // Returns the amount of removed variables
+    std::size_t remove_write_only_variables();
+    // Returns true if something was removed
+    bool remove_dead_instructions();
+    // Returns the amount of forwarded loads
+    std::size_t forward_loads();
+    // Remove names and decorations targeting an id which does not appear anymore in the module
+    void remove_dangling_annotations();
+
+    void write_back() {
+        usse::SpirvCode result(code.begin(), code.begin() + SPIRV_HEADER_SIZE);
+        result.reserve(code.size());
+        for (const SpirvInstruction &inst : insts) {
+            if (!inst.removed)
+                result.insert(result.end(), code.begin() + inst.offset, code.begin() + inst.offset + inst.word_count);
+        }
+        code = std::move(result);
+    }
+
+private:
+    usse::SpirvCode &code;
+    std::vector<SpirvInstruction> insts;
+    std::uint32_t bound = 0;
+    bool valid = true;
+
+    const std::uint32_t *words_of(const SpirvInstruction &inst) const {
+        return &code[inst.offset];
+    }
+
+    spv::Op op_of(const SpirvInstruction &inst) const {
+        return static_cast<spv::Op>(inst.opcode);
+    }
+
+    // Call f with every word which may be an id referenced by this instruction (the id defined by the instruction is not included if its layout is known)
+    template <typename F>
+    void visit_references(const SpirvInstruction &inst, F &&f) const {
+        const std::uint32_t *words = words_of(inst);
+        const bool known = visit_id_operands(op_of(inst), inst.word_count, [&](std::uint16_t index) { f(words[index]); });
+        if (!known) {
+            for (std::uint16_t i = 1; i < inst.word_count; i++) {
+                if (words[i] < bound)
+                    f(words[i]);
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> count_uses() const {
+        std::vector<std::uint32_t> uses(bound, 0);
+        for (const SpirvInstruction &inst : insts) {
+            if (inst.removed || is_annotation(op_of(inst)))
+                continue;
+            visit_references(inst, [&](std::uint32_t id) {
+                if (id < bound)
+                    uses[id]++;
+            });
+        }
+        return uses;
+    }
+};
+
+std::size_t SpirvModule::remove_unused_functions() {
+    const std::vector<std::uint32_t> uses = count_uses();
+    std::size_t removed_count = 0;
+
+    bool in_removed_function = false;
+    for (SpirvInstruction &inst : insts) {
+        if (inst.removed)
+            continue;
+
+        const spv::Op op = op_of(inst);
+        if (op == spv::OpFunction && uses[words_of(inst)[2]] == 0) {
+            in_removed_function = true;
+            removed_count++;
+        }
+
+        if (!in_removed_function)
+            continue;
+
+        inst.removed = true;
+        if (op == spv::OpFunctionEnd)
+            in_removed_function = false;
+    }
+
+    return removed_count;
+}
+
+std::size_t SpirvModule::remove_write_only_variables() {
+    // id of a variable or of an access chain on it -> id of the variable
+    std::unordered_map<std::uint32_t, std::uint32_t> roots;
+    for (const SpirvInstruction &inst : insts) {
+        const std::uint32_t *words = words_of(inst);
+        if (!inst.removed && op_of(inst) == spv::OpVariable && (words[3] == spv::StorageClassPrivate || words[3] == spv::StorageClassFunction))
+            roots.emplace(words[2], words[2]);
+    }
+
+    if (roots.empty())
+        return 0;
+
+    // access chains are always defined after their base, except when they come from an unreachable block, which is conservatively ignored
+    for (const SpirvInstruction &inst : insts) {
+        const std::uint32_t *words = words_of(inst);
+        if (!inst.removed && is_access_chain(op_of(inst))) {
+            const auto base = roots.find(words[3]);
+            if (base != roots.end())
+                roots.emplace(words[2], base->second);
+        }
+    }
+
+    std::unordered_set<std::uint32_t> read_roots;
+    const auto mark_read = [&](std::uint32_t id) {
+        const auto root = roots.find(id);
+        if (root != roots.end())
+            read_roots.insert(root->second);
+    };
+
+    for (const SpirvInstruction &inst : insts) {
+        const spv::Op op = op_of(inst);
+        if (inst.removed || is_annotation(op))
+            continue;
+
+        const std::uint32_t *words = words_of(inst);
+        if (op == spv::OpStore && roots.contains(words[1])) {
+            mark_read(words[2]);
+        } else if (is_access_chain(op) && roots.contains(words[2])) {
+            for (std::uint16_t i = 4; i < inst.word_count; i++)
+                mark_read(words[i]);
+        } else {
+            visit_references(inst, mark_read);
+        }
+    }
+
+    std::size_t removed_count = 0;
+    for (SpirvInstruction &inst : insts) {
+        if (inst.removed)
+            continue;
+
+        const spv::Op op = op_of(inst);
+        const std::uint32_t *words = words_of(inst);
+        std::uint32_t id;
+        if (op == spv::OpStore)
+            id = words[1];
+        else if (op == spv::OpVariable || is_access_chain(op))
+            id = words[2];
+        else
+            continue;
+
+        const auto root = roots.find(id);
+        if (root == roots.end() || read_roots.contains(root->second))
+            continue;
+
+        inst.removed = true;
+        if (op == spv::OpVariable)
+            removed_count++;
+    }
+
+    return removed_count;
+}
+
+bool SpirvModule::remove_dead_instructions() {
+    std::vector<std::uint32_t> uses = count_uses();
+    bool removed_any = false;
+
+    // going backward, so an instruction only used by dead instructions is removed in the same pass
+    for (auto it = insts.rbegin(); it != insts.rend(); ++it) {
+        SpirvInstruction &inst = *it;
+        const spv::Op op = op_of(inst);
+        const std::uint32_t *words = words_of(inst);
+        if (inst.removed || !is_pure(words, op) || uses[words[2]] != 0)
+            continue;
+
+        inst.removed = true;
+        removed_any = true;
+        visit_id_operands(op, inst.word_count, [&](std::uint16_t index) {
+            if (words[index] < bound && uses[words[index]] > 0)
+                uses[words[index]]--;
+        });
+    }
+
+    return removed_any;
+}
+
+std::size_t SpirvModule::forward_loads() {
+    // scalar constant id -> its value, two constants with the same value index the same element
+    std::unordered_map<std::uint32_t, std::uint64_t> constants;
+    // pointer id -> (variable, constant index values), only for pointers with a fully constant access chain
+    std::unordered_map<std::uint32_t, std::vector<std::uint64_t>> locations;
+    // pointer id -> variable, for all pointers
+    std::unordered_map<std::uint32_t, std::uint32_t> roots;
+    // ids which appear in an instruction we don't know the layout of, we can't replace them
+    std::unordered_set<std::uint32_t> opaque_ids;
+    // variables with a pointer used by something else than a load, a store or an access chain (copy, call, atomic...)
+    std::unordered_set<std::uint32_t> escaped_roots;
+    const auto mark_escaped = [&](std::uint32_t id) {
+        const auto root = roots.find(id);
+        if (root != roots.end())
+            escaped_roots.insert(root->second);
+    };
+
+    bool in_function = false;
+    for (const SpirvInstruction &inst : insts) {
+        if (inst.removed)
+            continue;
+
+        const spv::Op op = op_of(inst);
+        const std::uint32_t *words = words_of(inst);
+        if (op == spv::OpConstant && (inst.word_count == 4 || inst.word_count == 5)) {
+            const std::uint64_t high = inst.word_count == 5 ? words[4] : 0;
+            constants.emplace(words[2], (high << 32) | words[3]);
+        } else if (op == spv::OpVariable && is_tracked_storage(static_cast<spv::StorageClass>(words[3]))) {
+            roots.emplace(words[2], words[2]);
+            locations.emplace(words[2], std::vector<std::uint64_t>{ words[2] });
+        } else if (is_access_chain(op) && roots.contains(words[3])) {
+            roots.emplace(words[2], roots[words[3]]);
+            const auto base = locations.find(words[3]);
+            if (base == locations.end())
+                continue;
+
+            bool is_constant = true;
+            std::vector<std::uint64_t> location = base->second;
+            for (std::uint16_t i = 4; i < inst.word_count && is_constant; i++) {
+                const auto constant = constants.find(words[i]);
+                is_constant = constant != constants.end();
+                if (is_constant)
+                    location.push_back(constant->second);
+            }
+            if (is_constant)
+                locations.emplace(words[2], std::move(location));
+        } else if (!is_annotation(op)) {
+            const bool known = visit_id_operands(op, inst.word_count, [&](std::uint16_t index) {
+                if (!(op == spv::OpLoad && index == 3) && !(op == spv::OpStore && index == 1))
+                    mark_escaped(words[index]);
+            });
+            if (!known) {
+                for (std::uint16_t i = 1; i < inst.word_count; i++) {
+                    // loads only live in functions, literals from the global section can't be confused with them
+                    if (in_function)
+                        opaque_ids.insert(words[i]);
+                    mark_escaped(words[i]);
+                }
+            }
+        }
+
+        if (op == spv::OpFunction)
+            in_function = true;
+        else if (op == spv::OpFunctionEnd)
+            in_function = false;
+    }
+
+    std::erase_if(locations, [&](const auto &entry) { return escaped_roots.contains(entry.second[0]); });
+
+    // load result -> value it can be replaced with
+    std::unordered_map<std::uint32_t, std::uint32_t> replacements;
+    // location -> value currently stored there
+    std::map<std::vector<std::uint64_t>, std::uint32_t> known_values;
+
+    const auto overlaps = [](const std::vector<std::uint64_t> &a, const std::vector<std::uint64_t> &b) {
+        const std::size_t common = std::min(a.size(), b.size());
+        return std::equal(a.begin(), a.begin() + common, b.begin());
+    };
+    const auto invalidate_root = [&](std::uint32_t root) {
+        std::erase_if(known_values, [&](const auto &entry) { return entry.first[0] == root; });
+    };
+    const auto invalidate_location = [&](const std::vector<std::uint64_t> &location) {
+        std::erase_if(known_values, [&](const auto &entry) { return overlaps(entry.first, location); });
+    };
+
+    for (SpirvInstruction &inst : insts) {
+        if (inst.removed)
+            continue;
+
+        const spv::Op op = op_of(inst);
+        const std::uint32_t *words = words_of(inst);
+        if (op == spv::OpLabel || op == spv::OpFunctionCall || is_block_terminator(op)) {
+            // we only reason inside a block, and the callee may modify any private variable
+            known_values.clear();
+        } else if (op == spv::OpStore) {
+            const auto location = locations.find(words[1]);
+            if (location != locations.end()) {
+                invalidate_location(location->second);
+                if (!opaque_ids.contains(words[2]))
+                    known_values[location->second] = words[2];
+            } else if (roots.contains(words[1])) {
+                invalidate_root(roots[words[1]]);
+            }
+        } else if (op == spv::OpLoad) {
+            const auto location = locations.find(words[3]);
+            if (location == locations.end())
+                continue;
+
+            const auto value = known_values.find(location->second);
+            if (value != known_values.end() && !opaque_ids.contains(words[2])) {
+                replacements[words[2]] = value->second;
+            } else {
+                known_values[location->second] = words[2];
+            }
+        }
+    }
+
+    if (replacements.empty())
+        return 0;
+
+    const auto resolve = [&](std::uint32_t id) {
+        auto it = replacements.find(id);
+        while (it != replacements.end()) {
+            id = it->second;
+            it = replacements.find(id);
+        }
+        return id;
+    };
+
+    for (SpirvInstruction &inst : insts) {
+        const spv::Op op = op_of(inst);
+        if (inst.removed || is_annotation(op))
+            continue;
+
+        std::uint32_t *words = &code[inst.offset];
+        visit_id_operands(op, inst.word_count, [&](std::uint16_t index) {
+            words[index] = resolve(words[index]);
+        });
+    }
+
+    return replacements.size();
+}
+
+void SpirvModule::remove_dangling_annotations() {
+    std::vector<bool> referenced(bound, false);
+    for (const SpirvInstruction &inst : insts) {
+        if (inst.removed || is_annotation(op_of(inst)))
+            continue;
+        const std::uint32_t *words = words_of(inst);
+        for (std::uint16_t i = 1; i < inst.word_count; i++) {
+            if (words[i] < bound)
+                referenced[words[i]] = true;
+        }
+    }
+
+    for (SpirvInstruction &inst : insts) {
+        if (!inst.removed && is_annotation(op_of(inst)) && !referenced[words_of(inst)[1]])
+            inst.removed = true;
+    }
+}
+
+std::string SpirvOptimizationReport::to_string() const {
+    const auto percent = [](std::size_t before, std::size_t after) {
+        return before == 0 ? 0.0 : 100.0 * static_cast<double>(before - after) / static_cast<double>(before);
+    };
+
+    return fmt::format("instructions: {} -> {} ({:.1f}% less), words: {} -> {} ({:.1f}% less), removed variables: {}, removed functions: {}, forwarded loads: {}",
+        instructions_before, instructions_after, percent(instructions_before, instructions_after),
+        words_before, words_after, percent(words_before, words_after),
+        removed_variables, removed_functions, forwarded_loads);
+}
+
+SpirvOptimizationReport optimize_spirv(usse::SpirvCode &spirv, int level) {
+    SpirvOptimizationReport report;
+    report.words_before = spirv.size();
+    report.words_after = spirv.size();
+
+    if (level <= 0 || spirv.size() <= SPIRV_HEADER_SIZE || spirv[0] != spv::MagicNumber)
+        return report;
+
+    SpirvModule module(spirv);
+    if (!module.is_valid())
+        return report;
+
+    report.instructions_before = module.instruction_count();
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        if (level >= 2) {
+            const std::size_t forwarded = module.forward_loads();
+            report.forwarded_loads += forwarded;
+            changed |= forwarded > 0;
+        }
+
+        changed |= module.remove_dead_instructions();
+
+        const std::size_t removed_variables = module.remove_write_only_variables();
+        report.removed_variables += removed_variables;
+        changed |= removed_variables > 0;
+
+        const std::size_t removed_functions = module.remove_unused_functions();
+        report.removed_functions += removed_functions;
+        changed |= removed_functions > 0;
+    }
+
+    module.remove_dangling_annotations();
+
+    report.instructions_after = module.instruction_count();
+    module.write_back();
+    report.words_after = spirv.size();
+
+    return report;
+}
+
+std::string get_spirv_optimization_suffix(int level) {
+    if (level <= 0)
+        return "";
+
+    return fmt::format("-o{}", std::min(level, MAX_SPIRV_OPTIMIZATION_LEVEL));
+}
+
+} // namespace shader
@@ -25,6 +25,7 @@
 #include <gxm/types.h>
 #include <shader/gxp_parser.h>
 #include <shader/profile.h>
+#include <shader/spirv_optimizer.h>
 #include <shader/usse_translator_entry.h>
 #include <shader/usse_translator_types.h>
 #include <shader/usse_utilities.h>
@@ -116,6 +117,9 @@ struct TranslationState {
     bool is_vulkan = false;
     spv::ImageFormat image_storage_format = spv::ImageFormat::ImageFormatUnknown;
     const Hints *hints;
+    // Filled once the program body is translated, so that only the registers it reads are copied
+    spv::Function *uniform_copy_func = nullptr;
+    std::vector<UniformBuffer> uniform_buffers;
 };
 
 struct VertexProgramOutputProperties {
@@ -811,10 +815,11 @@ static size_t calculate_variable_size(const SceGxmProgramParameter &parameter, c
 }
 
 // For uniform buffer resigned in registers
-static void copy_uniform_block_to_register(spv::Builder &builder, spv::Id sa_bank, spv::Id block, spv::Id ite, const int start, const int vec4_count) {
+// Copy the vec4 [first_vec4, last_vec4) of the block to the sa bank, starting at register start
+static void copy_uniform_block_to_register(spv::Builder &builder, spv::Id sa_bank, spv::Id block, spv::Id ite, const int start, const int first_vec4, const int last_vec4) {
     int start_in_vec4_granularity = start / 4;
 
-    utils::make_for_loop(builder, ite, builder.makeIntConstant(0), builder.makeIntConstant(vec4_count), [&]() {
+    utils::make_for_loop(builder, ite, builder.makeIntConstant(first_vec4), builder.makeIntConstant(last_vec4), [&]() {
         spv::Id to_copy = utils::create_access_chain(builder, spv::StorageClassStorageBuffer, block, { builder.createLoad(ite, spv::NoPrecision) });
         to_copy = builder.createLoad(to_copy, spv::NoPrecision);
         const spv::Id ite_loaded = builder.createLoad(ite, spv::NoPrecision);
@@ -879,8 +884,6 @@ static SpirvShaderParameters create_parameters(spv::Builder &b, const SceGxmProg
 
     SamplerMap samplers;
 
-    spv::Id ite_copy = b.createVariable(spv::NoPrecision, spv::StorageClassFunction, i32_type, "i");
-
     using literal_pair = std::pair<std::uint32_t, spv::Id>;
 
     std::vector<literal_pair> literal_pairs;
@@ -1022,22 +1025,17 @@ static SpirvShaderParameters create_parameters(spv::Builder &b, const SceGxmProg
     spv_params.render_info_id = translation_state.render_info_id;
 
     for (const auto &buffer : program_input.uniform_buffers) {
-        if (buffer.reg_block_size > 0) {
-            if (features.support_memory_mapping) {
-                Operand dest{
-                    .num = static_cast<uint16_t>(buffer.reg_start_offset),
-                    .bank = RegisterBank::SECATTR,
-                    .type = DataType::F32,
-                };
-                const uint32_t copy_size = std::min(buffer.reg_block_size, REG_SA_COUNT - buffer.reg_start_offset);
-                usse::utils::buffer_address_load(b, spv_params, utils, features, dest, b.makeIntConstant(0), sizeof(uint32_t), copy_size, translation_state.is_fragment, buffer.index);
-            } else {
-                const uint32_t reg_block_size_in_f32v = std::min<uint32_t>(buffer.reg_block_size + 3, REG_SA_COUNT) / 4;
-                const auto spv_buffer = utils::create_access_chain(b, spv::StorageClassStorageBuffer, spv_params.buffer_container,
-                    { b.makeIntConstant(spv_params.buffers.at(buffer.index).index_in_container) });
-                copy_uniform_block_to_register(b, spv_params.uniforms, spv_buffer, ite_copy, buffer.reg_start_offset, reg_block_size_in_f32v);
-            }
-        }
+        if (buffer.reg_block_size > 0)
+            translation_state.uniform_buffers.push_back(buffer);
+    }
+
+    if (!translation_state.uniform_buffers.empty()) {
+        // The content of this function is generated by make_uniform_copy_body
+        spv::Block *last_build_point = b.getBuildPoint();
+        spv::Block *copy_block;
+        translation_state.uniform_copy_func = b.makeFunctionEntry(spv::NoPrecision, b.makeVoidType(), "copy_uniforms", {}, {}, {}, &copy_block);
+        b.setBuildPoint(last_build_point);
+        b.createFunctionCall(translation_state.uniform_copy_func, {});
     }
 
     const auto add_var_to_reg = [&](const Input &input, const std::string &name, std::uint16_t semantic, bool pa, bool regformat, std::int32_t location) {
@@ -1249,11 +1247,57 @@ static SpirvShaderParameters create_parameters(spv::Builder &b, const SceGxmProg
     return spv_params;
 }
 
-static void generate_shader_body(spv::Builder &b, const SpirvShaderParameters &parameters, const SceGxmProgram &program,
+static RegisterUsage generate_shader_body(spv::Builder &b, const SpirvShaderParameters &parameters, const SceGxmProgram &program,
     const FeatureState &features, utils::SpirvUtilFunctions &utils, spv::Function *begin_hook_func, spv::Function *end_hook_func,
     const NonDependentTextureQueryCallInfos &texture_queries, const spv::Id render_info_id) {
     // Do texture queries
-    usse::convert_gxp_usse_to_spirv(b, program, features, parameters, utils, begin_hook_func, end_hook_func, texture_queries, render_info_id);
+    return usse::convert_gxp_usse_to_spirv(b, program, features, parameters, utils, begin_hook_func, end_hook_func, texture_queries, render_info_id);
+}
+
+static void make_uniform_copy_body(spv::Builder &b, const SpirvShaderParameters &spv_params, utils::SpirvUtilFunctions &utils,
+    const FeatureState &features, const TranslationState &translation_state, const RegisterUsage &usage) {
+    if (!translation_state.uniform_copy_func)
+        return;
+
+    spv::Block *last_build_point = b.getBuildPoint();
+    b.setBuildPoint(translation_state.uniform_copy_func->getEntryBlock());
+
+    spv::Id ite_copy = spv::NoResult;
+
+    for (const auto &buffer : translation_state.uniform_buffers) {
+        const int start = static_cast<int>(buffer.reg_start_offset);
+
+        if (features.support_memory_mapping) {
+            // Registers are copied 4 by 4, like the vec4 of the block
+            const uint32_t copy_size = std::min(buffer.reg_block_size, REG_SA_COUNT - buffer.reg_start_offset);
+            const auto [first_group, end_group] = usage.get_uniform_read_range(start, static_cast<int>((copy_size + 3) / 4));
+            if (first_group == end_group)
+                continue;
+
+            Operand dest{
+                .num = static_cast<uint16_t>(start + 4 * first_group),
+                .bank = RegisterBank::SECATTR,
+                .type = DataType::F32,
+            };
+            const uint32_t nb_components = std::min<uint32_t>(copy_size - 4 * first_group, 4 * (end_group - first_group));
+            usse::utils::buffer_address_load(b, spv_params, utils, features, dest, b.makeIntConstant(static_cast<int>(first_group * 4 * sizeof(uint32_t))), sizeof(uint32_t), nb_components, translation_state.is_fragment, buffer.index);
+        } else {
+            const int reg_block_size_in_f32v = static_cast<int>(std::min<uint32_t>(buffer.reg_block_size + 3, REG_SA_COUNT) / 4);
+            const auto [first_vec4, end_vec4] = usage.get_uniform_read_range(start, reg_block_size_in_f32v);
+            if (first_vec4 == end_vec4)
+                continue;
+
+            if (ite_copy == spv::NoResult)
+                ite_copy = b.createVariable(spv::NoPrecision, spv::StorageClassFunction, b.makeIntType(32), "i");
+
+            const auto spv_buffer = utils::create_access_chain(b, spv::StorageClassStorageBuffer, spv_params.buffer_container,
+                { b.makeIntConstant(spv_params.buffers.at(buffer.index).index_in_container) });
+            copy_uniform_block_to_register(b, spv_params.uniforms, spv_buffer, ite_copy, start, first_vec4, end_vec4);
+        }
+    }
+
+    b.leaveFunction();
+    b.setBuildPoint(last_build_point);
 }
 
 static spv::Function *make_frag_finalize_function(spv::Builder &b, const SpirvShaderParameters &parameters,
@@ -1740,9 +1784,12 @@ static SpirvCode convert_gxp_to_spirv_impl(const SceGxmProgram &program, const s
             });
         }
 
-        generate_shader_body(b, parameters, program, features, utils, begin_hook_func, end_hook_func, texture_queries, translation_state.render_info_id);
+        const RegisterUsage usage = generate_shader_body(b, parameters, program, features, utils, begin_hook_func, end_hook_func, texture_queries, translation_state.render_info_id);
+        make_uniform_copy_body(b, parameters, utils, features, translation_state, usage);
     } else {
         generate_update_mask_body(b, utils, features, translation_state);
+        // The mask update program never reads the uniform registers
+        make_uniform_copy_body(b, parameters, utils, features, translation_state, RegisterUsage{});
     }
     b.leaveFunction();
 
@@ -1762,6 +1809,14 @@ static SpirvCode convert_gxp_to_spirv_impl(const SceGxmProgram &program, const s
 
     b.dump(spirv);
 
+    if (features.spirv_optimization_level > 0) {
+        const SpirvOptimizationReport report = optimize_spirv(spirv, features.spirv_optimization_level);
+        LOG_DEBUG("Optimized SPIR-V of shader {}: {}", shader_hash, report.to_string());
+        if (dumper) {
+            dumper("opt", report.to_string());
+        }
+    }
+
     if (LOG_SHADER_CODE || force_shader_debug) {
         std::string spirv_dump;
         spirv_disasm_print(spirv, &spirv_dump);
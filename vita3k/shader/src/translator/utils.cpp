@@ -33,7 +33,20 @@
 using namespace shader;
 using namespace usse;
 
+static void mark_register_read(RegisterUsage &usage, const Operand &op, const int shift_offset) {
+    if (op.bank == RegisterBank::INDEXED1 || op.bank == RegisterBank::INDEXED2) {
+        // The offset comes from an index register, only the bank is known
+        static constexpr RegisterBank indexed_banks[] = { RegisterBank::TEMP, RegisterBank::OUTPUT, RegisterBank::PRIMATTR, RegisterBank::SECATTR };
+        usage.mark_all_read(indexed_banks[(op.num >> 5) & 0b11]);
+        return;
+    }
+
+    // Same slots as the ones accessed by utils::load
+    usage.mark_read(op.bank, (op.num + shift_offset) >> 2, (op.num + shift_offset + 3) >> 2);
+}
+
 spv::Id USSETranslatorVisitor::load(Operand op, const Imm4 dest_mask, const int shift_offset) {
+    mark_register_read(m_recompiler.register_usage, op, shift_offset);
     return utils::load(m_b, m_spirv_params, m_util_funcs, m_features, op, dest_mask, shift_offset);
 }
 
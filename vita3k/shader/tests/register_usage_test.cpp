@@ -0,0 +1,56 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <shader/usse_translator_types.h>
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+using namespace shader::usse;
+
+TEST(register_usage, unread_uniforms_are_not_copied) {
+    RegisterUsage usage;
+    usage.mark_read(RegisterBank::TEMP, 0, 31);
+    usage.mark_read(RegisterBank::PRIMATTR, 0, 31);
+    EXPECT_EQ(usage.get_uniform_read_range(0, 8), std::make_pair(0, 0));
+}
+
+TEST(register_usage, only_the_read_part_of_a_uniform_block_is_copied) {
+    RegisterUsage usage;
+    // sa8-sa11 and sa20-sa23
+    usage.mark_read(RegisterBank::SECATTR, 2, 2);
+    usage.mark_read(RegisterBank::SECATTR, 5, 5);
+
+    // a block starting at sa4 puts its vec4 1 and 4 there
+    EXPECT_EQ(usage.get_uniform_read_range(4, 8), std::make_pair(1, 5));
+    // a block ending before them is skipped
+    EXPECT_EQ(usage.get_uniform_read_range(0, 2), std::make_pair(0, 0));
+}
+
+TEST(register_usage, unaligned_uniform_blocks_copy_both_slots) {
+    RegisterUsage usage;
+    // sa8-sa11, shared by the vec4 1 (sa6-sa9) and 2 (sa10-sa13) of a block starting at sa2
+    usage.mark_read(RegisterBank::SECATTR, 2, 2);
+    EXPECT_EQ(usage.get_uniform_read_range(2, 8), std::make_pair(1, 3));
+}
+
+TEST(register_usage, indexed_uniforms_copy_the_whole_block) {
+    RegisterUsage usage;
+    usage.mark_all_read(RegisterBank::SECATTR);
+    EXPECT_EQ(usage.get_uniform_read_range(4, 6), std::make_pair(0, 6));
+}
@@ -0,0 +1,227 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <gtest/gtest.h>
+#include <shader/spirv_optimizer.h>
+
+#include <SPIRV/spirv.hpp>
+
+#include <cstring>
+#include <initializer_list>
+
+using namespace shader;
+
+namespace {
+enum : std::uint32_t {
+    VOID_TYPE = 1,
+    FUNCTION_TYPE,
+    FLOAT_TYPE,
+    INT_TYPE,
+    UINT_TYPE,
+    INT_0,
+    INT_1,
+    UINT_1,
+    FLOAT_1,
+    FLOAT_2,
+    UINT_2,
+    ARRAY_TYPE,
+    PRIVATE_ARRAY_PTR,
+    PRIVATE_FLOAT_PTR,
+    REGISTERS,
+    OUTPUT_FLOAT_PTR,
+    OUTPUT,
+    BLOCK_TYPE,
+    UNIFORM_BLOCK_PTR,
+    UNIFORM_FLOAT_PTR,
+    UNIFORMS,
+    MAIN,
+    MAIN_LABEL,
+    // first id free for the body of main
+    BODY,
+    BOUND = BODY + 16
+};
+
+std::uint32_t float_bits(const float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+void add(usse::SpirvCode &code, const spv::Op op, std::initializer_list<std::uint32_t> operands) {
+    code.push_back(static_cast<std::uint32_t>(operands.size() + 1) << 16 | op);
+    code.insert(code.end(), operands);
+}
+
+// Start a fragment shader writing to OUTPUT with a uniform block, and with a private register bank if registers is set
+usse::SpirvCode begin_module(const bool registers) {
+    usse::SpirvCode code = { spv::MagicNumber, 0x10000, 0, BOUND, 0 };
+    add(code, spv::OpCapability, { spv::CapabilityShader });
+    add(code, spv::OpMemoryModel, { spv::AddressingModelLogical, spv::MemoryModelGLSL450 });
+    // the name is "main"
+    add(code, spv::OpEntryPoint, { spv::ExecutionModelFragment, MAIN, 0x6E69616D, 0, OUTPUT });
+    add(code, spv::OpDecorate, { BLOCK_TYPE, spv::DecorationBlock });
+    add(code, spv::OpTypeVoid, { VOID_TYPE });
+    add(code, spv::OpTypeFunction, { FUNCTION_TYPE, VOID_TYPE });
+    add(code, spv::OpTypeFloat, { FLOAT_TYPE, 32 });
+    add(code, spv::OpTypeInt, { INT_TYPE, 32, 1 });
+    add(code, spv::OpTypeInt, { UINT_TYPE, 32, 0 });
+    add(code, spv::OpConstant, { INT_TYPE, INT_0, 0 });
+    add(code, spv::OpConstant, { INT_TYPE, INT_1, 1 });
+    add(code, spv::OpConstant, { UINT_TYPE, UINT_1, 1 });
+    add(code, spv::OpConstant, { FLOAT_TYPE, FLOAT_1, float_bits(1.0f) });
+    add(code, spv::OpConstant, { FLOAT_TYPE, FLOAT_2, float_bits(2.0f) });
+    add(code, spv::OpConstant, { UINT_TYPE, UINT_2, 2 });
+    add(code, spv::OpTypeArray, { ARRAY_TYPE, FLOAT_TYPE, UINT_2 });
+    add(code, spv::OpTypePointer, { PRIVATE_ARRAY_PTR, spv::StorageClassPrivate, ARRAY_TYPE });
+    add(code, spv::OpTypePointer, { PRIVATE_FLOAT_PTR, spv::StorageClassPrivate, FLOAT_TYPE });
+    if (registers)
+        add(code, spv::OpVariable, { PRIVATE_ARRAY_PTR, REGISTERS, spv::StorageClassPrivate });
+    add(code, spv::OpTypePointer, { OUTPUT_FLOAT_PTR, spv::StorageClassOutput, FLOAT_TYPE });
+    add(code, spv::OpVariable, { OUTPUT_FLOAT_PTR, OUTPUT, spv::StorageClassOutput });
+    add(code, spv::OpTypeStruct, { BLOCK_TYPE, FLOAT_TYPE });
+    add(code, spv::OpTypePointer, { UNIFORM_BLOCK_PTR, spv::StorageClassUniform, BLOCK_TYPE });
+    add(code, spv::OpTypePointer, { UNIFORM_FLOAT_PTR, spv::StorageClassUniform, FLOAT_TYPE });
+    add(code, spv::OpVariable, { UNIFORM_BLOCK_PTR, UNIFORMS, spv::StorageClassUniform });
+    add(code, spv::OpFunction, { VOID_TYPE, MAIN, spv::FunctionControlMaskNone, FUNCTION_TYPE });
+    add(code, spv::OpLabel, { MAIN_LABEL });
+    return code;
+}
+
+void end_module(usse::SpirvCode &code) {
+    add(code, spv::OpReturn, {});
+    add(code, spv::OpFunctionEnd, {});
+}
+
+// Once optimized, the register bank is never read and is removed with its stores
+usse::SpirvCode output_only_module(const std::uint32_t value) {
+    usse::SpirvCode code = begin_module(false);
+    add(code, spv::OpStore, { OUTPUT, value });
+    end_module(code);
+    return code;
+}
+
+// Store first to registers[first_index] and second to registers[second_index], then output registers[load_index]
+usse::SpirvCode store_store_load_module(const std::uint32_t first_index, const std::uint32_t second_index, const std::uint32_t load_index) {
+    usse::SpirvCode code = begin_module(true);
+    add(code, spv::OpAccessChain, { PRIVATE_FLOAT_PTR, BODY, REGISTERS, first_index });
+    add(code, spv::OpStore, { BODY, FLOAT_1 });
+    add(code, spv::OpAccessChain, { PRIVATE_FLOAT_PTR, BODY + 1, REGISTERS, second_index });
+    add(code, spv::OpStore, { BODY + 1, FLOAT_2 });
+    add(code, spv::OpAccessChain, { PRIVATE_FLOAT_PTR, BODY + 2, REGISTERS, load_index });
+    add(code, spv::OpLoad, { FLOAT_TYPE, BODY + 3, BODY + 2 });
+    add(code, spv::OpStore, { OUTPUT, BODY + 3 });
+    end_module(code);
+    return code;
+}
+} // namespace
+
+TEST(spirv_optimizer, level_0_keeps_the_module) {
+    usse::SpirvCode code = store_store_load_module(INT_0, INT_1, INT_0);
+    const usse::SpirvCode original = code;
+
+    const SpirvOptimizationReport report = optimize_spirv(code, 0);
+    EXPECT_EQ(code, original);
+    EXPECT_EQ(report.words_after, original.size());
+}
+
+TEST(spirv_optimizer, level_1_removes_write_only_registers_only) {
+    usse::SpirvCode code = begin_module(true);
+    add(code, spv::OpAccessChain, { PRIVATE_FLOAT_PTR, BODY, REGISTERS, INT_0 });
+    add(code, spv::OpStore, { BODY, FLOAT_1 });
+    add(code, spv::OpStore, { OUTPUT, FLOAT_2 });
+    end_module(code);
+
+    const SpirvOptimizationReport report = optimize_spirv(code, 1);
+    EXPECT_EQ(code, output_only_module(FLOAT_2));
+    EXPECT_EQ(report.removed_variables, 1u);
+    EXPECT_EQ(report.forwarded_loads, 0u);
+}
+
+TEST(spirv_optimizer, forwards_the_last_store) {
+    usse::SpirvCode code = store_store_load_module(INT_0, INT_1, INT_0);
+
+    const SpirvOptimizationReport report = optimize_spirv(code, 2);
+    EXPECT_EQ(code, output_only_module(FLOAT_1));
+    EXPECT_EQ(report.forwarded_loads, 1u);
+    EXPECT_EQ(report.removed_variables, 1u);
+}
+
+TEST(spirv_optimizer, constants_with_the_same_value_alias) {
+    // INT_1 and UINT_1 are different ids for the same element
+    usse::SpirvCode code = store_store_load_module(INT_1, UINT_1, INT_1);
+
+    optimize_spirv(code, 2);
+    EXPECT_EQ(code, output_only_module(FLOAT_2));
+}
+
+TEST(spirv_optimizer, store_with_dynamic_index_invalidates_the_registers) {
+    usse::SpirvCode code = begin_module(true);
+    add(code, spv::OpAccessChain, { PRIVATE_FLOAT_PTR, BODY, REGISTERS, INT_0 });
+    add(code, spv::OpStore, { BODY, FLOAT_1 });
+    add(code, spv::OpAccessChain, { UNIFORM_FLOAT_PTR, BODY + 1, UNIFORMS, INT_0 });
+    add(code, spv::OpLoad, { FLOAT_TYPE, BODY + 2, BODY + 1 });
+    add(code, spv::OpConvertFToU, { UINT_TYPE, BODY + 3, BODY + 2 });
+    add(code, spv::OpAccessChain, { PRIVATE_FLOAT_PTR, BODY + 4, REGISTERS, BODY + 3 });
+    add(code, spv::OpStore, { BODY + 4, FLOAT_2 });
+    add(code, spv::OpAccessChain, { PRIVATE_FLOAT_PTR, BODY + 5, REGISTERS, INT_0 });
+    add(code, spv::OpLoad, { FLOAT_TYPE, BODY + 6, BODY + 5 });
+    add(code, spv::OpStore, { OUTPUT, BODY + 6 });
+    end_module(code);
+    const usse::SpirvCode original = code;
+
+    const SpirvOptimizationReport report = optimize_spirv(code, 2);
+    EXPECT_EQ(code, original);
+    EXPECT_EQ(report.forwarded_loads, 0u);
+}
+
+TEST(spirv_optimizer, reuses_uniform_loads) {
+    usse::SpirvCode code = begin_module(false);
+    add(code, spv::OpAccessChain, { UNIFORM_FLOAT_PTR, BODY, UNIFORMS, INT_0 });
+    add(code, spv::OpLoad, { FLOAT_TYPE, BODY + 1, BODY });
+    add(code, spv::OpAccessChain, { UNIFORM_FLOAT_PTR, BODY + 2, UNIFORMS, INT_0 });
+    add(code, spv::OpLoad, { FLOAT_TYPE, BODY + 3, BODY + 2 });
+    add(code, spv::OpFAdd, { FLOAT_TYPE, BODY + 4, BODY + 1, BODY + 3 });
+    add(code, spv::OpStore, { OUTPUT, BODY + 4 });
+    end_module(code);
+
+    usse::SpirvCode expected = begin_module(false);
+    add(expected, spv::OpAccessChain, { UNIFORM_FLOAT_PTR, BODY, UNIFORMS, INT_0 });
+    add(expected, spv::OpLoad, { FLOAT_TYPE, BODY + 1, BODY });
+    add(expected, spv::OpFAdd, { FLOAT_TYPE, BODY + 4, BODY + 1, BODY + 1 });
+    add(expected, spv::OpStore, { OUTPUT, BODY + 4 });
+    end_module(expected);
+
+    const SpirvOptimizationReport report = optimize_spirv(code, 2);
+    EXPECT_EQ(code, expected);
+    EXPECT_EQ(report.forwarded_loads, 1u);
+}
+
+TEST(spirv_optimizer, loads_are_not_forwarded_across_blocks) {
+    usse::SpirvCode code = begin_module(false);
+    add(code, spv::OpAccessChain, { UNIFORM_FLOAT_PTR, BODY, UNIFORMS, INT_0 });
+    add(code, spv::OpLoad, { FLOAT_TYPE, BODY + 1, BODY });
+    add(code, spv::OpBranch, { BODY + 2 });
+    add(code, spv::OpLabel, { BODY + 2 });
+    add(code, spv::OpLoad, { FLOAT_TYPE, BODY + 3, BODY });
+    add(code, spv::OpFAdd, { FLOAT_TYPE, BODY + 4, BODY + 1, BODY + 3 });
+    add(code, spv::OpStore, { OUTPUT, BODY + 4 });
+    end_module(code);
+    const usse::SpirvCode original = code;
+
+    optimize_spirv(code, 2);
+    EXPECT_EQ(code, original);
+}
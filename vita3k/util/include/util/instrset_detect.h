@@ -32,6 +32,8 @@ bool hasF16C(void); // true if F16C instructions supported
 bool hasAVX512ER(void); // true if AVX512ER instructions supported
 bool hasAVX512VBMI(void); // true if AVX512VBMI instructions supported
 bool hasAVX512VBMI2(void); // true if AVX512VBMI2 instructions supported
+bool hasAES(void); // true if AES-NI instructions supported
+bool hasVAES(void); // true if VAES instructions supported with AVX2
 
 // return values of function instrset_detect.
 // usage sample: if (instrset_detect()>=instrset_AVX) {/*AVX supported*/}
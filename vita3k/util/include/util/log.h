@@ -35,6 +35,8 @@ namespace logging {
 ExitCode init(const Root &root_paths, bool use_stdout);
 void set_level(spdlog::level::level_enum log_level);
 ExitCode add_sink(const fs::path &log_path);
+// Wait for the queued messages to be written, before the process is replaced
+void flush();
 
 #define LOG_TRACE SPDLOG_TRACE
 #define LOG_DEBUG SPDLOG_DEBUG
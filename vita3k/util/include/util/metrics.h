@@ -0,0 +1,114 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Per-frame counters of the emulator subsystems, shown in the performance overlay and optionally dumped to a file.
+// Each thread increments its own counters, they are only summed when a frame ends.
+namespace metrics {
+
+using CounterId = std::uint32_t;
+
+// The counters created with add_counter are numbered after these ones
+enum BuiltinCounter : CounterId {
+    // CPU time spent by the renderer executing the command lists, in nanoseconds
+    RENDER_TIME,
+    COMMAND_LISTS,
+    DRAWS,
+    TEXTURE_CACHE_HITS,
+    TEXTURE_CACHE_MISSES,
+    TEXTURE_UPLOADS,
+    SHADER_COMPILES,
+    PIPELINE_COMPILES,
+    HLE_CALLS,
+    // guest code blocks translated by the JIT
+    JIT_BLOCKS,
+    PAGE_FAULTS,
+    AUDIO_UNDERRUNS,
+    // time spent updating the NGS voices, in nanoseconds
+    NGS_TICK_TIME,
+    BUILTIN_COUNTER_COUNT
+};
+
+constexpr CounterId MAX_COUNTERS = 256;
+constexpr CounterId INVALID_COUNTER = MAX_COUNTERS;
+
+enum class DumpFormat {
+    CSV,
+    JSON
+};
+
+DumpFormat get_dump_format(const std::string &name);
+const char *get_dump_format_name(DumpFormat format);
+
+// Returns the counter with this name, creating it if needed, or INVALID_COUNTER once all of them are used
+CounterId add_counter(const std::string &name);
+std::vector<std::string> get_counter_names();
+
+// Lock free, only touches counters of the calling thread
+void add(CounterId id, std::uint64_t value = 1);
+
+// The source returns the total of the counter and is read when a frame ends,
+// for the counters incremented where add can't be called (in a signal handler for example)
+void set_source(CounterId id, std::function<std::uint64_t()> source);
+
+struct Frame {
+    std::uint64_t index = 0;
+    std::uint64_t time_ns = 0;
+    // indexed by CounterId
+    std::vector<std::uint64_t> values;
+
+    std::uint64_t get(CounterId id) const {
+        return id < values.size() ? values[id] : 0;
+    }
+};
+
+// Called once per emulated frame, aggregates the counters of all the threads
+void end_frame();
+Frame get_last_frame();
+
+// Writes the counters summed over every interval frames
+bool start_dump(const fs::path &path, DumpFormat format, std::uint32_t interval);
+void stop_dump();
+
+// Adds the time spent in its scope to a counter
+class ScopedTimer {
+    CounterId id;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit ScopedTimer(CounterId id)
+        : id(id)
+        , start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        add(id, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+};
+
+} // namespace metrics
@@ -0,0 +1,74 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+// Ring buffer for bytes - safe to use without locks as long as there is only one thread
+// inserting data (producer) and one thread removing data (consumer)
+class SPSCByteRingBuffer {
+public:
+    explicit SPSCByteRingBuffer(std::size_t size)
+        : buffer(new char[size])
+        , capacity(size) {}
+
+    std::size_t Capacity() const { return capacity; }
+    std::size_t Used() const { return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_acquire); }
+    std::size_t Free() const { return capacity - Used(); }
+
+    // Must only be called by the producer
+    std::size_t Insert(const void *in, std::size_t size) {
+        const std::size_t write = write_pos.load(std::memory_order_relaxed);
+        const std::size_t read = read_pos.load(std::memory_order_acquire);
+        const std::size_t insert_size = std::min(size, capacity - (write - read));
+
+        const std::size_t offset = write % capacity;
+        const std::size_t tail_size = std::min(insert_size, capacity - offset);
+        memcpy(&buffer[offset], in, tail_size);
+        memcpy(&buffer[0], static_cast<const char *>(in) + tail_size, insert_size - tail_size);
+
+        write_pos.store(write + insert_size, std::memory_order_release);
+        return insert_size;
+    }
+
+    // Must only be called by the consumer
+    std::size_t Remove(void *out, std::size_t size) {
+        const std::size_t read = read_pos.load(std::memory_order_relaxed);
+        const std::size_t write = write_pos.load(std::memory_order_acquire);
+        const std::size_t remove_size = std::min(size, write - read);
+
+        const std::size_t offset = read % capacity;
+        const std::size_t tail_size = std::min(remove_size, capacity - offset);
+        memcpy(out, &buffer[offset], tail_size);
+        memcpy(static_cast<char *>(out) + tail_size, &buffer[0], remove_size - tail_size);
+
+        read_pos.store(read + remove_size, std::memory_order_release);
+        return remove_size;
+    }
+
+private:
+    std::unique_ptr<char[]> buffer;
+    const std::size_t capacity;
+
+    // total number of bytes inserted/removed since the creation, the position in the buffer is these values modulo the capacity
+    std::atomic<std::size_t> read_pos = 0;
+    std::atomic<std::size_t> write_pos = 0;
+};
@@ -33,5 +33,7 @@ void replace(std::string &str, const std::string &in, const std::string &out);
 std::basic_string<uint8_t> string_to_byte_array(std::string string);
 std::string toupper(const std::string &s);
 std::string tolower(const std::string &s);
+// Escapes the quotes, backslashes and control characters of a string written in a JSON string
+std::string escape_json(const std::string &str);
 
 } // namespace string_utils
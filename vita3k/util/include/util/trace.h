@@ -0,0 +1,81 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <util/fs.h>
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+// Binary tracing of the guest activity, cheap enough to stay on while reproducing timing bugs.
+// The events are copied to a ring of the calling thread and written to the trace file by a background thread.
+namespace trace {
+
+enum class EventType : std::uint16_t {
+    // HLE import called, id is the NID, args are r0-r3 and lr
+    HLE_CALL,
+    // HLE import returned, id is the NID, args are r0
+    HLE_RETURN,
+    // import redirected to a LLE module, id is the NID, args are the pc of the stub
+    LLE_CALL,
+    // status of a guest thread changed, id is the new ThreadStatus, args are the previous one
+    THREAD_STATUS,
+};
+
+constexpr std::size_t MAX_EVENT_ARGS = 5;
+
+struct Event {
+    // nanoseconds since the trace was started
+    std::uint64_t timestamp;
+    std::uint32_t id;
+    std::int32_t thread_id;
+    std::uint32_t args[MAX_EVENT_ARGS];
+    EventType type;
+    std::uint16_t arg_count;
+};
+
+static_assert(sizeof(Event) == 40, "The events are written as is in the trace file");
+
+constexpr char FILE_MAGIC[8] = { 'V', '3', 'K', 'T', 'R', 'A', 'C', 'E' };
+constexpr std::uint32_t FILE_VERSION = 1;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t event_size;
+    // host date of the start of the trace, in nanoseconds since the unix epoch
+    std::uint64_t start_date;
+};
+
+extern std::atomic<bool> enabled;
+
+inline bool is_enabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+bool start(const fs::path &path);
+void stop();
+
+// Never blocks, the event is dropped if the ring of the thread is full
+void record(EventType type, std::uint32_t id, std::int32_t thread_id, std::initializer_list<std::uint32_t> args);
+
+bool read_file(const fs::path &path, FileHeader &header, std::vector<Event> &events);
+
+} // namespace trace
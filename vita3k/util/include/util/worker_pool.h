@@ -0,0 +1,77 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+// Fixed set of threads running the iterations of a loop in parallel
+class WorkerPool {
+public:
+    using Job = std::function<void(std::size_t)>;
+
+    explicit WorkerPool(unsigned int nb_workers);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    std::size_t worker_count() const { return workers.size(); }
+
+    // Start calling job(i) for each i in [0, count) on the workers, the job must stay alive until wait returns.
+    // Only one job can be submitted at a time.
+    void submit(std::size_t count, const Job &job);
+
+    // Help the workers with the remaining iterations and return once all of them are done
+    void wait();
+
+private:
+    void worker_loop();
+    // Run iterations until there are none left, returns the number of iterations done
+    std::size_t run_iterations();
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable job_cond;
+    std::condition_variable done_cond;
+
+    const Job *job = nullptr;
+    std::size_t job_count = 0;
+    std::atomic<std::size_t> next_index = 0;
+    // number of iterations not finished yet and of workers running iterations, protected by mutex
+    std::size_t remaining = 0;
+    std::size_t active_workers = 0;
+    // incremented at each submit so the workers know there is a new job
+    std::uint64_t generation = 0;
+    bool exiting = false;
+};
+
+// Call job(i) for each i in [0, count) on the threads of the pool shared by the whole emulator, helped by this thread.
+// caller_job, if any, runs on this thread meanwhile, for the work which can't be done on another thread.
+// The pool runs a single loop at a time, when it is busy or count is below 2 everything runs on this thread.
+void parallel_for(std::size_t count, const WorkerPool::Job &job, const std::function<void()> &caller_job = {});
+
+} // namespace util
@@ -229,5 +229,23 @@ bool hasAVX512VBMI2(void) {
     cpuid(abcd, 7); // call cpuid function 7
     return ((abcd[2] & (1 << 6)) != 0); // ecx bit 6 indicates AVX512VBMI2
 }
+
+// detect if CPU supports the AES-NI instruction set
+bool hasAES(void) {
+    if (instrset_detect() < 2)
+        return false; // must have SSE2
+    int abcd[4]; // cpuid results
+    cpuid(abcd, 1); // call cpuid function 1
+    return ((abcd[2] & (1 << 25)) != 0); // ecx bit 25 indicates AES-NI
+}
+
+// detect if CPU supports the 256-bit VAES instructions
+bool hasVAES(void) {
+    if (instrset_detect() < 8 || !hasAES())
+        return false; // must have AVX2 and AES-NI
+    int abcd[4]; // cpuid results
+    cpuid(abcd, 7); // call cpuid function 7
+    return ((abcd[2] & (1 << 9)) != 0); // ecx bit 9 indicates VAES
+}
 } // namespace instrset
 } // namespace util
@@ -0,0 +1,267 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/metrics.h>
+
+#include <util/log.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace metrics {
+
+static const char *const BUILTIN_COUNTER_NAMES[BUILTIN_COUNTER_COUNT] = {
+    "render_time_ns",
+    "command_lists",
+    "draws",
+    "texture_cache_hits",
+    "texture_cache_misses",
+    "texture_uploads",
+    "shader_compiles",
+    "pipeline_compiles",
+    "hle_calls",
+    "jit_blocks",
+    "page_faults",
+    "audio_underruns",
+    "ngs_tick_time_ns",
+};
+
+typedef std::array<std::uint64_t, MAX_COUNTERS> Totals;
+
+// Counters of one thread, only written by it
+struct ThreadCounters {
+    std::array<std::atomic<std::uint64_t>, MAX_COUNTERS> values{};
+
+    ThreadCounters();
+    ~ThreadCounters();
+};
+
+struct Dump {
+    fs::ofstream file;
+    DumpFormat format = DumpFormat::CSV;
+    std::uint32_t interval = 0;
+    // counters summed since the last written row
+    Frame sum;
+    std::uint32_t frames = 0;
+    // columns of the last CSV header written
+    std::size_t header_columns = 0;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::string> names{ std::begin(BUILTIN_COUNTER_NAMES), std::end(BUILTIN_COUNTER_NAMES) };
+    std::vector<ThreadCounters *> threads;
+    std::map<CounterId, std::function<std::uint64_t()>> sources;
+    // counters of the threads which have exited
+    Totals retired{};
+    // totals when the previous frame ended
+    Totals previous{};
+    Frame last_frame;
+    std::uint64_t frame_count = 0;
+    std::chrono::steady_clock::time_point last_frame_time;
+    Dump dump;
+};
+
+static Registry registry;
+
+ThreadCounters::ThreadCounters() {
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(this);
+}
+
+ThreadCounters::~ThreadCounters() {
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    for (CounterId i = 0; i < MAX_COUNTERS; i++)
+        registry.retired[i] += values[i].load(std::memory_order_relaxed);
+    std::erase(registry.threads, this);
+}
+
+DumpFormat get_dump_format(const std::string &name) {
+    if (name == "JSON")
+        return DumpFormat::JSON;
+    return DumpFormat::CSV;
+}
+
+const char *get_dump_format_name(DumpFormat format) {
+    switch (format) {
+    case DumpFormat::JSON: return "JSON";
+    case DumpFormat::CSV:
+    default: return "CSV";
+    }
+}
+
+CounterId add_counter(const std::string &name) {
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    const auto it = std::find(registry.names.begin(), registry.names.end(), name);
+    if (it != registry.names.end())
+        return static_cast<CounterId>(it - registry.names.begin());
+
+    if (registry.names.size() >= MAX_COUNTERS) {
+        LOG_WARN("No more metrics counters available, {} is not counted", name);
+        return INVALID_COUNTER;
+    }
+
+    registry.names.push_back(name);
+    return static_cast<CounterId>(registry.names.size() - 1);
+}
+
+std::vector<std::string> get_counter_names() {
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.names;
+}
+
+void add(CounterId id, std::uint64_t value) {
+    if (id >= MAX_COUNTERS)
+        return;
+
+    thread_local ThreadCounters counters;
+    std::atomic<std::uint64_t> &counter = counters.values[id];
+    // no other thread writes it, so no need for a locked add
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void set_source(CounterId id, std::function<std::uint64_t()> source) {
+    if (id >= MAX_COUNTERS)
+        return;
+
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    if (source)
+        registry.sources[id] = std::move(source);
+    else
+        registry.sources.erase(id);
+}
+
+// Called with the registry mutex held
+static void write_dump(Dump &dump, const std::vector<std::string> &names) {
+    const Frame &sum = dump.sum;
+    const double time_ms = sum.time_ns / 1e6;
+
+    if (dump.format == DumpFormat::CSV) {
+        // the counters created since the last header need a new one
+        if (dump.header_columns != sum.values.size()) {
+            dump.file << "frame,frames,time_ms";
+            for (std::size_t i = 0; i < sum.values.size(); i++)
+                dump.file << ',' << names[i];
+            dump.file << '\n';
+            dump.header_columns = sum.values.size();
+        }
+
+        dump.file << fmt::format("{},{},{:.3f}", sum.index, dump.frames, time_ms);
+        for (const std::uint64_t value : sum.values)
+            dump.file << ',' << value;
+        dump.file << '\n';
+    } else {
+        // one object per line
+        dump.file << fmt::format(R"({{"frame":{},"frames":{},"time_ms":{:.3f},"counters":{{)", sum.index, dump.frames, time_ms);
+        for (std::size_t i = 0; i < sum.values.size(); i++) {
+            std::string name = names[i];
+            std::erase_if(name, [](char c) { return c == '"' || c == '\\'; });
+            dump.file << fmt::format(R"({}"{}":{})", i == 0 ? "" : ",", name, sum.values[i]);
+        }
+        dump.file << "}}\n";
+    }
+}
+
+void end_frame() {
+    const auto now = std::chrono::steady_clock::now();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    const CounterId count = static_cast<CounterId>(registry.names.size());
+
+    Totals totals = registry.retired;
+    for (const ThreadCounters *thread : registry.threads) {
+        for (CounterId i = 0; i < count; i++)
+            totals[i] += thread->values[i].load(std::memory_order_relaxed);
+    }
+    for (const auto &[id, source] : registry.sources)
+        totals[id] = source();
+
+    Frame &frame = registry.last_frame;
+    frame.index = registry.frame_count;
+    frame.time_ns = registry.frame_count == 0 ? 0 : std::chrono::duration_cast<std::chrono::nanoseconds>(now - registry.last_frame_time).count();
+    frame.values.resize(count);
+    for (CounterId i = 0; i < count; i++)
+        frame.values[i] = totals[i] - registry.previous[i];
+    registry.previous = totals;
+    registry.last_frame_time = now;
+    registry.frame_count++;
+
+    Dump &dump = registry.dump;
+    if (!dump.file.is_open())
+        return;
+
+    if (dump.frames == 0)
+        dump.sum.index = frame.index;
+    dump.sum.time_ns += frame.time_ns;
+    dump.sum.values.resize(count);
+    for (CounterId i = 0; i < count; i++)
+        dump.sum.values[i] += frame.values[i];
+
+    if (++dump.frames == dump.interval) {
+        write_dump(dump, registry.names);
+        dump.sum = {};
+        dump.frames = 0;
+    }
+}
+
+Frame get_last_frame() {
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.last_frame;
+}
+
+bool start_dump(const fs::path &path, DumpFormat format, std::uint32_t interval) {
+    if (interval == 0)
+        return false;
+
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    Dump &dump = registry.dump;
+    if (dump.file.is_open()) {
+        LOG_WARN("The metrics are already dumped");
+        return false;
+    }
+
+    dump.file.open(path, std::ios::out | std::ios::trunc);
+    if (!dump.file.is_open()) {
+        LOG_ERROR("Failed to create the metrics file {}", path.string());
+        return false;
+    }
+
+    dump.format = format;
+    dump.interval = interval;
+    dump.sum = {};
+    dump.frames = 0;
+    dump.header_columns = 0;
+    LOG_INFO("Dumping the metrics every {} frames to {}", interval, path.string());
+
+    return true;
+}
+
+void stop_dump() {
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    Dump &dump = registry.dump;
+    if (!dump.file.is_open())
+        return;
+
+    // the frames of an unfinished interval are written too
+    if (dump.frames > 0)
+        write_dump(dump, registry.names);
+    dump.file.close();
+}
+
+} // namespace metrics
@@ -0,0 +1,214 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/trace.h>
+
+#include <util/log.h>
+#include <util/spsc_ring_buffer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace trace {
+
+std::atomic<bool> enabled = false;
+
+// 16K events for each thread, the writer drains them every few milliseconds
+static constexpr std::size_t RING_SIZE = sizeof(Event) * 16384;
+static constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(5);
+
+struct ThreadRing {
+    SPSCByteRingBuffer buffer{ RING_SIZE };
+    std::atomic<std::uint64_t> dropped = 0;
+};
+
+typedef std::shared_ptr<ThreadRing> ThreadRingPtr;
+
+// Ring of the calling thread, replaced when a new trace is started
+struct LocalRing {
+    ThreadRingPtr ring;
+    std::uint32_t session = 0;
+};
+
+struct Writer {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<ThreadRingPtr> rings;
+    std::thread thread;
+    fs::ofstream file;
+    bool stopping = false;
+    std::atomic<std::uint32_t> session = 0;
+    std::chrono::steady_clock::time_point start_time;
+    std::uint64_t event_count = 0;
+    std::uint64_t dropped_count = 0;
+
+    ~Writer() {
+        // at exit, spdlog may already be destroyed
+        stop(false);
+    }
+
+    void drain();
+    void stop(bool log);
+};
+
+static Writer writer;
+static thread_local LocalRing local_ring;
+
+// Called with the writer mutex held
+void Writer::drain() {
+    char chunk[sizeof(Event) * 256];
+    for (auto it = rings.begin(); it != rings.end();) {
+        ThreadRing &ring = **it;
+        while (const std::size_t size = ring.buffer.Remove(chunk, sizeof(chunk))) {
+            file.write(chunk, size);
+            event_count += size / sizeof(Event);
+        }
+        dropped_count += ring.dropped.exchange(0);
+
+        // the thread owning it has exited
+        if (it->use_count() == 1 && ring.buffer.Used() == 0)
+            it = rings.erase(it);
+        else
+            ++it;
+    }
+}
+
+void Writer::stop(bool log) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (!file.is_open())
+            return;
+        enabled = false;
+        stopping = true;
+    }
+    cond.notify_all();
+    thread.join();
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    drain();
+    file.close();
+    rings.clear();
+    LOG_INFO_IF(log, "Trace stopped, {} events written, {} dropped", event_count, dropped_count);
+}
+
+bool start(const fs::path &path) {
+    const std::lock_guard<std::mutex> lock(writer.mutex);
+    if (writer.file.is_open()) {
+        LOG_WARN("A trace is already running");
+        return false;
+    }
+
+    writer.file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!writer.file.is_open()) {
+        LOG_ERROR("Failed to create the trace file {}", path.string());
+        return false;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.event_size = sizeof(Event);
+    header.start_date = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    writer.file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    writer.start_time = std::chrono::steady_clock::now();
+    writer.stopping = false;
+    writer.event_count = 0;
+    writer.dropped_count = 0;
+    writer.session++;
+    writer.thread = std::thread([] {
+        std::unique_lock<std::mutex> lock(writer.mutex);
+        while (!writer.stopping) {
+            writer.cond.wait_for(lock, DRAIN_INTERVAL);
+            writer.drain();
+        }
+    });
+
+    enabled = true;
+    LOG_INFO("Tracing to {}", path.string());
+    return true;
+}
+
+void stop() {
+    writer.stop(true);
+}
+
+static ThreadRing *get_thread_ring() {
+    const std::uint32_t session = writer.session.load(std::memory_order_acquire);
+    if (local_ring.session != session) {
+        auto ring = std::make_shared<ThreadRing>();
+        const std::lock_guard<std::mutex> lock(writer.mutex);
+        if (!is_enabled())
+            return nullptr;
+        writer.rings.push_back(ring);
+        local_ring = { std::move(ring), session };
+    }
+
+    return local_ring.ring.get();
+}
+
+void record(EventType type, std::uint32_t id, std::int32_t thread_id, std::initializer_list<std::uint32_t> args) {
+    if (!is_enabled())
+        return;
+
+    ThreadRing *ring = get_thread_ring();
+    if (!ring)
+        return;
+
+    Event event{};
+    event.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - writer.start_time).count();
+    event.id = id;
+    event.thread_id = thread_id;
+    event.type = type;
+    event.arg_count = static_cast<std::uint16_t>(std::min(args.size(), MAX_EVENT_ARGS));
+    std::copy_n(args.begin(), event.arg_count, event.args);
+
+    if (ring->buffer.Free() < sizeof(Event)) {
+        ring->dropped++;
+        return;
+    }
+    ring->buffer.Insert(&event, sizeof(Event));
+}
+
+bool read_file(const fs::path &path, FileHeader &header, std::vector<Event> &events) {
+    fs::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open the trace file {}", path.string());
+        return false;
+    }
+
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        LOG_ERROR("{} is not a trace file", path.string());
+        return false;
+    }
+    if (header.version != FILE_VERSION || header.event_size != sizeof(Event)) {
+        LOG_ERROR("Unsupported trace file version {} (event size {})", header.version, header.event_size);
+        return false;
+    }
+
+    const std::size_t data_size = fs::file_size(path) - sizeof(header);
+    events.resize(data_size / sizeof(Event));
+    file.read(reinterpret_cast<char *>(events.data()), events.size() * sizeof(Event));
+    return true;
+}
+
+} // namespace trace
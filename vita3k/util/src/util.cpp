@@ -21,6 +21,7 @@
 #include <util/net_utils.h>
 #include <util/string_utils.h>
 
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/msvc_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
@@ -41,6 +42,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #include <memory>
 #include <stdexcept>
@@ -49,6 +51,8 @@ namespace logging {
 
 static const fs::path &LOG_FILE_NAME = "vita3k.log";
 static const char *LOG_PATTERN = "%^[%H:%M:%S.%e] |%L| [%!]: %v%$";
+// Messages waiting for the logging thread, the callers block when it is full so nothing is lost
+static constexpr std::size_t LOG_QUEUE_SIZE = 8192;
 std::vector<spdlog::sink_ptr> sinks;
 
 ExitCode init(const Root &root_paths, bool use_stdout) {
@@ -89,11 +93,26 @@ ExitCode add_sink(const fs::path &log_path) {
     }
 #endif
 
-    spdlog::set_default_logger(std::make_shared<spdlog::logger>("vita3k logger", begin(sinks), end(sinks)));
+    // the sinks are written by a background thread, so logging does not wait for the console or the disk
+    if (!spdlog::thread_pool())
+        spdlog::init_thread_pool(LOG_QUEUE_SIZE, 1);
+    const auto logger = std::make_shared<spdlog::async_logger>("vita3k logger", begin(sinks), end(sinks), spdlog::thread_pool(), spdlog::async_overflow_policy::block);
+    logger->flush_on(spdlog::level::err);
+    spdlog::set_default_logger(logger);
     spdlog::set_pattern(LOG_PATTERN);
     return Success;
 }
 
+void flush() {
+    if (const auto pool = spdlog::thread_pool()) {
+        while (pool->queue_size() > 0)
+            std::this_thread::yield();
+    }
+    // the sinks lock the message being written
+    for (const auto &sink : sinks)
+        sink->flush();
+}
+
 typedef std::set<std::string> NameSet;
 static std::mutex mutex;
 static NameSet logged;
@@ -229,6 +248,24 @@ std::string tolower(const std::string &s) {
     return r;
 }
 
+std::string escape_json(const std::string &str) {
+    std::string escaped;
+    for (const char c : str) {
+        switch (c) {
+        case '"': escaped += "\\\""; break;
+        case '\\': escaped += "\\\\"; break;
+        case '\n': escaped += "\\n"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+            else
+                escaped += c;
+            break;
+        }
+    }
+    return escaped;
+}
+
 } // namespace string_utils
 
 namespace net_utils {
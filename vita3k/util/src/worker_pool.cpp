@@ -0,0 +1,121 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/worker_pool.h>
+
+#include <algorithm>
+
+namespace util {
+
+WorkerPool::WorkerPool(unsigned int nb_workers) {
+    workers.reserve(nb_workers);
+    for (unsigned int i = 0; i < nb_workers; i++)
+        workers.emplace_back(&WorkerPool::worker_loop, this);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        exiting = true;
+    }
+    job_cond.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void WorkerPool::submit(std::size_t count, const Job &new_job) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        job = &new_job;
+        job_count = count;
+        next_index = 0;
+        remaining = count;
+        generation++;
+    }
+    job_cond.notify_all();
+}
+
+std::size_t WorkerPool::run_iterations() {
+    std::size_t done = 0;
+    for (std::size_t i = next_index++; i < job_count; i = next_index++) {
+        (*job)(i);
+        done++;
+    }
+
+    return done;
+}
+
+void WorkerPool::wait() {
+    const std::size_t done = run_iterations();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    remaining -= done;
+    // the workers must also be done looking for iterations before the next job can be submitted
+    done_cond.wait(lock, [&]() { return remaining == 0 && active_workers == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::worker_loop() {
+    std::uint64_t last_generation = 0;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        job_cond.wait(lock, [&]() { return exiting || (job && generation != last_generation); });
+        if (exiting)
+            return;
+
+        last_generation = generation;
+        active_workers++;
+        lock.unlock();
+        const std::size_t done = run_iterations();
+        lock.lock();
+        active_workers--;
+
+        remaining -= done;
+        if (remaining == 0 && active_workers == 0)
+            done_cond.notify_all();
+    }
+}
+
+static std::mutex shared_pool_mutex;
+
+static WorkerPool &get_shared_pool() {
+    // the thread calling parallel_for is the last worker
+    static WorkerPool pool(std::clamp(std::thread::hardware_concurrency(), 2u, 8u) - 1);
+    return pool;
+}
+
+void parallel_for(std::size_t count, const WorkerPool::Job &job, const std::function<void()> &caller_job) {
+    // the loops started while the pool is busy, including the ones started from a job, run serially
+    std::unique_lock<std::mutex> lock(shared_pool_mutex, std::try_to_lock);
+    if (count < 2 || !lock.owns_lock()) {
+        if (caller_job)
+            caller_job();
+        for (std::size_t i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+
+    WorkerPool &pool = get_shared_pool();
+    pool.submit(count, job);
+    if (caller_job)
+        caller_job();
+    pool.wait();
+}
+
+} // namespace util
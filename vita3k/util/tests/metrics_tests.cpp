@@ -0,0 +1,108 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/metrics.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(metrics, counters_of_all_threads_are_summed) {
+    // starts a new frame whatever the previous tests counted
+    metrics::end_frame();
+
+    constexpr int THREAD_COUNT = 4;
+    constexpr uint64_t DRAW_COUNT = 1000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        threads.emplace_back([] {
+            for (uint64_t j = 0; j < DRAW_COUNT; j++)
+                metrics::add(metrics::DRAWS);
+        });
+    }
+    // the counters of the threads which have exited are kept
+    for (auto &thread : threads)
+        thread.join();
+    metrics::add(metrics::COMMAND_LISTS, 3);
+
+    metrics::end_frame();
+    metrics::Frame frame = metrics::get_last_frame();
+    EXPECT_EQ(frame.get(metrics::DRAWS), THREAD_COUNT * DRAW_COUNT);
+    EXPECT_EQ(frame.get(metrics::COMMAND_LISTS), 3u);
+    EXPECT_EQ(frame.get(metrics::SHADER_COMPILES), 0u);
+
+    // only the increments of the frame are reported
+    metrics::add(metrics::DRAWS, 2);
+    metrics::end_frame();
+    frame = metrics::get_last_frame();
+    EXPECT_EQ(frame.get(metrics::DRAWS), 2u);
+    EXPECT_EQ(frame.get(metrics::COMMAND_LISTS), 0u);
+}
+
+TEST(metrics, named_counters_and_sources) {
+    const metrics::CounterId id = metrics::add_counter("hle_SceTest");
+    EXPECT_GE(id, metrics::BUILTIN_COUNTER_COUNT);
+    EXPECT_EQ(metrics::add_counter("hle_SceTest"), id);
+    EXPECT_EQ(metrics::get_counter_names()[id], "hle_SceTest");
+    EXPECT_EQ(metrics::add_counter("draws"), metrics::DRAWS);
+
+    std::atomic<uint64_t> faults = 10;
+    metrics::set_source(metrics::PAGE_FAULTS, [&] { return faults.load(); });
+    metrics::end_frame();
+
+    metrics::add(id, 5);
+    faults += 4;
+    metrics::end_frame();
+    const metrics::Frame frame = metrics::get_last_frame();
+    EXPECT_EQ(frame.get(id), 5u);
+    EXPECT_EQ(frame.get(metrics::PAGE_FAULTS), 4u);
+    metrics::set_source(metrics::PAGE_FAULTS, nullptr);
+
+    // ignored
+    metrics::add(metrics::INVALID_COUNTER);
+}
+
+TEST(metrics, dump_every_interval) {
+    const fs::path path = fs::temp_directory_path() / fs::unique_path("metrics-%%%%-%%%%.csv");
+    EXPECT_FALSE(metrics::start_dump(path, metrics::DumpFormat::CSV, 0));
+    ASSERT_TRUE(metrics::start_dump(path, metrics::DumpFormat::CSV, 2));
+
+    for (int i = 0; i < 5; i++) {
+        metrics::add(metrics::DRAWS, 10);
+        metrics::end_frame();
+    }
+    // adds a column, so a new header is written
+    metrics::add_counter("hle_SceDumpTest");
+    metrics::end_frame();
+    metrics::stop_dump();
+
+    fs::ifstream file(path);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);)
+        lines.push_back(line);
+    file.close();
+    fs::remove(path);
+
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_EQ(lines[0].rfind("frame,frames,time_ms,render_time_ns,command_lists,draws,", 0), 0u);
+    EXPECT_NE(lines[1].find(",2,"), std::string::npos);
+    EXPECT_EQ(lines[3].find("hle_SceDumpTest"), lines[3].size() - std::string("hle_SceDumpTest").size());
+    // the last interval is not finished, but still written
+    EXPECT_NE(lines[4].find(",2,"), std::string::npos);
+}
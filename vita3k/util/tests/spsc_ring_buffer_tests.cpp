@@ -0,0 +1,82 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/spsc_ring_buffer.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+TEST(spsc_ring_buffer, data_wraps_around) {
+    SPSCByteRingBuffer buffer(8);
+    const uint8_t first[6] = { 1, 2, 3, 4, 5, 6 };
+    EXPECT_EQ(buffer.Insert(first, sizeof(first)), 6u);
+
+    uint8_t out[8];
+    EXPECT_EQ(buffer.Remove(out, 4), 4u);
+    EXPECT_EQ(buffer.Free(), 6u);
+
+    // only 6 bytes fit, the end goes to the start of the storage
+    const uint8_t second[7] = { 7, 8, 9, 10, 11, 12, 13 };
+    EXPECT_EQ(buffer.Insert(second, sizeof(second)), 6u);
+    EXPECT_EQ(buffer.Used(), 8u);
+
+    EXPECT_EQ(buffer.Remove(out, sizeof(out)), 8u);
+    const uint8_t expected[8] = { 5, 6, 7, 8, 9, 10, 11, 12 };
+    EXPECT_EQ(std::vector<uint8_t>(out, out + 8), std::vector<uint8_t>(expected, expected + 8));
+    EXPECT_EQ(buffer.Remove(out, sizeof(out)), 0u);
+}
+
+TEST(spsc_ring_buffer, consumer_gets_the_producer_data_in_order) {
+    constexpr uint32_t VALUE_COUNT = 200000;
+    SPSCByteRingBuffer buffer(1000);
+
+    std::thread producer([&] {
+        uint32_t value = 0;
+        while (value < VALUE_COUNT) {
+            // several values at once, not always a multiple of the capacity
+            uint32_t values[7];
+            const uint32_t count = std::min<uint32_t>(7, VALUE_COUNT - value);
+            for (uint32_t i = 0; i < count; i++)
+                values[i] = value + i;
+            if (buffer.Free() < count * sizeof(uint32_t)) {
+                std::this_thread::yield();
+                continue;
+            }
+            buffer.Insert(values, count * sizeof(uint32_t));
+            value += count;
+        }
+    });
+
+    uint32_t expected = 0;
+    bool in_order = true;
+    while (expected < VALUE_COUNT && in_order) {
+        uint32_t value;
+        if (buffer.Used() < sizeof(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        buffer.Remove(&value, sizeof(value));
+        in_order = value == expected++;
+    }
+    producer.join();
+
+    EXPECT_TRUE(in_order) << "value " << expected - 1;
+    EXPECT_EQ(buffer.Used(), 0u);
+}
@@ -0,0 +1,34 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/string_utils.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(string_utils, escape_json_keeps_plain_text) {
+    EXPECT_EQ(string_utils::escape_json("PCSB00001 | Vita3K"), "PCSB00001 | Vita3K");
+    EXPECT_EQ(string_utils::escape_json(""), "");
+}
+
+TEST(string_utils, escape_json_escapes_quotes_and_control_characters) {
+    EXPECT_EQ(string_utils::escape_json("say \"hi\""), "say \\\"hi\\\"");
+    EXPECT_EQ(string_utils::escape_json("C:\\ux0"), "C:\\\\ux0");
+    EXPECT_EQ(string_utils::escape_json("a\nb"), "a\\nb");
+    EXPECT_EQ(string_utils::escape_json(std::string("\t\x01", 2)), "\\u0009\\u0001");
+}
@@ -0,0 +1,84 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/trace.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <thread>
+#include <vector>
+
+TEST(trace, events_are_written_by_the_writer) {
+    const fs::path path = fs::temp_directory_path() / fs::unique_path("trace-%%%%-%%%%.bin");
+    ASSERT_TRUE(trace::start(path));
+    EXPECT_TRUE(trace::is_enabled());
+
+    constexpr int THREAD_COUNT = 4;
+    constexpr uint32_t EVENT_COUNT = 1000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        threads.emplace_back([i] {
+            for (uint32_t j = 0; j < EVENT_COUNT; j++) {
+                trace::record(trace::EventType::HLE_CALL, 0x1234, i, { j, 1, 2, 3, 4 });
+                // leave some time to the writer so the ring never fills up
+                if (j % 64 == 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    trace::stop();
+    EXPECT_FALSE(trace::is_enabled());
+    // ignored once stopped
+    trace::record(trace::EventType::HLE_CALL, 0x1234, 0, {});
+
+    trace::FileHeader header;
+    std::vector<trace::Event> events;
+    ASSERT_TRUE(trace::read_file(path, header, events));
+    fs::remove(path);
+    EXPECT_EQ(header.version, trace::FILE_VERSION);
+    ASSERT_EQ(events.size(), THREAD_COUNT * EVENT_COUNT);
+
+    // the events of each thread keep their order
+    std::map<int32_t, uint32_t> next_index;
+    for (const trace::Event &event : events) {
+        EXPECT_EQ(event.type, trace::EventType::HLE_CALL);
+        EXPECT_EQ(event.id, 0x1234u);
+        EXPECT_EQ(event.arg_count, trace::MAX_EVENT_ARGS);
+        EXPECT_EQ(event.args[0], next_index[event.thread_id]++);
+        EXPECT_EQ(event.args[4], 4u);
+    }
+}
+
+TEST(trace, can_be_restarted) {
+    const fs::path path = fs::temp_directory_path() / fs::unique_path("trace-%%%%-%%%%.bin");
+    for (uint32_t i = 0; i < 2; i++) {
+        ASSERT_TRUE(trace::start(path));
+        trace::record(trace::EventType::THREAD_STATUS, i, 1, { 0 });
+        trace::stop();
+
+        trace::FileHeader header;
+        std::vector<trace::Event> events;
+        ASSERT_TRUE(trace::read_file(path, header, events));
+        ASSERT_EQ(events.size(), 1u);
+        EXPECT_EQ(events[0].id, i);
+    }
+    fs::remove(path);
+}
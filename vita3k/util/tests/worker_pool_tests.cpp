@@ -0,0 +1,51 @@
+// Vita3K emulator project
+// Copyright (C) 2023 Vita3K team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+#include <util/worker_pool.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST(worker_pool, parallel_for_calls_each_index_once) {
+    for (std::size_t count : { 0, 1, 2, 7, 1000 }) {
+        std::vector<std::atomic<int>> calls(count);
+        bool caller_done = false;
+        const std::thread::id caller = std::this_thread::get_id();
+        util::parallel_for(
+            count, [&](std::size_t i) { calls[i]++; },
+            [&]() {
+                EXPECT_EQ(std::this_thread::get_id(), caller);
+                caller_done = true;
+            });
+
+        EXPECT_TRUE(caller_done);
+        for (std::size_t i = 0; i < count; i++)
+            EXPECT_EQ(calls[i], 1) << "count = " << count << ", i = " << i;
+    }
+}
+
+TEST(worker_pool, nested_parallel_for_runs_serially) {
+    std::atomic<int> total = 0;
+    util::parallel_for(4, [&](std::size_t) {
+        // the pool is busy with the outer loop
+        util::parallel_for(10, [&](std::size_t) { total++; });
+    });
+    EXPECT_EQ(total, 40);
+}